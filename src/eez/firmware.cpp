@@ -29,6 +29,7 @@
 #include <eez/mp.h>
 #include <eez/sound.h>
 #include <eez/memory.h>
+#include <eez/trace.h>
 
 #include <eez/scpi/scpi.h>
 
@@ -48,11 +49,13 @@
 #include <eez/modules/psu/profile.h>
 #include <eez/modules/psu/list_program.h>
 #include <eez/modules/psu/trigger.h>
+#include <eez/modules/psu/sd_worker.h>
 #if OPTION_ETHERNET
 #include <eez/modules/psu/ethernet.h>
 #include <eez/modules/psu/ntp.h>
 #endif
 #include <eez/modules/psu/gui/psu.h>
+#include <eez/modules/psu/gui/file_manager.h>
 
 #if OPTION_FAN
 #include <eez/modules/aux_ps/fan.h>
@@ -87,11 +90,18 @@ void boot() {
 
     psu::event_queue::init();
 
+    // clock is used by all the threads, it is synced with RTC on the first use
+    psu::datetime::init();
+
 #if defined(EEZ_PLATFORM_STM32)
     mcu::sdram::init();
     //mcu::sdram::test();
 #endif
 
+#if OPTION_TRACE
+    trace::init();
+#endif
+
 #if OPTION_DISPLAY
     gui::startThread();
 #endif
@@ -106,8 +116,13 @@ void boot() {
 
 #if OPTION_ETHERNET
     mcu::ethernet::initMessageQueue();
+#endif
+    psu::profile::initIndexMutex();
+#if OPTION_DISPLAY
+    gui::file_manager::initMutex();
 #endif
     scpi::initMessageQueue();
+    psu::sd_worker::initMessageQueue();
 
     psu::startThread();
 
@@ -118,7 +133,6 @@ void boot() {
     }
 
     psu::rtc::init();
-    psu::datetime::init();
 
     mcu::eeprom::init();
     mcu::eeprom::test();
@@ -238,6 +252,7 @@ void boot() {
     mcu::ethernet::startThread();
 #endif
     scpi::startThread();
+    psu::sd_worker::startThread();
 
     mp::initMessageQueue();
     mp::startThread();
@@ -362,6 +377,10 @@ void shutdown() {
     } while (isThreadAlive());
 #endif
 
+#if OPTION_TRACE
+    trace::shutdownDump();
+#endif
+
     profile::shutdownSave();
 
     if (psu::isPowerUp()) {
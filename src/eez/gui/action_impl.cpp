@@ -49,6 +49,7 @@
 #include <eez/modules/psu/gui/file_manager.h>
 
 #include <eez/modules/psu/sd_card.h>
+#include <eez/modules/psu/sd_worker.h>
 
 #if OPTION_ENCODER
 #include <eez/modules/mcu/encoder.h>
@@ -1033,7 +1034,7 @@ void action_user_switch_clicked() {
         using namespace scpi;
         if (!g_screenshotGenerating) {
             g_screenshotGenerating = true;
-            osMessagePut(g_scpiMessageQueueId, SCPI_QUEUE_MESSAGE(SCPI_QUEUE_MESSAGE_TARGET_NONE, SCPI_QUEUE_MESSAGE_SCREENSHOT, 0), osWaitForever);
+            psu::sd_worker::postRequest(psu::sd_worker::REQUEST_SCREENSHOT);
         }
         break;
 
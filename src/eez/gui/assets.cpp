@@ -19,9 +19,11 @@
 #if OPTION_DISPLAY
 
 #include <assert.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <memory.h>
 
+#include <eez/debug.h>
 #include <eez/system.h>
 #include <eez/memory.h>
 
@@ -42,8 +44,12 @@ static Assets g_mainAssets;
 
 static Assets g_externalAssets;
 
+// set by fixPointers, loadBlock and fixPage while g_assetsMutexId is taken
 static Assets *g_fixPointersAssets;
 
+osMutexId(g_assetsMutexId);
+osMutexDef(g_assetsMutex);
+
 void StyleList_fixPointers() {
     g_fixPointersAssets->styles->first = (Style *)((uint8_t *)g_fixPointersAssets->styles + (uint32_t)g_fixPointersAssets->styles->first);
 }
@@ -86,6 +92,8 @@ void NameList_fixPointers(NameList *nameList) {
 }
 
 void fixPointers(Assets &assets) { 
+    osMutexWait(g_assetsMutexId, osWaitForever);
+
     g_fixPointersAssets = &assets;
 
     WidgetList_fixPointers(g_fixPointersAssets->document->pages);
@@ -93,6 +101,8 @@ void fixPointers(Assets &assets) {
     ColorsData_fixPointers();
     NameList_fixPointers(g_fixPointersAssets->actionNames);
     NameList_fixPointers(g_fixPointersAssets->dataItemNames);
+
+    osMutexRelease(g_assetsMutexId);
 }
 
 #define WIDGET_TYPE(NAME, ID) extern FixPointersFunctionType NAME##_fixPointers;
@@ -151,32 +161,205 @@ void initAssets(Assets &assets, bool external, uint8_t *decompressedAssets) {
     }
 }
 
+////////////////////////////////////////////////////////////////////////////////
+
+// Main assets can be stored in sections, where document, styles, colors and every font and bitmap
+// are compressed independently, so each section is decompressed (and its pointers fixed)
+// only when it is used for the first time:
+//
+//     uint32_t tag (ASSETS_SECTIONS_TAG)
+//     uint32_t number of fonts
+//     uint32_t number of bitmaps
+//     AssetsBlock blocks[3 + number of fonts + number of bitmaps]
+//     compressed blocks
+//
+// In the old format first uint32_t is decompressed size of the single compressed block.
+
+#define CONF_ASSETS_LAZY_LOADING 1 // set to 0 to decompress all the sections at boot
+
+#define ASSETS_SECTIONS_TAG 0x315A5A45
+
+#define MAX_ASSETS_BLOCKS 64
+#define MAX_PAGES 512
+
+struct AssetsBlock {
+    uint32_t compressedOffset;
+    uint32_t compressedSize;
+    uint32_t decompressedSize;
+};
+
+struct AssetsSectionsHeader {
+    uint32_t tag;
+    uint32_t numFonts;
+    uint32_t numBitmaps;
+    AssetsBlock blocks[1];
+};
+
+enum {
+    ASSETS_BLOCK_DOCUMENT,
+    ASSETS_BLOCK_STYLES,
+    ASSETS_BLOCK_COLORS,
+    ASSETS_BLOCK_FIRST_FONT
+};
+
+static const AssetsSectionsHeader *g_sectionsHeader;
+static uint8_t * volatile g_blocks[MAX_ASSETS_BLOCKS];
+static volatile uint32_t g_fixedPages[MAX_PAGES / 32];
+
+static AssetsLoadStats g_loadStats;
+
+static int getNumBlocks() {
+    return ASSETS_BLOCK_FIRST_FONT + g_sectionsHeader->numFonts + g_sectionsHeader->numBitmaps;
+}
+
+static uint8_t *loadBlock(int blockIndex) {
+    osMutexWait(g_assetsMutexId, osWaitForever);
+
+    // check again, other thread could load it in the meantime
+    uint8_t *block = g_blocks[blockIndex];
+
+    if (!block) {
+        uint32_t startTime = micros();
+
+        const AssetsBlock &assetsBlock = g_sectionsHeader->blocks[blockIndex];
+
+        block = DECOMPRESSED_ASSETS_START_ADDRESS + g_loadStats.ramUsed;
+        g_loadStats.ramUsed += ((assetsBlock.decompressedSize + 3) / 4) * 4;
+        assert(g_loadStats.ramUsed <= DECOMPRESSED_ASSETS_SIZE);
+
+        int result = LZ4_decompress_safe((const char *)assets + assetsBlock.compressedOffset, (char *)block, (int)assetsBlock.compressedSize, (int)assetsBlock.decompressedSize);
+        assert(result == (int)assetsBlock.decompressedSize);
+
+        g_fixPointersAssets = &g_mainAssets;
+
+        if (blockIndex == ASSETS_BLOCK_DOCUMENT) {
+            // pages are fixed one by one, see getPageWidget
+            g_mainAssets.document = (Document *)block;
+            assert(g_mainAssets.document->pages.count <= MAX_PAGES);
+            g_mainAssets.document->pages.first = (Widget *)(block + (uint32_t)g_mainAssets.document->pages.first);
+        } else if (blockIndex == ASSETS_BLOCK_STYLES) {
+            g_mainAssets.styles = (StyleList *)block;
+            StyleList_fixPointers();
+        } else if (blockIndex == ASSETS_BLOCK_COLORS) {
+            g_mainAssets.colorsData = (Colors *)block;
+            ColorsData_fixPointers();
+        }
+
+        g_blocks[blockIndex] = block;
+
+        if (g_assetsLoaded) {
+            uint32_t duration = micros() - startTime;
+            g_loadStats.numLazyLoads++;
+            g_loadStats.lazyLoadDuration += duration;
+            if (duration > g_loadStats.maxLazyLoadDuration) {
+                g_loadStats.maxLazyLoadDuration = duration;
+            }
+        }
+    }
+
+    osMutexRelease(g_assetsMutexId);
+
+    return block;
+}
+
+static inline uint8_t *getBlock(int blockIndex) {
+    uint8_t *block = g_blocks[blockIndex];
+    return block ? block : loadBlock(blockIndex);
+}
+
+static void fixPage(int pageIndex) {
+    osMutexWait(g_assetsMutexId, osWaitForever);
+
+    if (!(g_fixedPages[pageIndex / 32] & (1u << (pageIndex % 32)))) {
+        g_fixPointersAssets = &g_mainAssets;
+        Widget_fixPointers((Widget *)g_mainAssets.document->pages.first + pageIndex);
+        g_fixedPages[pageIndex / 32] |= 1u << (pageIndex % 32);
+    }
+
+    osMutexRelease(g_assetsMutexId);
+}
+
+void loadAllAssets() {
+    if (!g_sectionsHeader) {
+        return;
+    }
+
+    for (int blockIndex = 0; blockIndex < getNumBlocks(); blockIndex++) {
+        getBlock(blockIndex);
+    }
+
+    for (uint32_t pageIndex = 0; pageIndex < g_mainAssets.document->pages.count; pageIndex++) {
+        fixPage(pageIndex);
+    }
+}
+
 void decompressAssets() {
-    uint8_t *decompressedAssets;
+    uint32_t startTime = micros();
 
-    int compressedSize = sizeof(assets) - 4;
+    g_assetsMutexId = osMutexCreate(osMutex(g_assetsMutex));
 
-    // first 4 bytes (uint32_t) are decompressed size
-    uint32_t decompressedSize = ((uint32_t *)assets)[0];
-    assert(decompressedSize <= DECOMPRESSED_ASSETS_SIZE);
-    decompressedAssets = DECOMPRESSED_ASSETS_START_ADDRESS;
+    if (((uint32_t *)assets)[0] == ASSETS_SECTIONS_TAG) {
+        g_sectionsHeader = (const AssetsSectionsHeader *)assets;
+        assert(getNumBlocks() <= MAX_ASSETS_BLOCKS);
+
+        for (int blockIndex = 0; blockIndex < getNumBlocks(); blockIndex++) {
+            g_loadStats.ramTotal += ((g_sectionsHeader->blocks[blockIndex].decompressedSize + 3) / 4) * 4;
+        }
+
+#if !CONF_ASSETS_LAZY_LOADING
+        loadAllAssets();
+#endif
+    } else {
+        // exported by EEZ Studio and not yet repacked with tools/assets_repack
+        DebugTrace("Assets are not in the sections format, lazy loading is disabled\n");
+
+        uint8_t *decompressedAssets;
+
+        int compressedSize = sizeof(assets) - 4;
 
-    int result = LZ4_decompress_safe((const char *)assets + 4, (char *)decompressedAssets, compressedSize, (int)decompressedSize);
-    assert(result == (int)decompressedSize);
+        // first 4 bytes (uint32_t) are decompressed size
+        uint32_t decompressedSize = ((uint32_t *)assets)[0];
+        assert(decompressedSize <= DECOMPRESSED_ASSETS_SIZE);
+        decompressedAssets = DECOMPRESSED_ASSETS_START_ADDRESS;
 
-    initAssets(g_mainAssets, false, decompressedAssets);
+        int result = LZ4_decompress_safe((const char *)assets + 4, (char *)decompressedAssets, compressedSize, (int)decompressedSize);
+        assert(result == (int)decompressedSize);
 
-    fixPointers(g_mainAssets);
+        initAssets(g_mainAssets, false, decompressedAssets);
+
+        fixPointers(g_mainAssets);
+
+        g_loadStats.ramUsed = decompressedSize;
+        g_loadStats.ramTotal = decompressedSize;
+    }
+
+    g_loadStats.bootDuration = micros() - startTime;
 
     g_assetsLoaded = true;
 }
 
+const AssetsLoadStats &getAssetsLoadStats() {
+    return g_loadStats;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 const Style *getStyle(int styleID) {
+    if (g_sectionsHeader) {
+        getBlock(ASSETS_BLOCK_STYLES);
+    }
     return g_mainAssets.styles->first + styleID - 1;
 }
 
 const Widget* getPageWidget(int pageId) {
     if (pageId > 0) {
+        if (g_sectionsHeader) {
+            getBlock(ASSETS_BLOCK_DOCUMENT);
+            int pageIndex = pageId - 1;
+            if (!(g_fixedPages[pageIndex / 32] & (1u << (pageIndex % 32)))) {
+                fixPage(pageIndex);
+            }
+        }
         return g_mainAssets.document->pages.first + (pageId - 1);
     } else if (pageId < 0) {
         return g_externalAssets.document->pages.first + (-pageId - 1);
@@ -188,11 +371,17 @@ const uint8_t *getFontData(int fontID) {
     if (fontID == 0) {
         return 0;
     }
+    if (g_sectionsHeader) {
+        return getBlock(ASSETS_BLOCK_FIRST_FONT + fontID - 1);
+    }
     return g_mainAssets.fontsData + ((uint32_t *)g_mainAssets.fontsData)[fontID - 1];
 }
 
 const Bitmap *getBitmap(int bitmapID) {
     if (bitmapID > 0) {
+        if (g_sectionsHeader) {
+            return (const Bitmap *)getBlock(ASSETS_BLOCK_FIRST_FONT + g_sectionsHeader->numFonts + bitmapID - 1);
+        }
         return (const Bitmap *)(g_mainAssets.bitmapsData + ((uint32_t *)g_mainAssets.bitmapsData)[bitmapID - 1]);
     } else if (bitmapID < 0) {
         return (const Bitmap *)(g_externalAssets.bitmapsData + ((uint32_t *)g_externalAssets.bitmapsData)[-bitmapID - 1]);
@@ -200,12 +389,19 @@ const Bitmap *getBitmap(int bitmapID) {
     return nullptr;
 }
 
+static inline const Colors *getColorsData() {
+    if (g_sectionsHeader) {
+        getBlock(ASSETS_BLOCK_COLORS);
+    }
+    return g_mainAssets.colorsData;
+}
+
 int getThemesCount() {
-    return (int)g_mainAssets.colorsData->themes.count;
+    return (int)getColorsData()->themes.count;
 }
 
 const Theme *getTheme(int i) {
-    return g_mainAssets.colorsData->themes.first + i;
+    return getColorsData()->themes.first + i;
 }
 
 const char *getThemeName(int i) {
@@ -221,7 +417,7 @@ const uint32_t getThemeColorsCount(int themeIndex) {
 }
 
 const uint16_t *getColors() {
-    return g_mainAssets.colorsData->colors.first;
+    return getColorsData()->colors.first;
 }
 
 const char *getActionName(int16_t actionId) {
@@ -235,13 +431,121 @@ const char *getActionName(int16_t actionId) {
     return g_externalAssets.actionNames->first[actionId];
 }
 
-int16_t getDataIdFromName(const char *name) {
-    for (uint32_t i = 0; i < g_externalAssets.dataItemNames->count; i++) {
-        if (strcmp(g_externalAssets.dataItemNames->first[i], name) == 0) {
-            return -((int16_t)i+1);
+////////////////////////////////////////////////////////////////////////////////
+
+// Open addressing hash table for the name lookups. If name list is too big to be indexed,
+// it is searched linearly.
+
+#define NAME_INDEX_SIZE 2048 // power of 2, at most NAME_INDEX_SIZE / 2 names are indexed
+
+struct NameIndex {
+    const NameList *nameList;
+    bool valid;
+    uint16_t slots[NAME_INDEX_SIZE]; // name index + 1, 0 for the empty slot
+};
+
+static NameIndex g_dataItemNamesIndex;
+
+static uint32_t getNameHash(const char *name) {
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    while (*name) {
+        hash = (hash ^ (uint8_t)*name++) * 16777619u;
+    }
+    return hash;
+}
+
+static void NameIndex_build(NameIndex &index, const NameList *nameList) {
+    index.nameList = nameList;
+    index.valid = nameList && nameList->count <= NAME_INDEX_SIZE / 2;
+    if (!index.valid) {
+        return;
+    }
+
+    memset(index.slots, 0, sizeof(index.slots));
+
+    for (uint32_t i = 0; i < nameList->count; i++) {
+        uint32_t slot = getNameHash(nameList->first[i]) & (NAME_INDEX_SIZE - 1);
+        while (index.slots[slot]) {
+            slot = (slot + 1) & (NAME_INDEX_SIZE - 1);
+        }
+        index.slots[slot] = (uint16_t)(i + 1);
+    }
+}
+
+static int NameIndex_linearFind(const NameList *nameList, const char *name) {
+    if (nameList) {
+        for (uint32_t i = 0; i < nameList->count; i++) {
+            if (strcmp(nameList->first[i], name) == 0) {
+                return (int)i;
+            }
+        }
+    }
+    return -1;
+}
+
+static int NameIndex_find(const NameIndex &index, const char *name) {
+    if (!index.valid) {
+        return NameIndex_linearFind(index.nameList, name);
+    }
+
+    uint32_t slot = getNameHash(name) & (NAME_INDEX_SIZE - 1);
+    while (index.slots[slot]) {
+        int i = index.slots[slot] - 1;
+        if (strcmp(index.nameList->first[i], name) == 0) {
+            return i;
         }
+        slot = (slot + 1) & (NAME_INDEX_SIZE - 1);
+    }
+
+    return -1;
+}
+
+int16_t getDataIdFromName(const char *name) {
+    int i = NameIndex_find(g_dataItemNamesIndex, name);
+    return i != -1 ? -((int16_t)i + 1) : 0;
+}
+
+void benchmarkNameIndex(int numNames, int numLookups) {
+    // MicroPython heap is free when no script is running
+    uint8_t *buffer = MP_BUFFER + MP_BUFFER_SIZE / 2;
+
+    NameIndex *index = (NameIndex *)buffer;
+    NameList *nameList = (NameList *)(index + 1);
+    nameList->first = (const char **)(nameList + 1);
+    char *names = (char *)(nameList->first + numNames);
+    assert(names + numNames * 24 <= (char *)MP_BUFFER + MP_BUFFER_SIZE);
+
+    nameList->count = numNames;
+    for (int i = 0; i < numNames; i++) {
+        char *name = names + i * 24;
+        snprintf(name, 24, "external_data_item_%d", i);
+        nameList->first[i] = name;
+    }
+
+    uint32_t startTime = micros();
+    NameIndex_build(*index, nameList);
+    uint32_t buildDuration = micros() - startTime;
+
+    // sum of the results is compared, so lookups are not optimized away
+    int sums[2] = { 0, 0 };
+    uint32_t durations[2];
+
+    startTime = micros();
+    for (int i = 0; i < numLookups; i++) {
+        sums[0] += NameIndex_find(*index, nameList->first[(i * 7) % numNames]);
     }
-    return 0;
+    durations[0] = micros() - startTime;
+
+    startTime = micros();
+    for (int i = 0; i < numLookups; i++) {
+        sums[1] += NameIndex_linearFind(nameList, nameList->first[(i * 7) % numNames]);
+    }
+    durations[1] = micros() - startTime;
+
+    DebugTrace("Name index: %d names, build %u us, %d lookups: index %u us, linear %u us%s\n",
+        numNames, (unsigned)buildDuration, numLookups, (unsigned)durations[0], (unsigned)durations[1],
+        sums[0] != sums[1] ? ", MISMATCH" : "");
 }
 
 int getExternalAssetsFirstPageId() {
@@ -310,6 +614,8 @@ bool loadExternalAssets(const char *filePath, int *err) {
 
     fixPointers(g_externalAssets);
 
+    NameIndex_build(g_dataItemNamesIndex, g_externalAssets.dataItemNames);
+
     return true;
 }
 
@@ -25,8 +25,22 @@ namespace gui {
 
 void decompressAssets();
 
+// decompress all the asset sections not used so far
+void loadAllAssets();
+
 extern bool g_assetsLoaded;
 
+struct AssetsLoadStats {
+    uint32_t bootDuration;        // time spent in decompressAssets [us]
+    uint32_t numLazyLoads;        // number of sections decompressed after boot
+    uint32_t lazyLoadDuration;    // total time spent decompressing sections after boot [us]
+    uint32_t maxLazyLoadDuration; // [us]
+    uint32_t ramUsed;             // size of the decompressed assets [bytes]
+    uint32_t ramTotal;            // size of the decompressed assets when all sections are used [bytes]
+};
+
+const AssetsLoadStats &getAssetsLoadStats();
+
 const Style *getStyle(int styleID);
 const Widget *getPageWidget(int pageId);
 const uint8_t *getFontData(int fontID);
@@ -40,6 +54,10 @@ const uint16_t *getColors();
 const char *getActionName(int16_t actionId);
 int16_t getDataIdFromName(const char *name);
 
+// traces the time of the numLookups name lookups in the synthetic list of numNames names,
+// with and without the name index, uses MicroPython heap so it must not be called while script is running
+void benchmarkNameIndex(int numNames, int numLookups);
+
 int getExternalAssetsFirstPageId();
 
 #define GET_WIDGET_PROPERTY(widget, propertyName, type) ((type)widget->propertyName)
@@ -59,6 +59,9 @@ void eventHandling() {
 
     if (eventType != EVENT_TYPE_TOUCH_NONE) {
         psu::idle::noteHmiActivity();
+
+        // active widget, focus, etc. can be changed
+        invalidateAllData();
     }
 
     uint32_t tickCount = micros();
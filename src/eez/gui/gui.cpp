@@ -24,6 +24,7 @@
 #include <eez/firmware.h>
 #include <eez/sound.h>
 #include <eez/system.h>
+#include <eez/trace.h>
 #include <eez/util.h>
 
 #include <eez/gui/gui.h>
@@ -58,6 +59,8 @@ osThreadId g_guiTaskHandle;
 osMessageQDef(g_guiMessageQueue, GUI_QUEUE_SIZE, uint32_t);
 osMessageQId g_guiMessageQueueId;
 
+FrameStats g_frameStats;
+
 void startThread() {
     decompressAssets();
     mcu::display::onThemeChanged();
@@ -69,6 +72,8 @@ void startThread() {
 void oneIter();
 
 void mainLoop(const void *) {
+    TRACE_REGISTER_THREAD("GUI");
+
 #ifdef __EMSCRIPTEN__
 	oneIter();
 #else
@@ -119,12 +124,17 @@ void oneIter() {
         onGuiQueueMessage(type, param);
     }
 
+    TRACE_SCOPE("gui::oneIter");
+
     WATCHDOG_RESET();
 
     mcu::display::sync();
 
     g_wasBlinkTime = g_isBlinkTime;
     g_isBlinkTime = (millis() % (2 * CONF_GUI_BLINK_TIME)) > CONF_GUI_BLINK_TIME;
+    if (g_isBlinkTime != g_wasBlinkTime) {
+        invalidateAllData();
+    }
 
     touch::tick();
 
@@ -138,6 +148,8 @@ void oneIter() {
     eventHandling();
     stateManagmentHook();
 
+    uint64_t frameStartTime = microsPrecise();
+
     bool wasOn = mcu::display::isOn();
     if (wasOn) {
         mcu::display::beginBuffersDrawing();
@@ -152,6 +164,14 @@ void oneIter() {
 
     if (wasOn || mcu::display::isOn()) {
         mcu::display::endBuffersDrawing();
+
+        uint32_t frameTime = (uint32_t)(microsPrecise() - frameStartTime);
+        g_frameStats.numFrames++;
+        g_frameStats.lastTime = frameTime;
+        if (frameTime > g_frameStats.maxTime) {
+            g_frameStats.maxTime = frameTime;
+        }
+        g_frameStats.totalTime += frameTime;
     }
 }
 
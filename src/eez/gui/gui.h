@@ -65,6 +65,16 @@ void onGuiQueueMessageHook(uint8_t type, int16_t param);
 
 extern bool g_isBlinkTime;
 
+// time spent in drawing, measured on every GUI thread iteration while the display is on
+struct FrameStats {
+    uint32_t numFrames;
+    uint32_t lastTime;  // us
+    uint32_t maxTime;   // us
+    uint64_t totalTime; // us
+};
+
+extern FrameStats g_frameStats;
+
 ////////////////////////////////////////////////////////////////////////////////
 
 void stateManagmentHook();
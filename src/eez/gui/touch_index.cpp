@@ -0,0 +1,314 @@
+/*
+* EEZ Generic Firmware
+* Copyright (C) 2015-present, Envox d.o.o.
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#if OPTION_DISPLAY
+
+#include <string.h>
+
+#include <eez/debug.h>
+#include <eez/system.h>
+
+#include <eez/gui/gui.h>
+#include <eez/gui/touch_index.h>
+#include <eez/gui/widgets/container.h>
+
+namespace eez {
+namespace gui {
+namespace touch_index {
+
+#define MAX_ITEMS 96
+#define CELL_SIZE 64
+#define MAX_CELLS_X 13
+#define MAX_CELLS_Y 8
+#define MAX_INDEXES 2
+
+// Children of the dynamic widgets (list, grid, ...) can be smaller then WIDGET_MIN_TOUCH_SIZE
+// and placed at the widget border, so touch area of the dynamic widget is expanded for that much.
+#define DYNAMIC_WIDGET_TOUCH_MARGIN WIDGET_MIN_TOUCH_SIZE
+
+enum ItemType {
+    ITEM_TYPE_STATIC,  // widget is tested directly with findWidgetStep
+    ITEM_TYPE_DYNAMIC, // widget subtree is enumerated with findWidgetStep
+    ITEM_TYPE_OVERLAY  // same as dynamic, but overlay can be moved so it is never skipped
+};
+
+struct Item {
+    const Widget *widget;
+    int16_t x;
+    int16_t y;
+    uint8_t type;
+};
+
+struct Index {
+    AppContext *appContext;
+    int pageId;
+    bool valid;
+
+    int16_t xPage;
+    int16_t yPage;
+    uint8_t numCellsX;
+    uint8_t numCellsY;
+
+    uint32_t numItems;
+    Item items[MAX_ITEMS];
+
+    // bit i is set in cell if items[i] touch area intersects the cell
+    uint32_t cells[MAX_CELLS_X * MAX_CELLS_Y][MAX_ITEMS / 32];
+};
+
+static Index g_indexes[MAX_INDEXES];
+static bool g_enabled = true;
+static volatile bool g_invalidated;
+
+void invalidate() {
+    g_invalidated = true;
+}
+
+void setEnabled(bool enabled) {
+    g_enabled = enabled;
+}
+
+bool isEnabled() {
+    return g_enabled;
+}
+
+static int getCellX(Index &index, int x) {
+    int cellX = (x - index.xPage) / CELL_SIZE;
+    return cellX < 0 ? 0 : cellX >= index.numCellsX ? index.numCellsX - 1 : cellX;
+}
+
+static int getCellY(Index &index, int y) {
+    int cellY = (y - index.yPage) / CELL_SIZE;
+    return cellY < 0 ? 0 : cellY >= index.numCellsY ? index.numCellsY - 1 : cellY;
+}
+
+static bool addItem(Index &index, const Widget *widget, int x, int y, ItemType type) {
+    if (index.numItems == MAX_ITEMS) {
+        return false;
+    }
+
+    int itemIndex = index.numItems++;
+
+    Item &item = index.items[itemIndex];
+    item.widget = widget;
+    item.x = x;
+    item.y = y;
+    item.type = type;
+
+    int margin = type == ITEM_TYPE_STATIC ? WIDGET_MIN_TOUCH_SIZE / 2 : DYNAMIC_WIDGET_TOUCH_MARGIN;
+
+    int cellX1 = type == ITEM_TYPE_OVERLAY ? 0 : getCellX(index, x - margin);
+    int cellY1 = type == ITEM_TYPE_OVERLAY ? 0 : getCellY(index, y - margin);
+    int cellX2 = type == ITEM_TYPE_OVERLAY ? index.numCellsX - 1 : getCellX(index, x + widget->w + margin);
+    int cellY2 = type == ITEM_TYPE_OVERLAY ? index.numCellsY - 1 : getCellY(index, y + widget->h + margin);
+
+    for (int cellY = cellY1; cellY <= cellY2; cellY++) {
+        for (int cellX = cellX1; cellX <= cellX2; cellX++) {
+            index.cells[cellY * index.numCellsX + cellX][itemIndex / 32] |= 1u << (itemIndex % 32);
+        }
+    }
+
+    return true;
+}
+
+static bool addWidget(Index &index, const Widget *widget, int x, int y) {
+    x += widget->x;
+    y += widget->y;
+
+    if (widget->type == WIDGET_TYPE_CONTAINER) {
+        const ContainerWidget *containerWidget = GET_WIDGET_PROPERTY(widget, specific, const ContainerWidget *);
+        if (containerWidget->overlay != DATA_ID_NONE) {
+            return addItem(index, widget, x, y, ITEM_TYPE_OVERLAY);
+        }
+
+        // container itself is tested before its children, same as in enumWidget
+        if (widget->action != ACTION_ID_NONE || *g_onTouchWidgetFunctions[widget->type]) {
+            if (!addItem(index, widget, x, y, ITEM_TYPE_STATIC)) {
+                return false;
+            }
+        }
+
+        for (uint32_t i = 0; i < containerWidget->widgets.count; ++i) {
+            if (!addWidget(index, GET_WIDGET_LIST_ELEMENT(containerWidget->widgets, i), x, y)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    if (
+        widget->type == WIDGET_TYPE_LIST ||
+        widget->type == WIDGET_TYPE_GRID ||
+        widget->type == WIDGET_TYPE_SELECT ||
+        widget->type == WIDGET_TYPE_LAYOUT_VIEW ||
+        widget->type == WIDGET_TYPE_APP_VIEW
+    ) {
+        return addItem(index, widget, x, y, ITEM_TYPE_DYNAMIC);
+    }
+
+    if (widget->action != ACTION_ID_NONE || *g_onTouchWidgetFunctions[widget->type]) {
+        return addItem(index, widget, x, y, ITEM_TYPE_STATIC);
+    }
+
+    return true;
+}
+
+static Index *getIndex(AppContext *appContext) {
+    if (g_invalidated) {
+        g_invalidated = false;
+        for (int i = 0; i < MAX_INDEXES; i++) {
+            g_indexes[i].appContext = nullptr;
+        }
+    }
+
+    int pageId = appContext->getActivePageId();
+
+    Index *index = nullptr;
+    for (int i = 0; i < MAX_INDEXES; i++) {
+        if (g_indexes[i].appContext == appContext) {
+            index = &g_indexes[i];
+            break;
+        }
+        if (!index && !g_indexes[i].appContext) {
+            index = &g_indexes[i];
+        }
+    }
+
+    if (!index) {
+        return nullptr;
+    }
+
+    if (index->appContext != appContext || index->pageId != pageId) {
+        const Widget *page = getPageWidget(pageId);
+
+        memset(index, 0, sizeof(Index));
+
+        index->appContext = appContext;
+        index->pageId = pageId;
+
+        index->xPage = page->x;
+        index->yPage = page->y;
+
+        index->numCellsX = (page->w + CELL_SIZE - 1) / CELL_SIZE;
+        index->numCellsY = (page->h + CELL_SIZE - 1) / CELL_SIZE;
+
+        if (index->numCellsX > 0 && index->numCellsX <= MAX_CELLS_X && index->numCellsY > 0 && index->numCellsY <= MAX_CELLS_Y) {
+            index->valid = addWidget(*index, page, 0, 0);
+        } else {
+            index->valid = false;
+        }
+    }
+
+    return index->valid ? index : nullptr;
+}
+
+bool enumWidgets(WidgetCursor &widgetCursor, int touchX, int touchY) {
+    if (!g_enabled) {
+        return false;
+    }
+
+    Index *index = getIndex(widgetCursor.appContext);
+    if (!index) {
+        return false;
+    }
+
+    // items are stored relative to the enumeration start
+    int x = touchX - widgetCursor.x;
+    int y = touchY - widgetCursor.y;
+
+    uint32_t *cell = index->cells[getCellY(*index, y) * index->numCellsX + getCellX(*index, x)];
+
+    auto savedWidget = widgetCursor.widget;
+    auto savedX = widgetCursor.x;
+    auto savedY = widgetCursor.y;
+
+    // enumerate in the same order as enumWidget would do
+    for (uint32_t itemIndex = 0; itemIndex < index->numItems; itemIndex++) {
+        if (!(cell[itemIndex / 32] & (1u << (itemIndex % 32)))) {
+            continue;
+        }
+
+        Item &item = index->items[itemIndex];
+
+        widgetCursor.widget = item.widget;
+
+        if (item.type == ITEM_TYPE_STATIC) {
+            widgetCursor.x = savedX + item.x;
+            widgetCursor.y = savedY + item.y;
+            findWidgetStep(widgetCursor);
+        } else {
+            // enumWidget adds widget position itself
+            widgetCursor.x = savedX + item.x - item.widget->x;
+            widgetCursor.y = savedY + item.y - item.widget->y;
+            enumWidget(widgetCursor, findWidgetStep);
+        }
+    }
+
+    widgetCursor.widget = savedWidget;
+    widgetCursor.x = savedX;
+    widgetCursor.y = savedY;
+
+    return true;
+}
+
+void benchmark(AppContext *appContext, int numTouches) {
+    if (appContext->getActivePageId() == PAGE_ID_NONE || appContext->isActivePageInternal()) {
+        return;
+    }
+
+    const Widget *page = getPageWidget(appContext->getActivePageId());
+
+    bool savedEnabled = g_enabled;
+
+    uint32_t durations[2] = { 0, 0 };
+    int numMismatches = 0;
+
+    // fixed seed, so every run is done with the same touch points
+    uint32_t seed = 1;
+
+    for (int i = 0; i < numTouches; i++) {
+        seed = seed * 1103515245 + 12345;
+        int x = page->x + (seed >> 16) % page->w;
+        seed = seed * 1103515245 + 12345;
+        int y = page->y + (seed >> 16) % page->h;
+
+        WidgetCursor foundWidgets[2];
+        for (int j = 0; j < 2; j++) {
+            g_enabled = j == 0;
+            uint32_t start = micros();
+            foundWidgets[j] = findWidget(appContext, x, y);
+            durations[j] += micros() - start;
+        }
+
+        if (foundWidgets[0] != foundWidgets[1]) {
+            numMismatches++;
+        }
+    }
+
+    g_enabled = savedEnabled;
+
+    DebugTrace("Touch storm: %d touches, index %u us, walk %u us, %d mismatches\n",
+        numTouches, (unsigned)durations[0], (unsigned)durations[1], numMismatches);
+}
+
+} // namespace touch_index
+} // namespace gui
+} // namespace eez
+
+#endif
@@ -0,0 +1,48 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2015-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+namespace eez {
+namespace gui {
+
+// Spatial index (uniform grid) of the touchable widgets on the active page.
+// Only static part of the page is indexed, i.e. widgets whose position and visibility
+// doesn't depend on data. Lists, grids, selects, layout views, app views and overlays
+// are indexed as dynamic regions and touch inside them falls back to findWidget walk.
+namespace touch_index {
+
+// index is rebuilt on next lookup
+void invalidate();
+
+// Calls findWidgetStep only for the widgets (or dynamic subtrees) near the touch point,
+// in the same order as enumWidget would do. Returns false if index can't be used
+// for the active page of widgetCursor.appContext.
+bool enumWidgets(WidgetCursor &widgetCursor, int touchX, int touchY);
+
+void setEnabled(bool enabled);
+bool isEnabled();
+
+// Touch storm benchmark: finds widgets at numTouches pseudo random points of the active page,
+// with and without the index, and traces total time of both and the number of mismatches.
+void benchmark(AppContext *appContext, int numTouches);
+
+} // namespace touch_index
+
+} // namespace gui
+} // namespace eez
@@ -18,9 +18,16 @@
 
 #if OPTION_DISPLAY
 
+#include <assert.h>
+#include <string.h>
+
 #include <eez/debug.h>
+#include <eez/trace.h>
 
 #include <eez/gui/gui.h>
+#include <eez/gui/touch_index.h>
+#include <eez/gui/widgets/button.h>
+#include <eez/gui/widgets/container.h>
 
 namespace eez {
 namespace gui {
@@ -29,6 +36,33 @@ static uint8_t g_stateBuffer[2][CONF_MAX_STATE_SIZE];
 static WidgetState *g_previousState;
 static WidgetState *g_currentState;
 
+static UpdateMode g_updateMode = UPDATE_MODE_RETAINED;
+
+// Data dependencies are tracked with 64-bit mask, i.e. data ID is mapped to one of 64 bits.
+// Different data ID's can share the same bit, so this is conservative:
+// widget is sometimes evaluated even if its data is not changed, but never the other way around.
+#define DATA_ID_BIT(dataId) (((uint64_t)1) << (((uint16_t)(dataId)) & 63))
+
+static uint64_t g_invalidatedDataMask;
+static bool g_allDataInvalidated = true;
+
+static uint64_t g_frameInvalidatedDataMask;
+static bool g_frameAllDataInvalidated;
+
+static uint32_t g_numWidgetsVisited;
+static uint32_t g_numWidgetsRetained;
+static uint32_t g_numRetainedMismatches;
+
+struct WidgetDependencies {
+    const Widget *widget;
+    uint64_t dataMask;
+    bool retainable;
+};
+
+#define WIDGET_DEPENDENCIES_TABLE_SIZE 256
+static WidgetDependencies g_widgetDependencies[WIDGET_DEPENDENCIES_TABLE_SIZE];
+static uint32_t g_numWidgetDependencies;
+
 int getCurrentStateBufferIndex() {
     return (uint8_t *)g_currentState == &g_stateBuffer[0][0] ? 0 : 1;
 }
@@ -39,13 +73,186 @@ uint32_t getCurrentStateBufferSize(const WidgetCursor &widgetCursor) {
 
 void refreshScreen() {
     g_currentState = 0;
+    touch_index::invalidate();
+}
+
+void setUpdateMode(UpdateMode mode) {
+    g_updateMode = mode;
+}
+
+UpdateMode getUpdateMode() {
+    return g_updateMode;
+}
+
+void invalidateData(int16_t dataId) {
+    g_invalidatedDataMask |= DATA_ID_BIT(dataId);
+}
+
+void invalidateAllData() {
+    g_allDataInvalidated = true;
+}
+
+uint32_t getNumWidgetsVisited() {
+    return g_numWidgetsVisited;
+}
+
+uint32_t getNumWidgetsRetained() {
+    return g_numWidgetsRetained;
+}
+
+uint32_t getNumRetainedMismatches() {
+    return g_numRetainedMismatches;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static bool addDataDependency(int16_t dataId, uint64_t &dataMask) {
+    if (dataId == DATA_ID_NONE) {
+        return true;
+    }
+    if (dataId < 0 || !isDataTrackedHook(dataId)) {
+        return false;
+    }
+    dataMask |= DATA_ID_BIT(dataId);
+    return true;
 }
 
+static WidgetDependencies *getWidgetDependencies(const Widget *widget) {
+    uint32_t hash = (uint32_t)(((uintptr_t)widget) >> 2) % WIDGET_DEPENDENCIES_TABLE_SIZE;
+    for (uint32_t i = 0; i < WIDGET_DEPENDENCIES_TABLE_SIZE; i++) {
+        WidgetDependencies &entry = g_widgetDependencies[(hash + i) % WIDGET_DEPENDENCIES_TABLE_SIZE];
+        if (entry.widget == widget) {
+            return &entry;
+        }
+        if (!entry.widget) {
+            // table is kept at most 3/4 full, everything above is evaluated every time
+            if (g_numWidgetDependencies >= 3 * WIDGET_DEPENDENCIES_TABLE_SIZE / 4) {
+                return nullptr;
+            }
+
+            uint64_t dataMask = 0;
+            bool retainable = addDataDependency(widget->data, dataMask);
+
+            if (retainable) {
+                if (widget->type == WIDGET_TYPE_CONTAINER) {
+                    const ContainerWidget *containerWidget = GET_WIDGET_PROPERTY(widget, specific, const ContainerWidget *);
+                    if (containerWidget->overlay != DATA_ID_NONE) {
+                        retainable = false;
+                    } else {
+                        for (uint32_t index = 0; index < containerWidget->widgets.count && retainable; ++index) {
+                            WidgetDependencies *childEntry = getWidgetDependencies(GET_WIDGET_LIST_ELEMENT(containerWidget->widgets, index));
+                            if (childEntry && childEntry->retainable) {
+                                dataMask |= childEntry->dataMask;
+                            } else {
+                                retainable = false;
+                            }
+                        }
+                    }
+                } else if (widget->type == WIDGET_TYPE_BUTTON) {
+                    const ButtonWidget *buttonWidget = GET_WIDGET_PROPERTY(widget, specific, const ButtonWidget *);
+                    retainable = addDataDependency(buttonWidget->enabled, dataMask);
+                } else if (
+                    widget->type != WIDGET_TYPE_TEXT &&
+                    widget->type != WIDGET_TYPE_MULTILINE_TEXT &&
+                    widget->type != WIDGET_TYPE_DISPLAY_DATA &&
+                    widget->type != WIDGET_TYPE_RECTANGLE &&
+                    widget->type != WIDGET_TYPE_BITMAP
+                ) {
+                    // all the other widgets have dependencies (lists, overlays, graphs, ...)
+                    // that can't be determined from the widget definition
+                    retainable = false;
+                }
+            }
+
+            // recursive call above could use this slot
+            if (entry.widget) {
+                return getWidgetDependencies(widget);
+            }
+
+            entry.widget = widget;
+            entry.dataMask = dataMask;
+            entry.retainable = retainable;
+            g_numWidgetDependencies++;
+
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+static void resetWidgetDependencies() {
+    memset(g_widgetDependencies, 0, sizeof(g_widgetDependencies));
+    g_numWidgetDependencies = 0;
+}
+
+bool isWidgetRetained(const WidgetCursor &widgetCursor) {
+    if (g_updateMode == UPDATE_MODE_FULL || g_frameAllDataInvalidated) {
+        return false;
+    }
+
+    if (!widgetCursor.previousState || !widgetCursor.currentState) {
+        return false;
+    }
+
+    if (widgetCursor.previousState->flags.active != g_isActiveWidget) {
+        return false;
+    }
+
+    WidgetDependencies *entry = getWidgetDependencies(widgetCursor.widget);
+    return entry && entry->retainable && !(entry->dataMask & g_frameInvalidatedDataMask);
+}
+
+void retainWidgetState(const WidgetCursor &widgetCursor) {
+    uint16_t size = widgetCursor.previousState->size;
+    assert(getCurrentStateBufferSize(widgetCursor) + size <= CONF_MAX_STATE_SIZE);
+    memcpy(widgetCursor.currentState, widgetCursor.previousState, size);
+    g_numWidgetsRetained++;
+}
+
+void onWidgetDrawn(const WidgetCursor &widgetCursor, bool verifyRetained) {
+    g_numWidgetsVisited++;
+
+    if (verifyRetained && widgetCursor.previousState) {
+        WidgetState *currentState = widgetCursor.currentState;
+        WidgetState *previousState = widgetCursor.previousState;
+        if (
+            currentState->data != previousState->data ||
+            currentState->flags.active != previousState->flags.active ||
+            currentState->flags.focused != previousState->flags.focused ||
+            currentState->flags.blinking != previousState->flags.blinking ||
+            currentState->flags.enabled != previousState->flags.enabled
+        ) {
+            g_numRetainedMismatches++;
+            DebugTrace("Retained widget mismatch: type=%d, data=%d\n", (int)widgetCursor.widget->type, (int)widgetCursor.widget->data);
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 void updateScreen() {
+    TRACE_SCOPE("gui::updateScreen");
+
     g_isActiveWidget = false;
     g_previousState = g_currentState;
     g_currentState = (WidgetState *)(&g_stateBuffer[getCurrentStateBufferIndex() == 0 ? 1 : 0][0]);
 
+    if (!g_previousState) {
+        // new page or forced refresh, widget dependencies are registered again
+        resetWidgetDependencies();
+        g_allDataInvalidated = true;
+    }
+
+    invalidateChangedDataHook();
+
+    g_frameInvalidatedDataMask = g_invalidatedDataMask;
+    g_frameAllDataInvalidated = g_allDataInvalidated;
+    g_invalidatedDataMask = 0;
+    g_allDataInvalidated = false;
+
+    g_numWidgetsVisited = 0;
+    g_numWidgetsRetained = 0;
+
 	WidgetCursor widgetCursor;
 	widgetCursor.appContext = &getRootAppContext();
 	widgetCursor.previousState = g_previousState;
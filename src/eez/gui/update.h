@@ -21,7 +21,34 @@
 namespace eez {
 namespace gui {
 
+enum UpdateMode {
+    UPDATE_MODE_FULL,     // evaluate every widget on every frame
+    UPDATE_MODE_RETAINED, // evaluate only widgets whose data dependencies are invalidated
+    UPDATE_MODE_VERIFY    // evaluate every widget, but report widgets retained mode would miss
+};
+
 void updateScreen();
 
+void setUpdateMode(UpdateMode mode);
+UpdateMode getUpdateMode();
+
+// Must be called from the GUI thread, usually from invalidateChangedDataHook.
+void invalidateData(int16_t dataId);
+void invalidateAllData();
+
+// Returns true if widget (and all its children) state can be copied from the previous state.
+bool isWidgetRetained(const WidgetCursor &widgetCursor);
+void retainWidgetState(const WidgetCursor &widgetCursor);
+void onWidgetDrawn(const WidgetCursor &widgetCursor, bool verifyRetained);
+
+// statistics of the last updateScreen
+uint32_t getNumWidgetsVisited();
+uint32_t getNumWidgetsRetained();
+uint32_t getNumRetainedMismatches();
+
+// Data is tracked if application calls invalidateData every time when it is changed.
+bool isDataTrackedHook(int16_t dataId);
+void invalidateChangedDataHook();
+
 } // namespace gui
 } // namespace eez
\ No newline at end of file
@@ -25,6 +25,7 @@
 #include <eez/system.h>
 
 #include <eez/gui/gui.h>
+#include <eez/gui/touch_index.h>
 
 using namespace eez::mcu;
 
@@ -40,6 +41,9 @@ static int g_distanceToFoundWidget;
 
 bool g_isActiveWidget;
 
+// greater than zero while widgets that would be retained are evaluated in UPDATE_MODE_VERIFY
+static int g_verifyRetainedWidget;
+
 ////////////////////////////////////////////////////////////////////////////////
 
 FixPointersFunctionType NONE_fixPointers = nullptr;
@@ -111,6 +115,8 @@ void drawWidgetCallback(const WidgetCursor &widgetCursor_) {
     } else {
         defaultWidgetDraw(widgetCursor);
     }
+
+    onWidgetDrawn(widgetCursor, g_verifyRetainedWidget > 0);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -142,10 +148,24 @@ void enumWidget(WidgetCursor &widgetCursor, EnumWidgetsCallback callback) {
     bool savedIsActiveWidget = g_isActiveWidget;
     g_isActiveWidget = g_isActiveWidget || isActiveWidget(widgetCursor);
 
-    callback(widgetCursor);
+    bool retained = callback == drawWidgetCallback && isWidgetRetained(widgetCursor);
+
+    if (retained && getUpdateMode() == UPDATE_MODE_RETAINED) {
+        retainWidgetState(widgetCursor);
+    } else {
+        if (retained) {
+            ++g_verifyRetainedWidget;
+        }
+
+        callback(widgetCursor);
+
+        if (*g_enumWidgetFunctions[widgetCursor.widget->type]) {
+           (*g_enumWidgetFunctions[widgetCursor.widget->type])(widgetCursor, callback);
+        }
 
-    if (*g_enumWidgetFunctions[widgetCursor.widget->type]) {
-       (*g_enumWidgetFunctions[widgetCursor.widget->type])(widgetCursor, callback);
+        if (retained) {
+            --g_verifyRetainedWidget;
+        }
     }
 
     g_isActiveWidget = savedIsActiveWidget;
@@ -188,6 +208,10 @@ void enumWidgets(WidgetCursor &widgetCursor, EnumWidgetsCallback callback) {
         return;
     }
 
+    if (callback == findWidgetStep && touch_index::enumWidgets(widgetCursor, g_findWidgetAtX, g_findWidgetAtY)) {
+        return;
+    }
+
     auto savedWidget = widgetCursor.widget;
     widgetCursor.widget = getPageWidget(appContext->getActivePageId());
     enumWidget(widgetCursor, callback);
@@ -200,42 +224,51 @@ void enumWidgets(AppContext* appContext, EnumWidgetsCallback callback) {
 	}
 	WidgetCursor widgetCursor;
 	widgetCursor.appContext = appContext;
+
+    if (callback == findWidgetStep && touch_index::enumWidgets(widgetCursor, g_findWidgetAtX, g_findWidgetAtY)) {
+        return;
+    }
+
 	widgetCursor.widget = getPageWidget(appContext->getActivePageId());
 	enumWidget(widgetCursor, callback);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
-void findWidgetStep(const WidgetCursor &widgetCursor) {
-    const Widget *widget = widgetCursor.widget;
-
-    Overlay *overlay = getOverlay(widgetCursor);
+bool isWidgetTouched(int x, int y, int w, int h, int touchX, int touchY, int &distance) {
+    if (w < WIDGET_MIN_TOUCH_SIZE) {
+        x = x - (WIDGET_MIN_TOUCH_SIZE - w) / 2;
+        w = WIDGET_MIN_TOUCH_SIZE;
+    }
 
-    static const int MIN_SIZE = 50;
-        
-    int x = widgetCursor.x;
-    int w = overlay ? overlay->width : widget->w;
-    if (w < MIN_SIZE) {
-        x = x - (MIN_SIZE - w) / 2;
-        w = MIN_SIZE;
+    if (h < WIDGET_MIN_TOUCH_SIZE) {
+        y = y - (WIDGET_MIN_TOUCH_SIZE - h) / 2;
+        h = WIDGET_MIN_TOUCH_SIZE;
     }
 
-    int y = widgetCursor.y;
-    int h = overlay ? overlay->height : widget->h;
-    if (h < MIN_SIZE) {
-        y = y - (MIN_SIZE - h) / 2;
-        h = MIN_SIZE;
+    if (touchX >= x && touchX < x + w && touchY >= y && touchY < y + h) {
+        int dx = touchX - (x + w / 2);
+        int dy = touchY - (y + h / 2);
+        distance = dx * dx + dy * dy;
+        return true;
     }
 
-    bool inside = 
-        g_findWidgetAtX >= x && g_findWidgetAtX < x + w && 
-        g_findWidgetAtY >= y && g_findWidgetAtY < y + h;
+    return false;
+}
+
+void findWidgetStep(const WidgetCursor &widgetCursor) {
+    const Widget *widget = widgetCursor.widget;
 
-    if (inside && (widget->type == WIDGET_TYPE_APP_VIEW || getTouchFunction(widgetCursor))) {
-        int dx = g_findWidgetAtX - (x + w / 2);
-        int dy = g_findWidgetAtY - (y + h / 2);
-        int distance = dx * dx + dy * dy;
+    Overlay *overlay = getOverlay(widgetCursor);
+
+    int distance;
+    bool inside = isWidgetTouched(
+        widgetCursor.x, widgetCursor.y,
+        overlay ? overlay->width : widget->w, overlay ? overlay->height : widget->h,
+        g_findWidgetAtX, g_findWidgetAtY, distance
+    );
 
+    if (inside && (widget->type == WIDGET_TYPE_APP_VIEW || getTouchFunction(widgetCursor))) {
         if (widget->action == ACTION_ID_DRAG_OVERLAY) {
             if (overlay && !overlay->state) {
                 return;
@@ -287,6 +287,11 @@ struct WidgetCursor {
 void enumWidgets(AppContext* appContext, EnumWidgetsCallback callback);
 void enumWidgets(WidgetCursor &widgetCursor, EnumWidgetsCallback callback);
 
+// touch area of the widget is at least WIDGET_MIN_TOUCH_SIZE x WIDGET_MIN_TOUCH_SIZE
+#define WIDGET_MIN_TOUCH_SIZE 50
+
+bool isWidgetTouched(int x, int y, int w, int h, int touchX, int touchY, int &distance);
+
 void findWidgetStep(const WidgetCursor &widgetCursor);
 WidgetCursor findWidget(AppContext* appContext, int16_t x, int16_t y);
 
@@ -73,6 +73,16 @@ void ChannelInterface::readAllRegisters(int subchannelIndex, uint8_t ioexpRegist
 void ChannelInterface::onSpiIrq() {
 }
 
+void ChannelInterface::setAdcMuxSchedule(int subchannelIndex, AdcMuxSchedule muxSchedule) {
+}
+
+bool ChannelInterface::getAdcStats(int subchannelIndex, AdcStats &stats) {
+	return false;
+}
+
+void ChannelInterface::deferDacCurrentLoad(int subchannelIndex) {
+}
+
 #if defined(DEBUG) && defined(EEZ_PLATFORM_STM32)
 int ChannelInterface::getIoExpBitDirection(int subchannelIndex, int io_bit) {
 	return 0;
@@ -40,6 +40,23 @@ enum AdcDataType {
     ADC_DATA_TYPE_I_MON_DAC,
 };
 
+/// Order of the ADC conversions while output is enabled.
+enum AdcMuxSchedule {
+    ADC_MUX_SCHEDULE_U_I,    // U, I, U, I, ...
+    ADC_MUX_SCHEDULE_U_BURST // burst of U conversions followed by a single I conversion
+};
+
+struct AdcStats {
+    AdcMuxSchedule muxSchedule;
+    // conversions in the last second
+    uint32_t numConversions;
+    uint32_t numUMonConversions;
+    uint32_t numIMonConversions;
+    // since the power up
+    uint32_t numFifoOverflows;
+    uint32_t numMissedInterrupts;
+};
+
 enum DprogState {
     DPROG_STATE_OFF = 0,
     DPROG_STATE_ON = 1
@@ -165,6 +182,9 @@ struct ChannelInterface {
     virtual void setDacVoltageFloat(int subchannelIndex, float value) = 0;
     virtual void setDacCurrent(int subchannelIndex, uint16_t value) = 0;
     virtual void setDacCurrentFloat(int subchannelIndex, float value) = 0;
+    /// Next current value is loaded to the DAC output together with the next voltage value,
+    /// if the DAC has that option.
+    virtual void deferDacCurrentLoad(int subchannelIndex);
 
     virtual bool isDacTesting(int subchannelIndex) = 0;
 
@@ -182,6 +202,9 @@ struct ChannelInterface {
 
     virtual void onSpiIrq();
 
+    virtual void setAdcMuxSchedule(int subchannelIndex, AdcMuxSchedule muxSchedule);
+    virtual bool getAdcStats(int subchannelIndex, AdcStats &stats);
+
     virtual void getFirmwareVersion(uint8_t &majorVersion, uint8_t &minorVersion) = 0;
     virtual const char *getBrand() = 0;
     virtual void getSerial(char *text) = 0;
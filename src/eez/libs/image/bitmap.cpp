@@ -22,45 +22,45 @@
 #include <eez/libs/sd_fat/sd_fat.h>
 #include <eez/libs/image/bitmap.h>
 
-    // const uint8_t buffer[] = {
-    //     // BMP Header (14 bytes)
-
-    //     // ID field (42h, 4Dh): BM
-    //     0x42, 0x4D,
-    //     // size of BMP file
-    //     0x36, 0xFA, 0x05, 0x00, // 14 + 40 + (480 * 272 * 3) = 391734‬ = 0x5FA36
-    //     // unused
-    //     0x00, 0x00,
-    //     // unused
-    //     0x00, 0x00,
-    //     // Offset where the pixel array (bitmap data) can be found
-    //     0x36, 0x00, 0x00, 0x00, // 53 = 0x36
-
-    //     // DIB Header (40 bytes)
-
-    //     // Number of bytes in the DIB header (from this point)
-    //     0x28, 0x00, 0x00, 0x00, // 40 = 0x28
-    //     // Width of the bitmap in pixels
-    //     0xE0, 0x01, 0x00, 0x00, // 480 = 0x1E0
-    //     // Height of the bitmap in pixels. Positive for bottom to top pixel order.
-    //     0x10, 0x01, 0x00, 0x00, // 272 = 0x110
-    //     // Number of color planes being used
-    //     0x01, 0x00,
-    //     // Number of bits per pixel
-    //     0x18, 0x00, // 24 = 0x18
-    //     // BI_RGB, no pixel array compression used
-    //     0x00, 0x00, 0x00, 0x00,
-    //     // Size of the raw bitmap data (including padding)
-    //     0x00, 0xFA, 0x05, 0x00, // 480 * 272 * 3 = 0x5FA00
-    //     // Print resolution of the image,
-    //     // 72 DPI × 39.3701 inches per metre yields 2834.6472
-    //     0x13, 0x0B, 0x00, 0x00, // 2835 pixels/metre horizontal
-    //     0x13, 0x0B, 0x00, 0x00, // 2835 pixels/metre vertical
-    //     // Number of colors in the palette
-    //     0x00, 0x00, 0x00, 0x00,
-    //     // 0 means all colors are important
-    //     0x00, 0x00, 0x00, 0x00,
-    // };
+static const uint8_t g_screenshotBitmapHeader[] = {
+    // BMP Header (14 bytes)
+
+    // ID field (42h, 4Dh): BM
+    0x42, 0x4D,
+    // size of BMP file
+    0x36, 0xFA, 0x05, 0x00, // 14 + 40 + (480 * 272 * 3) = 391734‬ = 0x5FA36
+    // unused
+    0x00, 0x00,
+    // unused
+    0x00, 0x00,
+    // Offset where the pixel array (bitmap data) can be found
+    0x36, 0x00, 0x00, 0x00, // 54 = 0x36
+
+    // DIB Header (40 bytes)
+
+    // Number of bytes in the DIB header (from this point)
+    0x28, 0x00, 0x00, 0x00, // 40 = 0x28
+    // Width of the bitmap in pixels
+    0xE0, 0x01, 0x00, 0x00, // 480 = 0x1E0
+    // Height of the bitmap in pixels. Positive for bottom to top pixel order.
+    0x10, 0x01, 0x00, 0x00, // 272 = 0x110
+    // Number of color planes being used
+    0x01, 0x00,
+    // Number of bits per pixel
+    0x18, 0x00, // 24 = 0x18
+    // BI_RGB, no pixel array compression used
+    0x00, 0x00, 0x00, 0x00,
+    // Size of the raw bitmap data (including padding)
+    0x00, 0xFA, 0x05, 0x00, // 480 * 272 * 3 = 0x5FA00
+    // Print resolution of the image,
+    // 72 DPI × 39.3701 inches per metre yields 2834.6472
+    0x13, 0x0B, 0x00, 0x00, // 2835 pixels/metre horizontal
+    0x13, 0x0B, 0x00, 0x00, // 2835 pixels/metre vertical
+    // Number of colors in the palette
+    0x00, 0x00, 0x00, 0x00,
+    // 0 means all colors are important
+    0x00, 0x00, 0x00, 0x00,
+};
 
 uint32_t readUint32(const uint8_t *bytes) {
     return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (bytes[3] << 24);
@@ -158,3 +158,34 @@ bool bitmapDecode(const char *filePath, Image *image) {
 
     return true;
 }
+
+#define BITMAP_STREAM_CHUNK_LINES 8
+
+bool bitmapEncodeStream(const uint8_t *screenshotPixels, WriteImageDataFunction writeImageData) {
+    if (!writeImageData(g_screenshotBitmapHeader, sizeof(g_screenshotBitmapHeader))) {
+        return false;
+    }
+
+    static const uint32_t lineBytes = 480 * 3;
+
+    auto chunkBuffer = VRAM_SCREENSHOOT_JPEG_OUT_BUFFER;
+
+    // bottom to top pixel order, BGR
+    for (int line = 271; line >= 0; ) {
+        uint8_t *dst = chunkBuffer;
+        for (int i = 0; i < BITMAP_STREAM_CHUNK_LINES && line >= 0; i++, line--) {
+            const uint8_t *src = screenshotPixels + line * lineBytes;
+            for (uint32_t x = 0; x < lineBytes; x += 3) {
+                *dst++ = src[x + 2];
+                *dst++ = src[x + 1];
+                *dst++ = src[x];
+            }
+        }
+
+        if (!writeImageData(chunkBuffer, dst - chunkBuffer)) {
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -21,3 +21,9 @@
 #include <eez/libs/image/image.h>
 
 bool bitmapDecode(const char *filePath, Image *image);
+
+// 24-bit uncompressed BMP of the 480x272 screenshot, size is known in advance
+static const uint32_t BITMAP_SCREENSHOT_SIZE = 14 + 40 + 480 * 272 * 3;
+
+// No compression, so it is much faster then JPEG, rows are written as they are converted.
+bool bitmapEncodeStream(const uint8_t *screenshotPixels, WriteImageDataFunction writeImageData);
@@ -22,9 +22,12 @@
 #include <eez/libs/image/bitmap.h>
 #include <eez/libs/image/jpeg.h>
 
-bool imageDecode(const char *filePath, Image *image) {
+bool imageDecode(const char *filePath, Image *image, bool *fromPreviewCache) {
+    if (fromPreviewCache) {
+        *fromPreviewCache = false;
+    }
     if (eez::endsWithNoCase(filePath, ".bmp")) {
         return bitmapDecode(filePath, image);
     }
-    return jpegDecode(filePath, image);
+    return jpegDecode(filePath, image, fromPreviewCache);
 }
\ No newline at end of file
@@ -19,6 +19,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <stddef.h>
 
 struct Image {
     uint32_t width;
@@ -28,4 +29,12 @@ struct Image {
     uint8_t *pixels;
 };
 
-bool imageDecode(const char *filePath, Image *image);
\ No newline at end of file
+// Hidden directory where decoded images are cached as RGB565 previews (see jpegDecode).
+#define IMAGE_PREVIEW_CACHE_DIR "/.previews"
+
+// fromPreviewCache is set to true if the image was not decoded, but read from the preview cache
+bool imageDecode(const char *filePath, Image *image, bool *fromPreviewCache = nullptr);
+
+// Streaming encoders pass the encoded image data in chunks to this function as it is generated.
+// Returns false on write error.
+typedef bool (*WriteImageDataFunction)(const uint8_t *data, size_t size);
\ No newline at end of file
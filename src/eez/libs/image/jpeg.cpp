@@ -18,6 +18,7 @@
 
 #include <stdlib.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <memory.h>
 #include <assert.h>
 
@@ -39,6 +40,20 @@ extern "C" {
 #include <eez/util.h>
 #include <eez/libs/sd_fat/sd_fat.h>
 #include <eez/libs/image/jpeg.h>
+#include <eez/modules/psu/psu.h>
+#include <eez/modules/psu/sd_card.h>
+
+// Preview cache is used only in the simulator, where JPEG is decoded in software.
+// On STM32 hardware JPEG codec decodes the screenshot about as fast as the uncompressed
+// preview would be read back from the SD card, so there is no point in caching.
+#if defined(EEZ_PLATFORM_STM32)
+#define CONF_JPEG_PREVIEW_CACHE 0
+#else
+#define CONF_JPEG_PREVIEW_CACHE 1
+#endif
+
+#define PREVIEW_MAGIC 0x35363550 // "P565"
+#define PREVIEW_VERSION 2
 
 static size_t g_imageDataSize;
 
@@ -54,6 +69,37 @@ int jpegEncode(const uint8_t *screenshotPixels, unsigned char **imageData, size_
     return 0;
 }
 
+#define JPEG_STREAM_CHUNK_SIZE 4096
+
+static WriteImageDataFunction g_writeImageData;
+static bool g_writeImageDataFailed;
+
+static void flushImageData() {
+    // after write error encoder still runs till the end, but the rest of the output is dropped
+    if (g_imageDataSize > 0 && !g_writeImageDataFailed) {
+        if (!g_writeImageData(VRAM_SCREENSHOOT_JPEG_OUT_BUFFER, g_imageDataSize)) {
+            g_writeImageDataFailed = true;
+        }
+    }
+    g_imageDataSize = 0;
+}
+
+static void WRITE_ONE_BYTE_STREAM(unsigned char byte) {
+	VRAM_SCREENSHOOT_JPEG_OUT_BUFFER[g_imageDataSize++] = byte;
+    if (g_imageDataSize == JPEG_STREAM_CHUNK_SIZE) {
+        flushImageData();
+    }
+}
+
+bool jpegEncodeStream(const uint8_t *screenshotPixels, WriteImageDataFunction writeImageData) {
+    g_writeImageData = writeImageData;
+    g_writeImageDataFailed = false;
+	g_imageDataSize = 0;
+	TooJpeg::writeJpeg(WRITE_ONE_BYTE_STREAM, screenshotPixels, 480, 272);
+    flushImageData();
+    return !g_writeImageDataFailed;
+}
+
 uint8_t *g_fileData;
 
 #if defined(EEZ_PLATFORM_STM32)
@@ -100,7 +146,153 @@ extern "C" void njCopyMem(void* dest, const void* src, int size) {
 
 #endif
 
-bool jpegDecode(const char *filePath, Image *image) {
+#if CONF_JPEG_PREVIEW_CACHE
+
+// Source file is identified by its path (preview file name is the hash of the path),
+// size and modification time, so the cache hit doesn't read the source file at all.
+struct PreviewHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+    uint32_t fileSize;
+    uint32_t fileDateTime; // FAT format
+    uint16_t width;
+    uint16_t height;
+};
+
+static uint32_t getHash(const uint8_t *data, uint32_t size) {
+    uint32_t hash = 2166136261u;
+    for (uint32_t i = 0; i < size; i++) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static void getPreviewFilePath(const char *filePath, char *previewFilePath) {
+    uint32_t hash = getHash((const uint8_t *)filePath, strlen(filePath));
+    sprintf(previewFilePath, "%s/%08X.565", IMAGE_PREVIEW_CACHE_DIR, (unsigned)hash);
+}
+
+static bool getFileSizeAndDateTime(const char *filePath, uint32_t &fileSize, uint32_t &fileDateTime) {
+    eez::FileInfo fileInfo;
+    if (fileInfo.fstat(filePath) != eez::SD_FAT_RESULT_OK) {
+        return false;
+    }
+
+    fileSize = fileInfo.getSize();
+
+    fileDateTime =
+        ((fileInfo.getModifiedYear() - 1980) << 25) |
+        (fileInfo.getModifiedMonth() << 21) |
+        (fileInfo.getModifiedDay() << 16) |
+        (fileInfo.getModifiedHour() << 11) |
+        (fileInfo.getModifiedMinute() << 5) |
+        (fileInfo.getModifiedSecond() / 2);
+
+    return true;
+}
+
+// Preview is read to the start of FILE_VIEW_BUFFER.
+static bool loadPreview(const char *previewFilePath, uint32_t fileSize, uint32_t fileDateTime, Image *image) {
+    eez::File file;
+    if (!file.open(previewFilePath, FILE_OPEN_EXISTING | FILE_READ)) {
+        return false;
+    }
+
+    PreviewHeader header;
+    if (
+        file.read(&header, sizeof(header)) != sizeof(header) ||
+        header.magic != PREVIEW_MAGIC ||
+        header.version != PREVIEW_VERSION ||
+        header.fileSize != fileSize ||
+        header.fileDateTime != fileDateTime ||
+        header.width > 480 || header.height > 272
+    ) {
+        file.close();
+        return false;
+    }
+
+    uint32_t pixelsSize = header.width * header.height * 2;
+    if (file.read(FILE_VIEW_BUFFER, pixelsSize) != pixelsSize) {
+        file.close();
+        return false;
+    }
+
+    file.close();
+
+    image->width = header.width;
+    image->height = header.height;
+    image->bpp = 16;
+    image->lineOffset = 0;
+    image->pixels = FILE_VIEW_BUFFER;
+
+    return true;
+}
+
+static void savePreview(const char *previewFilePath, uint32_t fileSize, uint32_t fileDateTime, const Image *image) {
+    static uint16_t lineBuffer[480];
+
+    eez::File file;
+    if (!file.open(previewFilePath, FILE_CREATE_ALWAYS | FILE_WRITE)) {
+        // onSdCardFileChangeHook ignores the preview cache directory
+        if (!eez::psu::sd_card::makeParentDir(previewFilePath, nullptr) || !file.open(previewFilePath, FILE_CREATE_ALWAYS | FILE_WRITE)) {
+            return;
+        }
+    }
+
+    PreviewHeader header;
+    header.magic = PREVIEW_MAGIC;
+    header.version = PREVIEW_VERSION;
+    header.reserved = 0;
+    header.fileSize = fileSize;
+    header.fileDateTime = fileDateTime;
+    header.width = image->width;
+    header.height = image->height;
+
+    bool result = file.write(&header, sizeof(header)) == sizeof(header);
+
+    uint32_t lineBytes = image->width * 2;
+
+    for (uint32_t y = 0; result && y < image->height; y++) {
+        if (image->bpp == 24) {
+            const uint8_t *src = image->pixels + y * (image->width + image->lineOffset) * 3;
+            for (uint32_t x = 0; x < image->width; x++, src += 3) {
+                lineBuffer[x] = ((src[0] >> 3) << 11) | ((src[1] >> 2) << 5) | (src[2] >> 3);
+            }
+        } else {
+            memcpy(lineBuffer, image->pixels + y * (image->width + image->lineOffset) * 2, lineBytes);
+        }
+
+        result = file.write(lineBuffer, lineBytes) == lineBytes;
+    }
+
+    file.close();
+
+    if (!result) {
+        // better no preview than the truncated one
+        eez::psu::sd_card::deleteFile(previewFilePath, nullptr);
+    }
+}
+
+#endif
+
+bool jpegDecode(const char *filePath, Image *image, bool *fromPreviewCache) {
+#if CONF_JPEG_PREVIEW_CACHE
+    char previewFilePath[64];
+    getPreviewFilePath(filePath, previewFilePath);
+
+    uint32_t previewFileSize;
+    uint32_t previewFileDateTime;
+    bool isPreviewKeyValid = getFileSizeAndDateTime(filePath, previewFileSize, previewFileDateTime);
+
+    if (isPreviewKeyValid && loadPreview(previewFilePath, previewFileSize, previewFileDateTime, image)) {
+        if (fromPreviewCache) {
+            *fromPreviewCache = true;
+        }
+        return true;
+    }
+#endif
+
     eez::File file;
     if (!file.open(filePath, FILE_OPEN_EXISTING | FILE_READ)) {
         return false;
@@ -185,6 +377,12 @@ bool jpegDecode(const char *filePath, Image *image) {
     image->lineOffset = lineOffset;
     image->pixels = outputBuffer;
 
+#if CONF_JPEG_PREVIEW_CACHE
+    if (isPreviewKeyValid) {
+        savePreview(previewFilePath, previewFileSize, previewFileDateTime, image);
+    }
+#endif
+
     return true;
 
 #else
@@ -207,6 +405,12 @@ bool jpegDecode(const char *filePath, Image *image) {
     image->lineOffset = 0;
     image->pixels = njGetImage();
 
+#if CONF_JPEG_PREVIEW_CACHE
+    if (isPreviewKeyValid) {
+        savePreview(previewFilePath, previewFileSize, previewFileDateTime, image);
+    }
+#endif
+
     return true;
 
 #endif
@@ -22,4 +22,8 @@
 
 int jpegEncode(const uint8_t *screenshotPixels, unsigned char **imageData, size_t *imageDataSize);
 
-bool jpegDecode(const char *filePath, Image *image);
+// Encoded data is written in JPEG_STREAM_CHUNK_SIZE chunks while the image is encoded,
+// so whole JPEG output buffer is not needed.
+bool jpegEncodeStream(const uint8_t *screenshotPixels, WriteImageDataFunction writeImageData);
+
+bool jpegDecode(const char *filePath, Image *image, bool *fromPreviewCache = nullptr);
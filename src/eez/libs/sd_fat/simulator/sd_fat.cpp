@@ -40,6 +40,7 @@
 
 #endif
 
+#include <eez/trace.h>
 #include <eez/util.h>
 #include <scpi/scpi.h>
 
@@ -55,11 +56,6 @@ FileInfo::FileInfo() {
 #endif
 }
 
-SdFatResult FileInfo::fstat(const char *filePath) {
-    Directory dir;
-    return dir.findFirst(filePath, *this);
-}
-
 std::string getRealPath(const char *path) {
     std::string realPath;
 
@@ -81,6 +77,29 @@ std::string getRealPath(const char *path) {
     return getConfFilePath(realPath.c_str());
 }
 
+SdFatResult FileInfo::fstat(const char *filePath) {
+    // Directory::findFirst lists the directory, so the file is looked up directly
+    std::string realPath = getRealPath(filePath);
+#ifdef EEZ_PLATFORM_SIMULATOR_WIN32
+    HANDLE handle = FindFirstFileA(realPath.c_str(), &m_ffd);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return SD_FAT_RESULT_NO_FILE;
+    }
+    FindClose(handle);
+#else
+    struct stat stbuf;
+    if (stat(realPath.c_str(), &stbuf) != 0) {
+        return SD_FAT_RESULT_NO_FILE;
+    }
+    size_t i = realPath.rfind('/');
+    m_parentPath = i != std::string::npos ? realPath.substr(0, i) : ".";
+    memset(&m_fstatDirent, 0, sizeof(m_fstatDirent));
+    strncpy(m_fstatDirent.d_name, realPath.c_str() + (i != std::string::npos ? i + 1 : 0), sizeof(m_fstatDirent.d_name) - 1);
+    m_dirent = &m_fstatDirent;
+#endif
+    return SD_FAT_RESULT_OK;
+}
+
 bool pathExists(const char *path) {
     std::string realPath = getRealPath(path);
     struct stat path_stat;
@@ -278,6 +297,8 @@ File::File() : m_fp(NULL), m_isOpen(false) {
 }
 
 bool File::open(const char *path, uint8_t mode) {
+    TRACE_SCOPE("sd::open");
+
     const char *fmode;
 
     fmode = "";
@@ -367,14 +388,17 @@ int File::read() {
 }
 
 size_t File::read(void *buf, uint32_t nbyte) {
+    TRACE_SCOPE("sd::read");
     return fread(buf, 1, nbyte, m_fp);
 }
 
 size_t File::write(const void *buf, size_t size) {
+    TRACE_SCOPE("sd::write");
     return fwrite(buf, 1, size, m_fp);
 }
 
 bool File::sync() {
+    TRACE_SCOPE("sd::sync");
     return !fflush(m_fp);
 }
 
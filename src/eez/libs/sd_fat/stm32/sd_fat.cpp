@@ -22,6 +22,7 @@
 #include <scpi/scpi.h>
 
 #include <eez/debug.h>
+#include <eez/trace.h>
 #include <eez/util.h>
 #include <eez/libs/sd_fat/sd_fat.h>
 
@@ -138,6 +139,7 @@ File::File() : m_isOpen(false) {
 }
 
 bool File::open(const char *path, uint8_t mode) {
+    TRACE_SCOPE("sd::open");
 	auto result = f_open(&m_file, path, mode);
     CHECK_ERROR("File::open", result);
     m_isOpen = result == FR_OK;
@@ -203,6 +205,8 @@ int File::read() {
 }
 
 size_t File::read(void *buf, uint32_t size) {
+    TRACE_SCOPE("sd::read");
+
     static const uint32_t CHUNK_SIZE = 512;
 
     UINT brTotal = 0;
@@ -250,6 +254,8 @@ size_t File::read(void *buf, uint32_t size) {
 }
 
 size_t File::write(const void *buf, size_t size) {
+    TRACE_SCOPE("sd::write");
+
 	static const uint32_t CHUNK_SIZE = 512;
 
     UINT bwTotal = 0;
@@ -297,6 +303,7 @@ size_t File::write(const void *buf, size_t size) {
 }
 
 bool File::sync() {
+    TRACE_SCOPE("sd::sync");
     auto result = f_sync(&m_file);
     CHECK_ERROR("File::sync", result);
     return result == FR_OK;
@@ -18,6 +18,7 @@
 
 #include <assert.h>
 #include <stdio.h>
+#include <string.h>
 
 #if defined(EEZ_PLATFORM_STM32)
 #include <main.h>
@@ -43,6 +44,7 @@
 #endif
 
 #include <eez/firmware.h>
+#include <eez/trace.h>
 
 #include <eez/scpi/scpi.h>
 
@@ -135,6 +137,32 @@ int main(int argc, char **argv) {
     //SCB_EnableDCache();
 #endif
 
+#if defined(EEZ_PLATFORM_SIMULATOR) && OPTION_TRACE
+    // --trace <file path on the SD card> [--trace-format json|binary], written on shutdown
+    const char *traceFilePath = nullptr;
+    eez::trace::DumpFormat traceFormat = eez::trace::DUMP_FORMAT_JSON;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--trace") == 0) {
+            traceFilePath = argv[++i];
+        } else if (strcmp(argv[i], "--trace-format") == 0) {
+            traceFormat = strcmp(argv[++i], "binary") == 0 ? eez::trace::DUMP_FORMAT_BINARY : eez::trace::DUMP_FORMAT_JSON;
+        }
+    }
+    if (traceFilePath) {
+        eez::trace::setShutdownDump(traceFilePath, traceFormat);
+    }
+#endif
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+    // --virtual-time, see osKernelEnableVirtualTime
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--virtual-time") == 0) {
+            osKernelEnableVirtualTime();
+            break;
+        }
+    }
+#endif
+
     g_mainTaskHandle = osThreadCreate(osThread(g_mainTask), nullptr);
 
     osKernelStart();
@@ -168,7 +196,8 @@ void mainTask(const void *) {
     eez::boot();
 
 #if defined(EEZ_PLATFORM_SIMULATOR) && !defined(__EMSCRIPTEN__)
-    g_consoleInputTaskHandle = osThreadCreate(osThread(g_consoleInputTask), nullptr);
+    // blocks on stdin
+    g_consoleInputTaskHandle = osThreadCreateExternal(osThread(g_consoleInputTask), nullptr);
 #endif
 
     while (true) {
@@ -53,13 +53,14 @@ static const uint32_t FILE_VIEW_BUFFER_SIZE = 3 * 512 * 1024;
 static uint8_t * const MP_BUFFER = FILE_VIEW_BUFFER + FILE_VIEW_BUFFER_SIZE;
 static const uint32_t MP_BUFFER_SIZE = 512 * 1024;
 
-static uint8_t * const SOUND_TUNES_MEMORY = MP_BUFFER + MP_BUFFER_SIZE;
-static const uint32_t SOUND_TUNES_MEMORY_SIZE = 32 * 1024;
-
-static uint8_t * const FILE_MANAGER_MEMORY = SOUND_TUNES_MEMORY + SOUND_TUNES_MEMORY_SIZE;
+static uint8_t * const FILE_MANAGER_MEMORY = MP_BUFFER + MP_BUFFER_SIZE;
 static const uint32_t FILE_MANAGER_MEMORY_SIZE = 512 * 1024;
 
-static uint8_t * const VRAM_SCREENSHOOT_JPEG_OUT_BUFFER = FILE_MANAGER_MEMORY + FILE_MANAGER_MEMORY_SIZE;
+// two buffers for the double buffered MMEM upload and download
+static uint8_t * const SD_TRANSFER_BUFFER = FILE_MANAGER_MEMORY + FILE_MANAGER_MEMORY_SIZE;
+static const uint32_t SD_TRANSFER_BUFFER_SIZE = 2 * 64 * 1024;
+
+static uint8_t * const VRAM_SCREENSHOOT_JPEG_OUT_BUFFER = SD_TRANSFER_BUFFER + SD_TRANSFER_BUFFER_SIZE;
 static const uint32_t VRAM_SCREENSHOOT_JPEG_OUT_BUFFER_SIZE = 256 * 1024;
 
 static uint8_t * const SCREENSHOOT_BUFFER_START_ADDRESS = VRAM_SCREENSHOOT_JPEG_OUT_BUFFER + VRAM_SCREENSHOOT_JPEG_OUT_BUFFER_SIZE;
@@ -93,4 +94,13 @@ static uint8_t * const VRAM_AUX_BUFFER6_START_ADDRESS = VRAM_AUX_BUFFER5_START_A
 static uint8_t * const VRAM_AUX_BUFFER7_START_ADDRESS = VRAM_AUX_BUFFER6_START_ADDRESS + VRAM_BUFFER_SIZE;
 static uint8_t * const VRAM_AUX_BUFFER8_START_ADDRESS = VRAM_AUX_BUFFER7_START_ADDRESS + VRAM_BUFFER_SIZE;
 
-static uint8_t * const MEMORY_END = VRAM_AUX_BUFFER8_START_ADDRESS + VRAM_BUFFER_SIZE;
+// per thread ring buffers of the trace events
+static uint8_t * const TRACE_BUFFER = VRAM_AUX_BUFFER8_START_ADDRESS + VRAM_BUFFER_SIZE;
+#if defined(EEZ_PLATFORM_STM32)
+static const uint32_t TRACE_BUFFER_SIZE = 64 * 1024;
+#endif
+#if defined(EEZ_PLATFORM_SIMULATOR)
+static const uint32_t TRACE_BUFFER_SIZE = 2 * 1024 * 1024;
+#endif
+
+static uint8_t * const MEMORY_END = TRACE_BUFFER + TRACE_BUFFER_SIZE;
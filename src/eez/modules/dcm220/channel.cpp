@@ -32,6 +32,7 @@
 #include <eez/modules/psu/psu.h>
 #include <eez/modules/psu/channel_dispatcher.h>
 #include <eez/modules/psu/event_queue.h>
+#include <eez/modules/psu/simulator_load.h>
 #include <eez/scpi/regs.h>
 #include <eez/system.h>
 
@@ -371,38 +372,14 @@ struct Channel : ChannelInterface {
         }
 
 #if defined(EEZ_PLATFORM_SIMULATOR)
-        if (channel.isOutputEnabled()) {
-            if (channel.simulator.getLoadEnabled()) {
-                float u_set_v = uSet[channel.subchannelIndex];
-                float i_set_a = iSet[channel.subchannelIndex];
-
-                float u_mon_v = i_set_a * channel.simulator.load;
-                float i_mon_a = i_set_a;
-                if (u_mon_v > u_set_v) {
-                    u_mon_v = u_set_v;
-                    i_mon_a = u_set_v / channel.simulator.load;
-
-                    simulator::setCC(channel.channelIndex, false);
-                } else {
-                    simulator::setCC(channel.channelIndex, true);
-                }
-
-                uMon[channel.subchannelIndex] = u_mon_v;
-                iMon[channel.subchannelIndex] = i_mon_a;
-            } else {
-                uMon[channel.subchannelIndex] = uSet[channel.subchannelIndex];
-                iMon[channel.subchannelIndex] = 0;
-                if (uSet[channel.subchannelIndex] > 0 && iSet[channel.subchannelIndex] > 0) {
-                    simulator::setCC(channel.channelIndex, false);
-                } else {
-                    simulator::setCC(channel.channelIndex, true);
-                }
-            }
-        } else {
-            uMon[channel.subchannelIndex] = 0;
-            iMon[channel.subchannelIndex] = 0;
-            simulator::setCC(channel.channelIndex, false);
-        }
+        float u_mon_v;
+        float i_mon_a;
+        bool cc;
+        simulator::updateLoad(channel, channel.isOutputEnabled(), uSet[channel.subchannelIndex], iSet[channel.subchannelIndex], u_mon_v, i_mon_a, cc);
+        simulator::setCC(channel.channelIndex, cc);
+
+        uMon[channel.subchannelIndex] = simulator::adcConversion(u_mon_v, channel.params.U_MAX);
+        iMon[channel.subchannelIndex] = simulator::adcConversion(i_mon_a, channel.params.I_MAX);
 #endif
 
         //
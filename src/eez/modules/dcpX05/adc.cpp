@@ -18,12 +18,14 @@
 
 #include <eez/modules/psu/psu.h>
 
+#include <eez/system.h>
+
 #include <eez/modules/psu/channel_dispatcher.h>
+#include <eez/modules/psu/simulator_load.h>
 #include <eez/modules/dcpX05/adc.h>
 
 #if defined(EEZ_PLATFORM_STM32)
 #include <eez/platform/stm32/spi.h>
-#include <eez/system.h>
 #include <eez/index.h>
 #include <scpi/scpi.h>
 #endif
@@ -40,6 +42,17 @@
 namespace eez {
 namespace psu {
 
+/// Conversion time in microseconds for each CONF_ADC_SPS in normal mode.
+static const uint32_t ADC_NORMAL_MODE_CONVERSION_TIME[] = { 50000, 22222, 11111, 5714, 3030, 1667, 1000 };
+
+#if CONF_ADC_MODE == 1
+#define ADC_CONVERSION_TIME (4 * ADC_NORMAL_MODE_CONVERSION_TIME[CONF_ADC_SPS])
+#elif CONF_ADC_MODE == 2
+#define ADC_CONVERSION_TIME (ADC_NORMAL_MODE_CONVERSION_TIME[CONF_ADC_SPS] / 2)
+#else
+#define ADC_CONVERSION_TIME ADC_NORMAL_MODE_CONVERSION_TIME[CONF_ADC_SPS]
+#endif
+
 #if defined(EEZ_PLATFORM_STM32)
 
 float remapAdcDataToVoltage(Channel& channel, AdcDataType adcDataType, int16_t adcData) {
@@ -123,88 +136,52 @@ void updateValues(Channel &channel) {
         }
     }
 
-    if (channel.simulator.getLoadEnabled()) {
-        float u_set_v;
-        if (series) {
-            u_set_v = channel.isRemoteProgrammingEnabled()
-                ? remap(channel0.simulator.voltProgExt + channel1.simulator.voltProgExt, 0, 0, 2.5, channel.u.max)
-                : g_uSet[0] + g_uSet[1];
-        } else {
-            u_set_v = channel.isRemoteProgrammingEnabled()
-                ? remap(channel.simulator.voltProgExt, 0, 0, 2.5, channel.u.max)
-                : g_uSet[channelIndex];
-        }
-
-        float i_set_a;
-        if (parallel) {
-            i_set_a = g_iSet[0] + g_iSet[1];
-        } else {
-            i_set_a = g_iSet[channelIndex];
-        }
+    float u_set_v;
+    if (series) {
+        u_set_v = channel.isRemoteProgrammingEnabled()
+            ? remap(channel0.simulator.voltProgExt + channel1.simulator.voltProgExt, 0, 0, 2.5, channel.u.max)
+            : g_uSet[0] + g_uSet[1];
+    } else {
+        u_set_v = channel.isRemoteProgrammingEnabled()
+            ? remap(channel.simulator.voltProgExt, 0, 0, 2.5, channel.u.max)
+            : g_uSet[channelIndex];
+    }
 
-        float u_mon_v = i_set_a * channel.simulator.load;
-        float i_mon_a = i_set_a;
-        if (u_mon_v > u_set_v) {
-            u_mon_v = u_set_v;
-            i_mon_a = u_set_v / channel.simulator.load;
-
-            simulator::setCV(channel.channelIndex, true);
-            simulator::setCC(channel.channelIndex, false);
-        } else {
-            simulator::setCV(channel.channelIndex, false);
-            simulator::setCC(channel.channelIndex, true);
-        }
+    float i_set_a;
+    if (parallel) {
+        i_set_a = g_iSet[0] + g_iSet[1];
+    } else {
+        i_set_a = g_iSet[channelIndex];
+    }
 
-        if (series) {
-            g_uMon[0] = u_mon_v / 2;
-            g_uMon[1] = u_mon_v / 2;
-        } else {
-            g_uMon[channelIndex] = u_mon_v;
-        }
+    float u_mon_v;
+    float i_mon_a;
+    bool cc;
+    simulator::updateLoad(channel, channel.isOutputEnabled(), u_set_v, i_set_a, u_mon_v, i_mon_a, cc);
 
-        if (parallel) {
-            g_iMon[0] = i_mon_a / 2;
-            g_iMon[1] = i_mon_a / 2;
-        } else {
-            g_iMon[channelIndex] = i_mon_a;
-        }
+    simulator::setCV(channel.channelIndex, !cc);
+    simulator::setCC(channel.channelIndex, cc);
 
-        return;
+    if (series) {
+        g_uMon[0] = u_mon_v / 2;
+        g_uMon[1] = u_mon_v / 2;
     } else {
-        if (channel.isOutputEnabled()) {
-            if (series) {
-                g_uMon[0] = g_uSet[0];
-                g_uMon[1] = g_uSet[1];
-            } else {
-                g_uMon[channelIndex] = g_uSet[channelIndex];
-            }
-
-            if (series) {
-                g_iMon[0] = 0;
-                g_iMon[1] = 0;
-            } else {
-                g_iMon[channelIndex] = 0;
-            }
-
-            if (g_uSet[channelIndex] > 0 && g_iSet[channelIndex] > 0) {
-                simulator::setCV(channel.channelIndex, true);
-                simulator::setCC(channel.channelIndex, false);
-            } else {
-                simulator::setCV(channel.channelIndex, false);
-                simulator::setCC(channel.channelIndex, true);
-            }
-            return;
-        }
+        g_uMon[channelIndex] = u_mon_v;
     }
 
-    g_uMon[channelIndex] = 0;
-    g_iMon[channelIndex] = 0;
-    simulator::setCV(channel.channelIndex, true);
-    simulator::setCC(channel.channelIndex, false);
+    if (parallel) {
+        g_iMon[0] = i_mon_a / 2;
+        g_iMon[1] = i_mon_a / 2;
+    } else {
+        g_iMon[channelIndex] = i_mon_a;
+    }
 }
 #endif
 
 void AnalogDigitalConverter::init() {
+    fifoHead = 0;
+    fifoTail = 0;
+
 #if defined(EEZ_PLATFORM_STM32)
     uint8_t data[4];
     uint8_t result[4];
@@ -278,6 +255,7 @@ bool AnalogDigitalConverter::test() {
 
 void AnalogDigitalConverter::start(AdcDataType adcDataType_) {
     adcDataType = adcDataType_;
+    start_time = microsPrecise();
 
 #if defined(EEZ_PLATFORM_STM32)
 	uint8_t data[3];
@@ -354,19 +332,108 @@ float AnalogDigitalConverter::read(Channel& channel) {
     updateValues(channel);
 
     if (adcDataType == ADC_DATA_TYPE_U_MON) {
-        return g_uMon[channel.channelIndex];
+        return simulator::adcConversion(g_uMon[channel.channelIndex], channel.params.U_MAX);
     }
 
     if (adcDataType == ADC_DATA_TYPE_I_MON) {
-        return g_iMon[channel.channelIndex];
+        return simulator::adcConversion(g_iMon[channel.channelIndex], channel.getDualRangeMax());
     }
 
     if (adcDataType == ADC_DATA_TYPE_U_MON_DAC) {
-        return g_uSet[channel.channelIndex];
+        return simulator::adcConversion(g_uSet[channel.channelIndex], channel.params.U_MAX);
+    }
+
+    return simulator::adcConversion(g_iSet[channel.channelIndex], channel.getDualRangeMax());
+#endif
+}
+
+uint64_t AnalogDigitalConverter::getStartTime() {
+    return start_time;
+}
+
+bool AnalogDigitalConverter::isConversionTimeElapsed() {
+#if defined(EEZ_PLATFORM_STM32)
+    // ADC internal oscillator is within 10%
+    return microsPrecise() - start_time >= ADC_CONVERSION_TIME * 9 / 10;
+#else
+    return microsPrecise() - start_time >= ADC_CONVERSION_TIME;
+#endif
+}
+
+AdcDataType AnalogDigitalConverter::getNextAdcDataType(Channel &channel) {
+    if (adcDataType == ADC_DATA_TYPE_U_MON) {
+        if (muxSchedule == ADC_MUX_SCHEDULE_U_BURST && ++uBurstCounter < ADC_U_BURST_LENGTH) {
+            return ADC_DATA_TYPE_U_MON;
+        }
+        uBurstCounter = 0;
+        return ADC_DATA_TYPE_I_MON;
+    }
+
+    if (adcDataType == ADC_DATA_TYPE_I_MON && channel.isRemoteProgrammingEnabled()) {
+        return ADC_DATA_TYPE_U_MON_DAC;
     }
 
-    return g_iSet[channel.channelIndex];
+    return ADC_DATA_TYPE_U_MON;
+}
+
+void AnalogDigitalConverter::acquire(Channel &channel) {
+    AdcSample sample;
+    sample.adcDataType = adcDataType;
+    sample.value = read(channel);
+    sample.time = microsPrecise();
+
+    start(getNextAdcDataType(channel));
+
+    numConversions++;
+    if (sample.adcDataType == ADC_DATA_TYPE_U_MON) {
+        numUMonConversions++;
+    } else if (sample.adcDataType == ADC_DATA_TYPE_I_MON) {
+        numIMonConversions++;
+    }
+
+#ifdef DEBUG
+    debug::g_adcCounter.inc();
 #endif
+
+    uint8_t nextFifoHead = (fifoHead + 1) % ADC_FIFO_SIZE;
+    if (nextFifoHead == fifoTail) {
+        stats.numFifoOverflows++;
+        return;
+    }
+
+    fifo[fifoHead] = sample;
+    fifoHead = nextFifoHead;
+}
+
+bool AnalogDigitalConverter::popSample(AdcSample &sample) {
+    if (fifoTail == fifoHead) {
+        return false;
+    }
+
+    sample = fifo[fifoTail];
+    fifoTail = (fifoTail + 1) % ADC_FIFO_SIZE;
+
+    return true;
+}
+
+void AnalogDigitalConverter::setMuxSchedule(AdcMuxSchedule muxSchedule_) {
+    muxSchedule = muxSchedule_;
+    uBurstCounter = 0;
+}
+
+void AnalogDigitalConverter::tickStats(uint32_t tickCount) {
+    if (tickCount - statsTime >= 1000000) {
+        stats.muxSchedule = muxSchedule;
+        stats.numConversions = numConversions;
+        stats.numUMonConversions = numUMonConversions;
+        stats.numIMonConversions = numIMonConversions;
+
+        numConversions = 0;
+        numUMonConversions = 0;
+        numIMonConversions = 0;
+
+        statsTime = tickCount;
+    }
 }
 
 void AnalogDigitalConverter::readAllRegisters(uint8_t registers[]) {
@@ -25,6 +25,17 @@ namespace psu {
 
 class Channel;
 
+/// Number of U conversions in the ADC_MUX_SCHEDULE_U_BURST before the I conversion.
+#define ADC_U_BURST_LENGTH 7
+
+#define ADC_FIFO_SIZE 8
+
+struct AdcSample {
+    AdcDataType adcDataType;
+    float value;
+    uint64_t time; // microsPrecise() when the conversion is read
+};
+
 /// Analog to digital converter HW used by the channel.
 class AnalogDigitalConverter {
   public:
@@ -35,17 +46,47 @@ class AnalogDigitalConverter {
     TestResult g_testResult;
     
     AdcDataType adcDataType;
+    AdcMuxSchedule muxSchedule;
 
     void init();
     bool test();
 
     void start(AdcDataType adcDataType);
+    uint64_t getStartTime();
     float read(Channel& channel);
 
     void readAllRegisters(uint8_t registers[]);
 
+    /// Conversion can't be finished before this, DRDY seen earlier belongs to some previous conversion.
+    /// On the simulator this is used as emulated DRDY.
+    bool isConversionTimeElapsed();
+
+    /// Reads finished conversion into the FIFO and starts the next one from the mux schedule.
+    void acquire(Channel &channel);
+    bool popSample(AdcSample &sample);
+
+    void setMuxSchedule(AdcMuxSchedule muxSchedule);
+    void tickStats(uint32_t tickCount);
+
+    AdcStats stats;
+
   private:
-    uint32_t start_time;
+    // microsPrecise, micros has 200 us granularity on STM32 which is comparable to the conversion time
+    uint64_t start_time;
+
+    uint8_t uBurstCounter;
+
+    AdcSample fifo[ADC_FIFO_SIZE];
+    // written only by acquire and popSample
+    volatile uint8_t fifoHead;
+    volatile uint8_t fifoTail;
+
+    uint32_t statsTime;
+    uint32_t numConversions;
+    uint32_t numUMonConversions;
+    uint32_t numIMonConversions;
+
+    AdcDataType getNextAdcDataType(Channel &channel);
 
 #if defined(EEZ_PLATFORM_STM32)
     uint8_t getReg1Val();
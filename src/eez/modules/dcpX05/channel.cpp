@@ -210,17 +210,11 @@ struct Channel : ChannelInterface {
 		return TEST_FAILED;
 	}
 
-	AdcDataType getNextAdcDataType(AdcDataType adcDataType) {
-		if (adcDataType == ADC_DATA_TYPE_U_MON) {
-			return ADC_DATA_TYPE_I_MON;
+	void drainAdcFifo(psu::Channel &channel) {
+		AdcSample sample;
+		while (adc.popSample(sample)) {
+			channel.onAdcData(sample.adcDataType, sample.value, sample.time);
 		}
-
-		psu::Channel &channel = psu::Channel::getBySlotIndex(slotIndex);
-		if (adcDataType == ADC_DATA_TYPE_I_MON && channel.isRemoteProgrammingEnabled()) {
-			return ADC_DATA_TYPE_U_MON_DAC;
-		}
-
-		return ADC_DATA_TYPE_U_MON;
 	}
 
 	void tick(int subchannelIndex, uint32_t tickCount) {
@@ -242,16 +236,26 @@ struct Channel : ChannelInterface {
 		}
 #endif
 
-		if (channel.isOutputEnabled() && ioexp.isAdcReady()) {
-			auto adcDataType = adc.adcDataType;
-			float value = adc.read(channel);
-			adc.start(getNextAdcDataType(adcDataType));
-			channel.onAdcData(adcDataType, value);
-#ifdef DEBUG
-			psu::debug::g_adcCounter.inc();
+		if (channel.isOutputEnabled()) {
+#if defined(EEZ_PLATFORM_STM32)
+			// DCP405 conversions are acquired from onSpiIrq, this only catches a lost DRDY interrupt
+			if (ioexp.isAdcReady() && (!ioexp.isAdcReadyInterruptEnabled() || microsPrecise() - adc.getStartTime() > CONF_ADC_CONVERSION_MAX_TIME_MS * 1000)) {
+				if (ioexp.isAdcReadyInterruptEnabled()) {
+					adc.stats.numMissedInterrupts++;
+				}
+				adc.acquire(channel);
+			}
+#else
+			// emulated DRDY
+			if (adc.isConversionTimeElapsed()) {
+				adc.acquire(channel);
+			}
 #endif
+			drainAdcFifo(channel);
 		}
 
+		adc.tickStats(tickCount);
+
 		if (channel.params.features & CH_FEATURE_DPROG) {
 			if (channel.flags.dprogState == DPROG_STATE_ON) {
 				// turn off DP after delay
@@ -627,6 +631,10 @@ struct Channel : ChannelInterface {
 		restoreVoltageToValueBeforeBalancing(psu::Channel::getBySlotIndex(slotIndex));
 	}
 
+	void deferDacCurrentLoad(int subchannelIndex) {
+		dac.deferCurrentLoad();
+	}
+
 	bool isDacTesting(int subchannelIndex) {
 		return dac.isTesting();
 	}
@@ -692,6 +700,15 @@ struct Channel : ChannelInterface {
 		adc.readAllRegisters(adcRegisters);
 	}
 
+	void setAdcMuxSchedule(int subchannelIndex, AdcMuxSchedule muxSchedule) {
+		adc.setMuxSchedule(muxSchedule);
+	}
+
+	bool getAdcStats(int subchannelIndex, AdcStats &stats) {
+		stats = adc.stats;
+		return true;
+	}
+
 	#if defined(DEBUG) && defined(EEZ_PLATFORM_STM32)
 	int getIoExpBitDirection(int subchannelIndex, int io_bit) {
 		return ioexp.getBitDirection(io_bit);
@@ -745,13 +762,28 @@ struct Channel : ChannelInterface {
 		uint8_t intcap = ioexp.readIntcapRegister();
 		// DebugTrace("CH%d INTCAP 0x%02X\n", (int)(channel.channelIndex + 1), (int)intcap);
 		psu::Channel &channel = psu::Channel::getBySlotIndex(slotIndex);
-		if (channel.params.features & CH_FEATURE_HW_OVP) {
+		if ((channel.params.features & CH_FEATURE_HW_OVP) && g_slots[slotIndex].moduleRevision >= MODULE_REVISION_DCP405_R2B5) {
 			if (!(intcap & (1 << IOExpander::DCP405_R2B5_IO_BIT_IN_OVP_FAULT))) {
 				if (channel.isOutputEnabled()) {
 					channel.enterOvpProtection();
 				}
 			}
 		}
+
+		if (ioexp.isAdcReadyInterruptEnabled() && !(intcap & (1 << IOExpander::DCP405_IO_BIT_IN_ADC_DRDY))) {
+			if (isDacTesting(0) || !adc.isConversionTimeElapsed()) {
+				// already read by adcMeasure functions or by the tick
+				return;
+			}
+
+			if (channel.isOutputEnabled()) {
+				adc.acquire(channel);
+				drainAdcFifo(channel);
+			} else {
+				// DRDY is cleared by reading the data, otherwise interrupt stays active
+				adc.read(channel);
+			}
+		}
 	}
 #endif
 
@@ -40,6 +40,7 @@ namespace psu {
 #if defined(EEZ_PLATFORM_STM32)
 static const uint8_t DATA_BUFFER_A = 0B00010000;
 static const uint8_t DATA_BUFFER_B = 0B00100100;
+static const uint8_t LOAD_A = 0B00010000; // LDA bit of the control byte
 #endif
 
 static const uint16_t DAC_MIN = 0;
@@ -119,6 +120,12 @@ bool DigitalAnalogConverter::test(IOExpander &ioexp, AnalogDigitalConverter &adc
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void DigitalAnalogConverter::deferCurrentLoad() {
+#if defined(EEZ_PLATFORM_STM32)
+    m_currentLoadDeferred = true;
+#endif
+}
+
 void DigitalAnalogConverter::setVoltage(float value) {
     Channel &channel = Channel::getBySlotIndex(slotIndex);
 
@@ -184,6 +191,15 @@ void DigitalAnalogConverter::set(uint8_t buffer, uint16_t value) {
     uint8_t result[3];
 
     data[0] = buffer;
+    if (m_currentLoadDeferred) {
+        if (buffer == DATA_BUFFER_A) {
+            data[0] &= ~LOAD_A;
+        } else {
+            // both outputs are loaded at the same time
+            data[0] |= LOAD_A;
+            m_currentLoadDeferred = false;
+        }
+    }
     data[1] = value >> 8;
     data[2] = value & 0xFF;
 
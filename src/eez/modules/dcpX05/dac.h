@@ -38,12 +38,17 @@ class DigitalAnalogConverter {
     void setCurrent(float voltage);
     void setDacCurrent(uint16_t current);
 
+    /// Next current value is only written to the DAC buffer A and loaded
+    /// to the output together with the next voltage value.
+    void deferCurrentLoad();
+
     bool isTesting() {
         return m_testing;
     }
 
   private:
     bool m_testing;
+    bool m_currentLoadDeferred;
 
 #if defined(EEZ_PLATFORM_STM32)
     void set(uint8_t buffer, uint16_t value);
@@ -70,15 +70,18 @@ static const uint8_t REG_VALUE_IPOLA    = 0B00000000; // no pin is inverted
 static const uint8_t REG_VALUE_IPOLB    = 0B00000000; // no pin is inverted
 
 static const uint8_t REG_VALUE_GPINTENA = 0B00000000; // no interrupts
-static const uint8_t DCP405_REG_VALUE_GPINTENA = 0B00100000; // enable interrupt for HW OVP Fault
+static const uint8_t DCP405_REG_VALUE_GPINTENA = 0B00110000; // enable interrupt for HW OVP Fault and ADC DRDY
+static const uint8_t DCP405B_REG_VALUE_GPINTENA = 0B00010000; // enable interrupt for ADC DRDY
 static const uint8_t REG_VALUE_GPINTENB = 0B00000000; // no interrupts
 
 static const uint8_t REG_VALUE_DEFVALA  = 0B00000000; //
-static const uint8_t DCP405_REG_VALUE_DEFVALA  = 0B00100000; // default value for HW OVP Fault is 1
+static const uint8_t DCP405_REG_VALUE_DEFVALA  = 0B00110000; // default value for HW OVP Fault and ADC DRDY is 1
+static const uint8_t DCP405B_REG_VALUE_DEFVALA  = 0B00010000; // default value for ADC DRDY is 1
 static const uint8_t REG_VALUE_DEFVALB  = 0B00000000; //
 
 static const uint8_t REG_VALUE_INTCONA  = 0B00000000;
-static const uint8_t DCP405_REG_VALUE_INTCONA  = 0B00100000; // compare HW OVP Fault value with default value
+static const uint8_t DCP405_REG_VALUE_INTCONA  = 0B00110000; // compare HW OVP Fault and ADC DRDY value with default value
+static const uint8_t DCP405B_REG_VALUE_INTCONA  = 0B00010000; // compare ADC DRDY value with default value
 static const uint8_t REG_VALUE_INTCONB  = 0B00000000; //
 
 static const uint8_t REG_VALUE_IOCON    = 0B00100000; // sequential operation disabled, hw addressing disabled
@@ -154,6 +157,12 @@ uint8_t IOExpander::getRegValue(int i) {
             value = DCP405B_REG_VALUE_GPIOA;
         } else if (reg == REG_GPIOB) {
             value = DCP405B_REG_VALUE_GPIOB;
+        } else if (reg == REG_GPINTENA) {
+            value = DCP405B_REG_VALUE_GPINTENA;
+        } else if (reg == REG_DEFVALA) {
+            value = DCP405B_REG_VALUE_DEFVALA;
+        } else if (reg == REG_INTCONA) {
+            value = DCP405B_REG_VALUE_INTCONA;
         }
     }
 
@@ -367,6 +376,16 @@ bool IOExpander::isAdcReady() {
 #endif
 }
 
+bool IOExpander::isAdcReadyInterruptEnabled() {
+#if defined(EEZ_PLATFORM_STM32)
+    // DCP505 DRDY is on the port B and only INTA is connected
+	auto &slot = g_slots[slotIndex];
+    return slot.moduleInfo->moduleType == MODULE_TYPE_DCP405 || slot.moduleInfo->moduleType == MODULE_TYPE_DCP405B;
+#else
+    return false;
+#endif
+}
+
 void IOExpander::changeBit(int io_bit, bool set) {
 #if defined(EEZ_PLATFORM_STM32)
     if (io_bit < 8) {
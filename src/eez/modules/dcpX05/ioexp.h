@@ -79,6 +79,7 @@ public:
 #endif
 
     bool isAdcReady();
+    bool isAdcReadyInterruptEnabled();
 
     void readAllRegisters(uint8_t registers[]);
 
@@ -114,10 +114,12 @@ const int MAX_WRITE_CHUNK_SIZE = 16;
 bool write(const uint8_t *buffer, uint16_t bufferSize, uint16_t address) {
 
 #if defined(EEZ_PLATFORM_STM32)
-    for (uint16_t i = 0; i < bufferSize; i += MAX_WRITE_CHUNK_SIZE) {
+    // chunks are aligned, so chunk never crosses the page boundary
+    uint16_t chunkSize;
+    for (uint16_t i = 0; i < bufferSize; i += chunkSize) {
         uint16_t chunkAddress = address + i;
 
-        uint16_t chunkSize = MIN(MAX_WRITE_CHUNK_SIZE, bufferSize - i);
+        chunkSize = MIN(MAX_WRITE_CHUNK_SIZE - chunkAddress % MAX_WRITE_CHUNK_SIZE, bufferSize - i);
 
         HAL_StatusTypeDef returnValue;
 
@@ -28,6 +28,7 @@
 |64     |  24|[Total ON-time counter](#ontime-counter)  |
 |1024   |  64|[Device configuration](#device)           |
 |1536   | 128|[Device configuration 2](#device2)        |
+|4096   |4096|[Device configuration journal](#journal)  |
 
 ## <a name="ontime-counter">ON-time counter</a>
 
@@ -64,6 +65,12 @@
 |58    |2   |int                      |Touch screen cal. TRX        |
 |60    |2   |int                      |Touch screen cal. TRY        |
 
+## <a name="journal">Device configuration journal</a>
+
+Ring of 64 pages, 64 bytes each. Page starts with the header (checksum, sequence,
+sequence of the first page of the generation) followed by the records
+(checksum, offset in device configuration, size, data). Page index is sequence % 64.
+
 ## <a name="device">Device configuration 2</a>
 
 |Offset|Size|Type                     |Description                  |
@@ -114,6 +121,9 @@ static const uint16_t EEPROM_ONTIME_START_ADDRESS = 64;
 
 static const uint16_t EEPROM_SIZE = 32768;
 
+// write to the EEPROM can't cross the page boundary
+static const uint16_t EEPROM_PAGE_SIZE = 64;
+
 void init();
 bool test();
 
@@ -61,6 +61,7 @@ extern ip4_addr_t gw;
 
 #include <eez/firmware.h>
 #include <eez/system.h>
+#include <eez/trace.h>
 #include <eez/scpi/scpi.h>
 #include <eez/modules/mcu/ethernet.h>
 #include <eez/modules/psu/psu.h>
@@ -552,6 +553,9 @@ int write(const char *buffer, int buffer_size) {
 #else
     if (client_socket != -1) {
         int n = ::write(client_socket, buffer, buffer_size);
+        if (n < 0 && errno == EWOULDBLOCK) {
+            return 0;
+        }
         if (n < 0) {
             close(client_socket);
             client_socket = -1;
@@ -631,9 +635,12 @@ void onIdle() {
 #endif
 
 void mainLoop(const void *) {
+    TRACE_REGISTER_THREAD("Ethernet");
+
     while (1) {
         osEvent event = osMessageGet(g_ethernetMessageQueueId, 10);
         if (event.status == osEventMessage) {
+            TRACE_SCOPE("ethernet::event");
             uint8_t eventType = event.value.v & 0xFF;
             if (eventType == QUEUE_MESSAGE_PUSH_EVENT) {
                 mqtt::pushEvent((int16_t)(event.value.v >> 8));
@@ -771,12 +778,31 @@ void releaseInputBuffer() {
 
 int writeBuffer(const char *buffer, uint32_t length) {
 #if defined(EEZ_PLATFORM_STM32)
-	netconn_write(g_tcpClientConnection, (void *)buffer, (uint16_t)length, NETCONN_COPY);
+    // netconn_write length is 16-bit
+    for (uint32_t i = 0; i < length; i += 32768) {
+        netconn_write(g_tcpClientConnection, (void *)(buffer + i), (uint16_t)MIN(length - i, 32768), NETCONN_COPY);
+    }
     return length;
 #endif
 
 #if defined(EEZ_PLATFORM_SIMULATOR)
-    int numWritten = write(buffer, length);
+    // socket is non-blocking, so wait until whole buffer is sent
+    uint32_t numWritten = 0;
+    while (numWritten < length) {
+        int n = write(buffer + numWritten, length - numWritten);
+        if (n <= 0) {
+#ifdef EEZ_PLATFORM_SIMULATOR_WIN32
+            if (client_socket == INVALID_SOCKET) {
+#else
+            if (client_socket == -1) {
+#endif
+                break;
+            }
+            osDelay(1);
+            continue;
+        }
+        numWritten += n;
+    }
     osDelay(1);
     return numWritten;
 #endif
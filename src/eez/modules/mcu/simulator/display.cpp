@@ -25,8 +25,10 @@
 #include <utility>
 #include <string>
 
+#if !defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
 #include <SDL.h>
 #include <SDL_image.h>
+#endif
 
 #include <cmsis_os.h>
 
@@ -54,8 +56,13 @@ static const char *ICON = "eez.png";
 
 static bool g_isOn;
 
+#if !defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
 static SDL_Window *g_mainWindow;
 static SDL_Renderer *g_renderer;
+#else
+// frames are rendered into the VRAM buffers, but nothing is presented
+static void *g_mainWindow;
+#endif
 
 static uint32_t *g_buffer;
 static uint32_t *g_lastBuffer;
@@ -116,6 +123,7 @@ std::string getFullPath(std::string category, std::string path) {
 }
 
 int getDesktopResolution(int *w, int *h) {
+#if !defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
     SDL_Init(SDL_INIT_VIDEO);
 
     SDL_DisplayMode dm;
@@ -125,6 +133,7 @@ int getDesktopResolution(int *w, int *h) {
 
         return 1;
     }
+#endif
 
     *w = -1;
     *h = -1;
@@ -133,6 +142,10 @@ int getDesktopResolution(int *w, int *h) {
 }
 
 bool init() {
+#if defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
+    g_mainWindow = &g_isOn;
+    return true;
+#else
     // Set texture filtering to linear
     if (!SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "1")) {
         printf("Warning: Linear texture filtering not enabled!");
@@ -176,6 +189,7 @@ bool init() {
     SDL_ShowWindow(g_mainWindow);
 
     return true;
+#endif
 }
 
 void *getBufferPointer() {
@@ -236,6 +250,7 @@ void updateScreen(uint32_t *buffer) {
         return;
     }
 
+#if !defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
     SDL_Surface *rgbSurface = SDL_CreateRGBSurfaceFrom(
         buffer, DISPLAY_WIDTH, DISPLAY_HEIGHT, 32, 4 * DISPLAY_WIDTH, 0, 0, 0, 0);
     if (rgbSurface != NULL) {
@@ -255,6 +270,7 @@ void updateScreen(uint32_t *buffer) {
         printf("Unable to render text surface! SDL Error: %s\n", SDL_GetError());
     }
     SDL_RenderPresent(g_renderer);
+#endif
 }
 
 void animate() {
@@ -308,7 +324,8 @@ void sync() {
     int32_t diff = 1000 / 60 - (tickCount - g_lastTickCount);
     g_lastTickCount = tickCount;
     if (diff > 0 && diff < 1000 / 60) {
-        SDL_Delay(diff);
+        // not SDL_Delay, so the frame rate follows the virtual time
+        osDelay(diff);
     }
 
     if (!isOn()) {
@@ -33,6 +33,8 @@
 #include <eez/modules/psu/persist_conf.h>
 #include <eez/modules/psu/profile.h>
 #include <eez/modules/psu/ramp.h>
+#include <eez/modules/psu/simulator_load.h>
+#include <eez/modules/psu/sweep.h>
 #include <eez/modules/psu/trigger.h>
 #include <eez/scpi/regs.h>
 #include <eez/sound.h>
@@ -68,53 +70,48 @@ void Channel::Value::resetMonValues() {
     mon_adc = 0;
     mon = 0;
     mon_last = 0;
+    mon_dlog = 0;
     mon_dac = 0;
 
-    mon_index = -1;
+    for (int i = 0; i < NUM_MON_TAPS; i++) {
+        mon_filters[i].reset();
+    }
     mon_dac_index = -1;
 
     mon_measured = false;
 }
 
-void Channel::Value::addMonValue(float value, float prec) {
+void Channel::Value::addMonValue(float value, float prec, const MonFilterConf *monFilterConf) {
     if (io_pins::isInhibited()) {
         value = 0;
     }
     
-    mon_last = roundPrec(value, prec);
+    for (int i = 0; i < NUM_MON_TAPS; i++) {
+        mon_filters[i].addSample(monFilterConf[i], value);
+    }
 
-    if (mon_index == -1) {
-        mon_index = 0;
-        for (int i = 0; i < NUM_ADC_AVERAGING_VALUES; ++i) {
-            mon_arr[i] = value;
-        }
-        mon_total = NUM_ADC_AVERAGING_VALUES * value;
-        mon = mon_last;
-        mon_prev = mon_last;
+    mon_last = roundPrec(mon_filters[MON_TAP_FAST].value, prec);
+    mon_dlog = roundPrec(mon_filters[MON_TAP_DLOG].value, prec);
+
+    float mon_next = mon_filters[MON_TAP_DISPLAY].value;
+    if (io_pins::isInhibited()) {
+        mon = 0;
+        mon_prev = 0;
+    } else if (!mon_measured) {
+        mon = roundPrec(mon_next, prec);
+        mon_prev = mon_next;
     } else {
-        mon_total -= mon_arr[mon_index];
-        mon_total += value;
-        mon_arr[mon_index] = value;
-        mon_index = (mon_index + 1) % NUM_ADC_AVERAGING_VALUES;
-
-        if (io_pins::isInhibited()) {
-            mon = 0;
-            mon_prev = 0;
-        } else {
 #if defined(EEZ_PLATFORM_STM32)
-            float mon_next = mon_total / NUM_ADC_AVERAGING_VALUES;
-            if (fabs(mon_prev - mon_next) >= prec) {
-                mon = roundPrec(mon_next, prec);
-                mon_prev = mon_next;
-            }
+        if (fabs(mon_prev - mon_next) >= prec) {
+            mon = roundPrec(mon_next, prec);
+            mon_prev = mon_next;
+        }
 #endif
-            
+
 #if defined(EEZ_PLATFORM_SIMULATOR)
-            float mon_next = roundPrec(mon_total / NUM_ADC_AVERAGING_VALUES, prec);
-            mon = mon_next;
-            mon_prev = mon_next;
+        mon = roundPrec(mon_next, prec);
+        mon_prev = mon_next;
 #endif
-        }
     }
 
     mon_measured = true;
@@ -146,9 +143,9 @@ void Channel::Value::addMonDacValue(float value, float prec) {
 #endif
         
 #if defined(EEZ_PLATFORM_SIMULATOR)
-        float mon_next = roundPrec(mon_total / NUM_ADC_AVERAGING_VALUES, prec);
-        mon = mon_next;
-        mon_prev = mon_next;
+        float mon_dac_next = roundPrec(mon_dac_total / NUM_ADC_AVERAGING_VALUES, prec);
+        mon_dac = mon_dac_next;
+        mon_dac_prev = mon_dac_next;
 #endif
     }
 }
@@ -420,6 +417,8 @@ void Channel::set(uint8_t slotIndex_, uint8_t subchannelIndex_) {
     flags.displayValue2 = DISPLAY_VALUE_CURRENT;
     ytViewRate = GUI_YT_VIEW_RATE_DEFAULT;
 
+    memcpy(monFilterConf, g_defaultMonFilterConf, sizeof(monFilterConf));
+
     autoRangeCheckLastTickCount = 0;
 
     flags.cvMode = 0;
@@ -438,6 +437,26 @@ int Channel::reg_get_ques_isum_bit_mask_for_channel_protection_value(ProtectionV
     return QUES_ISUM_OPP;
 }
 
+static void addProtectionLatency(ProtectionLatency &latency, uint32_t value) {
+    latency.last = value;
+
+    if (latency.numTrips == 0 || value < latency.min) {
+        latency.min = value;
+    }
+
+    if (value > latency.max) {
+        latency.max = value;
+    }
+
+    latency.numTrips++;
+
+    int binIndex = 0;
+    while (binIndex < PROTECTION_LATENCY_NUM_BINS - 1 && value >= PROTECTION_LATENCY_BIN_LIMITS[binIndex]) {
+        binIndex++;
+    }
+    latency.bins[binIndex]++;
+}
+
 void Channel::protectionEnter(ProtectionValue &cpv) {
     if (getVoltageTriggerMode() != TRIGGER_MODE_FIXED) {
         trigger::abort();
@@ -445,6 +464,16 @@ void Channel::protectionEnter(ProtectionValue &cpv) {
 
     channel_dispatcher::outputEnable(*this, false);
 
+    // HW OVP enters here without the alarm
+    if (cpv.flags.alarmed) {
+        cpv.flags.alarmed = 0;
+
+        // microsPrecise, because micros has 200 us granularity on STM32 and the first bins are smaller than that
+        uint64_t latency = microsPrecise() - cpv.alarm_started;
+        uint64_t delay = (uint64_t)(getProtectionDelay(cpv) * 1000000UL);
+        addProtectionLatency(cpv.latency, latency > delay ? (uint32_t)MIN(latency - delay, 0xFFFFFFFF) : 0);
+    }
+
     cpv.flags.tripped = 1;
 
     int bit_mask = reg_get_ques_isum_bit_mask_for_channel_protection_value(cpv);
@@ -478,60 +507,48 @@ bool Channel::checkSwOvpCondition(float uProtectionLevel) {
     return channel_dispatcher::getUMonLast(*this) >= uProtectionLevel || (flags.rprogEnabled && channel_dispatcher::getUMonDacLast(*this) >= uProtectionLevel);
 }
 
-void Channel::protectionCheck(ProtectionValue &cpv) {
-    bool state;
-    bool condition;
+bool Channel::isProtectionEnabled(ProtectionValue &cpv) {
+    if (IS_OVP_VALUE(this, cpv)) {
+        return (flags.rprogEnabled || prot_conf.flags.u_state) && !((params.features & CH_FEATURE_HW_OVP) && prot_conf.flags.u_type);
+    } else if (IS_OCP_VALUE(this, cpv)) {
+        return prot_conf.flags.i_state;
+    } else {
+        return prot_conf.flags.p_state;
+    }
+}
+
+float Channel::getProtectionDelay(ProtectionValue &cpv) {
     float delay;
+    if (IS_OVP_VALUE(this, cpv)) {
+        delay = prot_conf.u_delay - PROT_DELAY_CORRECTION;
+    } else if (IS_OCP_VALUE(this, cpv)) {
+        delay = prot_conf.i_delay - PROT_DELAY_CORRECTION;
+    } else {
+        delay = prot_conf.p_delay;
+    }
+    return delay > 0 ? delay : 0;
+}
+
+// Every ADC sample is checked as soon as it arrives (mon_last, not the averaged mon value)
+// and the alarm starts at the time of the sample, not when it is processed.
+void Channel::protectionCheck(ProtectionValue &cpv, uint64_t sampleTime) {
+    bool condition;
 
     if (IS_OVP_VALUE(this, cpv)) {
-        state = (flags.rprogEnabled || prot_conf.flags.u_state) && !((params.features & CH_FEATURE_HW_OVP) && prot_conf.flags.u_type);
         condition = checkSwOvpCondition(channel_dispatcher::getUProtectionLevel(*this));
-        delay = prot_conf.u_delay;
-        delay -= PROT_DELAY_CORRECTION;
     } else if (IS_OCP_VALUE(this, cpv)) {
-        state = prot_conf.flags.i_state;
         condition = channel_dispatcher::getIMonLast(*this) >= channel_dispatcher::getISet(*this);
-        delay = prot_conf.i_delay;
-        delay -= PROT_DELAY_CORRECTION;
     } else {
-        state = prot_conf.flags.p_state;
         condition = channel_dispatcher::getUMonLast(*this) * channel_dispatcher::getIMonLast(*this) > channel_dispatcher::getPowerProtectionLevel(*this);
-        delay = prot_conf.p_delay;
     }
 
-    if (state && isOutputEnabled() && condition) {
-        if (delay > 0) {
-            if (cpv.flags.alarmed) {
-                if (micros() - cpv.alarm_started >= delay * 1000000UL) {
-                    cpv.flags.alarmed = 0;
-
-                    // if (IS_OVP_VALUE(this, cpv)) {
-                    //    DebugTrace("OVP condition: CV_MODE=%d, CC_MODE=%d, I DIFF=%d mA, I MON=%d
-                    //    mA", (int)flags.cvMode, (int)flags.ccMode, (int)(fabs(i.mon_last - i.set)
-                    //    * 1000), (int)(i.mon_last * 1000));
-                    //}
-                    // else if (IS_OCP_VALUE(this, cpv)) {
-                    //    DebugTrace("OCP condition: CC_MODE=%d, CV_MODE=%d, U DIFF=%d mV",
-                    //    (int)flags.ccMode, (int)flags.cvMode, (int)(fabs(u.mon_last - u.set) *
-                    //    1000));
-                    //}
-
-                    protectionEnter(cpv);
-                }
-            } else {
-                cpv.flags.alarmed = 1;
-                cpv.alarm_started = micros();
-            }
-        } else {
-            // if (IS_OVP_VALUE(this, cpv)) {
-            //    DebugTrace("OVP condition: CV_MODE=%d, CC_MODE=%d, I DIFF=%d mA",
-            //    (int)flags.cvMode, (int)flags.ccMode, (int)(fabs(i.mon_last - i.set) * 1000));
-            //}
-            // else if (IS_OCP_VALUE(this, cpv)) {
-            //    DebugTrace("OCP condition: CC_MODE=%d, CV_MODE=%d, U DIFF=%d mV",
-            //    (int)flags.ccMode, (int)flags.cvMode, (int)(fabs(u.mon_last - u.set) * 1000));
-            //}
+    if (isProtectionEnabled(cpv) && isOutputEnabled() && condition) {
+        if (!cpv.flags.alarmed) {
+            cpv.flags.alarmed = 1;
+            cpv.alarm_started = sampleTime;
+        }
 
+        if (microsPrecise() - cpv.alarm_started >= getProtectionDelay(cpv) * 1000000UL) {
             protectionEnter(cpv);
         }
     } else {
@@ -539,6 +556,16 @@ void Channel::protectionCheck(ProtectionValue &cpv) {
     }
 }
 
+// Called from tick, so the protection with the delay is tripped when the delay
+// expires and not at the first ADC sample after that.
+void Channel::protectionCheckDelay(ProtectionValue &cpv) {
+    if (cpv.flags.alarmed && isProtectionEnabled(cpv) && isOutputEnabled()) {
+        if (microsPrecise() - cpv.alarm_started >= getProtectionDelay(cpv) * 1000000UL) {
+            protectionEnter(cpv);
+        }
+    }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 void Channel::init() {
@@ -639,9 +666,13 @@ void Channel::reset() {
 
     outputDelayDuration = 0;
 
+    // SENS:MON:FILT
+    memcpy(monFilterConf, g_defaultMonFilterConf, sizeof(monFilterConf));
+
 #ifdef EEZ_PLATFORM_SIMULATOR
     simulator.setLoadEnabled(false);
     simulator.load = 10;
+    simulator::resetLoad(channelIndex);
 #endif
 
     channelInterface->reset(subchannelIndex);
@@ -763,6 +794,10 @@ void Channel::tick(uint32_t tick_usec) {
 
     channelInterface->tick(subchannelIndex, tick_usec);
 
+    protectionCheckDelay(ovp);
+    protectionCheckDelay(ocp);
+    protectionCheckDelay(opp);
+
     if (params.features & CH_FEATURE_RPOL) {
         unsigned rpol = 0;
             
@@ -866,7 +901,7 @@ void Channel::addUMonAdcValue(float value) {
         value = remap(value, cal_conf.u.min.adc, cal_conf.u.min.val, cal_conf.u.max.adc, cal_conf.u.max.val);
     }
 
-    u.addMonValue(value, getVoltageResolution());
+    u.addMonValue(value, getVoltageResolution(), monFilterConf);
 }
 
 void Channel::addIMonAdcValue(float value) {
@@ -876,7 +911,7 @@ void Channel::addIMonAdcValue(float value) {
             cal_conf.i[flags.currentCurrentRange].max.adc, cal_conf.i[flags.currentCurrentRange].max.val);
     }
 
-    i.addMonValue(value, getCurrentResolution());
+    i.addMonValue(value, getCurrentResolution(), monFilterConf);
 }
 
 void Channel::addUMonDacAdcValue(float value) {
@@ -888,6 +923,10 @@ void Channel::addIMonDacAdcValue(float value) {
 }
 
 void Channel::onAdcData(AdcDataType adcDataType, float value) {
+    onAdcData(adcDataType, value, microsPrecise());
+}
+
+void Channel::onAdcData(AdcDataType adcDataType, float value, uint64_t sampleTime) {
     switch (adcDataType) {
     case ADC_DATA_TYPE_U_MON:
         addUMonAdcValue(value);
@@ -906,7 +945,9 @@ void Channel::onAdcData(AdcDataType adcDataType, float value) {
         break;
     }
 
-    protectionCheck();
+    protectionCheck(sampleTime);
+
+    sweep::onAdcData(*this, adcDataType);
 }
 
 void Channel::setCcMode(bool cc_mode) {
@@ -927,10 +968,10 @@ void Channel::setCvMode(bool cv_mode) {
     }
 }
 
-void Channel::protectionCheck() {
-    protectionCheck(ovp);
-    protectionCheck(ocp);
-    protectionCheck(opp);
+void Channel::protectionCheck(uint64_t sampleTime) {
+    protectionCheck(ovp, sampleTime);
+    protectionCheck(ocp, sampleTime);
+    protectionCheck(opp, sampleTime);
 }
 
 void Channel::adcMeasureMonDac() {
@@ -1581,6 +1622,23 @@ void Channel::setCurrentRangeSelectionMode(CurrentRangeSelectionMode mode) {
     setCurrent(i.set);
 }
 
+static MonFilterConf g_setMonFilterConfValues[CH_MAX][NUM_MON_TAPS];
+
+void Channel::setMonFilterConf(MonTap tap, const MonFilterConf &conf) {
+    if (osThreadGetId() != g_psuTaskHandle) {
+        g_setMonFilterConfValues[channelIndex][tap] = conf;
+        osMessagePut(g_psuMessageQueueId, PSU_QUEUE_MESSAGE(PSU_QUEUE_SET_MON_FILTER_CONF, (channelIndex << 8) | tap), osWaitForever);
+        return;
+    }
+
+    // filters are restarted by MonFilter::addSample if the length is changed
+    monFilterConf[tap] = conf;
+}
+
+void Channel::setMonFilterConfInPsuThread(MonTap tap) {
+    setMonFilterConf(tap, g_setMonFilterConfValues[channelIndex][tap]);
+}
+
 void Channel::enableAutoSelectCurrentRange(bool enable) {
     flags.autoSelectCurrentRange = enable;
 
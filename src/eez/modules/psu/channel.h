@@ -20,6 +20,7 @@
 
 #include <math.h>
 
+#include <eez/modules/psu/mon_filter.h>
 #include <eez/modules/psu/persist_conf.h>
 #include <eez/modules/psu/temp_sensor.h>
 
@@ -72,10 +73,28 @@ struct ProtectionFlags {
     unsigned tripped : 1;
 };
 
+#define PROTECTION_LATENCY_NUM_BINS 8
+
+/// Upper limits of the latency histogram bins in microseconds, the last bin has no limit.
+static const uint32_t PROTECTION_LATENCY_BIN_LIMITS[PROTECTION_LATENCY_NUM_BINS - 1] = {
+    100, 250, 500, 1000, 2500, 5000, 10000
+};
+
+/// Trip latency statistics. Latency is the time from the first ADC sample
+/// over the protection level until the output is disabled, without the programmed delay.
+struct ProtectionLatency {
+    uint32_t numTrips;
+    uint32_t last; // us
+    uint32_t min; // us
+    uint32_t max; // us
+    uint32_t bins[PROTECTION_LATENCY_NUM_BINS];
+};
+
 /// Runtime protection values
 struct ProtectionValue {
     ProtectionFlags flags;
-    uint32_t alarm_started;
+    uint64_t alarm_started; // microsPrecise() of the first ADC sample over the protection level
+    ProtectionLatency latency;
 };
 
 enum ChannelMode {
@@ -227,15 +246,14 @@ class Channel {
 
         float mon_adc; // uncalibrated
 
-        float mon_last; // calibrated, latest measurement
+        float mon_last; // calibrated, latest measurement (MON_TAP_FAST)
+
+        float mon; // calibrated, average value (MON_TAP_DISPLAY)
 
-        float mon; // calibrated, average value
+        float mon_dlog; // calibrated, MON_TAP_DLOG
 
-        // used for calculating average value
         float mon_prev;
-        int8_t mon_index;
-        float mon_arr[NUM_ADC_AVERAGING_VALUES];
-        float mon_total;
+        MonFilter mon_filters[NUM_MON_TAPS];
 
         float mon_dac;
         float mon_dac_prev;
@@ -257,7 +275,7 @@ class Channel {
         void init(float set_, float step_, float limit_);
         void resetMonValues();
         void addMonDacValue(float value, float precision);
-        void addMonValue(float value, float precision);
+        void addMonValue(float value, float precision, const MonFilterConf *monFilterConf);
     };
 
 #ifdef EEZ_PLATFORM_SIMULATOR
@@ -338,6 +356,9 @@ class Channel {
 
     float outputDelayDuration;
 
+    /// SENS:MON:FILT, the filters read it on every ADC sample, so it is changed only in the PSU thread.
+    MonFilterConf monFilterConf[NUM_MON_TAPS];
+
 #ifdef EEZ_PLATFORM_SIMULATOR
     Simulator simulator;
 #endif // EEZ_PLATFORM_SIMULATOR
@@ -381,6 +402,8 @@ class Channel {
 
     /// Called from channel driver when ADC data is ready.
     void onAdcData(AdcDataType adcDataType, float value);
+    /// Same as above, sampleTime is microsPrecise() at the end of the conversion.
+    void onAdcData(AdcDataType adcDataType, float value, uint64_t sampleTime);
 
     /// Called when device power is turned off, so channel
     /// can do its own housekeeping.
@@ -530,6 +553,10 @@ class Channel {
 
     bool hasSupportForCurrentDualRange() const;
     void setCurrentRangeSelectionMode(CurrentRangeSelectionMode mode);
+
+    /// Can be called from any thread, conf is applied in the PSU thread.
+    void setMonFilterConf(MonTap tap, const MonFilterConf &conf);
+    void setMonFilterConfInPsuThread(MonTap tap);
     CurrentRangeSelectionMode getCurrentRangeSelectionMode() {
         return (CurrentRangeSelectionMode)flags.currentRangeSelectionMode;
     }
@@ -590,8 +617,11 @@ private:
 
     void clearProtectionConf();
     void protectionEnter(ProtectionValue &cpv);
-    void protectionCheck(ProtectionValue &cpv);
-    void protectionCheck();
+    bool isProtectionEnabled(ProtectionValue &cpv);
+    float getProtectionDelay(ProtectionValue &cpv);
+    void protectionCheck(ProtectionValue &cpv, uint64_t sampleTime);
+    void protectionCheck(uint64_t sampleTime);
+    void protectionCheckDelay(ProtectionValue &cpv);
 
     void doCalibrationEnable(bool enable);
     bool isVoltageCalibrationEnabled();
@@ -19,6 +19,8 @@
 #include <float.h>
 #include <assert.h>
 
+#include <eez/debug.h>
+
 #include <eez/modules/psu/psu.h>
 #include <eez/modules/psu/calibration.h>
 #include <eez/modules/psu/channel_dispatcher.h>
@@ -131,6 +133,8 @@ bool setCouplingType(CouplingType couplingType, int *err) {
 void setCouplingTypeInPsuThread(CouplingType couplingType) {
     trigger::abort();
 
+    clearStaged();
+
     g_couplingType = couplingType;
 
     disableOutputForAllChannels();
@@ -224,6 +228,8 @@ void setTrackingChannels(uint16_t trackingEnabled) {
     if (osThreadGetId() != g_psuTaskHandle) {
         osMessagePut(g_psuMessageQueueId, PSU_QUEUE_MESSAGE(PSU_QUEUE_SET_TRACKING_CHANNELS, trackingEnabled), osWaitForever);
     } else {
+        clearStaged();
+
         bool resetTrackingChannels = false;
         for (int i = 0; i < CH_NUM; i++) {
             Channel &trackingChannel = Channel::get(i);
@@ -417,6 +423,13 @@ float getUMonLast(const Channel &channel) {
     return channel.u.mon_last;
 }
 
+float getUMonDlog(const Channel &channel) {
+    if (channel.channelIndex < 2 && g_couplingType == COUPLING_TYPE_SERIES) {
+        return Channel::get(0).u.mon_dlog + Channel::get(1).u.mon_dlog;
+    }
+    return channel.u.mon_dlog;
+}
+
 float getUMonDac(const Channel &channel) {
     if (channel.channelIndex < 2 && g_couplingType == COUPLING_TYPE_SERIES) {
         return Channel::get(0).u.mon_dac + Channel::get(1).u.mon_dac;
@@ -743,6 +756,13 @@ float getIMonLast(const Channel &channel) {
     return channel.i.mon_last;
 }
 
+float getIMonDlog(const Channel &channel) {
+    if (channel.channelIndex < 2 && g_couplingType == COUPLING_TYPE_PARALLEL) {
+        return Channel::get(0).i.mon_dlog + Channel::get(1).i.mon_dlog;
+    }
+    return channel.i.mon_dlog;
+}
+
 float getIMonDac(const Channel &channel) {
     if (channel.channelIndex < 2 && g_couplingType == COUPLING_TYPE_PARALLEL) {
         return Channel::get(0).i.mon_dac + Channel::get(1).i.mon_dac;
@@ -1286,6 +1306,181 @@ void disableOutputForAllTrackingChannels() {
     syncOutputEnable();
 }
 
+static uint32_t g_stagedVoltageMask;
+static uint32_t g_stagedCurrentMask;
+static uint32_t g_stagedOutputMask;
+static uint32_t g_stagedOutputEnableMask;
+static float g_stagedVoltageValues[CH_MAX];
+static float g_stagedCurrentValues[CH_MAX];
+static volatile bool g_commitPending;
+static int g_commitErr;
+static uint32_t g_lastCommitSkew;
+
+void stageVoltage(Channel &channel, float voltage) {
+    g_stagedVoltageValues[channel.channelIndex] = voltage;
+    g_stagedVoltageMask |= 1 << channel.channelIndex;
+}
+
+void stageCurrent(Channel &channel, float current) {
+    g_stagedCurrentValues[channel.channelIndex] = current;
+    g_stagedCurrentMask |= 1 << channel.channelIndex;
+}
+
+void stageOutputEnable(Channel &channel, bool enable) {
+    g_stagedOutputMask |= 1 << channel.channelIndex;
+    if (enable) {
+        g_stagedOutputEnableMask |= 1 << channel.channelIndex;
+    } else {
+        g_stagedOutputEnableMask &= ~(1 << channel.channelIndex);
+    }
+}
+
+void clearStaged() {
+    g_stagedVoltageMask = 0;
+    g_stagedCurrentMask = 0;
+    g_stagedOutputMask = 0;
+    g_stagedOutputEnableMask = 0;
+}
+
+// channels whose DACs are written when the value is set for the channels in the mask
+static uint32_t getCoupledChannelsMask(uint32_t mask) {
+    uint32_t coupledMask = 0;
+
+    for (int i = 0; i < CH_NUM; i++) {
+        if (mask & (1 << i)) {
+            Channel &channel = Channel::get(i);
+            if (i < 2 && (g_couplingType == COUPLING_TYPE_SERIES || g_couplingType == COUPLING_TYPE_PARALLEL)) {
+                coupledMask |= 0x03;
+            } else if (channel.flags.trackingEnabled) {
+                for (int j = 0; j < CH_NUM; j++) {
+                    if (Channel::get(j).flags.trackingEnabled) {
+                        coupledMask |= 1 << j;
+                    }
+                }
+            } else {
+                coupledMask |= 1 << i;
+            }
+        }
+    }
+
+    return coupledMask;
+}
+
+bool commitStaged(int *err) {
+    if (osThreadGetId() != g_psuTaskHandle) {
+        g_commitPending = true;
+        osMessagePut(g_psuMessageQueueId, PSU_QUEUE_MESSAGE(PSU_QUEUE_COMMIT_STAGED, 0), osWaitForever);
+        while (g_commitPending) {
+            osDelay(1);
+        }
+    } else {
+        commitStagedInPsuThread();
+    }
+
+    if (g_commitErr) {
+        if (err) {
+            *err = g_commitErr;
+        }
+        return false;
+    }
+
+    return true;
+}
+
+// Limits and output state could be changed since the values were staged.
+static bool testStaged(uint32_t voltageMask, uint32_t currentMask, uint32_t outputMask, uint32_t outputEnableMask, int *err) {
+    for (int i = 0; i < CH_NUM; i++) {
+        Channel &channel = Channel::get(i);
+
+        float voltage = voltageMask & (1 << i) ? g_stagedVoltageValues[i] : getUSet(channel);
+        float current = currentMask & (1 << i) ? g_stagedCurrentValues[i] : getISet(channel);
+
+        if ((voltageMask & (1 << i)) && voltage > getULimit(channel)) {
+            *err = SCPI_ERROR_VOLTAGE_LIMIT_EXCEEDED;
+            return false;
+        }
+
+        if ((currentMask & (1 << i)) && current > getILimit(channel)) {
+            *err = SCPI_ERROR_CURRENT_LIMIT_EXCEEDED;
+            return false;
+        }
+
+        if (((voltageMask | currentMask) & (1 << i)) && voltage * current > getPowerLimit(channel)) {
+            *err = SCPI_ERROR_POWER_LIMIT_EXCEEDED;
+            return false;
+        }
+
+        if (outputMask & (1 << i)) {
+            bool callTriggerAbort = false;
+            if (!testOutputEnable(channel, outputEnableMask & (1 << i) ? true : false, callTriggerAbort, err)) {
+                return false;
+            }
+            if (callTriggerAbort) {
+                *err = SCPI_ERROR_CANNOT_CHANGE_TRANSIENT_TRIGGER;
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+void commitStagedInPsuThread() {
+    uint32_t voltageMask = g_stagedVoltageMask;
+    uint32_t currentMask = g_stagedCurrentMask;
+    uint32_t outputMask = g_stagedOutputMask;
+    uint32_t outputEnableMask = g_stagedOutputEnableMask;
+    clearStaged();
+
+    // nothing is applied if any of the staged values is not valid anymore
+    g_commitErr = 0;
+    if (!testStaged(voltageMask, currentMask, outputMask, outputEnableMask, &g_commitErr)) {
+        g_commitPending = false;
+        return;
+    }
+
+    // Current DAC output is loaded with the voltage DAC output on the channels where
+    // both are written. Currents are written first for that reason.
+    uint32_t latchMask = getCoupledChannelsMask(voltageMask) & getCoupledChannelsMask(currentMask);
+    for (int i = 0; i < CH_NUM; i++) {
+        if (latchMask & (1 << i)) {
+            Channel &channel = Channel::get(i);
+            channel.channelInterface->deferDacCurrentLoad(channel.subchannelIndex);
+        }
+    }
+
+    uint64_t startTime = microsPrecise();
+
+    for (int i = 0; i < CH_NUM; i++) {
+        if (currentMask & (1 << i)) {
+            setCurrent(Channel::get(i), g_stagedCurrentValues[i]);
+        }
+    }
+
+    for (int i = 0; i < CH_NUM; i++) {
+        if (voltageMask & (1 << i)) {
+            setVoltage(Channel::get(i), g_stagedVoltageValues[i]);
+        }
+    }
+
+    g_lastCommitSkew = (uint32_t)(microsPrecise() - startTime);
+
+    if (outputMask) {
+        for (int i = 0; i < CH_NUM; i++) {
+            if (outputMask & (1 << i)) {
+                outputEnableOnNextSync(Channel::get(i), outputEnableMask & (1 << i) ? true : false);
+            }
+        }
+        Channel::syncOutputEnable();
+    }
+
+    g_commitPending = false;
+}
+
+uint32_t getLastCommitSkew() {
+    return g_lastCommitSkew;
+}
+
 void remoteSensingEnable(Channel &channel, bool enable) {
     if (channel.channelIndex < 2 && (g_couplingType == COUPLING_TYPE_SERIES || g_couplingType == COUPLING_TYPE_PARALLEL)) {
         Channel::get(0).remoteSensingEnable(enable);
@@ -46,6 +46,7 @@ float getUSet(const Channel &channel);
 float getUSetUnbalanced(const Channel &channel);
 float getUMon(const Channel &channel);
 float getUMonLast(const Channel &channel);
+float getUMonDlog(const Channel &channel);
 float getUMonDac(const Channel &channel);
 float getUMonDacLast(const Channel &channel);
 float getULimit(const Channel &channel);
@@ -69,6 +70,7 @@ float getISet(const Channel &channel);
 float getISetUnbalanced(const Channel &channel);
 float getIMon(const Channel &channel);
 float getIMonLast(const Channel &channel);
+float getIMonDlog(const Channel &channel);
 float getIMonDac(const Channel &channel);
 float getILimit(const Channel &channel);
 float getIMaxLimit(const Channel &channel);
@@ -107,9 +109,24 @@ void outputEnable(Channel &channel, bool enable);
 void outputEnableOnNextSync(Channel &channel, bool enable);
 void syncOutputEnable();
 bool outputEnable(uint32_t channels, bool enable, int *err);
+bool testOutputEnable(Channel &channel, bool enable, bool &callTriggerAbort, int *err);
 void disableOutputForAllChannels();
 void disableOutputForAllTrackingChannels();
 
+// Voltage, current and output state staged for any number of channels are committed
+// as one PSU thread message: all the current DACs, then all the voltage DACs are written
+// back to back and then the outputs are changed together.
+void stageVoltage(Channel &channel, float voltage);
+void stageCurrent(Channel &channel, float current);
+void stageOutputEnable(Channel &channel, bool enable);
+void clearStaged();
+// Staged values are dropped on *RST, coupling or tracking change and protection trip.
+// Returns when the staged values are applied, nothing is applied if any of them fails the test.
+bool commitStaged(int *err);
+void commitStagedInPsuThread();
+// Time between the first and the last DAC write of the last commit in microseconds.
+uint32_t getLastCommitSkew();
+
 void remoteSensingEnable(Channel &channel, bool enable);
 
 bool isTripped(Channel &channel);
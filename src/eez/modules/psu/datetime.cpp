@@ -70,7 +70,126 @@ static struct {
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// Software wall clock. RTC is read at boot, after date/time is changed and every
+// CONF_RTC_SYNC_PERIOD_MS, in between time is advanced from 64-bit microsPrecise().
+// Periodic sync never moves the clock backwards, if it is ahead of the RTC it is held
+// until the RTC catches up. Only the explicit date/time change can move it backwards.
+
+#define CONF_RTC_SYNC_PERIOD_MS 60000
+
+// local time in ms since 1970 at g_anchorMicros, clock is held at g_anchorMs until g_anchorMicros
+static volatile uint64_t g_anchorMs;
+static volatile uint64_t g_anchorMicros;
+// odd while anchor is changed
+static volatile uint32_t g_anchorSeq;
+static volatile bool g_clockValid;
+
+static uint32_t g_lastSyncTickCount;
+
+static ClockStats g_clockStats;
+
+osMutexId(g_clockMutexId);
+osMutexDef(g_clockMutex);
+
+static void setAnchor(uint64_t anchorMs, uint64_t anchorMicros) {
+    g_anchorSeq++;
+    g_anchorMs = anchorMs;
+    g_anchorMicros = anchorMicros;
+    g_anchorSeq++;
+}
+
+static void syncClock(bool force) {
+    uint8_t year, month, day, hour, minute, second;
+    if (!rtc::readDateTime(year, month, day, hour, minute, second)) {
+        return;
+    }
+    uint64_t tickCount = microsPrecise();
+    uint64_t rtcMs = makeTime(2000 + year, month, day, hour, minute, second) * 1000ULL;
+
+    osMutexWait(g_clockMutexId, osWaitForever);
+
+    if (!g_clockValid || force) {
+        setAnchor(rtcMs, tickCount);
+        g_clockValid = true;
+    } else {
+        uint64_t clockMs = g_anchorMs;
+        if (tickCount > g_anchorMicros) {
+            clockMs += (tickCount - g_anchorMicros) / 1000;
+        }
+
+        // RTC resolution is 1 second, so clock should be within [rtcMs, rtcMs + 1000)
+        int32_t driftMs;
+        if (clockMs < rtcMs) {
+            // behind, step forward
+            driftMs = -(int32_t)(rtcMs - clockMs);
+            setAnchor(rtcMs, tickCount);
+        } else if (clockMs >= rtcMs + 1000) {
+            // ahead, hold the current time for driftMs, so it continues from rtcMs + 999
+            driftMs = (int32_t)(clockMs - (rtcMs + 999));
+            setAnchor(clockMs, tickCount + driftMs * 1000ULL);
+        } else {
+            driftMs = 0;
+        }
+
+        g_clockStats.numSyncs++;
+        g_clockStats.lastDriftMs = driftMs;
+        if (driftMs != 0) {
+            g_clockStats.numCorrections++;
+            if ((driftMs < 0 ? -driftMs : driftMs) > (g_clockStats.maxDriftMs < 0 ? -g_clockStats.maxDriftMs : g_clockStats.maxDriftMs)) {
+                g_clockStats.maxDriftMs = driftMs;
+            }
+        }
+    }
+
+    osMutexRelease(g_clockMutexId);
+}
+
+uint64_t nowMs() {
+    if (!g_clockValid) {
+        syncClock(true);
+        if (!g_clockValid) {
+            return 0;
+        }
+    }
+
+    uint32_t seq;
+    uint64_t anchorMs;
+    uint64_t anchorMicros;
+    do {
+        seq = g_anchorSeq;
+        anchorMs = g_anchorMs;
+        anchorMicros = g_anchorMicros;
+    } while ((seq & 1) || seq != g_anchorSeq);
+
+    uint64_t tickCount = microsPrecise();
+    return tickCount > anchorMicros ? anchorMs + (tickCount - anchorMicros) / 1000 : anchorMs;
+}
+
+const ClockStats &getClockStats() {
+    return g_clockStats;
+}
+
+static bool getClockDateTime(uint8_t &year, uint8_t &month, uint8_t &day, uint8_t &hour, uint8_t &minute, uint8_t &second) {
+    uint64_t ms = nowMs();
+    if (!g_clockValid) {
+        return false;
+    }
+
+    int year_, month_, day_, hour_, minute_, second_;
+    breakTime((uint32_t)(ms / 1000), year_, month_, day_, hour_, minute_, second_);
+
+    year = (uint8_t)(year_ - 2000);
+    month = (uint8_t)month_;
+    day = (uint8_t)day_;
+    hour = (uint8_t)hour_;
+    minute = (uint8_t)minute_;
+    second = (uint8_t)second_;
+
+    return true;
+}
+
 void init() {
+    g_clockMutexId = osMutexCreate(osMutex(g_clockMutex));
 }
 
 int cmp_datetime(uint8_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t minute,
@@ -144,9 +263,7 @@ bool isValidTime(uint8_t hour, uint8_t minute, uint8_t second) {
 }
 
 bool dstCheck() {
-    uint8_t year, month, day, hour, minute, second;
-    rtc::readDateTime(year, month, day, hour, minute, second);
-    uint32_t now = makeTime(2000 + year, month, day, hour, minute, second);
+    uint32_t now = datetime::now();
 
     bool dst = isDst(now, (DstRule)persist_conf::devConf.dstRule);
 
@@ -220,13 +337,19 @@ void tick(uint32_t tickCount) {
     static uint32_t g_lastTickCount;
     int32_t diff = tickCount - g_lastTickCount;
     if (diff > 1000000L) {
+        if (tickCount - g_lastSyncTickCount > CONF_RTC_SYNC_PERIOD_MS * 1000UL) {
+            syncClock(false);
+            g_lastSyncTickCount = tickCount;
+        }
+
         dstCheck();
         g_lastTickCount = tickCount;
     }
 }
 
 bool getDate(uint8_t &year, uint8_t &month, uint8_t &day) {
-    return rtc::readDate(year, month, day);
+    uint8_t hour, minute, second;
+    return getClockDateTime(year, month, day, hour, minute, second);
 }
 
 bool checkDateTime() {
@@ -243,6 +366,7 @@ bool checkDateTime() {
 
 bool setDate(uint8_t year, uint8_t month, uint8_t day, unsigned dst) {
     if (rtc::writeDate(year, month, day)) {
+        syncClock(true);
         persist_conf::writeSystemDate(year, month, day, dst);
         setQuesBits(QUES_TIME, !checkDateTime());
         event_queue::pushEvent(event_queue::EVENT_INFO_SYSTEM_DATE_TIME_CHANGED);
@@ -252,11 +376,13 @@ bool setDate(uint8_t year, uint8_t month, uint8_t day, unsigned dst) {
 }
 
 bool getTime(uint8_t &hour, uint8_t &minute, uint8_t &second) {
-    return rtc::readTime(hour, minute, second);
+    uint8_t year, month, day;
+    return getClockDateTime(year, month, day, hour, minute, second);
 }
 
 bool setTime(uint8_t hour, uint8_t minute, uint8_t second, unsigned dst) {
     if (rtc::writeTime(hour, minute, second)) {
+        syncClock(true);
         persist_conf::writeSystemTime(hour, minute, second, dst);
         setQuesBits(QUES_TIME, !checkDateTime());
         event_queue::pushEvent(event_queue::EVENT_INFO_SYSTEM_DATE_TIME_CHANGED);
@@ -266,12 +392,13 @@ bool setTime(uint8_t hour, uint8_t minute, uint8_t second, unsigned dst) {
 }
 
 bool getDateTime(uint8_t &year, uint8_t &month, uint8_t &day, uint8_t &hour, uint8_t &minute, uint8_t &second) {
-    return rtc::readDateTime(year, month, day, hour, minute, second);
+    return getClockDateTime(year, month, day, hour, minute, second);
 }
 
 bool setDateTime(uint8_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t minute,
                  uint8_t second, bool pushChangedEvent, unsigned dst) {
     if (rtc::writeDateTime(year, month, day, hour, minute, second)) {
+        syncClock(true);
         persist_conf::writeSystemDateTime(year, month, day, hour, minute, second, dst);
         setQuesBits(QUES_TIME, !checkDateTime());
         if (pushChangedEvent) {
@@ -342,16 +469,11 @@ bool getDateTimeAsString(char *buffer) {
 }
 
 uint32_t now() {
-    uint8_t year, month, day, hour, minute, second;
-    rtc::readDateTime(year, month, day, hour, minute, second);
-    return makeTime(2000 + year, month, day, hour, minute, second);
+    return (uint32_t)(nowMs() / 1000);
 }
 
 uint32_t nowUtc() {
-    uint8_t year, month, day, hour, minute, second;
-    rtc::readDateTime(year, month, day, hour, minute, second);
-    uint32_t now = makeTime(2000 + year, month, day, hour, minute, second);
-    return localToUtc(now, persist_conf::devConf.timeZone, (DstRule)persist_conf::devConf.dstRule);
+    return localToUtc(now(), persist_conf::devConf.timeZone, (DstRule)persist_conf::devConf.dstRule);
 }
 
 uint32_t makeTime(int year, int month, int day, int hour, int minute, int second) {
@@ -54,6 +54,18 @@ bool getDateTimeAsString(char *buffer);
 uint32_t now();
 uint32_t nowUtc();
 
+/// Local time in milliseconds since 1970, from the software clock (no RTC access).
+uint64_t nowMs();
+
+struct ClockStats {
+    uint32_t numSyncs;       // periodic syncs with RTC
+    uint32_t numCorrections; // syncs where clock was outside of the RTC second
+    int32_t lastDriftMs;     // clock - RTC, 0 if clock was within the RTC second
+    int32_t maxDriftMs;
+};
+
+const ClockStats &getClockStats();
+
 uint32_t makeTime(int year, int month, int day, int hour, int minute, int second);
 void breakTime(uint32_t time, int &resultYear, int &resultMonth, int &resultDay, int &resultHour, int &resultMinute, int &resultSecond);
 
@@ -24,12 +24,39 @@
 #include <eez/modules/psu/serial_psu.h>
 #include <eez/system.h>
 
+#if OPTION_DISPLAY
+#include <eez/gui/assets.h>
+#endif
+
 namespace eez {
 namespace psu {
 namespace debug {
 
 DebugCounterVariable g_adcCounter("ADC_COUNTER");
 DebugValueVariable g_encoderCounter("ENC_COUNTER", 100);
+DebugValueVariable g_guiWidgetsVisited("GUI_VISITED", 100);
+DebugValueVariable g_guiWidgetsRetained("GUI_RETAINED", 100);
+DebugValueVariable g_guiRetainedMismatches("GUI_MISMATCHES");
+DebugValueVariable g_assetsBootDuration("ASSETS_BOOT_US");
+DebugValueVariable g_assetsLazyLoads("ASSETS_LAZY_LOADS");
+DebugValueVariable g_assetsMaxLazyLoadDuration("ASSETS_LAZY_MAX_US");
+DebugValueVariable g_assetsRamUsed("ASSETS_RAM_KB");
+DebugValueVariable g_assetsRamTotal("ASSETS_RAM_ALL_KB");
+DebugValueVariable g_screenshotTimeToFirstByte("SCREENSHOT_TTFB_US");
+DebugValueVariable g_screenshotDuration("SCREENSHOT_US");
+DebugValueVariable g_clockDrift("CLOCK_DRIFT_MS");
+DebugValueVariable g_clockMaxDrift("CLOCK_MAX_DRIFT_MS");
+DebugValueVariable g_clockCorrections("CLOCK_CORRECTIONS");
+DebugValueVariable g_uploadSpeed("MMEM_UPLOAD_KB_S");
+DebugValueVariable g_downloadSpeed("MMEM_DOWNLOAD_KB_S");
+DebugValueVariable g_imageDecodeTime("IMAGE_DECODE_US");
+DebugValueVariable g_profileRecallTime("PROFILE_RECALL_US");
+DebugValueVariable g_confJournalBytes("CONF_JOURNAL_BYTES");
+DebugValueVariable g_confBlockBytes("CONF_BLOCK_BYTES");
+DebugValueVariable g_schedCycleMaxTime("SCHED_CYCLE_MAX_US");
+DebugValueVariable g_schedCycleOverruns("SCHED_CYCLE_OVERRUNS");
+DebugValueVariable g_schedDeadlineMisses("SCHED_DEADLINE_MISSES");
+DebugValueVariable g_schedDeferrals("SCHED_DEFERRALS");
 DebugValueVariable g_uDac[CH_MAX] = { DebugValueVariable("CH1 U_DAC"), DebugValueVariable("CH2 U_DAC"), DebugValueVariable("CH3 U_DAC"), DebugValueVariable("CH4 U_DAC"), DebugValueVariable("CH5 U_DAC"), DebugValueVariable("CH6 U_DAC") };
 DebugValueVariable g_uMon[CH_MAX] = { DebugValueVariable("CH1 U_MON"), DebugValueVariable("CH2 U_MON"), DebugValueVariable("CH3 U_MON"), DebugValueVariable("CH4 U_MON"), DebugValueVariable("CH5 U_MON"), DebugValueVariable("CH6 U_MON") };
 DebugValueVariable g_uMonDac[CH_MAX] = { DebugValueVariable("CH1 U_MON_DAC"), DebugValueVariable("CH2 U_MON_DAC"), DebugValueVariable("CH3 U_MON_DAC"), DebugValueVariable("CH4 U_MON_DAC"), DebugValueVariable("CH5 U_MON_DAC"), DebugValueVariable("CH6 U_MON_DAC") };
@@ -40,6 +67,29 @@ DebugValueVariable g_iMonDac[CH_MAX] = { DebugValueVariable("CH1 I_MON_DAC"), De
 DebugVariable *g_variables[] = { 
     &g_adcCounter,
     &g_encoderCounter,
+    &g_guiWidgetsVisited,
+    &g_guiWidgetsRetained,
+    &g_guiRetainedMismatches,
+    &g_assetsBootDuration,
+    &g_assetsLazyLoads,
+    &g_assetsMaxLazyLoadDuration,
+    &g_assetsRamUsed,
+    &g_assetsRamTotal,
+    &g_screenshotTimeToFirstByte,
+    &g_screenshotDuration,
+    &g_clockDrift,
+    &g_clockMaxDrift,
+    &g_clockCorrections,
+    &g_uploadSpeed,
+    &g_downloadSpeed,
+    &g_imageDecodeTime,
+    &g_profileRecallTime,
+    &g_confJournalBytes,
+    &g_confBlockBytes,
+    &g_schedCycleMaxTime,
+    &g_schedCycleOverruns,
+    &g_schedDeadlineMisses,
+    &g_schedDeferrals,
     &g_uDac[0], &g_uMon[0], &g_uMonDac[0], &g_iDac[0], &g_iMon[0], &g_iMonDac[0],
     &g_uDac[1], &g_uMon[1], &g_uMonDac[1], &g_iDac[1], &g_iMon[1], &g_iMonDac[1],
     &g_uDac[2], &g_uMon[2], &g_uMonDac[2], &g_iDac[2], &g_iMon[2], &g_iMonDac[2],
@@ -84,6 +134,20 @@ void tick(uint32_t tickCount) {
             for (unsigned i = 0; i < sizeof(g_variables) / sizeof(DebugVariable *); ++i) {
                 g_variables[i]->tick1secPeriod();
             }
+
+            const datetime::ClockStats &clockStats = datetime::getClockStats();
+            g_clockDrift.set(clockStats.lastDriftMs);
+            g_clockMaxDrift.set(clockStats.maxDriftMs);
+            g_clockCorrections.set(clockStats.numCorrections);
+
+#if OPTION_DISPLAY
+            const gui::AssetsLoadStats &assetsLoadStats = gui::getAssetsLoadStats();
+            g_assetsBootDuration.set(assetsLoadStats.bootDuration);
+            g_assetsLazyLoads.set(assetsLoadStats.numLazyLoads);
+            g_assetsMaxLazyLoadDuration.set(assetsLoadStats.maxLazyLoadDuration);
+            g_assetsRamUsed.set(assetsLoadStats.ramUsed / 1024);
+            g_assetsRamTotal.set(assetsLoadStats.ramTotal / 1024);
+#endif
             g_previousTickCount1sec = tickCount;
         }
     } else {
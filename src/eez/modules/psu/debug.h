@@ -37,6 +37,38 @@ void tick(uint32_t tickCount);
 extern DebugCounterVariable g_adcCounter;
 extern DebugValueVariable g_encoderCounter;
 
+extern DebugValueVariable g_guiWidgetsVisited;
+extern DebugValueVariable g_guiWidgetsRetained;
+extern DebugValueVariable g_guiRetainedMismatches;
+
+extern DebugValueVariable g_assetsBootDuration;
+extern DebugValueVariable g_assetsLazyLoads;
+extern DebugValueVariable g_assetsMaxLazyLoadDuration;
+extern DebugValueVariable g_assetsRamUsed;
+extern DebugValueVariable g_assetsRamTotal;
+
+extern DebugValueVariable g_screenshotTimeToFirstByte;
+extern DebugValueVariable g_screenshotDuration;
+
+extern DebugValueVariable g_clockDrift;
+extern DebugValueVariable g_clockMaxDrift;
+extern DebugValueVariable g_clockCorrections;
+
+extern DebugValueVariable g_uploadSpeed;
+extern DebugValueVariable g_downloadSpeed;
+
+extern DebugValueVariable g_imageDecodeTime;
+
+extern DebugValueVariable g_profileRecallTime;
+
+extern DebugValueVariable g_confJournalBytes;
+extern DebugValueVariable g_confBlockBytes;
+
+extern DebugValueVariable g_schedCycleMaxTime;
+extern DebugValueVariable g_schedCycleOverruns;
+extern DebugValueVariable g_schedDeadlineMisses;
+extern DebugValueVariable g_schedDeferrals;
+
 extern DebugValueVariable g_uDac[CH_MAX];
 extern DebugValueVariable g_uMon[CH_MAX];
 extern DebugValueVariable g_uMonDac[CH_MAX];
@@ -30,6 +30,7 @@
 #include <eez/modules/psu/scpi/psu.h>
 #include <eez/modules/psu/sd_card.h>
 #include <eez/system.h>
+#include <eez/trace.h>
 #include <eez/modules/psu/dlog_record.h>
 #include <eez/modules/psu/event_queue.h>
 #include <eez/gui/widgets/yt_graph.h>
@@ -119,6 +120,10 @@ static uint32_t g_lastSavedBufferTickCount;
 osMutexId(g_mutexId);
 osMutexDef(g_mutex);
 
+// file is written from SD worker, but also flushed from SCPI thread when recording is finished
+osMutexId(g_fileWriteMutexId);
+osMutexDef(g_fileWriteMutex);
+
 void abortAfterError();
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -209,8 +214,7 @@ void getNextWriteBuffer(const uint8_t *&buffer, uint32_t &bufferSize, bool flush
     }
 }
 
-// returns true if there is more data to write
-void fileWrite(bool flush) {
+static void doFileWrite(bool flush) {
     if (g_state != STATE_EXECUTING) {
         return;
     }
@@ -224,6 +228,8 @@ void fileWrite(bool flush) {
             return;
         }
 
+        TRACE_SCOPE("dlog::write");
+
         int err = 0;
 
         File file;
@@ -258,6 +264,16 @@ void fileWrite(bool flush) {
     }
 }
 
+void fileWrite(bool flush) {
+    if (g_state != STATE_EXECUTING) {
+        return;
+    }
+
+    osMutexWait(g_fileWriteMutexId, osWaitForever);
+    doFileWrite(flush);
+    osMutexRelease(g_fileWriteMutexId);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 static void flushData() {
@@ -265,7 +281,7 @@ static void flushData() {
 
     uint32_t timeout = millis() + CONF_WRITE_FLUSH_TIMEOUT_MS;
     while (g_lastSavedBufferIndex < g_bufferIndex && millis() < timeout) {
-        fileWrite(true);
+        doFileWrite(true);
     }
 
     //DebugTrace("flush after: %d\n", g_bufferIndex - g_lastSavedBufferIndex);
@@ -524,21 +540,21 @@ static void log(uint32_t tickCount) {
                 float iMon = 0;
 
                 if (g_recording.parameters.logVoltage[i]) {
-                    uMon = channel_dispatcher::getUMonLast(channel);
+                    uMon = channel_dispatcher::getUMonDlog(channel);
                     writeFloat(uMon);
                 }
 
                 if (g_recording.parameters.logCurrent[i]) {
-                    iMon = channel_dispatcher::getIMonLast(channel);
+                    iMon = channel_dispatcher::getIMonDlog(channel);
                     writeFloat(iMon);
                 }
 
                 if (g_recording.parameters.logPower[i]) {
                     if (!g_recording.parameters.logVoltage[i]) {
-                        uMon = channel_dispatcher::getUMonLast(channel);
+                        uMon = channel_dispatcher::getUMonDlog(channel);
                     }
                     if (!g_recording.parameters.logCurrent[i]) {
-                        iMon = channel_dispatcher::getIMonLast(channel);
+                        iMon = channel_dispatcher::getIMonDlog(channel);
                     }
                     writeFloat(uMon * iMon);
                 }
@@ -582,6 +598,7 @@ static int doStartImmediately() {
 static int doInitiate(bool traceInitiated) {
     if (!g_mutexId) {
         g_mutexId = osMutexCreate(osMutex(g_mutex));
+        g_fileWriteMutexId = osMutexCreate(osMutex(g_fileWriteMutex));
     }
 
     int err;
@@ -613,12 +630,14 @@ static void resetParameters() {
 }
 
 static void doFinish(bool afterError) {
+    osMutexWait(g_fileWriteMutexId, osWaitForever);
     if (!afterError) {
         flushData();
         onSdCardFileChangeHook(g_parameters.filePath);
     }
     resetParameters();
     setState(STATE_IDLE);
+    osMutexRelease(g_fileWriteMutexId);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -31,6 +31,7 @@
 #include <eez/modules/psu/dlog_record.h>
 #include <eez/modules/psu/scpi/psu.h>
 #include <eez/modules/psu/serial_psu.h>
+#include <eez/modules/psu/sd_worker.h>
 #include <eez/modules/psu/gui/psu.h>
 #if OPTION_ETHERNET
 #include <eez/modules/psu/ethernet.h>
@@ -267,7 +268,7 @@ float getValue(uint32_t rowIndex, uint8_t columnIndex, float *max) {
         g_blockIndexToLoad = blockIndex;
         g_loadScale = g_recording.xAxisDiv / g_recording.xAxisDivMin;
 
-        osMessagePut(g_scpiMessageQueueId, SCPI_QUEUE_MESSAGE(SCPI_QUEUE_MESSAGE_TARGET_NONE, SCPI_QUEUE_MESSAGE_DLOG_LOAD_BLOCK, 0), osWaitForever);
+        sd_worker::postRequest(sd_worker::REQUEST_DLOG_LOAD_BLOCK);
     }
 
     uint32_t blockElementIndex = (blockElementAddress % BLOCK_SIZE) / sizeof(BlockElement);
@@ -564,14 +565,14 @@ void scaleToFit(Recording &recording) {
 }
 
 bool openFile(const char *filePath, int *err) {
-    if (osThreadGetId() != g_scpiTaskHandle) {
+    if (!sd_worker::isSdCardThread()) {
         g_state = STATE_LOADING;
         g_loadingStartTickCount = millis();
 
         strcpy(g_filePath, filePath);
         memset(&g_recording, 0, sizeof(Recording));
 
-        osMessagePut(g_scpiMessageQueueId, SCPI_QUEUE_MESSAGE(SCPI_QUEUE_MESSAGE_TARGET_NONE, SCPI_QUEUE_MESSAGE_DLOG_SHOW_FILE, 0), osWaitForever);
+        sd_worker::postRequest(sd_worker::REQUEST_DLOG_SHOW_FILE);
         return true;
     }
 
@@ -21,6 +21,7 @@
 #include <string.h>
 #include <stdlib.h>
 
+#include <eez/debug.h>
 #include <eez/system.h>
 #include <eez/mp.h>
 #include <eez/memory.h>
@@ -42,6 +43,9 @@
 #include <eez/modules/psu/persist_conf.h>
 #include <eez/modules/psu/sd_card.h>
 #include <eez/modules/psu/dlog_view.h>
+#include <eez/modules/psu/sd_worker.h>
+#include <eez/modules/psu/debug.h>
+#include <eez/modules/psu/profile.h>
 
 #include <eez/modules/psu/scpi/psu.h>
 
@@ -54,6 +58,12 @@
 
 #include <eez/libs/image/image.h>
 
+// hidden root directory with one catalog cache file per directory and list view
+#define CATALOG_CACHE_DIR "/.catalog"
+#define CATALOG_CACHE_MAGIC 0x4C544143 // "CATL"
+#define CATALOG_CACHE_VERSION 1
+#define CATALOG_CACHE_MAX_INVALIDATED 8
+
 using namespace eez::psu::gui;
 
 namespace eez {
@@ -98,25 +108,340 @@ static void (*g_fileBrowserOnFileSelected)(const char *filePath);
 static ListViewOption g_rootDirectoryListViewOption = LIST_VIEW_LARGE_ICONS;
 static ListViewOption g_scriptsDirectoryListViewOption = LIST_VIEW_SCRIPTS;
 
+// While directory is scanned, already scanned items are shown in directory order.
+// They are sorted only after the whole directory is scanned.
+static bool g_partial;
+
+// set when directory is changed while the previous one is still scanned
+static bool g_reloadRequested;
+
+// Items are only appended by the SD worker and never moved, sorted order is kept
+// in the separate index placed after the items. Index is changed and read under the mutex.
+static uint16_t *g_sortedIndex;
+static SortFilesOption g_sortFilesOption;
+osMutexId(g_fileItemsMutexId);
+osMutexDef(g_fileItemsMutex);
+
+// Sum of the hashes of all directory entries, i.e. it doesn't depend on the entries order.
+static uint32_t g_catalogSignature;
+
+static uint32_t g_invalidatedDirectories[CATALOG_CACHE_MAX_INVALIDATED];
+static uint32_t g_numInvalidatedDirectories;
+
+struct CatalogCacheHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint8_t kind;
+    uint8_t sortFilesOption;
+    uint32_t signature;
+    uint32_t numFiles;
+    char directory[MAX_PATH_LENGTH + 1];
+};
+
+struct CatalogCacheEntry {
+    uint8_t type;
+    uint8_t descriptionLength;
+    uint16_t nameLength;
+    uint32_t size;
+    uint32_t dateTime;
+};
+
+static void sort();
+
+static bool addFileItem(FileType type, const char *name, const char *description, uint32_t size, uint32_t dateTime) {
+    size_t nameLen = 4 * ((strlen(name) + 1 + 3) / 4);
+
+    size_t descriptionLen = description ? strlen(description) : 0;
+    if (descriptionLen > 0) {
+        descriptionLen = 4 * ((descriptionLen + 1 + 3) / 4);
+    }
+
+    // space for the sorted index is also reserved
+    if (g_frontBufferPosition + sizeof(FileItem) + (g_filesCount + 1) * sizeof(uint16_t) > g_backBufferPosition - nameLen - descriptionLen) {
+        return false;
+    }
+
+    auto fileItem = (FileItem *)g_frontBufferPosition;
+    g_frontBufferPosition += sizeof(FileItem);
+
+    fileItem->type = type;
+
+    g_backBufferPosition -= nameLen;
+    strcpy((char *)g_backBufferPosition, name);
+    fileItem->name = (const char *)g_backBufferPosition;
+
+    if (descriptionLen > 0) {
+        g_backBufferPosition -= descriptionLen;
+        strcpy((char *)g_backBufferPosition, description);
+        fileItem->description = (const char *)g_backBufferPosition;
+    } else {
+        fileItem->description = nullptr;
+    }
+
+    fileItem->size = size;
+    fileItem->dateTime = dateTime;
+
+    // item is visible to the GUI thread from now on
+    g_filesCount++;
+
+    return true;
+}
+
+static void resetFileItems() {
+    osMutexWait(g_fileItemsMutexId, osWaitForever);
+    g_frontBufferPosition = FILE_MANAGER_MEMORY;
+    g_backBufferPosition = FILE_MANAGER_MEMORY + FILE_MANAGER_MEMORY_SIZE;
+    g_filesCount = 0;
+    g_sortedIndex = nullptr;
+    osMutexRelease(g_fileItemsMutexId);
+}
+
+static FileItem *getFileItemAt(uint32_t itemIndex) {
+    return (FileItem *)(FILE_MANAGER_MEMORY + itemIndex * sizeof(FileItem));
+}
+
+// without the index items are in directory order, or in cached sort order
+static uint32_t getSortedItemIndex(uint32_t fileIndex) {
+    return g_sortedIndex ? g_sortedIndex[fileIndex] : fileIndex;
+}
+
+static uint32_t getModifiedDateTime(FileInfo *fileInfo) {
+    int year = fileInfo->getModifiedYear();
+    int month = fileInfo->getModifiedMonth();
+    int day = fileInfo->getModifiedDay();
+
+    int hour = fileInfo->getModifiedHour();
+    int minute = fileInfo->getModifiedMinute();
+    int second = fileInfo->getModifiedSecond();
+
+    return psu::datetime::makeTime(year, month, day, hour, minute, second);
+}
+
+static uint32_t getHash(uint32_t hash, const char *str) {
+    while (*str) {
+        hash = (hash ^ (uint8_t)*str++) * 16777619u;
+    }
+    return hash;
+}
+
+static uint32_t getDirectoryHash(const char *directory) {
+    return getHash(2166136261u, strcmp(directory, "/") == 0 ? "" : directory);
+}
+
+static uint32_t getCatalogEntryHash(const char *name, uint32_t size, uint32_t dateTime) {
+    uint32_t hash = getHash(2166136261u, name);
+    hash = (hash ^ size) * 16777619u;
+    hash = (hash ^ dateTime) * 16777619u;
+    return hash;
+}
+
+static bool isCacheEntry(const char *name) {
+    return isRootDirectory() && (
+        strcmp(name, CATALOG_CACHE_DIR + 1) == 0 ||
+        strcmp(name, IMAGE_PREVIEW_CACHE_DIR + 1) == 0 ||
+        strcmp(name, PROFILE_INDEX_FILE_PATH + 1) == 0
+    );
+}
+
+static bool isInDirectory(const char *filePath, const char *dirPath) {
+    size_t n = strlen(dirPath);
+    return strncmp(filePath, dirPath, n) == 0 && (filePath[n] == 0 || filePath[n] == '/');
+}
+
+// cache entries are not listed, so changing them doesn't change any catalog
+static bool isCacheFilePath(const char *filePath) {
+    return isInDirectory(filePath, CATALOG_CACHE_DIR) || isInDirectory(filePath, IMAGE_PREVIEW_CACHE_DIR);
+}
+
+// The same directory is listed differently in the file browser and in the scripts view.
+static uint8_t getCatalogKind() {
+    if (g_fileBrowserMode) {
+        return 0x80 | g_fileBrowserFileType;
+    }
+    return getListViewOption();
+}
+
+static void getCatalogCacheFilePath(const char *directory, char *filePath) {
+    uint32_t hash = (getDirectoryHash(directory) ^ getCatalogKind()) * 16777619u;
+    sprintf(filePath, "%s/%08X.cat", CATALOG_CACHE_DIR, (unsigned)hash);
+}
+
+// Called for the files changed by us, so we don't have to wait for the catalog
+// signature check to find out that cached catalog is stale.
+static void invalidateCatalogCache(const char *filePath) {
+    char parentDirPath[MAX_PATH_LENGTH + 1];
+    getParentDir(filePath, parentDirPath);
+
+    g_invalidatedDirectories[g_numInvalidatedDirectories++ % CATALOG_CACHE_MAX_INVALIDATED] = getDirectoryHash(parentDirPath);
+}
+
+static bool isCatalogCacheInvalidated(const char *directory, bool clear) {
+    uint32_t hash = getDirectoryHash(directory);
+    bool result = false;
+    for (int i = 0; i < CATALOG_CACHE_MAX_INVALIDATED; i++) {
+        if (g_invalidatedDirectories[i] == hash) {
+            if (clear) {
+                g_invalidatedDirectories[i] = 0;
+            }
+            result = true;
+        }
+    }
+    return result;
+}
+
+static bool loadCatalogCache(const char *directory, uint32_t &signature) {
+    char filePath[MAX_PATH_LENGTH + 1];
+    getCatalogCacheFilePath(directory, filePath);
+
+    File file;
+    if (!file.open(filePath, FILE_OPEN_EXISTING | FILE_READ)) {
+        return false;
+    }
+
+    psu::sd_card::BufferedFileRead bufferedFile(file);
+
+    CatalogCacheHeader header;
+    if (
+        bufferedFile.read(&header, sizeof(header)) != (int)sizeof(header) ||
+        header.magic != CATALOG_CACHE_MAGIC ||
+        header.version != CATALOG_CACHE_VERSION ||
+        header.kind != getCatalogKind() ||
+        strcmp(header.directory, directory) != 0
+    ) {
+        file.close();
+        return false;
+    }
+
+    resetFileItems();
+
+    bool result = true;
+
+    for (uint32_t i = 0; i < header.numFiles; i++) {
+        CatalogCacheEntry entry;
+        char name[MAX_PATH_LENGTH + 1];
+        char description[MAX_FILE_DESCRIPTION_LENGTH + 1];
+
+        if (
+            bufferedFile.read(&entry, sizeof(entry)) != (int)sizeof(entry) ||
+            entry.nameLength > MAX_PATH_LENGTH ||
+            entry.descriptionLength > MAX_FILE_DESCRIPTION_LENGTH ||
+            bufferedFile.read(name, entry.nameLength) != entry.nameLength ||
+            bufferedFile.read(description, entry.descriptionLength) != entry.descriptionLength
+        ) {
+            result = false;
+            break;
+        }
+
+        name[entry.nameLength] = 0;
+        description[entry.descriptionLength] = 0;
+
+        addFileItem((FileType)entry.type, name, description, entry.size, entry.dateTime);
+    }
+
+    file.close();
+
+    if (!result) {
+        resetFileItems();
+        return false;
+    }
+
+    if (header.sortFilesOption != psu::persist_conf::devConf.sortFilesOption) {
+        sort();
+    } else {
+        g_sortFilesOption = (SortFilesOption)header.sortFilesOption;
+    }
+
+    signature = header.signature;
+    return true;
+}
+
+static void saveCatalogCache(const char *directory, uint32_t signature) {
+    char filePath[MAX_PATH_LENGTH + 1];
+    getCatalogCacheFilePath(directory, filePath);
+
+    // onSdCardFileChangeHook ignores the cache directory
+    File file;
+    if (!file.open(filePath, FILE_CREATE_ALWAYS | FILE_WRITE)) {
+        if (!psu::sd_card::makeParentDir(filePath, nullptr) || !file.open(filePath, FILE_CREATE_ALWAYS | FILE_WRITE)) {
+            return;
+        }
+    }
+
+    psu::sd_card::BufferedFileWrite bufferedFile(file);
+
+    CatalogCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = CATALOG_CACHE_MAGIC;
+    header.version = CATALOG_CACHE_VERSION;
+    header.kind = getCatalogKind();
+    header.sortFilesOption = g_sortFilesOption;
+    header.signature = signature;
+    header.numFiles = g_filesCount;
+    strcpy(header.directory, directory);
+
+    bool result = bufferedFile.write((const uint8_t *)&header, sizeof(header));
+
+    for (uint32_t i = 0; result && i < g_filesCount; i++) {
+        // items are saved in sorted order
+        auto fileItem = getFileItemAt(getSortedItemIndex(i));
+
+        CatalogCacheEntry entry;
+        entry.type = fileItem->type;
+        entry.nameLength = strlen(fileItem->name);
+        entry.descriptionLength = fileItem->description ? strlen(fileItem->description) : 0;
+        entry.size = fileItem->size;
+        entry.dateTime = fileItem->dateTime;
+
+        result =
+            bufferedFile.write((const uint8_t *)&entry, sizeof(entry)) &&
+            bufferedFile.write((const uint8_t *)fileItem->name, entry.nameLength) &&
+            bufferedFile.write((const uint8_t *)fileItem->description, entry.descriptionLength);
+    }
+
+    if (result) {
+        result = bufferedFile.flush();
+    }
+
+    file.close();
+
+    if (!result) {
+        // better no cache than the truncated one
+        psu::sd_card::deleteFile(filePath, nullptr);
+    }
+}
+
+static void signatureCallback(void *param, const char *name, FileType type, size_t size) {
+    if (isCacheEntry(name)) {
+        return;
+    }
+
+    g_catalogSignature += getCatalogEntryHash(name, size, getModifiedDateTime((FileInfo *)param));
+}
+
 void catalogCallback(void *param, const char *name, FileType type, size_t size) {
-    if (g_fileBrowserMode && type != FILE_TYPE_DIRECTORY && type != g_fileBrowserFileType) {
+    if (g_reloadRequested || isCacheEntry(name)) {
         return;
     }
 
     auto fileInfo = (FileInfo *)param;
- 
+    uint32_t dateTime = getModifiedDateTime(fileInfo);
+
+    g_catalogSignature += getCatalogEntryHash(name, size, dateTime);
+
+    if (g_fileBrowserMode && type != FILE_TYPE_DIRECTORY && type != g_fileBrowserFileType) {
+        return;
+    }
+
     char fileNameWithoutExtension[MAX_PATH_LENGTH + 1];
 
     char description[MAX_FILE_DESCRIPTION_LENGTH + 1];
-    size_t descriptionLen = 0;
+    description[0] = 0;
 
     if (isScriptsDirectory() && (getListViewOption() == LIST_VIEW_SCRIPTS || getListViewOption() == LIST_VIEW_LARGE_ICONS)) {
         if (type != FILE_TYPE_MICROPYTHON) {
             return;
         }
 
-        description[0] = 0;
-
         if (getListViewOption() == LIST_VIEW_SCRIPTS) {
             char filePath[MAX_PATH_LENGTH + 1];
             strcpy(filePath, g_currentDirectory);
@@ -137,11 +462,6 @@ void catalogCallback(void *param, const char *name, FileType type, size_t size)
             }
         }
 
-        descriptionLen = strlen(description);
-        if (descriptionLen > 0) {
-            descriptionLen = 4 * ((descriptionLen + 1 + 3) / 4);
-        }
-
         const char *str = strrchr(name, '.');
         if (str) {
             auto n = str - name;
@@ -151,42 +471,7 @@ void catalogCallback(void *param, const char *name, FileType type, size_t size)
         }
     }
 
-    size_t nameLen = 4 * ((strlen(name) + 1 + 3) / 4);
-
-    if (g_frontBufferPosition + sizeof(FileItem) > g_backBufferPosition - nameLen - descriptionLen) {
-        return;
-    }
-
-    auto fileItem = (FileItem *)g_frontBufferPosition;
-    g_frontBufferPosition += sizeof(FileItem);
-
-    fileItem->type = type;
-
-    g_backBufferPosition -= nameLen;
-    strcpy((char *)g_backBufferPosition, name);
-    fileItem->name = (const char *)g_backBufferPosition;
-
-    if (descriptionLen > 0) {
-        g_backBufferPosition -= descriptionLen;
-        strcpy((char *)g_backBufferPosition, description);
-        fileItem->description = (const char *)g_backBufferPosition;
-    } else {
-        fileItem->description = nullptr;
-    }
-
-    fileItem->size = size;
-
-    int year = fileInfo->getModifiedYear();
-    int month = fileInfo->getModifiedMonth();
-    int day = fileInfo->getModifiedDay();
-
-    int hour = fileInfo->getModifiedHour();
-    int minute = fileInfo->getModifiedMinute();
-    int second = fileInfo->getModifiedSecond();
-
-    fileItem->dateTime = psu::datetime::makeTime(year, month, day, hour, minute, second);
-
-    g_filesCount++;
+    addFileItem(type, name, description, size, dateTime);
 }
 
 RootDirectoryType getRootDirectoryType(FileItem *item) {
@@ -261,18 +546,18 @@ int compareFunc(const void *p1, const void *p2, SortFilesOption sortFilesOption)
 
 
 int compareFunc(const void *p1, const void *p2) {
-    int result = compareFunc(p1, p2, psu::persist_conf::devConf.sortFilesOption);
+    int result = compareFunc(p1, p2, g_sortFilesOption);
     if (result != 0) {
         return result;
     }
 
-    if (psu::persist_conf::devConf.sortFilesOption == SORT_FILES_BY_NAME_ASC || psu::persist_conf::devConf.sortFilesOption == SORT_FILES_BY_NAME_DESC) {
+    if (g_sortFilesOption == SORT_FILES_BY_NAME_ASC || g_sortFilesOption == SORT_FILES_BY_NAME_DESC) {
         int result = compareFunc(p1, p2, SORT_FILES_BY_SIZE_ASC);
         if (result != 0) {
             return result;
         }
         return compareFunc(p1, p2, SORT_FILES_BY_TIME_ASC);
-    } else if (psu::persist_conf::devConf.sortFilesOption == SORT_FILES_BY_SIZE_ASC || psu::persist_conf::devConf.sortFilesOption == SORT_FILES_BY_SIZE_DESC) {
+    } else if (g_sortFilesOption == SORT_FILES_BY_SIZE_ASC || g_sortFilesOption == SORT_FILES_BY_SIZE_DESC) {
         int result = compareFunc(p1, p2, SORT_FILES_BY_NAME_ASC);
         if (result != 0) {
             return result;
@@ -288,12 +573,51 @@ int compareFunc(const void *p1, const void *p2) {
 
 } 
 
-void sort() {
-    qsort(FILE_MANAGER_MEMORY, g_filesCount, sizeof(FileItem), compareFunc);
+static int compareIndexFunc(const void *p1, const void *p2) {
+    return compareFunc(getFileItemAt(*(const uint16_t *)p1), getFileItemAt(*(const uint16_t *)p2));
+}
+
+// Called only from the SD worker, which is the only one changing the file items.
+static void sort() {
+    osMutexWait(g_fileItemsMutexId, osWaitForever);
+
+    int32_t selectedItemIndex = g_selectedFileIndex >= 0 && (uint32_t)g_selectedFileIndex < g_filesCount ? getSortedItemIndex(g_selectedFileIndex) : -1;
+
+    auto sortedIndex = (uint16_t *)g_frontBufferPosition;
+    if (sortedIndex != g_sortedIndex) {
+        for (uint32_t i = 0; i < g_filesCount; i++) {
+            sortedIndex[i] = i;
+        }
+    }
+
+    // option is read once, it can be changed from the GUI thread while sorting
+    g_sortFilesOption = psu::persist_conf::devConf.sortFilesOption;
+    qsort(sortedIndex, g_filesCount, sizeof(uint16_t), compareIndexFunc);
+    g_sortedIndex = sortedIndex;
+
+    // selection stays on the same file
+    if (selectedItemIndex != -1) {
+        for (uint32_t i = 0; i < g_filesCount; i++) {
+            if (sortedIndex[i] == selectedItemIndex) {
+                g_selectedFileIndex = i;
+                break;
+            }
+        }
+    }
+
+    osMutexRelease(g_fileItemsMutexId);
+}
+
+void initMutex() {
+    g_fileItemsMutexId = osMutexCreate(osMutex(g_fileItemsMutex));
 }
 
 void loadDirectory() {
     if (g_state == STATE_LOADING) {
+        // previous directory is still scanned, SD worker will start again when it is done
+        g_reloadRequested = true;
+        g_selectedFileIndex = -1;
+        g_loadingStartTickCount = millis();
         return;
     }
 
@@ -304,32 +628,95 @@ void loadDirectory() {
     g_filesStartPosition = 0;
     g_loadingStartTickCount = millis();
 
-    if (osThreadGetId() != scpi::g_scpiTaskHandle) {
-        using namespace scpi;
-        osMessagePut(g_scpiMessageQueueId, SCPI_QUEUE_MESSAGE(SCPI_QUEUE_MESSAGE_TARGET_NONE, SCPI_QUEUE_MESSAGE_TYPE_FILE_MANAGER_LOAD_DIRECTORY, 0), osWaitForever);
+    if (!psu::sd_worker::isSdCardThread()) {
+        psu::sd_worker::postRequest(psu::sd_worker::REQUEST_FILE_MANAGER_LOAD_DIRECTORY);
     } else {
         doLoadDirectory();
     }
 }
 
-void doLoadDirectory() {
-    if (g_state != STATE_LOADING) {
-        return;
-    }
-
-    g_frontBufferPosition = FILE_MANAGER_MEMORY;
-    g_backBufferPosition = FILE_MANAGER_MEMORY + FILE_MANAGER_MEMORY_SIZE;
+static void loadCurrentDirectory() {
+    char directory[MAX_PATH_LENGTH + 1];
+    strcpy(directory, g_currentDirectory);
 
     int numFiles;
     int err;
-    if (psu::sd_card::catalog(g_currentDirectory, 0, catalogCallback, &numFiles, &err)) {
-        sort();
+
+    uint32_t cachedSignature;
+    if (!isCatalogCacheInvalidated(directory, false) && loadCatalogCache(directory, cachedSignature)) {
+        if (g_reloadRequested) {
+            return;
+        }
+
+        // show cached catalog at once and then check if directory was changed since it was cached
         setFilesStartPosition(g_savedFilesStartPosition);
         g_state = STATE_READY;
+
+        g_catalogSignature = 0;
+        if (!psu::sd_card::catalog(directory, 0, signatureCallback, &numFiles, &err)) {
+            return;
+        }
+
+        if (g_catalogSignature == cachedSignature || g_state != STATE_READY || strcmp(directory, g_currentDirectory) != 0) {
+            return;
+        }
+
+        g_state = STATE_LOADING;
+        g_selectedFileIndex = -1;
+        g_savedFilesStartPosition = g_filesStartPosition;
+        g_filesStartPosition = 0;
+        g_loadingStartTickCount = millis();
+    }
+
+    resetFileItems();
+    g_catalogSignature = 0;
+    isCatalogCacheInvalidated(directory, true);
+
+    g_partial = true;
+    bool result = psu::sd_card::catalog(directory, 0, catalogCallback, &numFiles, &err);
+    g_partial = false;
+
+    if (g_reloadRequested) {
+        return;
+    }
+
+    if (result) {
+        // first page was already shown, so keep its position and selection
+        bool partialShown = g_filesCount >= getFilesPageSize();
+        sort();
+        saveCatalogCache(directory, g_catalogSignature);
+        if (!partialShown) {
+            setFilesStartPosition(g_savedFilesStartPosition);
+        }
+        g_state = STATE_READY;
     } else {
     	g_state = STATE_NOT_PRESENT;
     }
+}
+
+void doLoadDirectory() {
+    if (g_state != STATE_LOADING) {
+        return;
+    }
+
+    while (true) {
+        g_reloadRequested = false;
+        loadCurrentDirectory();
+        if (!g_reloadRequested) {
+            break;
+        }
+
+        g_state = STATE_LOADING;
+        g_filesStartPosition = 0;
+        g_savedFilesStartPosition = 0;
+    }
+}
 
+void doSortFiles() {
+    // if directory is loading, it will be sorted with the new option when it is loaded
+    if (g_state == STATE_READY) {
+        sort();
+    }
 }
 
 void onSdCardMountedChange() {
@@ -400,29 +787,41 @@ SortFilesOption getSortFilesOption() {
 void setSortFilesOption(SortFilesOption sortFilesOption) {
     psu::persist_conf::setSortFilesOption(sortFilesOption);
 
-    sort();
-
     g_filesStartPosition = 0;
 
     if (!g_fileBrowserMode) {
         g_selectedFileIndex = -1;
     }
+
+    if (!psu::sd_worker::isSdCardThread()) {
+        psu::sd_worker::postRequest(psu::sd_worker::REQUEST_FILE_MANAGER_SORT_FILES);
+    } else {
+        doSortFiles();
+    }
 }
 
 const char *getCurrentDirectory() {
     return *g_currentDirectory == 0 ? "/<Root directory>" : g_currentDirectory;
 }
 
-static FileItem *getFileItem(uint32_t fileIndex) {
-    if (g_state != STATE_READY) {
-        return nullptr;
+// First page is shown and can be used while the rest of the directory is scanned.
+static bool isFileListReady() {
+    if (g_state == STATE_READY) {
+        return true;
     }
+    return g_state == STATE_LOADING && g_partial && !g_reloadRequested && g_filesCount >= getFilesPageSize();
+}
 
-    if (fileIndex >= g_filesCount) {
+static FileItem *getFileItem(uint32_t fileIndex) {
+    if (!isFileListReady()) {
         return nullptr;
     }
 
-    return (FileItem *)(FILE_MANAGER_MEMORY + fileIndex * sizeof(FileItem));
+    osMutexWait(g_fileItemsMutexId, osWaitForever);
+    FileItem *fileItem = fileIndex < g_filesCount ? getFileItemAt(getSortedItemIndex(fileIndex)) : nullptr;
+    osMutexRelease(g_fileItemsMutexId);
+
+    return fileItem;
 }
 
 State getState() {
@@ -432,6 +831,9 @@ State getState() {
     }
 
     if (g_state == STATE_LOADING) {
+        if (isFileListReady()) {
+            return STATE_READY;
+        }
         if (millis() - g_loadingStartTickCount < 1000) {
             return STATE_STARTING; // during 1st second of loading
         }
@@ -450,7 +852,7 @@ bool isScriptsDirectory() {
 }
 
 void goToParentDirectory() {
-    if (g_state != STATE_READY) {
+    if (!isFileListReady()) {
         return;
     }
 
@@ -598,17 +1000,13 @@ bool isFileSelected(uint32_t fileIndex) {
 }
 
 bool isSelectFileActionEnabled(uint32_t fileIndex) {
-    return fileIndex < g_filesCount;
+    return isFileListReady() && fileIndex < g_filesCount;
 }
 
 void selectFile(uint32_t fileIndex) {
-    if (g_state != STATE_READY) {
-        return;
-    }
-
-    if (fileIndex < g_filesCount) {
-        auto fileItem = getFileItem(fileIndex);
-        if (fileItem && fileItem->type == FILE_TYPE_DIRECTORY) {
+    auto fileItem = getFileItem(fileIndex);
+    if (fileItem) {
+        if (fileItem->type == FILE_TYPE_DIRECTORY) {
             if (strlen(g_currentDirectory) + 1 + strlen(fileItem->name) <= MAX_PATH_LENGTH) {
                 strcat(g_currentDirectory, "/");
                 strcat(g_currentDirectory, fileItem->name);
@@ -689,8 +1087,7 @@ void openFile() {
 
         pushPage(gui::PAGE_ID_IMAGE_VIEW);
 
-        using namespace scpi;
-        osMessagePut(g_scpiMessageQueueId, SCPI_QUEUE_MESSAGE(SCPI_QUEUE_MESSAGE_TARGET_NONE, SCPI_QUEUE_MESSAGE_TYPE_FILE_MANAGER_OPEN_IMAGE_FILE, 0), osWaitForever);
+        psu::sd_worker::postRequest(psu::sd_worker::REQUEST_FILE_MANAGER_OPEN_IMAGE_FILE);
     } else if (fileItem->type == FILE_TYPE_MICROPYTHON) {
         mp::startScript(filePath);
     }
@@ -709,9 +1106,19 @@ void openImageFile() {
         strcat(filePath, "/");
         strcat(filePath, fileItem->name);
 
-        if (!imageDecode(filePath, &g_openedImage)) {
+        uint32_t startTime = micros();
+        bool fromPreviewCache;
+        if (!imageDecode(filePath, &g_openedImage, &fromPreviewCache)) {
             g_imageLoadFailed = true;
-        }            
+            return;
+        }
+
+        uint32_t decodeTime = micros() - startTime;
+        DebugTrace("Image %ux%u %s in %u us\n", (unsigned)g_openedImage.width, (unsigned)g_openedImage.height,
+            fromPreviewCache ? "loaded from preview cache" : "decoded", (unsigned)decodeTime);
+#ifdef DEBUG
+        psu::debug::g_imageDecodeTime.set(decodeTime);
+#endif
     }
 }
 
@@ -787,10 +1194,9 @@ static char g_fileNameWithoutExtension[MAX_PATH_LENGTH + 1];
 void onRenameFileOk(char *fileNameWithoutExtension) {
     strcpy(g_fileNameWithoutExtension, fileNameWithoutExtension);
 
-    if (osThreadGetId() != scpi::g_scpiTaskHandle) {
+    if (!psu::sd_worker::isSdCardThread()) {
         popPage();
-        using namespace scpi;
-        osMessagePut(g_scpiMessageQueueId, SCPI_QUEUE_MESSAGE(SCPI_QUEUE_MESSAGE_TARGET_NONE, SCPI_QUEUE_MESSAGE_TYPE_FILE_MANAGER_RENAME_FILE, 0), osWaitForever);
+        psu::sd_worker::postRequest(psu::sd_worker::REQUEST_FILE_MANAGER_RENAME_FILE);
     } else {
         doRenameFile();
     }
@@ -859,10 +1265,9 @@ bool isDeleteFileEnabled() {
 }
 
 void deleteFile() {
-    if (osThreadGetId() != scpi::g_scpiTaskHandle) {
+    if (!psu::sd_worker::isSdCardThread()) {
         popPage();
-        using namespace scpi;
-        osMessagePut(g_scpiMessageQueueId, SCPI_QUEUE_MESSAGE(SCPI_QUEUE_MESSAGE_TARGET_NONE, SCPI_QUEUE_MESSAGE_TYPE_FILE_MANAGER_DELETE_FILE, 0), osWaitForever);
+        psu::sd_worker::postRequest(psu::sd_worker::REQUEST_FILE_MANAGER_DELETE_FILE);
         return;
     }
 
@@ -1270,6 +1675,15 @@ void action_file_manager_new_file() {
 using namespace gui::file_manager;
 
 void onSdCardFileChangeHook(const char *filePath1, const char *filePath2) {
+    if (isCacheFilePath(filePath1) && !filePath2) {
+        return;
+    }
+
+    invalidateCatalogCache(filePath1);
+    if (filePath2) {
+        invalidateCatalogCache(filePath2);
+    }
+
 	if (g_fileBrowserMode) {
 		return;
 	}
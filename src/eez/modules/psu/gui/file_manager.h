@@ -96,7 +96,11 @@ extern const char *g_fileBrowserTitle;
 bool isSaveDialog();
 void newFile();
 
+// file items are changed in the SD worker and read in the GUI thread
+void initMutex();
+
 void doLoadDirectory();
+void doSortFiles();
 void doRenameFile();
 void onSdCardMountedChange();
 
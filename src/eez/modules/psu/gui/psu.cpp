@@ -25,9 +25,11 @@
 #include <eez/modules/psu/psu.h>
 #include <eez/modules/psu/calibration.h>
 #include <eez/modules/psu/channel_dispatcher.h>
+#include <eez/modules/psu/debug.h>
 #include <eez/modules/psu/devices.h>
 #include <eez/modules/psu/event_queue.h>
 #include <eez/modules/psu/idle.h>
+#include <eez/modules/psu/io_pins.h>
 #include <eez/modules/psu/temperature.h>
 #include <eez/modules/psu/trigger.h>
 #include <eez/modules/psu/dlog_view.h>
@@ -35,6 +37,8 @@
 #include <eez/modules/psu/dlog_view.h>
 #include <eez/modules/psu/sd_card.h>
 
+#include <eez/gui/touch_index.h>
+
 #include <eez/modules/psu/gui/psu.h>
 #include <eez/modules/psu/gui/animations.h>
 #include <eez/modules/psu/gui/edit_mode.h>
@@ -1896,6 +1900,136 @@ void stateManagmentHook() {
 
 ////////////////////////////////////////////////////////////////////////////////
 
+static const int16_t g_trackedChannelDataIds[] = {
+    DATA_ID_CHANNEL_STATUS,
+    DATA_ID_CHANNEL_OUTPUT_STATE,
+    DATA_ID_CHANNEL_IS_CC,
+    DATA_ID_CHANNEL_IS_CV,
+    DATA_ID_CHANNEL_U_SET,
+    DATA_ID_CHANNEL_U_MON,
+    DATA_ID_CHANNEL_U_MON_DAC,
+    DATA_ID_CHANNEL_U_LIMIT,
+    DATA_ID_CHANNEL_U_EDIT,
+    DATA_ID_CHANNEL_I_SET,
+    DATA_ID_CHANNEL_I_MON,
+    DATA_ID_CHANNEL_I_MON_DAC,
+    DATA_ID_CHANNEL_I_LIMIT,
+    DATA_ID_CHANNEL_I_EDIT,
+    DATA_ID_CHANNEL_P_MON,
+    DATA_ID_CHANNEL_DISPLAY_VALUE1,
+    DATA_ID_CHANNEL_DISPLAY_VALUE2
+};
+
+// everything tracked channel data depends on
+struct ChannelDataSnapshot {
+    float uSet;
+    float uMon;
+    float uMonDac;
+    float uLimit;
+    float iSet;
+    float iMon;
+    float iMonDac;
+    float iLimit;
+    float pLimit;
+    uint32_t flags;
+    uint8_t status;
+    uint8_t mode;
+};
+
+struct GlobalDataSnapshot {
+    Cursor focusCursor;
+    int16_t focusDataId;
+    Value focusEditValue;
+    bool isInhibited;
+    uint8_t dlogState;
+    uint8_t couplingType;
+    int activePageId;
+};
+
+static ChannelDataSnapshot g_channelDataSnapshots[CH_MAX];
+static uint32_t g_channelDataChangedTime[CH_MAX];
+static GlobalDataSnapshot g_globalDataSnapshot;
+
+bool isDataTrackedHook(int16_t dataId) {
+    for (unsigned i = 0; i < sizeof(g_trackedChannelDataIds) / sizeof(int16_t); i++) {
+        if (g_trackedChannelDataIds[i] == dataId) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void invalidateChangedDataHook() {
+    using namespace psu;
+
+    GlobalDataSnapshot globalDataSnapshot;
+    globalDataSnapshot.focusCursor = g_focusCursor;
+    globalDataSnapshot.focusDataId = g_focusDataId;
+    globalDataSnapshot.focusEditValue = g_focusEditValue;
+    globalDataSnapshot.isInhibited = io_pins::isInhibited();
+    globalDataSnapshot.dlogState = (uint8_t)dlog_record::getState();
+    globalDataSnapshot.couplingType = (uint8_t)channel_dispatcher::getCouplingType();
+    globalDataSnapshot.activePageId = g_psuAppContext.getActivePageId();
+
+    if (
+        globalDataSnapshot.focusCursor != g_globalDataSnapshot.focusCursor ||
+        globalDataSnapshot.focusDataId != g_globalDataSnapshot.focusDataId ||
+        globalDataSnapshot.focusEditValue != g_globalDataSnapshot.focusEditValue ||
+        globalDataSnapshot.isInhibited != g_globalDataSnapshot.isInhibited ||
+        globalDataSnapshot.dlogState != g_globalDataSnapshot.dlogState ||
+        globalDataSnapshot.couplingType != g_globalDataSnapshot.couplingType ||
+        globalDataSnapshot.activePageId != g_globalDataSnapshot.activePageId
+    ) {
+        g_globalDataSnapshot = globalDataSnapshot;
+        invalidateAllData();
+    }
+
+    uint32_t tickCount = millis();
+
+    for (int i = 0; i < CH_NUM; i++) {
+        Channel &channel = Channel::get(i);
+
+        ChannelDataSnapshot channelDataSnapshot;
+        memset(&channelDataSnapshot, 0, sizeof(ChannelDataSnapshot));
+        channelDataSnapshot.uSet = channel.u.set;
+        channelDataSnapshot.uMon = channel.u.mon_last;
+        channelDataSnapshot.uMonDac = channel.u.mon_dac_last;
+        channelDataSnapshot.uLimit = channel.u.limit;
+        channelDataSnapshot.iSet = channel.i.set;
+        channelDataSnapshot.iMon = channel.i.mon_last;
+        channelDataSnapshot.iMonDac = channel.i.mon_dac_last;
+        channelDataSnapshot.iLimit = channel.i.limit;
+        channelDataSnapshot.pLimit = channel.p_limit;
+        memcpy(&channelDataSnapshot.flags, &channel.flags, sizeof(channelDataSnapshot.flags));
+        channelDataSnapshot.status = channel.isInstalled() ? (channel.isOk() ? 1 : 2) : 0;
+        channelDataSnapshot.mode = (uint8_t)channel.getMode();
+
+        if (memcmp(&channelDataSnapshot, &g_channelDataSnapshots[i], sizeof(ChannelDataSnapshot)) != 0) {
+            memcpy(&g_channelDataSnapshots[i], &channelDataSnapshot, sizeof(ChannelDataSnapshot));
+            g_channelDataChangedTime[i] = tickCount;
+        } else if (tickCount - g_channelDataChangedTime[i] > channel.params.MON_REFRESH_RATE_MS) {
+            // display data widgets can postpone refresh of the changed value for MON_REFRESH_RATE_MS,
+            // so keep channel data invalidated during that period
+            continue;
+        }
+
+        // data is not per cursor, so this invalidates data for all the channels
+        for (unsigned j = 0; j < sizeof(g_trackedChannelDataIds) / sizeof(int16_t); j++) {
+            invalidateData(g_trackedChannelDataIds[j]);
+        }
+    }
+
+#ifdef DEBUG
+    if (globalDataSnapshot.activePageId == PAGE_ID_MAIN) {
+        psu::debug::g_guiWidgetsVisited.set(getNumWidgetsVisited());
+        psu::debug::g_guiWidgetsRetained.set(getNumWidgetsRetained());
+    }
+    psu::debug::g_guiRetainedMismatches.set(getNumRetainedMismatches());
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 using namespace eez::psu::gui;
 
 static EventQueuePage g_EventQueuePage;
@@ -2146,6 +2280,8 @@ void onGuiQueueMessageHook(uint8_t type, int16_t param) {
         g_psuAppContext.doShowAsyncOperationInProgress();
     } else if (type == GUI_QUEUE_MESSAGE_TYPE_HIDE_ASYNC_OPERATION_IN_PROGRESS) {
         g_psuAppContext.doHideAsyncOperationInProgress();
+    } else if (type == GUI_QUEUE_MESSAGE_TYPE_TOUCH_INDEX_BENCHMARK) {
+        eez::gui::touch_index::benchmark(&g_psuAppContext, param);
     }
 }
 
@@ -28,6 +28,7 @@
 
 #include <eez/modules/psu/psu.h>
 #include <eez/modules/psu/channel_dispatcher.h>
+#include <eez/modules/psu/sd_worker.h>
 #include <eez/modules/psu/list_program.h>
 #include <eez/modules/psu/trigger.h>
 #include <eez/modules/psu/sd_card.h>
@@ -235,6 +236,8 @@ bool loadList(
 #endif
 
     for (int i = 0; i < MAX_LIST_LENGTH; ++i) {
+        sd_worker::writeDlogIfDue();
+
         sd_card::matchZeroOrMoreSpaces(file);
         if (!file.available() || file.peek() == '`') {
             break;
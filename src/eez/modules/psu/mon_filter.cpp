@@ -0,0 +1,143 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2015-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <eez/debug.h>
+#include <eez/system.h>
+
+#include <eez/modules/psu/psu.h>
+#include <eez/modules/psu/mon_filter.h>
+
+namespace eez {
+namespace psu {
+
+const MonFilterConf g_defaultMonFilterConf[NUM_MON_TAPS] = {
+    { 1, 1, 0 },                        // MON_TAP_FAST, every sample as it is
+    { NUM_ADC_AVERAGING_VALUES, 1, 0 }, // MON_TAP_DISPLAY
+    { 1, 1, 0 }                         // MON_TAP_DLOG
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+void MonFilter::reset() {
+    length = 0;
+}
+
+bool MonFilter::addSample(const MonFilterConf &conf, float sample) {
+    if (length != conf.length) {
+        // first sample after the reset or conf change fills the whole window
+        length = conf.length;
+        index = 0;
+        decimationCounter = 0;
+        for (int i = 0; i < length; i++) {
+            arr[i] = sample;
+        }
+        total = length * sample;
+        iir = sample;
+        value = sample;
+        return true;
+    }
+
+    total += sample - arr[index];
+    arr[index] = sample;
+    if (++index == length) {
+        index = 0;
+        // once per window the sum is calculated again, so the rounding errors of
+        // the running sum are not accumulated
+        total = 0;
+        for (int i = 0; i < length; i++) {
+            total += arr[i];
+        }
+    }
+
+    if (++decimationCounter < conf.decimation) {
+        return false;
+    }
+    decimationCounter = 0;
+
+    float boxcar = total / length;
+    if (conf.iirCoefficient > 0) {
+        iir += conf.iirCoefficient * (boxcar - iir);
+        value = iir;
+    } else {
+        value = boxcar;
+    }
+
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool isMonFilterConfValid(const MonFilterConf &conf) {
+    return conf.length >= 1 && conf.length <= MON_FILTER_MAX_LENGTH &&
+        conf.decimation >= 1 && conf.decimation <= MON_FILTER_MAX_DECIMATION &&
+        conf.iirCoefficient >= 0 && conf.iirCoefficient <= 1.0f;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static const char *g_monTapNames[NUM_MON_TAPS] = { "FAST", "DISPLAY", "DLOG" };
+
+void benchmarkMonFilters(const MonFilterConf *conf, uint32_t numSamples) {
+    static MonFilter filters[NUM_MON_TAPS];
+
+    for (int tap = 0; tap < NUM_MON_TAPS; tap++) {
+        filters[tap].reset();
+    }
+
+    volatile float sink = 0;
+
+    uint32_t start = micros();
+    for (uint32_t i = 0; i < numSamples; i++) {
+        float sample = (i & 0xFF) * 0.01f;
+        for (int tap = 0; tap < NUM_MON_TAPS; tap++) {
+            filters[tap].addSample(conf[tap], sample);
+        }
+        sink = filters[MON_TAP_DISPLAY].value;
+    }
+    uint32_t duration = micros() - start;
+    (void)sink;
+
+    DebugTrace("Mon filters: %u samples in %u us, %u ns per sample\n", (unsigned)numSamples, (unsigned)duration,
+        (unsigned)(numSamples ? (uint64_t)duration * 1000 / numSamples : 0));
+
+    // step response, number of samples from the 0 to 1 step until the output reaches 90% and 99%
+    for (int tap = 0; tap < NUM_MON_TAPS; tap++) {
+        MonFilter &filter = filters[tap];
+        filter.reset();
+        filter.addSample(conf[tap], 0);
+
+        int t90 = -1;
+        int t99 = -1;
+        for (int i = 1; i <= 10000 && t99 == -1; i++) {
+            filter.addSample(conf[tap], 1.0f);
+            if (t90 == -1 && filter.value >= 0.9f) {
+                t90 = i;
+            }
+            if (filter.value >= 0.99f) {
+                t99 = i;
+            }
+        }
+
+        DebugTrace("Mon filter %s: length %d, decimation %d, IIR %d/1000, step 90%% after %d, 99%% after %d samples\n",
+            g_monTapNames[tap], (int)conf[tap].length, (int)conf[tap].decimation,
+            (int)(conf[tap].iirCoefficient * 1000), t90, t99);
+    }
+}
+
+} // namespace psu
+} // namespace eez
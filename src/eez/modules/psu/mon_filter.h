@@ -0,0 +1,71 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2015-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+namespace eez {
+namespace psu {
+
+/// Every ADC sample of Umon and Imon is fed once to the filter of each tap,
+/// consumers read the tap with the bandwidth they need.
+enum MonTap {
+    MON_TAP_FAST,    // protections, Channel::Value::mon_last
+    MON_TAP_DISPLAY, // GUI and averaged values, Channel::Value::mon
+    MON_TAP_DLOG,    // data logging, Channel::Value::mon_dlog
+    NUM_MON_TAPS
+};
+
+#define MON_FILTER_MAX_LENGTH 32
+#define MON_FILTER_MAX_DECIMATION 255
+
+/// Each channel has its own configuration for every tap, see Channel::monFilterConf.
+struct MonFilterConf {
+    uint16_t length;      // boxcar length in samples, 1 - MON_FILTER_MAX_LENGTH
+    uint16_t decimation;  // output is updated on every decimation-th sample
+    float iirCoefficient; // 0 - off, else out += k * (boxcar - out) on every output
+};
+
+/// Boxcar (moving average) with the running sum, decimation and optional
+/// first order IIR after the boxcar.
+struct MonFilter {
+    float value; // last output
+
+    uint8_t length; // length at the last reset, filter is restarted when conf is changed
+    uint8_t index;
+    uint8_t decimationCounter;
+    float arr[MON_FILTER_MAX_LENGTH];
+    float total;
+    float iir;
+
+    void reset();
+
+    /// Returns true if the output is updated.
+    bool addSample(const MonFilterConf &conf, float sample);
+};
+
+extern const MonFilterConf g_defaultMonFilterConf[NUM_MON_TAPS];
+
+bool isMonFilterConfValid(const MonFilterConf &conf);
+
+/// Traces CPU time per sample for the filter bank and the step response of every tap.
+void benchmarkMonFilters(const MonFilterConf *conf, uint32_t numSamples);
+
+} // namespace psu
+} // namespace eez
@@ -20,8 +20,10 @@
 #include <ctype.h> 
 
 #include <eez/system.h>
+#include <eez/util.h>
 
 #include <eez/modules/psu/psu.h>
+#include <eez/modules/psu/debug.h>
 
 #include <eez/modules/mcu/eeprom.h>
 #include <eez/modules/bp3c/eeprom.h>
@@ -76,25 +78,22 @@ const DeviceConfiguration &devConf = g_devConf;
 DeviceConfiguration g_defaultDevConf;
 DeviceConfiguration g_savedDevConf;
 
+// Blocks are only read, if there is no journal yet.
 struct DevConfBlock {
     uint16_t end;
     uint16_t version;
-    bool dirty;
-    unsigned numSaveErrors;
-    uint32_t minTickCountsBetweenSaves;
-    uint32_t lastSaveTickCount;
 };
 
 static DevConfBlock g_devConfBlocks[] = {
-    { offsetof(DeviceConfiguration, dateYear), 1, false, 0, 0, 0 },
-    { offsetof(DeviceConfiguration, profileAutoRecallLocation), 1, false, 0, 0, 0 },
-    { offsetof(DeviceConfiguration, startOfBlock4), 1, false, 0, 0, 0 },
-    { offsetof(DeviceConfiguration, triggerSource), 1, false, 0, 0, 0 },
-    { offsetof(DeviceConfiguration, ytGraphUpdateMethod), 1, false, 0, 0, 0 },
-    { offsetof(DeviceConfiguration, userSwitchAction), 1, false, 0, 60 * 1000, 0 },
-    { offsetof(DeviceConfiguration, ethernetHostName), 1, false, 0, 0, 0 },
-    { offsetof(DeviceConfiguration, fanMode), 1, false, 0, 0, 0 },
-    { sizeof(DeviceConfiguration), 1, false, 0, 0, 0 },
+    { offsetof(DeviceConfiguration, dateYear), 1 },
+    { offsetof(DeviceConfiguration, profileAutoRecallLocation), 1 },
+    { offsetof(DeviceConfiguration, startOfBlock4), 1 },
+    { offsetof(DeviceConfiguration, triggerSource), 1 },
+    { offsetof(DeviceConfiguration, ytGraphUpdateMethod), 1 },
+    { offsetof(DeviceConfiguration, userSwitchAction), 1 },
+    { offsetof(DeviceConfiguration, ethernetHostName), 1 },
+    { offsetof(DeviceConfiguration, fanMode), 1 },
+    { sizeof(DeviceConfiguration), 1 },
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -332,14 +331,6 @@ bool checkBlock(const BlockHeader *block, uint16_t size, uint16_t version) {
 
 ////////////////////////////////////////////////////////////////////////////////
 
-static bool save(BlockHeader *block, uint16_t size, uint16_t address, uint16_t version) {
-    block->version = version;
-    block->checksum = calcChecksum(block, size);
-    return confWrite((const uint8_t *)block, size, address);
-}
-
-////////////////////////////////////////////////////////////////////////////////
-
 static bool moduleSave(int slotIndex, BlockHeader *block, uint16_t size, uint16_t address, uint16_t version) {
     block->version = version;
     block->checksum = calcChecksum(block, size);
@@ -350,43 +341,363 @@ static bool moduleSave(int slotIndex, BlockHeader *block, uint16_t size, uint16_
 
 static const unsigned PERSISTENT_STORAGE_ADDRESS_ALIGNMENT = 32;
 
-void init() {
-    initDefaultDevConf();
+////////////////////////////////////////////////////////////////////////////////
+
+// Device configuration is saved to the journal in the MCU EEPROM: ring of pages with
+// the records of changed devConf bytes, i.e. (offset, size, data). Generation is the snapshot
+// of the whole devConf, ended with the commit record, followed by the records appended after.
+// When generation gets too big, a new one is written after it (compaction), so the current
+// generation stays intact until the new one is committed.
+
+static const uint16_t JOURNAL_ADDRESS = 4096;
+static const uint16_t JOURNAL_PAGE_SIZE = mcu::eeprom::EEPROM_PAGE_SIZE;
+static const uint32_t JOURNAL_NUM_PAGES = 64;
+static const uint32_t JOURNAL_MAX_GENERATION_PAGES = JOURNAL_NUM_PAGES / 2;
+
+static const uint16_t JOURNAL_COMMIT_RECORD_OFFSET = 0xFFFF;
+
+// changes are written when devConf is not changed for this long, i.e. slider drag is written once
+#define CONF_JOURNAL_FLUSH_DELAY_MS 1000
+#define CONF_JOURNAL_MAX_FLUSH_DELAY_MS 10000
+
+struct JournalPageHeader {
+    uint32_t checksum;
+    uint32_t sequence;
+    uint32_t generationStart; // sequence of the first page of the generation
+};
+
+struct JournalRecordHeader {
+    uint32_t checksum; // also includes page sequence, so stale records from the previous ring cycle are invalid
+    uint16_t offset;
+    uint16_t size;
+};
+
+static const uint16_t JOURNAL_MAX_RECORD_DATA_SIZE = JOURNAL_PAGE_SIZE - sizeof(JournalPageHeader) - sizeof(JournalRecordHeader);
+
+struct Journal {
+    bool valid;
+    uint32_t sequence; // of the last written page
+    uint32_t generationStart;
+    uint16_t pageOffset; // write position in the last written page
+    unsigned numSaveErrors;
+};
+
+static Journal g_journal;
+
+// devConf not yet written to the journal is checked against this to detect when it stops changing
+static uint32_t g_pendingChecksum;
+static bool g_isPending;
+static uint32_t g_pendingStartTickCount;
+static uint32_t g_pendingChangeTickCount;
+
+static uint16_t getJournalPageAddress(uint32_t sequence) {
+    return JOURNAL_ADDRESS + (sequence % JOURNAL_NUM_PAGES) * JOURNAL_PAGE_SIZE;
+}
+
+static uint32_t calcJournalPageChecksum(const JournalPageHeader *header) {
+    return crc32((const uint8_t *)header + sizeof(uint32_t), sizeof(JournalPageHeader) - sizeof(uint32_t));
+}
+
+static uint32_t calcJournalRecordChecksum(uint32_t sequence, const JournalRecordHeader &record, const uint8_t *data) {
+    uint8_t buffer[sizeof(uint32_t) + JOURNAL_PAGE_SIZE];
+    uint16_t size = 0;
+    memcpy(buffer + size, &sequence, sizeof(uint32_t));
+    size += sizeof(uint32_t);
+    memcpy(buffer + size, &record.offset, sizeof(uint16_t));
+    size += sizeof(uint16_t);
+    memcpy(buffer + size, &record.size, sizeof(uint16_t));
+    size += sizeof(uint16_t);
+    if (record.size > 0) {
+        memcpy(buffer + size, data, record.size);
+        size += record.size;
+    }
+    return crc32(buffer, size);
+}
+
+static bool readJournalPage(uint32_t sequence, uint8_t *page, JournalPageHeader &header) {
+    if (!confRead(page, JOURNAL_PAGE_SIZE, getJournalPageAddress(sequence), -1)) {
+        return false;
+    }
+    memcpy(&header, page, sizeof(JournalPageHeader));
+    return header.checksum == calcJournalPageChecksum(&header) && header.sequence == sequence;
+}
+
+// Applies the page records to conf, returns the write position after the last valid record.
+static uint16_t replayJournalPage(uint32_t sequence, const uint8_t *page, DeviceConfiguration &conf, bool &committed) {
+    uint16_t pageOffset = sizeof(JournalPageHeader);
+
+    while (pageOffset + sizeof(JournalRecordHeader) <= JOURNAL_PAGE_SIZE) {
+        // records are not aligned
+        JournalRecordHeader record;
+        memcpy(&record, page + pageOffset, sizeof(JournalRecordHeader));
+        const uint8_t *data = page + pageOffset + sizeof(JournalRecordHeader);
+
+        if (
+            pageOffset + sizeof(JournalRecordHeader) + record.size > JOURNAL_PAGE_SIZE ||
+            record.checksum != calcJournalRecordChecksum(sequence, record, data)
+        ) {
+            break;
+        }
+
+        if (record.offset == JOURNAL_COMMIT_RECORD_OFFSET) {
+            committed = true;
+        } else if (record.offset + record.size <= sizeof(DeviceConfiguration)) {
+            memcpy((uint8_t *)&conf + record.offset, data, record.size);
+        }
+
+        pageOffset += sizeof(JournalRecordHeader) + record.size;
+    }
+
+    return pageOffset;
+}
+
+static bool replayJournalGeneration(uint32_t lastSequence, DeviceConfiguration &conf) {
+    uint8_t page[JOURNAL_PAGE_SIZE];
+    JournalPageHeader header;
+
+    if (!readJournalPage(lastSequence, page, header)) {
+        return false;
+    }
+
+    uint32_t generationStart = header.generationStart;
+    if (generationStart > lastSequence || lastSequence - generationStart >= JOURNAL_MAX_GENERATION_PAGES) {
+        return false;
+    }
+
+    // bytes not in the snapshot (devConf got bigger) are left at default
+    memcpy(&conf, &g_defaultDevConf, sizeof(DeviceConfiguration));
+
+    bool committed = false;
+    uint16_t pageOffset = 0;
+    for (uint32_t sequence = generationStart; sequence <= lastSequence; sequence++) {
+        if (!readJournalPage(sequence, page, header)) {
+            return false;
+        }
+        pageOffset = replayJournalPage(sequence, page, conf, committed);
+    }
+
+    if (!committed) {
+        return false;
+    }
+
+    g_journal.valid = true;
+    g_journal.sequence = lastSequence;
+    g_journal.generationStart = generationStart;
+    g_journal.pageOffset = pageOffset;
+
+    return true;
+}
+
+static bool loadJournal(DeviceConfiguration &conf) {
+    g_journal.valid = false;
+    g_journal.sequence = 0;
+
+    // find the last written page
+    bool found = false;
+    for (uint32_t i = 0; i < JOURNAL_NUM_PAGES; i++) {
+        JournalPageHeader header;
+        if (
+            confRead((uint8_t *)&header, sizeof(JournalPageHeader), JOURNAL_ADDRESS + i * JOURNAL_PAGE_SIZE, -1) &&
+            header.checksum == calcJournalPageChecksum(&header) &&
+            header.sequence % JOURNAL_NUM_PAGES == i &&
+            (!found || header.sequence > g_journal.sequence)
+        ) {
+            g_journal.sequence = header.sequence;
+            found = true;
+        }
+    }
+
+    if (!found) {
+        return false;
+    }
+
+    uint32_t lastSequence = g_journal.sequence;
+
+    if (replayJournalGeneration(lastSequence, conf)) {
+        return true;
+    }
+
+    // last generation is not committed, try the previous one
+    uint8_t page[JOURNAL_PAGE_SIZE];
+    JournalPageHeader header;
+    if (readJournalPage(lastSequence, page, header)) {
+        uint32_t generationStart = header.generationStart;
+        if (generationStart > 0 && generationStart <= lastSequence && replayJournalGeneration(generationStart - 1, conf)) {
+            // pages of the broken generation must not become part of this generation
+            g_journal.valid = false;
+            g_journal.sequence = lastSequence;
+            return true;
+        }
+    }
+
+    g_journal.sequence = lastSequence;
+    return false;
+}
+
+static uint32_t g_journalBytesWritten;
+
+// Returns false if record doesn't fit in the current generation or on write error.
+static bool appendJournalRecord(uint16_t offset, const uint8_t *data, uint16_t size) {
+    uint8_t buffer[JOURNAL_PAGE_SIZE];
+    uint16_t bufferSize = 0;
+
+    uint16_t recordSize = sizeof(JournalRecordHeader) + size;
 
-    //bool storageInitialized = true;
+    uint32_t sequence = g_journal.sequence;
+    uint16_t pageOffset = g_journal.pageOffset;
 
-    uint8_t blockData[sizeof(BlockHeader) + sizeof(DeviceConfiguration)];
-    uint16_t blockAddress = PERSIST_CONF_DEV_CONF_ADDRESS;
+    if (pageOffset + recordSize > JOURNAL_PAGE_SIZE) {
+        sequence++;
+        if (sequence - g_journal.generationStart >= JOURNAL_MAX_GENERATION_PAGES) {
+            return false;
+        }
+
+        JournalPageHeader header;
+        header.sequence = sequence;
+        header.generationStart = g_journal.generationStart;
+        header.checksum = calcJournalPageChecksum(&header);
+        memcpy(buffer, &header, sizeof(JournalPageHeader));
+
+        pageOffset = 0;
+        bufferSize = sizeof(JournalPageHeader);
+    }
+
+    JournalRecordHeader record;
+    record.offset = offset;
+    record.size = size;
+    record.checksum = calcJournalRecordChecksum(sequence, record, data);
+    memcpy(buffer + bufferSize, &record, sizeof(JournalRecordHeader));
+    if (size > 0) {
+        memcpy(buffer + bufferSize + sizeof(JournalRecordHeader), data, size);
+    }
+    bufferSize += recordSize;
+
+    if (!confWrite(buffer, bufferSize, getJournalPageAddress(sequence) + pageOffset)) {
+        return false;
+    }
+
+    g_journalBytesWritten += bufferSize;
+
+    g_journal.sequence = sequence;
+    g_journal.pageOffset = pageOffset + bufferSize;
+
+    return true;
+}
+
+// Writes only the bytes of conf that differ from savedConf. Nearby changes are merged into
+// one record, if the gap is smaller than the record header.
+static bool appendJournalChanges(const DeviceConfiguration &conf, const DeviceConfiguration &savedConf) {
+    const uint8_t *p = (const uint8_t *)&conf;
+    const uint8_t *q = (const uint8_t *)&savedConf;
+
+    uint16_t offset = 0;
+    while (offset < sizeof(DeviceConfiguration)) {
+        if (p[offset] == q[offset]) {
+            offset++;
+            continue;
+        }
+
+        uint16_t end = offset + 1;
+        for (uint16_t i = end; i < sizeof(DeviceConfiguration) && i - offset < JOURNAL_MAX_RECORD_DATA_SIZE && (unsigned)(i - end) < sizeof(JournalRecordHeader); i++) {
+            if (p[i] != q[i]) {
+                end = i + 1;
+            }
+        }
+
+        if (!appendJournalRecord(offset, p + offset, end - offset)) {
+            return false;
+        }
+
+        offset = end;
+    }
+
+    return true;
+}
+
+static bool writeJournalSnapshot(const DeviceConfiguration &conf) {
+    g_journal.valid = false;
+
+    // new generation starts with the new page
+    g_journal.generationStart = g_journal.sequence + 1;
+    g_journal.pageOffset = JOURNAL_PAGE_SIZE;
+
+    for (uint16_t offset = 0; offset < sizeof(DeviceConfiguration); offset += JOURNAL_MAX_RECORD_DATA_SIZE) {
+        uint16_t size = MIN(JOURNAL_MAX_RECORD_DATA_SIZE, sizeof(DeviceConfiguration) - offset);
+        if (!appendJournalRecord(offset, (const uint8_t *)&conf + offset, size)) {
+            return false;
+        }
+    }
+
+    if (!appendJournalRecord(JOURNAL_COMMIT_RECORD_OFFSET, nullptr, 0)) {
+        return false;
+    }
+
+    g_journal.valid = true;
+
+    return true;
+}
+
+#ifdef DEBUG
+static uint32_t g_blockRewriteBytes;
+
+// what the block rewrite would write for the same change (each block is saved twice)
+static uint32_t getBlockRewriteSize(const DeviceConfiguration &conf, const DeviceConfiguration &savedConf) {
+    uint32_t size = 0;
     uint16_t blockStart = 0;
     for (unsigned i = 0; i < sizeof(g_devConfBlocks) / sizeof(DevConfBlock); i++) {
         uint16_t blockEnd = g_devConfBlocks[i].end;
         uint16_t blockSize = blockEnd - blockStart;
-        uint16_t blockStorageSize = PERSISTENT_STORAGE_ADDRESS_ALIGNMENT * ((sizeof(BlockHeader) + blockSize + PERSISTENT_STORAGE_ADDRESS_ALIGNMENT - 1) / PERSISTENT_STORAGE_ADDRESS_ALIGNMENT);
-
-        if (!confRead(blockData, blockStorageSize, blockAddress, g_devConfBlocks[i].version)) {
-            if (!confRead(blockData, blockStorageSize, blockAddress + blockStorageSize, g_devConfBlocks[i].version)) {
-                //if (i == 0) {
-                //    // if we can't read first block at both locations we assume storage is not initialized
-                //    storageInitialized = false;
-                //} else if (storageInitialized) {
-                //    // generate error only if storage is intialized and we failed to read block at both locations
-                //    pushEvent(event_queue::EVENT_ERROR_EEPROM_MCU_CRC_CHECK_ERROR);
-                //}
-
-                // use default g_devConf data for this block
-                memcpy(blockData + sizeof(BlockHeader), (uint8_t *)&g_defaultDevConf + blockStart, blockSize);
-
-                // mark this block dirty, so it will be saved to persistent storage
-                g_devConfBlocks[i].dirty = true;
-            }
+        if (memcmp((const uint8_t *)&conf + blockStart, (const uint8_t *)&savedConf + blockStart, blockSize) != 0) {
+            size += 2 * PERSISTENT_STORAGE_ADDRESS_ALIGNMENT * ((sizeof(BlockHeader) + blockSize + PERSISTENT_STORAGE_ADDRESS_ALIGNMENT - 1) / PERSISTENT_STORAGE_ADDRESS_ALIGNMENT);
         }
+        blockStart = blockEnd;
+    }
+    return size;
+}
+#endif
 
-        // copy this block to g_devConf
-        memcpy((uint8_t *)&g_devConf + blockStart, blockData + sizeof(BlockHeader), blockSize);
-
-        blockAddress += 2 * blockStorageSize;
+// Failed save is reported for each block of the configuration that is not saved,
+// the same as before the journal.
+static void pushSaveErrorEvents(const DeviceConfiguration &conf, const DeviceConfiguration &savedConf, bool wasJournalValid) {
+    uint16_t blockStart = 0;
+    for (unsigned i = 0; i < sizeof(g_devConfBlocks) / sizeof(DevConfBlock); i++) {
+        uint16_t blockEnd = g_devConfBlocks[i].end;
+        if (!wasJournalValid || memcmp((const uint8_t *)&conf + blockStart, (const uint8_t *)&savedConf + blockStart, blockEnd - blockStart) != 0) {
+            event_queue::pushEvent(event_queue::EVENT_ERROR_SAVE_DEV_CONF_BLOCK_0 + i);
+        }
         blockStart = blockEnd;
     }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void init() {
+    initDefaultDevConf();
+
+    if (!loadJournal(g_devConf)) {
+        // journal is not valid, so snapshot will be written on the first tick
+        uint8_t blockData[sizeof(BlockHeader) + sizeof(DeviceConfiguration)];
+        uint16_t blockAddress = PERSIST_CONF_DEV_CONF_ADDRESS;
+        uint16_t blockStart = 0;
+        for (unsigned i = 0; i < sizeof(g_devConfBlocks) / sizeof(DevConfBlock); i++) {
+            uint16_t blockEnd = g_devConfBlocks[i].end;
+            uint16_t blockSize = blockEnd - blockStart;
+            uint16_t blockStorageSize = PERSISTENT_STORAGE_ADDRESS_ALIGNMENT * ((sizeof(BlockHeader) + blockSize + PERSISTENT_STORAGE_ADDRESS_ALIGNMENT - 1) / PERSISTENT_STORAGE_ADDRESS_ALIGNMENT);
+
+            if (!confRead(blockData, blockStorageSize, blockAddress, g_devConfBlocks[i].version)) {
+                if (!confRead(blockData, blockStorageSize, blockAddress + blockStorageSize, g_devConfBlocks[i].version)) {
+                    // use default g_devConf data for this block
+                    memcpy(blockData + sizeof(BlockHeader), (uint8_t *)&g_defaultDevConf + blockStart, blockSize);
+                }
+            }
+
+            // copy this block to g_devConf
+            memcpy((uint8_t *)&g_devConf + blockStart, blockData + sizeof(BlockHeader), blockSize);
+
+            blockAddress += 2 * blockStorageSize;
+            blockStart = blockEnd;
+        }
+    }
 
     // remember this g_devConf to be used to detect when it changes
     memcpy(&g_savedDevConf, &g_devConf, sizeof(DeviceConfiguration));
@@ -405,59 +716,74 @@ void init() {
 }
 
 bool saveAll(bool force) {
-    bool moreDirtyBlocks = false;
+    if (g_journal.numSaveErrors >= CONF_MAX_NUMBER_OF_SAVE_ERRORS_ALLOWED) {
+        return false;
+    }
 
     uint32_t tickCountMillis = millis();
 
-    // write dirty device configuration blocks
     DeviceConfiguration devConf;
     memcpy(&devConf, &g_devConf, sizeof(DeviceConfiguration));
 
-    uint8_t blockData[sizeof(BlockHeader) + sizeof(DeviceConfiguration)];
-    uint16_t blockAddress = PERSIST_CONF_DEV_CONF_ADDRESS;
-    uint16_t blockStart = 0;
-    for (unsigned i = 0; i < sizeof(g_devConfBlocks) / sizeof(DevConfBlock); i++) {
-        uint16_t blockEnd = g_devConfBlocks[i].end;
-        uint16_t blockSize = blockEnd - blockStart;
-        uint16_t blockStorageSize = PERSISTENT_STORAGE_ADDRESS_ALIGNMENT * ((sizeof(BlockHeader) + blockSize + PERSISTENT_STORAGE_ADDRESS_ALIGNMENT - 1) / PERSISTENT_STORAGE_ADDRESS_ALIGNMENT);
+    if (g_journal.valid && memcmp(&devConf, &g_savedDevConf, sizeof(DeviceConfiguration)) == 0) {
+        g_isPending = false;
+        return false;
+    }
 
-        if (!g_devConfBlocks[i].dirty) {
-            // compare devConf with last saved g_devConf
-            g_devConfBlocks[i].dirty = memcmp((uint8_t *)&devConf + blockStart, (uint8_t *)&g_savedDevConf + blockStart, blockSize) != 0;
+    if (!force) {
+        uint32_t checksum = crc32((const uint8_t *)&devConf, sizeof(DeviceConfiguration));
+        if (!g_isPending) {
+            g_isPending = true;
+            g_pendingStartTickCount = tickCountMillis;
+            g_pendingChangeTickCount = tickCountMillis;
+            g_pendingChecksum = checksum;
+        } else if (checksum != g_pendingChecksum) {
+            g_pendingChangeTickCount = tickCountMillis;
+            g_pendingChecksum = checksum;
         }
 
         if (
-            g_devConfBlocks[i].dirty && 
-            g_devConfBlocks[i].numSaveErrors < CONF_MAX_NUMBER_OF_SAVE_ERRORS_ALLOWED && 
-			(force || (tickCountMillis - g_devConfBlocks[i].lastSaveTickCount >= g_devConfBlocks[i].minTickCountsBetweenSaves))
+            tickCountMillis - g_pendingChangeTickCount < CONF_JOURNAL_FLUSH_DELAY_MS &&
+            tickCountMillis - g_pendingStartTickCount < CONF_JOURNAL_MAX_FLUSH_DELAY_MS
         ) {
-        	memset(blockData, 0, blockStorageSize);
-            memcpy(blockData + sizeof(BlockHeader), (uint8_t *)&devConf + blockStart, blockSize);
-
-        	bool saved = save((BlockHeader *)blockData, blockStorageSize, blockAddress, g_devConfBlocks[i].version);
-        	saved |= save((BlockHeader *)blockData, blockStorageSize, blockAddress + blockStorageSize, g_devConfBlocks[i].version);
-
-            if (saved) {
-                memcpy((uint8_t *)&g_savedDevConf + blockStart, (uint8_t *)&devConf + blockStart, blockSize);
-                g_devConfBlocks[i].dirty = false;
-                g_devConfBlocks[i].numSaveErrors = 0;
-                g_devConfBlocks[i].lastSaveTickCount = tickCountMillis;
-            } else {
-                if (++g_devConfBlocks[i].numSaveErrors == CONF_MAX_NUMBER_OF_SAVE_ERRORS_ALLOWED) {
-                    event_queue::pushEvent(event_queue::EVENT_ERROR_SAVE_DEV_CONF_BLOCK_0 + i);
-                } else {
-                    moreDirtyBlocks = true;
-                }
-            }
+            return false;
         }
+    }
 
-        blockAddress += 2 * blockStorageSize;
-        blockStart = blockEnd;
+#ifdef DEBUG
+    uint32_t journalBytesWritten = g_journalBytesWritten;
+#endif
+
+    // compaction if the change doesn't fit in the current generation
+    bool wasJournalValid = g_journal.valid;
+    bool saved = (g_journal.valid && appendJournalChanges(devConf, g_savedDevConf)) || writeJournalSnapshot(devConf);
+
+    if (!saved) {
+        if (++g_journal.numSaveErrors == CONF_MAX_NUMBER_OF_SAVE_ERRORS_ALLOWED) {
+            pushSaveErrorEvents(devConf, g_savedDevConf, wasJournalValid);
+            return false;
+        }
+        return true;
     }
 
-    return moreDirtyBlocks;
+#ifdef DEBUG
+    uint32_t blockRewriteSize = getBlockRewriteSize(devConf, g_savedDevConf);
+    g_blockRewriteBytes += blockRewriteSize;
+    debug::g_confJournalBytes.set(g_journalBytesWritten);
+    debug::g_confBlockBytes.set(g_blockRewriteBytes);
+    DebugTrace("Device configuration saved: %u bytes, block rewrite would be %u bytes\n",
+        (unsigned)(g_journalBytesWritten - journalBytesWritten), (unsigned)blockRewriteSize);
+#endif
+
+    memcpy(&g_savedDevConf, &devConf, sizeof(DeviceConfiguration));
+    g_isPending = false;
+    g_journal.numSaveErrors = 0;
+
+    return false;
 }
 
+// Called from the idle branch of the SCPI thread main loop, i.e. only when there is no
+// pending message, which is also where the other MCU EEPROM writes (on-time counters) are done.
 void tick() {
     saveAll(false);
 }
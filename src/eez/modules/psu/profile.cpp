@@ -17,8 +17,12 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
 
+#include <eez/debug.h>
 #include <eez/file_type.h>
+#include <eez/number.h>
 
 #include <eez/scpi/scpi.h>
 
@@ -26,6 +30,7 @@
 #include <eez/modules/psu/calibration.h>
 #include <eez/modules/psu/channel_dispatcher.h>
 #include <eez/modules/psu/datetime.h>
+#include <eez/modules/psu/debug.h>
 #include <eez/modules/psu/event_queue.h>
 #include <eez/modules/psu/idle.h>
 #include <eez/modules/psu/list_program.h>
@@ -44,6 +49,10 @@
 
 #define CONF_PROFILE_SAVE_TIMEOUT_MS 2000
 
+// first byte is 0, so binary profile can't be mistaken for the text one
+#define BINARY_PROFILE_MAGIC 0x50425A00
+#define BINARY_PROFILE_VERSION 1
+
 namespace eez {
 namespace psu {
 namespace profile {
@@ -66,6 +75,50 @@ static profile::Parameters g_profilesCache[NUM_PROFILE_LOCATIONS];
 static List g_listsProfile0[CH_MAX];
 static List g_listsProfile10[CH_MAX];
 
+// Profile 0 file is the last full (compacted) save followed by the journal of changed records
+// appended by autosave. Journal is appended only if g_profilesCache[0] and g_listsProfile0 are
+// known to be the same as the file content.
+struct Profile0Journal {
+    bool valid;
+    uint32_t fileSize;
+    uint32_t snapshotSize;
+};
+static Profile0Journal g_profile0Journal;
+
+// Index has the name of each location, so mount doesn't have to open every profile file.
+// Entry is verified against the size and modification time of the profile file
+// by the background request after mount. Zero size or time means "unknown".
+
+#define PROFILE_INDEX_MAGIC 0x58444950 // "PIDX"
+#define PROFILE_INDEX_VERSION 1
+
+struct ProfileIndexEntry {
+    uint8_t isValid;
+    uint8_t reserved[3];
+    uint32_t fileSize;
+    uint32_t dateTime;
+    char name[PROFILE_NAME_MAX_LENGTH + 1];
+};
+
+struct ProfileIndex {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t numLocations;
+    ProfileIndexEntry entries[NUM_PROFILE_LOCATIONS];
+    uint32_t checksum;
+};
+
+static ProfileIndex g_profileIndex;
+
+// index is changed from the SCPI thread (save, rename and delete) and from the SD worker (verify)
+osMutexId(g_profileIndexMutexId);
+osMutexDef(g_profileIndexMutex);
+
+enum ProfileFormat {
+    PROFILE_FORMAT_TEXT,
+    PROFILE_FORMAT_BINARY
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 
 static void loadProfileName(int location);
@@ -78,7 +131,8 @@ static void resetProfileToDefaults(Parameters &profile);
 static void saveState(Parameters &profile, List *lists);
 static bool recallState(Parameters &profile, List *lists, int recallOptions, int *err);
 
-static bool saveProfileToFile(const char *filePath, Parameters &profile, List *lists, bool showProgress, int *err);
+static bool saveProfileToFile(const char *filePath, Parameters &profile, List *lists, ProfileFormat format, bool showProgress, int *err, uint32_t *fileSize = nullptr);
+static bool appendProfileToFile(const char *filePath, Parameters &profile, List *lists, const Parameters &previous, const bool *listChanged, uint32_t &fileSize);
 static void saveStateToProfile0(bool merge);
 
 enum {
@@ -92,9 +146,17 @@ static bool doRecallFromLastLocation(int *err);
 static bool isTickSaveAllowed();
 static bool isAutoSaveAllowed();
 static bool isProfile0Dirty();
+static bool isProfile0ListDirty(int channelIndex);
+
+static bool loadIndex();
+static void updateIndex(int location);
 
 ////////////////////////////////////////////////////////////////////////////////
 
+void initIndexMutex() {
+    g_profileIndexMutexId = osMutexCreate(osMutex(g_profileIndexMutex));
+}
+
 void init() {
 	onAfterSdCardMounted();
 }
@@ -110,8 +172,30 @@ void tick() {
 }
 
 void onAfterSdCardMounted() {
-    for (int profileIndex = 1; profileIndex < NUM_PROFILE_LOCATIONS; profileIndex++) {
-		loadProfileName(profileIndex);
+    osMutexWait(g_profileIndexMutexId, osWaitForever);
+
+    if (!loadIndex()) {
+        // all names are loaded by verifyIndex
+        memset(&g_profileIndex, 0, sizeof(ProfileIndex));
+    }
+
+    for (int location = 1; location < NUM_PROFILE_LOCATIONS; location++) {
+        auto &entry = g_profileIndex.entries[location];
+        auto &profile = g_profilesCache[location];
+
+        profile.flags.isValid = entry.isValid;
+        memcpy(profile.name, entry.name, sizeof(profile.name));
+        profile.name[PROFILE_NAME_MAX_LENGTH] = 0;
+        profile.loadStatus = LOAD_STATUS_ONLY_NAME;
+    }
+
+    osMutexRelease(g_profileIndexMutexId);
+
+    using namespace eez::scpi;
+    if (osThreadGetId() != g_scpiTaskHandle) {
+        osMessagePut(g_scpiMessageQueueId, SCPI_QUEUE_MESSAGE(SCPI_QUEUE_MESSAGE_TARGET_NONE, SCPI_QUEUE_MESSAGE_TYPE_VERIFY_PROFILE_INDEX, 0), osWaitForever);
+    } else {
+        verifyIndex();
     }
 }
 
@@ -148,6 +232,13 @@ bool recallFromLocation(int location, int recallOptions, bool showProgress, int
     char filePath[MAX_PATH_LENGTH];
     getProfileFilePath(location, filePath);
 
+#ifdef DEBUG
+    uint32_t startTime = micros();
+#endif
+
+    // lists are loaded to g_listsProfile0
+    g_profile0Journal.valid = false;
+
     Parameters profile;
     resetProfileToDefaults(profile);
     if (!loadProfileFromFile(filePath, profile, g_listsProfile0, 0, showProgress, err)) {
@@ -158,6 +249,10 @@ bool recallFromLocation(int location, int recallOptions, bool showProgress, int
         return false;
     }
 
+#ifdef DEBUG
+    debug::g_profileRecallTime.set(micros() - startTime);
+#endif
+
     if (location == 0) {
         if (!(recallOptions & profile::RECALL_OPTION_IGNORE_POWER)) {
             // save to cache
@@ -177,6 +272,8 @@ bool recallFromLocation(int location, int recallOptions, bool showProgress, int
 }
 
 bool recallFromFile(const char *filePath, int recallOptions, bool showProgress, int *err) {
+    g_profile0Journal.valid = false;
+
     Parameters profile;
     resetProfileToDefaults(profile);
     if (!loadProfileFromFile(filePath, profile, g_listsProfile0, 0, showProgress, err)) {
@@ -226,13 +323,19 @@ bool saveToLocation(int location, const char *name, bool showProgress, int *err)
         strcpy(profile.name, name);
     }
 
-    if (!saveProfileToFile(filePath, profile, nullptr, showProgress, err)) {
+    if (location == 0) {
+        g_profile0Journal.valid = false;
+    }
+
+    if (!saveProfileToFile(filePath, profile, nullptr, PROFILE_FORMAT_BINARY, showProgress, err)) {
         return false;
     }
 
     // save to cache
     memcpy(&g_profilesCache[location], &profile, sizeof(profile));
 
+    updateIndex(location);
+
     return true;
 }
 
@@ -240,14 +343,18 @@ bool saveToFile(const char *filePath, bool showProgress, int *err) {
     Parameters profile;
     memset(&profile, 0, sizeof(Parameters));
     saveState(profile, nullptr);
-    return saveProfileToFile(filePath, profile, nullptr, showProgress, err);
+    return saveProfileToFile(filePath, profile, nullptr, PROFILE_FORMAT_TEXT, showProgress, err);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// Imported text profile is loaded as is, it is converted to binary on the next save to location.
 bool importFileToLocation(const char *filePath, int location, bool showProgress, int *err) {
     char profileFilePath[MAX_PATH_LENGTH];
     getProfileFilePath(location, profileFilePath);
+    if (location == 0) {
+        g_profile0Journal.valid = false;
+    }
     if (sd_card::copyFile(filePath, profileFilePath, true, err)) {
         loadProfileParametersToCache(location);
         return true;
@@ -255,10 +362,22 @@ bool importFileToLocation(const char *filePath, int location, bool showProgress,
     return false;
 }
 
+// Exported profile is always in text format, so it can be edited.
 bool exportLocationToFile(int location, const char *filePath, bool showProgress, int *err) {
     char profileFilePath[MAX_PATH_LENGTH];
     getProfileFilePath(location, profileFilePath);
-    return sd_card::copyFile(profileFilePath, filePath, true, err);
+
+    // lists are loaded to g_listsProfile0
+    g_profile0Journal.valid = false;
+    memset(g_listsProfile0, 0, sizeof(g_listsProfile0));
+
+    Parameters profile;
+    resetProfileToDefaults(profile);
+    if (!loadProfileFromFile(profileFilePath, profile, g_listsProfile0, 0, false, err)) {
+        return false;
+    }
+
+    return saveProfileToFile(filePath, profile, g_listsProfile0, PROFILE_FORMAT_TEXT, showProgress, err);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -273,13 +392,13 @@ bool deleteLocation(int location, bool showProgress, int *err) {
 
         char filePath[MAX_PATH_LENGTH];
         getProfileFilePath(location, filePath);
-        if (!sd_card::exists(filePath, err)) {
-            return true;
+        if (sd_card::exists(filePath, err)) {
+            if (!sd_card::deleteFile(filePath, err)) {
+                return false;
+            }
         }
 
-        if (!sd_card::deleteFile(filePath, err)) {
-            return false;
-        }
+        updateIndex(location);
 
         return true;
     } else {
@@ -355,12 +474,14 @@ bool setName(int location, const char *name, bool showProgress, int *err) {
                 strcpy(profile.name, name);
             }
 
-            if (!saveProfileToFile(filePath, profile, g_listsProfile10, showProgress, err)) {
+            if (!saveProfileToFile(filePath, profile, g_listsProfile10, PROFILE_FORMAT_BINARY, showProgress, err)) {
                 return false;
             }
 
             memcpy(profileFromCache, &profile, sizeof(profile));
 
+            updateIndex(location);
+
             return true;
         }
     }
@@ -409,6 +530,10 @@ void loadProfileParametersToCache(int location) {
         
         osMessagePut(g_scpiMessageQueueId, SCPI_QUEUE_MESSAGE(SCPI_QUEUE_MESSAGE_TARGET_NONE, SCPI_QUEUE_MESSAGE_TYPE_LOAD_PROFILE, location), osWaitForever);
     } else {
+        if (location == 0) {
+            g_profile0Journal.valid = false;
+        }
+
         char filePath[MAX_PATH_LENGTH];
         getProfileFilePath(location, filePath);
         int err;
@@ -419,11 +544,186 @@ void loadProfileParametersToCache(int location) {
         }
 
         g_profilesCache[location].loadStatus = LOAD_STATUS_LOADED;
+
+        // lazy index check
+        if (location > 0) {
+            osMutexWait(g_profileIndexMutexId, osWaitForever);
+            auto &entry = g_profileIndex.entries[location];
+            auto &profile = g_profilesCache[location];
+            bool isIndexEntryChanged = entry.isValid != profile.flags.isValid || (profile.flags.isValid && strcmp(entry.name, profile.name) != 0);
+            osMutexRelease(g_profileIndexMutexId);
+
+            if (isIndexEntryChanged) {
+                updateIndex(location);
+            }
+        }
     }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 
+static uint32_t getIndexChecksum() {
+    uint32_t hash = 2166136261u;
+    const uint8_t *p = (const uint8_t *)&g_profileIndex;
+    for (size_t i = 0; i < offsetof(ProfileIndex, checksum); i++) {
+        hash = (hash ^ p[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static bool loadIndex() {
+    File file;
+    if (!file.open(PROFILE_INDEX_FILE_PATH, FILE_OPEN_EXISTING | FILE_READ)) {
+        return false;
+    }
+
+    bool result = file.read(&g_profileIndex, sizeof(ProfileIndex)) == sizeof(ProfileIndex);
+
+    file.close();
+
+    return result &&
+        g_profileIndex.magic == PROFILE_INDEX_MAGIC &&
+        g_profileIndex.version == PROFILE_INDEX_VERSION &&
+        g_profileIndex.numLocations == NUM_PROFILE_LOCATIONS &&
+        g_profileIndex.checksum == getIndexChecksum();
+}
+
+static void saveIndex() {
+    g_profileIndex.magic = PROFILE_INDEX_MAGIC;
+    g_profileIndex.version = PROFILE_INDEX_VERSION;
+    g_profileIndex.numLocations = NUM_PROFILE_LOCATIONS;
+    g_profileIndex.checksum = getIndexChecksum();
+
+    File file;
+    if (!file.open(PROFILE_INDEX_FILE_PATH, FILE_CREATE_ALWAYS | FILE_WRITE)) {
+        return;
+    }
+
+    bool result = file.write(&g_profileIndex, sizeof(ProfileIndex)) == sizeof(ProfileIndex);
+
+    file.close();
+
+    if (!result) {
+        // it will be rebuilt on the next mount
+        sd_card::deleteFile(PROFILE_INDEX_FILE_PATH, nullptr);
+    }
+}
+
+static void setIndexEntry(int location, uint32_t fileSize, uint32_t dateTime) {
+    auto &entry = g_profileIndex.entries[location];
+    auto &profile = g_profilesCache[location];
+
+    memset(&entry, 0, sizeof(ProfileIndexEntry));
+    if (profile.flags.isValid) {
+        entry.isValid = 1;
+        entry.fileSize = fileSize;
+        entry.dateTime = dateTime;
+        strcpy(entry.name, profile.name);
+    }
+}
+
+static uint32_t getModifiedDateTime(FileInfo &fileInfo) {
+    return datetime::makeTime(
+        fileInfo.getModifiedYear(), fileInfo.getModifiedMonth(), fileInfo.getModifiedDay(),
+        fileInfo.getModifiedHour(), fileInfo.getModifiedMinute(), fileInfo.getModifiedSecond()
+    );
+}
+
+// Entry gets the size and modification time of the profile file as verifyIndex will see them.
+static void updateIndex(int location) {
+    if (location > 0 && location < NUM_PROFILE_LOCATIONS) {
+        uint32_t fileSize = 0;
+        uint32_t dateTime = 0;
+        if (g_profilesCache[location].flags.isValid) {
+            char filePath[MAX_PATH_LENGTH];
+            getProfileFilePath(location, filePath);
+            FileInfo fileInfo;
+            if (fileInfo.fstat(filePath) == SD_FAT_RESULT_OK) {
+                fileSize = fileInfo.getSize();
+                dateTime = getModifiedDateTime(fileInfo);
+            }
+        }
+
+        osMutexWait(g_profileIndexMutexId, osWaitForever);
+        setIndexEntry(location, fileSize, dateTime);
+        saveIndex();
+        osMutexRelease(g_profileIndexMutexId);
+    }
+}
+
+void verifyIndex() {
+    if (!sd_card::isMounted(nullptr)) {
+        return;
+    }
+
+    uint32_t fileSizes[NUM_PROFILE_LOCATIONS];
+    uint32_t dateTimes[NUM_PROFILE_LOCATIONS];
+    bool exists[NUM_PROFILE_LOCATIONS];
+    memset(exists, 0, sizeof(exists));
+
+    Directory dir;
+    FileInfo fileInfo;
+    if (dir.findFirst(PROFILES_DIR, nullptr, fileInfo) == SD_FAT_RESULT_OK) {
+        const char *extension = getExtensionFromFileType(FILE_TYPE_PROFILE);
+
+        while (fileInfo) {
+            char name[MAX_PATH_LENGTH + 1] = { 0 };
+            fileInfo.getName(name, MAX_PATH_LENGTH);
+
+            // only "<location>.profile" files
+            char *end;
+            long location = strtol(name, &end, 10);
+            if (end != name && strcmp(end, extension) == 0 && location > 0 && location < NUM_PROFILE_LOCATIONS) {
+                exists[location] = true;
+                fileSizes[location] = fileInfo.getSize();
+                dateTimes[location] = getModifiedDateTime(fileInfo);
+            }
+
+            if (dir.findNext(fileInfo) != SD_FAT_RESULT_OK) {
+                break;
+            }
+        }
+
+        dir.close();
+    }
+
+    osMutexWait(g_profileIndexMutexId, osWaitForever);
+
+    bool changed = false;
+
+    for (int location = 1; location < NUM_PROFILE_LOCATIONS; location++) {
+        auto &entry = g_profileIndex.entries[location];
+
+        if (!exists[location]) {
+            if (entry.isValid) {
+                g_profilesCache[location].flags.isValid = 0;
+                g_profilesCache[location].name[0] = 0;
+                setIndexEntry(location, 0, 0);
+                changed = true;
+            }
+        } else if (entry.isValid && entry.fileSize == fileSizes[location] && (entry.dateTime == 0 || entry.dateTime == dateTimes[location])) {
+            if (entry.dateTime == 0) {
+                entry.dateTime = dateTimes[location];
+                changed = true;
+            }
+        } else {
+            g_profilesCache[location].flags.isValid = 0;
+            g_profilesCache[location].name[0] = 0;
+            loadProfileName(location);
+            setIndexEntry(location, fileSizes[location], dateTimes[location]);
+            changed = true;
+        }
+    }
+
+    if (changed) {
+        saveIndex();
+    }
+
+    osMutexRelease(g_profileIndexMutexId);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 static void loadProfileName(int location) {
     char filePath[MAX_PATH_LENGTH];
     getProfileFilePath(location, filePath);
@@ -467,6 +767,8 @@ static void resetProfileToDefaults(Parameters &profile) {
         profile.channels[i].i_rampDuration = RAMP_DURATION_DEF_VALUE;
 
         profile.channels[i].outputDelayDuration = 0;
+
+        memcpy(profile.channels[i].monFilterConf, g_defaultMonFilterConf, sizeof(g_defaultMonFilterConf));
     }
 }
 
@@ -618,6 +920,8 @@ static void saveState(Parameters &profile, List *lists) {
             profile.channels[i].flags.displayValue2 = channel.flags.displayValue2;
             profile.channels[i].ytViewRate = channel.ytViewRate;
 
+            memcpy(profile.channels[i].monFilterConf, channel.monFilterConf, sizeof(channel.monFilterConf));
+
 #ifdef EEZ_PLATFORM_SIMULATOR
             profile.channels[i].load_enabled = channel.simulator.load_enabled;
             profile.channels[i].load = channel.simulator.load;
@@ -775,6 +1079,12 @@ static bool recallState(Parameters &profile, List *lists, int recallOptions, int
 
             channel.outputDelayDuration = profile.channels[i].outputDelayDuration;
 
+            for (int tap = 0; tap < NUM_MON_TAPS; tap++) {
+                // profiles saved before SENS:MON:FILT was added don't have this field
+                auto &monFilterConf = profile.channels[i].monFilterConf[tap];
+                channel.setMonFilterConf((MonTap)tap, isMonFilterConfValid(monFilterConf) ? monFilterConf : g_defaultMonFilterConf[tap]);
+            }
+
             auto &list = lists[i];
             channel_dispatcher::setDwellList(channel, list.dwellList, list.dwellListLength);
             channel_dispatcher::setVoltageList(channel, list.voltageList, list.voltageListLength);
@@ -854,8 +1164,11 @@ bool WriteContext::property(const char *propertyName, unsigned int value) {
 
 bool WriteContext::property(const char *propertyName, float value) {
     char line[256 + 1];
-    sprintf(line, "\t%s=%g\n", propertyName, value);
-    return file.write((uint8_t *)line, strlen(line));
+    sprintf(line, "\t%s=", propertyName);
+    size_t length = strlen(line);
+    length += number::formatFloat(value, line + length);
+    line[length++] = '\n';
+    return file.write((uint8_t *)line, length);
 }
 
 bool WriteContext::property(const char *propertyName, const char *str) {
@@ -998,6 +1311,16 @@ static bool profileWrite(WriteContext &ctx, const Parameters &parameters, List *
             WRITE_PROPERTY("i_triggerValue", channel.i_triggerValue);
             WRITE_PROPERTY("listCount", channel.listCount);
 
+            WRITE_PROPERTY("monFastLength", channel.monFilterConf[MON_TAP_FAST].length);
+            WRITE_PROPERTY("monFastDecimation", channel.monFilterConf[MON_TAP_FAST].decimation);
+            WRITE_PROPERTY("monFastIir", channel.monFilterConf[MON_TAP_FAST].iirCoefficient);
+            WRITE_PROPERTY("monDisplayLength", channel.monFilterConf[MON_TAP_DISPLAY].length);
+            WRITE_PROPERTY("monDisplayDecimation", channel.monFilterConf[MON_TAP_DISPLAY].decimation);
+            WRITE_PROPERTY("monDisplayIir", channel.monFilterConf[MON_TAP_DISPLAY].iirCoefficient);
+            WRITE_PROPERTY("monDlogLength", channel.monFilterConf[MON_TAP_DLOG].length);
+            WRITE_PROPERTY("monDlogDecimation", channel.monFilterConf[MON_TAP_DLOG].decimation);
+            WRITE_PROPERTY("monDlogIir", channel.monFilterConf[MON_TAP_DLOG].iirCoefficient);
+
             WRITE_PROPERTY("u_rampDuration", channel.u_rampDuration);
             WRITE_PROPERTY("i_rampDuration", channel.i_rampDuration);
 
@@ -1076,7 +1399,325 @@ static bool profileWrite(WriteContext &ctx, const Parameters &parameters, List *
     return true;
 }
 
-static bool saveProfileToFile(const char *filePath, Parameters &profile, List *lists, bool showProgress, int *err) {
+////////////////////////////////////////////////////////////////////////////////
+
+// Binary profile is the header followed by the records: {key, size, payload}.
+// Records are applied in the file order, i.e. record overrides any previous record
+// with the same key, so autosave can append only the changed records to the file.
+
+struct BinaryProfileHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+};
+
+struct BinaryRecordHeader {
+    uint16_t key;
+    uint16_t size;
+};
+
+#define BINARY_KEY(group, property) (uint16_t)(((group) << 8) | (property))
+
+#define BINARY_GROUP_SYSTEM 0x00
+#define BINARY_GROUP_CHANNEL 0x10 // + channel index
+#define BINARY_GROUP_TEMP_SENSOR 0x20 // + temp sensor index
+
+enum BinarySystemProperty {
+    BINARY_PROPERTY_PROFILE_NAME = 1,
+    BINARY_PROPERTY_POWER_IS_UP,
+    BINARY_PROPERTY_COUPLING_TYPE
+};
+
+enum BinaryChannelProperty {
+    BINARY_PROPERTY_OUTPUT_ENABLED = 1,
+    BINARY_PROPERTY_SENSE_ENABLED,
+    BINARY_PROPERTY_U_STATE,
+    BINARY_PROPERTY_I_STATE,
+    BINARY_PROPERTY_P_STATE,
+    BINARY_PROPERTY_RPROG_ENABLED,
+    BINARY_PROPERTY_DISPLAY_VALUE1,
+    BINARY_PROPERTY_DISPLAY_VALUE2,
+    BINARY_PROPERTY_U_TRIGGER_MODE,
+    BINARY_PROPERTY_I_TRIGGER_MODE,
+    BINARY_PROPERTY_CURRENT_RANGE_SELECTION_MODE,
+    BINARY_PROPERTY_AUTO_SELECT_CURRENT_RANGE,
+    BINARY_PROPERTY_TRIGGER_OUTPUT_STATE,
+    BINARY_PROPERTY_TRIGGER_ON_LIST_STOP,
+    BINARY_PROPERTY_U_TYPE,
+    BINARY_PROPERTY_DPROG_STATE,
+    BINARY_PROPERTY_TRACKING_ENABLED,
+    BINARY_PROPERTY_LAST_CHANNEL_FLAG = BINARY_PROPERTY_TRACKING_ENABLED,
+
+    BINARY_PROPERTY_CHANNEL_FIELD = 0x40, // + index in g_binaryChannelFields
+    BINARY_PROPERTY_LIST = 0x80
+};
+
+enum BinaryTempSensorProperty {
+    BINARY_PROPERTY_TEMP_SENSOR_DELAY = 1,
+    BINARY_PROPERTY_TEMP_SENSOR_LEVEL,
+    BINARY_PROPERTY_TEMP_SENSOR_STATE
+};
+
+struct BinaryChannelField {
+    uint8_t size;
+    uint8_t offset;
+};
+
+#define BINARY_CHANNEL_FIELD(name) { (uint8_t)sizeof(ChannelParameters::name), (uint8_t)offsetof(ChannelParameters, name) }
+
+// Field index is stored in the file, so new fields must be added at the end,
+// but before the simulator only fields, so the index is the same on every platform.
+static const BinaryChannelField g_binaryChannelFields[] = {
+    BINARY_CHANNEL_FIELD(moduleType),
+    BINARY_CHANNEL_FIELD(moduleRevision),
+    BINARY_CHANNEL_FIELD(u_set),
+    BINARY_CHANNEL_FIELD(u_step),
+    BINARY_CHANNEL_FIELD(u_limit),
+    BINARY_CHANNEL_FIELD(u_delay),
+    BINARY_CHANNEL_FIELD(u_level),
+    BINARY_CHANNEL_FIELD(i_set),
+    BINARY_CHANNEL_FIELD(i_step),
+    BINARY_CHANNEL_FIELD(i_limit),
+    BINARY_CHANNEL_FIELD(i_delay),
+    BINARY_CHANNEL_FIELD(p_limit),
+    BINARY_CHANNEL_FIELD(p_delay),
+    BINARY_CHANNEL_FIELD(p_level),
+    BINARY_CHANNEL_FIELD(ytViewRate),
+    BINARY_CHANNEL_FIELD(u_triggerValue),
+    BINARY_CHANNEL_FIELD(i_triggerValue),
+    BINARY_CHANNEL_FIELD(listCount),
+    BINARY_CHANNEL_FIELD(u_rampDuration),
+    BINARY_CHANNEL_FIELD(i_rampDuration),
+    BINARY_CHANNEL_FIELD(outputDelayDuration),
+    BINARY_CHANNEL_FIELD(monFilterConf),
+#ifdef EEZ_PLATFORM_SIMULATOR
+    BINARY_CHANNEL_FIELD(load_enabled),
+    BINARY_CHANNEL_FIELD(load),
+    BINARY_CHANNEL_FIELD(voltProgExt),
+#endif
+};
+
+static const int NUM_BINARY_CHANNEL_FIELDS = sizeof(g_binaryChannelFields) / sizeof(BinaryChannelField);
+
+static uint8_t getChannelFlag(const ChannelFlags &flags, int property) {
+    switch (property) {
+    case BINARY_PROPERTY_OUTPUT_ENABLED: return flags.output_enabled;
+    case BINARY_PROPERTY_SENSE_ENABLED: return flags.sense_enabled;
+    case BINARY_PROPERTY_U_STATE: return flags.u_state;
+    case BINARY_PROPERTY_I_STATE: return flags.i_state;
+    case BINARY_PROPERTY_P_STATE: return flags.p_state;
+    case BINARY_PROPERTY_RPROG_ENABLED: return flags.rprog_enabled;
+    case BINARY_PROPERTY_DISPLAY_VALUE1: return flags.displayValue1;
+    case BINARY_PROPERTY_DISPLAY_VALUE2: return flags.displayValue2;
+    case BINARY_PROPERTY_U_TRIGGER_MODE: return flags.u_triggerMode;
+    case BINARY_PROPERTY_I_TRIGGER_MODE: return flags.i_triggerMode;
+    case BINARY_PROPERTY_CURRENT_RANGE_SELECTION_MODE: return flags.currentRangeSelectionMode;
+    case BINARY_PROPERTY_AUTO_SELECT_CURRENT_RANGE: return flags.autoSelectCurrentRange;
+    case BINARY_PROPERTY_TRIGGER_OUTPUT_STATE: return flags.triggerOutputState;
+    case BINARY_PROPERTY_TRIGGER_ON_LIST_STOP: return flags.triggerOnListStop;
+    case BINARY_PROPERTY_U_TYPE: return flags.u_type;
+    case BINARY_PROPERTY_DPROG_STATE: return flags.dprogState;
+    case BINARY_PROPERTY_TRACKING_ENABLED: return flags.trackingEnabled;
+    }
+    return 0;
+}
+
+static void setChannelFlag(ChannelFlags &flags, int property, uint8_t value) {
+    switch (property) {
+    case BINARY_PROPERTY_OUTPUT_ENABLED: flags.output_enabled = value; break;
+    case BINARY_PROPERTY_SENSE_ENABLED: flags.sense_enabled = value; break;
+    case BINARY_PROPERTY_U_STATE: flags.u_state = value; break;
+    case BINARY_PROPERTY_I_STATE: flags.i_state = value; break;
+    case BINARY_PROPERTY_P_STATE: flags.p_state = value; break;
+    case BINARY_PROPERTY_RPROG_ENABLED: flags.rprog_enabled = value; break;
+    case BINARY_PROPERTY_DISPLAY_VALUE1: flags.displayValue1 = value; break;
+    case BINARY_PROPERTY_DISPLAY_VALUE2: flags.displayValue2 = value; break;
+    case BINARY_PROPERTY_U_TRIGGER_MODE: flags.u_triggerMode = value; break;
+    case BINARY_PROPERTY_I_TRIGGER_MODE: flags.i_triggerMode = value; break;
+    case BINARY_PROPERTY_CURRENT_RANGE_SELECTION_MODE: flags.currentRangeSelectionMode = value; break;
+    case BINARY_PROPERTY_AUTO_SELECT_CURRENT_RANGE: flags.autoSelectCurrentRange = value; break;
+    case BINARY_PROPERTY_TRIGGER_OUTPUT_STATE: flags.triggerOutputState = value; break;
+    case BINARY_PROPERTY_TRIGGER_ON_LIST_STOP: flags.triggerOnListStop = value; break;
+    case BINARY_PROPERTY_U_TYPE: flags.u_type = value; break;
+    case BINARY_PROPERTY_DPROG_STATE: flags.dprogState = value; break;
+    case BINARY_PROPERTY_TRACKING_ENABLED: flags.trackingEnabled = value; break;
+    }
+}
+
+class BinaryWriteContext {
+public:
+    BinaryWriteContext(File &file_);
+
+    bool header();
+    bool record(uint16_t key, const void *data, uint16_t size);
+    bool recordHeader(uint16_t key, uint16_t size);
+    bool write(const void *data, uint32_t size);
+
+    bool flush();
+
+    uint32_t numBytes;
+
+private:
+    sd_card::BufferedFileWrite file;
+};
+
+BinaryWriteContext::BinaryWriteContext(File &file_)
+    : numBytes(0)
+    , file(file_)
+{
+}
+
+bool BinaryWriteContext::header() {
+    BinaryProfileHeader header;
+    header.magic = BINARY_PROFILE_MAGIC;
+    header.version = BINARY_PROFILE_VERSION;
+    header.reserved = 0;
+    return write(&header, sizeof(header));
+}
+
+bool BinaryWriteContext::record(uint16_t key, const void *data, uint16_t size) {
+    return recordHeader(key, size) && write(data, size);
+}
+
+bool BinaryWriteContext::recordHeader(uint16_t key, uint16_t size) {
+    BinaryRecordHeader recordHeader;
+    recordHeader.key = key;
+    recordHeader.size = size;
+    return write(&recordHeader, sizeof(recordHeader));
+}
+
+bool BinaryWriteContext::write(const void *data, uint32_t size) {
+    numBytes += size;
+    return file.write((const uint8_t *)data, size);
+}
+
+bool BinaryWriteContext::flush() {
+    return file.flush();
+}
+
+#define BINARY_WRITE_RECORD(key, data, size) if (!ctx.record(key, data, size)) return false
+
+static bool binaryWriteList(
+    BinaryWriteContext &ctx, uint16_t key,
+    float *dwellList, uint16_t dwellListLength,
+    float *voltageList, uint16_t voltageListLength,
+    float *currentList, uint16_t currentListLength
+) {
+    uint16_t lengths[3] = { dwellListLength, voltageListLength, currentListLength };
+    uint16_t size = sizeof(lengths) + (dwellListLength + voltageListLength + currentListLength) * sizeof(float);
+    return
+        ctx.recordHeader(key, size) &&
+        ctx.write(lengths, sizeof(lengths)) &&
+        ctx.write(dwellList, dwellListLength * sizeof(float)) &&
+        ctx.write(voltageList, voltageListLength * sizeof(float)) &&
+        ctx.write(currentList, currentListLength * sizeof(float));
+}
+
+// If previous is set, only the records that differ from previous are written.
+// listChanged tells, per channel, if list should be written in that case.
+static bool binaryProfileWrite(BinaryWriteContext &ctx, const Parameters &parameters, List *lists, const Parameters *previous, const bool *listChanged) {
+    if (!previous || strcmp(parameters.name, previous->name) != 0) {
+        // name is the first record, so only name can be read quickly
+        BINARY_WRITE_RECORD(BINARY_KEY(BINARY_GROUP_SYSTEM, BINARY_PROPERTY_PROFILE_NAME), parameters.name, strlen(parameters.name));
+    }
+
+    uint8_t value = parameters.flags.powerIsUp;
+    if (!previous || value != previous->flags.powerIsUp) {
+        BINARY_WRITE_RECORD(BINARY_KEY(BINARY_GROUP_SYSTEM, BINARY_PROPERTY_POWER_IS_UP), &value, 1);
+    }
+
+    value = parameters.flags.couplingType;
+    if (!previous || value != previous->flags.couplingType) {
+        BINARY_WRITE_RECORD(BINARY_KEY(BINARY_GROUP_SYSTEM, BINARY_PROPERTY_COUPLING_TYPE), &value, 1);
+    }
+
+    for (int channelIndex = 0; channelIndex < CH_MAX; channelIndex++) {
+        auto &channel = parameters.channels[channelIndex];
+        if (!channel.flags.parameters_are_valid) {
+            continue;
+        }
+
+        const ChannelParameters *previousChannel = previous && previous->channels[channelIndex].flags.parameters_are_valid ? &previous->channels[channelIndex] : nullptr;
+
+        uint8_t group = BINARY_GROUP_CHANNEL + channelIndex;
+
+        for (int property = 1; property <= BINARY_PROPERTY_LAST_CHANNEL_FLAG; property++) {
+            value = getChannelFlag(channel.flags, property);
+            if (!previousChannel || value != getChannelFlag(previousChannel->flags, property)) {
+                BINARY_WRITE_RECORD(BINARY_KEY(group, property), &value, 1);
+            }
+        }
+
+        for (int i = 0; i < NUM_BINARY_CHANNEL_FIELDS; i++) {
+            auto &field = g_binaryChannelFields[i];
+            const uint8_t *data = (const uint8_t *)&channel + field.offset;
+            if (!previousChannel || memcmp(data, (const uint8_t *)previousChannel + field.offset, field.size) != 0) {
+                BINARY_WRITE_RECORD(BINARY_KEY(group, BINARY_PROPERTY_CHANNEL_FIELD + i), data, field.size);
+            }
+        }
+
+        if (!previousChannel || !listChanged || listChanged[channelIndex]) {
+            uint16_t key = BINARY_KEY(group, BINARY_PROPERTY_LIST);
+            if (lists) {
+                auto &list = lists[channelIndex];
+                if (!binaryWriteList(ctx, key,
+                    list.dwellList, list.dwellListLength,
+                    list.voltageList, list.voltageListLength,
+                    list.currentList, list.currentListLength)
+                ) {
+                    return false;
+                }
+            } else {
+                auto &channel = Channel::get(channelIndex);
+
+                uint16_t dwellListLength;
+                float *dwellList = list::getDwellList(channel, &dwellListLength);
+
+                uint16_t voltageListLength;
+                float *voltageList = list::getVoltageList(channel, &voltageListLength);
+
+                uint16_t currentListLength;
+                float *currentList = list::getCurrentList(channel, &currentListLength);
+
+                if (!binaryWriteList(ctx, key,
+                    dwellList, dwellListLength,
+                    voltageList, voltageListLength,
+                    currentList, currentListLength)
+                ) {
+                    return false;
+                }
+            }
+        }
+    }
+
+    for (int i = 0; i < temp_sensor::NUM_TEMP_SENSORS; ++i) {
+        if (!temperature::sensors[i].isInstalled()) {
+            continue;
+        }
+
+        auto &tempSensorProt = parameters.tempProt[i];
+        const temperature::ProtectionConfiguration *previousTempSensorProt = previous ? &previous->tempProt[i] : nullptr;
+
+        uint8_t group = BINARY_GROUP_TEMP_SENSOR + i;
+
+        if (!previousTempSensorProt || tempSensorProt.delay != previousTempSensorProt->delay) {
+            BINARY_WRITE_RECORD(BINARY_KEY(group, BINARY_PROPERTY_TEMP_SENSOR_DELAY), &tempSensorProt.delay, sizeof(float));
+        }
+
+        if (!previousTempSensorProt || tempSensorProt.level != previousTempSensorProt->level) {
+            BINARY_WRITE_RECORD(BINARY_KEY(group, BINARY_PROPERTY_TEMP_SENSOR_LEVEL), &tempSensorProt.level, sizeof(float));
+        }
+
+        value = tempSensorProt.state;
+        if (!previousTempSensorProt || tempSensorProt.state != previousTempSensorProt->state) {
+            BINARY_WRITE_RECORD(BINARY_KEY(group, BINARY_PROPERTY_TEMP_SENSOR_STATE), &value, 1);
+        }
+    }
+
+    return true;
+}
+
+static bool saveProfileToFile(const char *filePath, Parameters &profile, List *lists, ProfileFormat format, bool showProgress, int *err, uint32_t *fileSize) {
     if (!sd_card::isMounted(err)) {
         if (err) {
             *err = SCPI_ERROR_MISSING_MASS_MEDIA;
@@ -1096,14 +1737,27 @@ static bool saveProfileToFile(const char *filePath, Parameters &profile, List *l
         File file;
 
         if (file.open(filePath, FILE_CREATE_ALWAYS | FILE_WRITE)) {
-            WriteContext ctx(file);
+            if (format == PROFILE_FORMAT_BINARY) {
+                BinaryWriteContext ctx(file);
 
-            if (profileWrite(ctx, profile, lists, showProgress)) {
-                if (ctx.flush()) {
+                if (ctx.header() && binaryProfileWrite(ctx, profile, lists, nullptr, nullptr) && ctx.flush()) {
                     file.close();
+                    if (fileSize) {
+                        *fileSize = ctx.numBytes;
+                    }
                     onSdCardFileChangeHook(filePath);
                     return true;
                 }
+            } else {
+                WriteContext ctx(file);
+
+                if (profileWrite(ctx, profile, lists, showProgress)) {
+                    if (ctx.flush()) {
+                        file.close();
+                        onSdCardFileChangeHook(filePath);
+                        return true;
+                    }
+                }
             }
         }
 
@@ -1116,6 +1770,37 @@ static bool saveProfileToFile(const char *filePath, Parameters &profile, List *l
     return false;
 }
 
+// Appends to the binary profile file the records changed since previous.
+// Fails if file size is not the expected fileSize, i.e. file was changed by someone else.
+static bool appendProfileToFile(const char *filePath, Parameters &profile, List *lists, const Parameters &previous, const bool *listChanged, uint32_t &fileSize) {
+    if (!sd_card::isMounted(nullptr)) {
+        return false;
+    }
+
+    File file;
+    if (!file.open(filePath, FILE_OPEN_APPEND | FILE_WRITE)) {
+        return false;
+    }
+
+    bool result = false;
+
+    if (file.size() == fileSize) {
+        BinaryWriteContext ctx(file);
+        if (binaryProfileWrite(ctx, profile, lists, &previous, listChanged) && ctx.flush()) {
+            fileSize += ctx.numBytes;
+            result = true;
+        }
+    }
+
+    file.close();
+
+    if (result) {
+        onSdCardFileChangeHook(filePath);
+    }
+
+    return result;
+}
+
 static void saveStateToProfile0(bool merge) {
     char filePath[MAX_PATH_LENGTH];
     getProfileFilePath(0, filePath);
@@ -1125,13 +1810,37 @@ static void saveStateToProfile0(bool merge) {
         memset(g_listsProfile0, 0, CH_MAX * sizeof(List));
     }
 
-    saveState(g_profilesCache[0], g_listsProfile0);
+    if (merge && g_profile0Journal.valid) {
+        Parameters previous;
+        memcpy(&previous, &g_profilesCache[0], sizeof(Parameters));
+
+        bool listChanged[CH_MAX];
+        for (int channelIndex = 0; channelIndex < CH_MAX; channelIndex++) {
+            listChanged[channelIndex] = channelIndex < CH_NUM && isProfile0ListDirty(channelIndex);
+        }
+
+        saveState(g_profilesCache[0], g_listsProfile0);
+
+        // when journal gets bigger than the last full save, file is compacted with the full save
+        if (g_profile0Journal.fileSize - g_profile0Journal.snapshotSize < g_profile0Journal.snapshotSize) {
+            if (appendProfileToFile(filePath, g_profilesCache[0], g_listsProfile0, previous, listChanged, g_profile0Journal.fileSize)) {
+                return;
+            }
+        }
+    } else {
+        saveState(g_profilesCache[0], g_listsProfile0);
+    }
+
+    g_profile0Journal.valid = false;
 
     int err;
-    if (!saveProfileToFile(filePath, g_profilesCache[0], g_listsProfile0, false, &err)) {
+    if (!saveProfileToFile(filePath, g_profilesCache[0], g_listsProfile0, PROFILE_FORMAT_BINARY, false, &err, &g_profile0Journal.fileSize)) {
         generateError(err);
         return;
     }
+
+    g_profile0Journal.snapshotSize = g_profile0Journal.fileSize;
+    g_profile0Journal.valid = true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1156,6 +1865,10 @@ public:
 
     void skipPropertyValue();
 
+    // binary profile starts with 0, which is never in the text profile
+    bool isBinary() { return file.peek() == 0; }
+    sd_card::BufferedFileRead &getFile() { return file; }
+
     bool result;
 
 private:
@@ -1423,6 +2136,16 @@ static bool profileReadCallback(ReadContext &ctx, Parameters &parameters, List *
         READ_PROPERTY(i_triggerValue, channel.i_triggerValue);
         READ_PROPERTY(listCount, channel.listCount);
 
+        READ_PROPERTY(monFastLength, channel.monFilterConf[MON_TAP_FAST].length);
+        READ_PROPERTY(monFastDecimation, channel.monFilterConf[MON_TAP_FAST].decimation);
+        READ_PROPERTY(monFastIir, channel.monFilterConf[MON_TAP_FAST].iirCoefficient);
+        READ_PROPERTY(monDisplayLength, channel.monFilterConf[MON_TAP_DISPLAY].length);
+        READ_PROPERTY(monDisplayDecimation, channel.monFilterConf[MON_TAP_DISPLAY].decimation);
+        READ_PROPERTY(monDisplayIir, channel.monFilterConf[MON_TAP_DISPLAY].iirCoefficient);
+        READ_PROPERTY(monDlogLength, channel.monFilterConf[MON_TAP_DLOG].length);
+        READ_PROPERTY(monDlogDecimation, channel.monFilterConf[MON_TAP_DLOG].decimation);
+        READ_PROPERTY(monDlogIir, channel.monFilterConf[MON_TAP_DLOG].iirCoefficient);
+
         READ_PROPERTY(u_rampDuration, channel.u_rampDuration);
         READ_PROPERTY(i_rampDuration, channel.i_rampDuration);
 
@@ -1457,6 +2180,133 @@ static bool profileRead(ReadContext &ctx, Parameters &parameters, List *lists, i
     return ctx.doRead(profileReadCallback, parameters, lists, options, showProgress);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+
+// Skips record payload, returns false at the end of file.
+static bool binarySkip(sd_card::BufferedFileRead &file, uint32_t size) {
+    uint8_t buffer[64];
+    while (size > 0) {
+        uint32_t chunkSize = size < sizeof(buffer) ? size : sizeof(buffer);
+        if ((uint32_t)file.read(buffer, chunkSize) != chunkSize) {
+            return false;
+        }
+        size -= chunkSize;
+    }
+    return true;
+}
+
+static bool binaryReadList(sd_card::BufferedFileRead &file, uint16_t size, List &list) {
+    uint16_t lengths[3];
+    if (size < sizeof(lengths)) {
+        return binarySkip(file, size);
+    }
+
+    if (file.read(lengths, sizeof(lengths)) != sizeof(lengths)) {
+        return false;
+    }
+
+    if (
+        lengths[0] > MAX_LIST_LENGTH || lengths[1] > MAX_LIST_LENGTH || lengths[2] > MAX_LIST_LENGTH ||
+        size != sizeof(lengths) + (lengths[0] + lengths[1] + lengths[2]) * sizeof(float)
+    ) {
+        return binarySkip(file, size - sizeof(lengths));
+    }
+
+    // lengths are set only if the whole record is read
+    if (
+        file.read(list.dwellList, lengths[0] * sizeof(float)) != (int)(lengths[0] * sizeof(float)) ||
+        file.read(list.voltageList, lengths[1] * sizeof(float)) != (int)(lengths[1] * sizeof(float)) ||
+        file.read(list.currentList, lengths[2] * sizeof(float)) != (int)(lengths[2] * sizeof(float))
+    ) {
+        return false;
+    }
+
+    list.dwellListLength = lengths[0];
+    list.voltageListLength = lengths[1];
+    list.currentListLength = lengths[2];
+
+    return true;
+}
+
+// Unknown records are skipped. Incomplete record at the end of file, which can be left
+// by the interrupted autosave, is ignored.
+static bool binaryProfileRead(sd_card::BufferedFileRead &file, Parameters &parameters, List *lists, int options) {
+    BinaryProfileHeader header;
+    if (file.read(&header, sizeof(header)) != sizeof(header) || header.magic != BINARY_PROFILE_MAGIC || header.version != BINARY_PROFILE_VERSION) {
+        return false;
+    }
+
+    BinaryRecordHeader record;
+    while (file.read(&record, sizeof(record)) == sizeof(record)) {
+        int group = record.key >> 8;
+        int property = record.key & 0xFF;
+
+        if (group >= BINARY_GROUP_CHANNEL && group < BINARY_GROUP_CHANNEL + CH_MAX && property == BINARY_PROPERTY_LIST) {
+            int channelIndex = group - BINARY_GROUP_CHANNEL;
+            parameters.channels[channelIndex].flags.parameters_are_valid = 1;
+            if (!(lists ? binaryReadList(file, record.size, lists[channelIndex]) : binarySkip(file, record.size))) {
+                break;
+            }
+            continue;
+        }
+
+        uint8_t data[PROFILE_NAME_MAX_LENGTH];
+        if (record.size > sizeof(data)) {
+            if (!binarySkip(file, record.size)) {
+                break;
+            }
+            continue;
+        }
+
+        if (file.read(data, record.size) != record.size) {
+            break;
+        }
+
+        if (group == BINARY_GROUP_SYSTEM) {
+            if (property == BINARY_PROPERTY_PROFILE_NAME) {
+                memcpy(parameters.name, data, record.size);
+                parameters.name[record.size] = 0;
+                if (options & LOAD_PROFILE_FROM_FILE_OPTION_ONLY_NAME) {
+                    break;
+                }
+            } else if (property == BINARY_PROPERTY_POWER_IS_UP && record.size == 1) {
+                parameters.flags.powerIsUp = data[0];
+            } else if (property == BINARY_PROPERTY_COUPLING_TYPE && record.size == 1) {
+                parameters.flags.couplingType = data[0];
+            }
+        } else if (group >= BINARY_GROUP_CHANNEL && group < BINARY_GROUP_CHANNEL + CH_MAX) {
+            auto &channel = parameters.channels[group - BINARY_GROUP_CHANNEL];
+
+            channel.flags.parameters_are_valid = 1;
+
+            if (property >= 1 && property <= BINARY_PROPERTY_LAST_CHANNEL_FLAG) {
+                if (record.size == 1) {
+                    setChannelFlag(channel.flags, property, data[0]);
+                }
+            } else if (property >= BINARY_PROPERTY_CHANNEL_FIELD && property < BINARY_PROPERTY_CHANNEL_FIELD + NUM_BINARY_CHANNEL_FIELDS) {
+                auto &field = g_binaryChannelFields[property - BINARY_PROPERTY_CHANNEL_FIELD];
+                if (record.size == field.size) {
+                    memcpy((uint8_t *)&channel + field.offset, data, field.size);
+                }
+            }
+        } else if (group >= BINARY_GROUP_TEMP_SENSOR && group < BINARY_GROUP_TEMP_SENSOR + temp_sensor::MAX_NUM_TEMP_SENSORS) {
+            auto &tempSensorProt = parameters.tempProt[group - BINARY_GROUP_TEMP_SENSOR];
+
+            if (property == BINARY_PROPERTY_TEMP_SENSOR_DELAY && record.size == sizeof(float)) {
+                memcpy(&tempSensorProt.delay, data, sizeof(float));
+            } else if (property == BINARY_PROPERTY_TEMP_SENSOR_LEVEL && record.size == sizeof(float)) {
+                memcpy(&tempSensorProt.level, data, sizeof(float));
+            } else if (property == BINARY_PROPERTY_TEMP_SENSOR_STATE && record.size == 1) {
+                tempSensorProt.state = data[0] ? true : false;
+            }
+        }
+    }
+
+    parameters.flags.isValid = 1;
+
+    return true;
+}
+
 static bool loadProfileFromFile(const char *filePath, Parameters &profile, List *lists, int options, bool showProgress, int *err) {
     if (!sd_card::isMounted(err)) {
         if (err) {
@@ -1483,7 +2333,12 @@ static bool loadProfileFromFile(const char *filePath, Parameters &profile, List
 
     ReadContext ctx(file);
 
-    bool result = profileRead(ctx, profile, lists, options, showProgress);
+    bool result;
+    if (ctx.isBinary()) {
+        result = binaryProfileRead(ctx.getFile(), profile, lists, options);
+    } else {
+        result = profileRead(ctx, profile, lists, options, showProgress);
+    }
 
     file.close();
 
@@ -1529,30 +2384,89 @@ static bool isProfile0Dirty() {
     }
 
     for (int channelIndex = 0; channelIndex < CH_NUM; channelIndex++) {
-        auto &channel = Channel::get(channelIndex);
+        if (isProfile0ListDirty(channelIndex)) {
+            return true;
+        }
+    }
+
+    return false;
+}
 
-        auto &list = g_listsProfile0[channelIndex];
+static bool isProfile0ListDirty(int channelIndex) {
+    auto &channel = Channel::get(channelIndex);
 
-        uint16_t dwellListLength;
-        float *dwellList = list::getDwellList(channel, &dwellListLength);
-        if (dwellListLength != list.dwellListLength || memcmp(dwellList, list.dwellList, sizeof(list.dwellList)) != 0) {
-            return true;
+    auto &list = g_listsProfile0[channelIndex];
+
+    uint16_t dwellListLength;
+    float *dwellList = list::getDwellList(channel, &dwellListLength);
+    if (dwellListLength != list.dwellListLength || memcmp(dwellList, list.dwellList, sizeof(list.dwellList)) != 0) {
+        return true;
+    }
+
+    uint16_t voltageListLength;
+    float *voltageList = list::getVoltageList(channel, &voltageListLength);
+    if (voltageListLength != list.voltageListLength || memcmp(voltageList, list.voltageList, sizeof(list.voltageList)) != 0) {
+        return true;
+    }
+
+    uint16_t currentListLength;
+    float *currentList = list::getCurrentList(channel, &currentListLength);
+    if (currentListLength != list.currentListLength || memcmp(currentList, list.currentList, sizeof(list.currentList)) != 0) {
+        return true;
+    }
+
+    return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void benchmarkRecall(int numIterations) {
+    static const char *g_formatNames[] = { "text", "binary" };
+
+    // profile is loaded to g_listsProfile0
+    g_profile0Journal.valid = false;
+
+    Parameters profile;
+    memset(&profile, 0, sizeof(Parameters));
+    saveState(profile, nullptr);
+
+    for (int format = PROFILE_FORMAT_TEXT; format <= PROFILE_FORMAT_BINARY; format++) {
+        char filePath[MAX_PATH_LENGTH];
+        sprintf(filePath, "%s%sbenchmark_%s%s", PROFILES_DIR, PATH_SEPARATOR, g_formatNames[format], getExtensionFromFileType(FILE_TYPE_PROFILE));
+
+        int err;
+        if (!saveProfileToFile(filePath, profile, nullptr, (ProfileFormat)format, false, &err)) {
+            // don't leave the partially written benchmark file in the profiles directory
+            sd_card::deleteFile(filePath, nullptr);
+            DebugTrace("Profile recall benchmark failed, err=%d\n", err);
+            return;
         }
 
-        uint16_t voltageListLength;
-        float *voltageList = list::getVoltageList(channel, &voltageListLength);
-        if (voltageListLength != list.voltageListLength || memcmp(voltageList, list.voltageList, sizeof(list.voltageList)) != 0) {
-            return true;
+        size_t fileSize = 0;
+        File file;
+        if (file.open(filePath, FILE_OPEN_EXISTING | FILE_READ)) {
+            fileSize = file.size();
+            file.close();
         }
 
-        uint16_t currentListLength;
-        float *currentList = list::getCurrentList(channel, &currentListLength);
-        if (currentListLength != list.currentListLength || memcmp(currentList, list.currentList, sizeof(list.currentList)) != 0) {
-            return true;
+        uint32_t startTime = micros();
+        bool result = true;
+        for (int i = 0; result && i < numIterations; i++) {
+            Parameters loadedProfile;
+            resetProfileToDefaults(loadedProfile);
+            result = loadProfileFromFile(filePath, loadedProfile, g_listsProfile0, 0, false, &err);
         }
-    }
+        uint32_t duration = micros() - startTime;
 
-    return false;
+        sd_card::deleteFile(filePath, nullptr);
+
+        if (!result) {
+            DebugTrace("Profile recall benchmark failed, err=%d\n", err);
+            return;
+        }
+
+        DebugTrace("Profile %s: %u bytes, load %u us\n", g_formatNames[format], (unsigned)fileSize, (unsigned)(duration / numIterations));
+    }
 }
 
 } // namespace profile
@@ -18,10 +18,13 @@
 
 #pragma once
 
+#include <eez/modules/psu/mon_filter.h>
 #include <eez/modules/psu/temperature.h>
 
 #define PROFILE_EXT ".profile"
 
+#define PROFILE_INDEX_FILE_PATH "/.profiles"
+
 namespace eez {
 namespace psu {
 /// PSU configuration profiles (save, recall, ...).
@@ -73,6 +76,7 @@ struct ChannelParameters {
     float u_rampDuration;
     float i_rampDuration;
     float outputDelayDuration;
+    MonFilterConf monFilterConf[NUM_MON_TAPS];
 #ifdef EEZ_PLATFORM_SIMULATOR
     bool load_enabled;
     float load;
@@ -103,6 +107,9 @@ struct Parameters {
     temperature::ProtectionConfiguration tempProt[temp_sensor::MAX_NUM_TEMP_SENSORS];
 };
 
+// index is changed in the SCPI thread and in profile::init, mutex is created before both of them
+void initIndexMutex();
+
 void init();
 void tick();
 
@@ -144,6 +151,12 @@ void setFreezeState(bool value);
 
 void loadProfileParametersToCache(int location);
 
+// checks the index against the profile files and loads the names that are out of date
+void verifyIndex();
+
+// saves the current state in text and binary format and traces size and load time of both
+void benchmarkRecall(int numIterations);
+
 }
 }
 } // namespace eez::psu::profile
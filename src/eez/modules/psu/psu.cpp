@@ -24,6 +24,7 @@
 #include <eez/system.h>
 #include <eez/sound.h>
 #include <eez/index.h>
+#include <eez/trace.h>
 
 #include <eez/scpi/scpi.h>
 
@@ -48,6 +49,8 @@
 #include <eez/modules/psu/io_pins.h>
 #include <eez/modules/psu/list_program.h>
 #include <eez/modules/psu/ramp.h>
+#include <eez/modules/psu/scheduler.h>
+#include <eez/modules/psu/sweep.h>
 #include <eez/modules/psu/trigger.h>
 #include <eez/modules/psu/ontime.h>
 
@@ -209,7 +212,11 @@ void (*g_diagCallback)();
 
 ////////////////////////////////////////////////////////////////////////////////
 
+static void initScheduler();
+
 void startThread() {
+    initScheduler();
+
     g_psuMessageQueueId = osMessageCreate(osMessageQ(g_psuMessageQueue), NULL);
     g_psuTaskHandle = osThreadCreate(osThread(g_psuTask), nullptr);
 
@@ -222,6 +229,8 @@ void startThread() {
 void oneIter();
 
 void mainLoop(const void *) {
+    TRACE_REGISTER_THREAD("PSU");
+
 #ifdef __EMSCRIPTEN__
     oneIter();
 #else
@@ -286,6 +295,10 @@ void oneIter() {
             channel_dispatcher::setVoltageInPsuThread((int)param);
         } else if (type == PSU_QUEUE_MESSAGE_TYPE_SET_CURRENT) {
             channel_dispatcher::setCurrentInPsuThread((int)param);
+        } else if (type == PSU_QUEUE_COMMIT_STAGED) {
+            channel_dispatcher::commitStagedInPsuThread();
+        } else if (type == PSU_QUEUE_SET_MON_FILTER_CONF) {
+            Channel::get(param >> 8).setMonFilterConfInPsuThread((MonTap)(param & 0xFF));
         } else if (type == PSU_QUEUE_RESET_CHANNELS_HISTORY) {
             Channel::resetHistoryForAllChannels();
         } 
@@ -440,6 +453,9 @@ bool psuReset() {
     // CAL[:MODE] OFF
     calibration::stop();
 
+    // APPL:STAGE
+    channel_dispatcher::clearStaged();
+
     // reset channels
     int err;
     if (!channel_dispatcher::setCouplingType(channel_dispatcher::COUPLING_TYPE_NONE, &err)) {
@@ -662,6 +678,8 @@ void powerDownBySensor() {
 ////////////////////////////////////////////////////////////////////////////////
 
 void onProtectionTripped() {
+    channel_dispatcher::clearStaged();
+
     if (isPowerUp()) {
         if (persist_conf::isShutdownWhenProtectionTrippedEnabled()) {
             powerDownBySensor();
@@ -675,45 +693,43 @@ void onProtectionTripped() {
 
 ////////////////////////////////////////////////////////////////////////////////
 
-typedef void (*TickFunc)(uint32_t tickCount);
-static TickFunc g_tickFuncs[] = {
-    temperature::tick,
+static void channelsTick(uint32_t tickCount) {
+    for (int i = 0; i < CH_NUM; ++i) {
+        Channel::get(i).tick(tickCount);
+    }
+}
+
+// Sorted by priority. Slow tasks with the same period have different phase,
+// so only one of them is executed in the same tick.
+// name, func, priority, period [us], phase [us], budget [us]
+static scheduler::Task g_tasks[] = {
+    { "ramp",        ramp::tick,        scheduler::PRIORITY_CRITICAL,    0,     0,     20 },
+    { "sweep",       sweep::tick,       scheduler::PRIORITY_CRITICAL,    0,     0,     20 },
+    { "trigger",     trigger::tick,     scheduler::PRIORITY_HIGH,     1000,     0,     50 },
+    { "list",        list::tick,        scheduler::PRIORITY_HIGH,     1000,     0,     50 },
+    { "channels",    channelsTick,      scheduler::PRIORITY_HIGH,     1000,     0,    300 },
+    { "dlog",        dlog_record::tick, scheduler::PRIORITY_NORMAL,   1000,     0,    200 },
+    { "io_pins",     io_pins::tick,     scheduler::PRIORITY_NORMAL,   1000,     0,     50 },
+    { "temperature", temperature::tick, scheduler::PRIORITY_LOW,      4000,     0,    200 },
 #if OPTION_FAN
-    aux_ps::fan::tick,
+    { "fan",         aux_ps::fan::tick, scheduler::PRIORITY_LOW,      4000,  1000,    100 },
 #endif
-    datetime::tick,
-    idle::tick
+    { "datetime",    datetime::tick,    scheduler::PRIORITY_LOW,      4000,  2000,    100 },
+    { "idle",        idle::tick,        scheduler::PRIORITY_LOW,      4000,  3000,     50 },
 };
-static const int NUM_TICK_FUNCS = sizeof(g_tickFuncs) / sizeof(TickFunc);
-static int g_tickFuncIndex = 0;
-
-void tick() {
-    WATCHDOG_RESET();
 
-    uint32_t tickCount = micros();
+#define SCHEDULER_CYCLE_BUDGET 500 // us
 
-#if defined(EEZ_PLATFORM_STM32)
-    if (g_tickCount % 5) {
-        ramp::tick(tickCount);
-        return;
-    }
-#endif
-
-    trigger::tick(tickCount);
-    tickCount = micros();
-    list::tick(tickCount);
-    ramp::tick(tickCount);
-
-    for (int i = 0; i < CH_NUM; ++i) {
-        Channel::get(i).tick(tickCount);
-    }
+static void initScheduler() {
+    scheduler::init(g_tasks, sizeof(g_tasks) / sizeof(scheduler::Task), SCHEDULER_CYCLE_BUDGET);
+}
 
-    dlog_record::tick(tickCount);
+void tick() {
+    TRACE_SCOPE("psu::tick");
 
-    io_pins::tick(tickCount);
+    WATCHDOG_RESET();
 
-    g_tickFuncs[g_tickFuncIndex](tickCount);
-    g_tickFuncIndex = (g_tickFuncIndex + 1) % NUM_TICK_FUNCS;
+    scheduler::tick(micros());
 
     if (g_diagCallback) {
         g_diagCallback();
@@ -78,6 +78,8 @@ enum {
     PSU_QUEUE_MESSAGE_TYPE_SET_VOLTAGE,
     PSU_QUEUE_MESSAGE_TYPE_SET_CURRENT,
     PSU_QUEUE_RESET_CHANNELS_HISTORY,
+    PSU_QUEUE_COMMIT_STAGED,
+    PSU_QUEUE_SET_MON_FILTER_CONF,
 };
 
 #define PSU_QUEUE_MESSAGE(type, param) (((param) << 8) | (type))
@@ -83,6 +83,12 @@ bool test() {
 
 #if defined(EEZ_PLATFORM_SIMULATOR)
 uint32_t nowUtc() {
+#if !defined(__EMSCRIPTEN__)
+    if (osKernelIsVirtualTime()) {
+        // fixed start, so the virtual time runs are reproducible
+        return datetime::makeTime(2020, 1, 1, 0, 0, 0) + (uint32_t)(osKernelVirtualTime() / 1000000);
+    }
+#endif
     time_t now_time_t = time(0);
     struct tm *now_tm = gmtime(&now_time_t);
     return datetime::makeTime(1900 + now_tm->tm_year, now_tm->tm_mon + 1, now_tm->tm_mday,
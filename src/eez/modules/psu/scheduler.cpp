@@ -0,0 +1,191 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2015-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <eez/debug.h>
+#include <eez/system.h>
+#include <eez/trace.h>
+
+#include <eez/modules/psu/psu.h>
+#include <eez/modules/psu/scheduler.h>
+
+#ifdef DEBUG
+#include <eez/modules/psu/debug.h>
+#endif
+
+namespace eez {
+namespace psu {
+namespace scheduler {
+
+static Task *g_tasks;
+static int g_numTasks;
+static CycleStats g_cycleStats;
+
+// micros() is good enough for the periods, execution time is measured with microsPrecise()
+static uint32_t getElapsedTime(uint64_t startTime) {
+    return (uint32_t)(microsPrecise() - startTime);
+}
+
+void init(Task *tasks, int numTasks, uint32_t cycleBudget) {
+    g_tasks = tasks;
+    g_numTasks = numTasks;
+    g_cycleStats.budget = cycleBudget;
+
+    uint32_t tickCount = micros();
+    for (int i = 0; i < g_numTasks; i++) {
+        g_tasks[i].nextRunTime = tickCount + g_tasks[i].phase;
+        g_tasks[i].deferred = false;
+    }
+
+    resetStats();
+}
+
+void resetStats() {
+    for (int i = 0; i < g_numTasks; i++) {
+        Task &task = g_tasks[i];
+        task.numRuns = 0;
+        task.numDeadlineMisses = 0;
+        task.numOverruns = 0;
+        task.numDeferrals = 0;
+        task.lastTime = 0;
+        task.maxTime = 0;
+        task.totalTime = 0;
+    }
+
+    g_cycleStats.numCycles = 0;
+    g_cycleStats.numOverruns = 0;
+    g_cycleStats.maxTime = 0;
+    g_cycleStats.totalTime = 0;
+}
+
+static void runTask(Task &task) {
+    TRACE_BEGIN(task.name);
+    uint64_t startTime = microsPrecise();
+    task.func(micros());
+    uint32_t duration = getElapsedTime(startTime);
+    TRACE_END(task.name);
+
+    task.numRuns++;
+    task.lastTime = duration;
+    if (duration > task.maxTime) {
+        task.maxTime = duration;
+    }
+    task.totalTime += duration;
+    if (task.budget > 0 && duration > task.budget) {
+        task.numOverruns++;
+    }
+}
+
+static void updateCycleStats(uint32_t duration) {
+    g_cycleStats.numCycles++;
+    if (duration > g_cycleStats.maxTime) {
+        g_cycleStats.maxTime = duration;
+    }
+    g_cycleStats.totalTime += duration;
+    if (duration > g_cycleStats.budget) {
+        g_cycleStats.numOverruns++;
+    }
+
+#ifdef DEBUG
+    uint32_t numDeadlineMisses = 0;
+    uint32_t numDeferrals = 0;
+    for (int i = 0; i < g_numTasks; i++) {
+        numDeadlineMisses += g_tasks[i].numDeadlineMisses;
+        numDeferrals += g_tasks[i].numDeferrals;
+    }
+
+    debug::g_schedCycleMaxTime.set(g_cycleStats.maxTime);
+    debug::g_schedCycleOverruns.set(g_cycleStats.numOverruns);
+    debug::g_schedDeadlineMisses.set(numDeadlineMisses);
+    debug::g_schedDeferrals.set(numDeferrals);
+#endif
+}
+
+void tick(uint32_t tickCount) {
+    uint64_t startTime = microsPrecise();
+
+    for (int i = 0; i < g_numTasks; i++) {
+        Task &task = g_tasks[i];
+
+        if (task.period > 0) {
+            int32_t lateness = (int32_t)(tickCount - task.nextRunTime);
+            if (lateness < 0) {
+                continue;
+            }
+
+            if (task.priority > PRIORITY_HIGH && !task.deferred && getElapsedTime(startTime) > g_cycleStats.budget) {
+                task.deferred = true;
+                task.numDeferrals++;
+                continue;
+            }
+
+            if ((uint32_t)lateness >= task.period) {
+                task.numDeadlineMisses++;
+                // skip the missed periods
+                task.nextRunTime = tickCount + task.period;
+            } else {
+                task.nextRunTime += task.period;
+            }
+        }
+
+        task.deferred = false;
+        runTask(task);
+    }
+
+    updateCycleStats(getElapsedTime(startTime));
+}
+
+int getNumTasks() {
+    return g_numTasks;
+}
+
+const Task &getTask(int taskIndex) {
+    return g_tasks[taskIndex];
+}
+
+const CycleStats &getCycleStats() {
+    return g_cycleStats;
+}
+
+void benchmark(uint32_t numCycles) {
+    resetStats();
+
+    for (uint32_t i = 0; i < numCycles; i++) {
+        uint64_t startTime = microsPrecise();
+        for (int j = 0; j < g_numTasks; j++) {
+            runTask(g_tasks[j]);
+        }
+        updateCycleStats(getElapsedTime(startTime));
+        WATCHDOG_RESET();
+    }
+
+    for (int i = 0; i < g_numTasks; i++) {
+        const Task &task = g_tasks[i];
+        DebugTrace("Sched %s: avg %u us, max %u us, budget %u us, overruns %u\n", task.name,
+            (unsigned)(task.numRuns ? task.totalTime / task.numRuns : 0), (unsigned)task.maxTime,
+            (unsigned)task.budget, (unsigned)task.numOverruns);
+    }
+
+    DebugTrace("Sched cycle: %u cycles, avg %u us, max %u us, budget %u us, overruns %u\n",
+        (unsigned)g_cycleStats.numCycles,
+        (unsigned)(g_cycleStats.numCycles ? g_cycleStats.totalTime / g_cycleStats.numCycles : 0),
+        (unsigned)g_cycleStats.maxTime, (unsigned)g_cycleStats.budget, (unsigned)g_cycleStats.numOverruns);
+}
+
+} // namespace scheduler
+} // namespace psu
+} // namespace eez
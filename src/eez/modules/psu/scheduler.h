@@ -0,0 +1,84 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2015-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+namespace eez {
+namespace psu {
+
+// Runs the PSU thread tasks on the tick. Every task has a period and a priority,
+// due tasks are executed in the order of priority and the normal and low priority tasks
+// are moved to the next tick when the time spent in the current tick is over the cycle budget.
+namespace scheduler {
+
+typedef void (*TaskFunc)(uint32_t tickCount);
+
+enum TaskPriority {
+    PRIORITY_CRITICAL, // never deferred
+    PRIORITY_HIGH,     // never deferred
+    PRIORITY_NORMAL,   // deferred at most once in a row
+    PRIORITY_LOW       // deferred at most once in a row
+};
+
+struct Task {
+    const char *name;
+    TaskFunc func;
+    TaskPriority priority;
+    uint32_t period; // us, 0 - on every tick
+    uint32_t phase;  // us, delay of the first run, used to spread the tasks with the same period
+    uint32_t budget; // us
+
+    uint32_t nextRunTime;
+    bool deferred;
+
+    uint32_t numRuns;
+    uint32_t numDeadlineMisses; // started one or more periods after it was due
+    uint32_t numOverruns;       // executed longer than the budget
+    uint32_t numDeferrals;      // moved to the next tick because of the cycle budget
+    uint32_t lastTime;          // us
+    uint32_t maxTime;           // us
+    uint64_t totalTime;         // us
+};
+
+struct CycleStats {
+    uint32_t budget; // us
+    uint32_t numCycles;
+    uint32_t numOverruns;
+    uint32_t maxTime;   // us
+    uint64_t totalTime; // us
+};
+
+/// Tasks must be sorted by priority.
+void init(Task *tasks, int numTasks, uint32_t cycleBudget);
+void tick(uint32_t tickCount);
+
+void resetStats();
+
+int getNumTasks();
+const Task &getTask(int taskIndex);
+const CycleStats &getCycleStats();
+
+/// Executes all the tasks numCycles times regardless of the period,
+/// must be called from the PSU thread. Stats are reset before.
+void benchmark(uint32_t numCycles);
+
+} // namespace scheduler
+} // namespace psu
+} // namespace eez
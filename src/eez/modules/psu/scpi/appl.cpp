@@ -88,6 +88,81 @@ scpi_result_t scpi_cmd_apply(scpi_t *context) {
     return SCPI_RES_OK;
 }
 
+scpi_result_t scpi_cmd_applyStage(scpi_t *context) {
+    Channel *channel = param_channel(context, TRUE);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    float voltage;
+    if (!get_voltage_param(context, voltage, channel, 0)) {
+        return SCPI_RES_ERR;
+    }
+
+    float current;
+    if (!get_current_param(context, current, channel, 0)) {
+        return SCPI_RES_ERR;
+    }
+
+    bool call_output_enable = false;
+    bool enable;
+    if (SCPI_ParamBool(context, &enable, FALSE)) {
+        call_output_enable = true;
+    } else if (SCPI_ParamErrorOccurred(context)) {
+        return SCPI_RES_ERR;
+    }
+
+    if (voltage > channel_dispatcher::getULimit(*channel)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_VOLTAGE_LIMIT_EXCEEDED);
+        return SCPI_RES_ERR;
+    }
+
+    if (current > channel_dispatcher::getILimit(*channel)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_CURRENT_LIMIT_EXCEEDED);
+        return SCPI_RES_ERR;
+    }
+
+    if (voltage * current > channel_dispatcher::getPowerLimit(*channel)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_POWER_LIMIT_EXCEEDED);
+        return SCPI_RES_ERR;
+    }
+
+    if (call_output_enable) {
+        bool callTriggerAbort = false;
+        int err;
+        if (!channel_dispatcher::testOutputEnable(*channel, enable, callTriggerAbort, &err)) {
+            SCPI_ErrorPush(context, err);
+            return SCPI_RES_ERR;
+        }
+        if (callTriggerAbort) {
+            SCPI_ErrorPush(context, SCPI_ERROR_CANNOT_CHANGE_TRANSIENT_TRIGGER);
+            return SCPI_RES_ERR;
+        }
+    }
+
+    channel_dispatcher::stageVoltage(*channel, voltage);
+    channel_dispatcher::stageCurrent(*channel, current);
+    if (call_output_enable) {
+        channel_dispatcher::stageOutputEnable(*channel, enable);
+    }
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_applyStageClear(scpi_t *context) {
+    channel_dispatcher::clearStaged();
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_applyCommit(scpi_t *context) {
+    int err;
+    if (!channel_dispatcher::commitStaged(&err)) {
+        SCPI_ErrorPush(context, err);
+        return SCPI_RES_ERR;
+    }
+    return SCPI_RES_OK;
+}
+
 scpi_result_t scpi_cmd_applyQ(scpi_t *context) {
     Channel *channel = param_channel(context, TRUE);
     if (!channel) {
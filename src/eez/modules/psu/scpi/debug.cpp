@@ -20,7 +20,11 @@
 #include <stdio.h>
 
 #include <eez/firmware.h>
+#include <eez/mp.h>
+#include <eez/number.h>
+#include <eez/sound.h>
 #include <eez/system.h>
+#include <eez/trace.h>
 
 #if OPTION_FAN
 #include <eez/modules/aux_ps/fan.h>
@@ -30,8 +34,15 @@
 #include <eez/modules/psu/serial_psu.h>
 #include <eez/modules/psu/temperature.h>
 #include <eez/modules/psu/ontime.h>
+#include <eez/modules/psu/persist_conf.h>
 #include <eez/modules/psu/scpi/psu.h>
 #include <eez/modules/psu/event_queue.h>
+#include <eez/modules/psu/mon_filter.h>
+#include <eez/modules/psu/profile.h>
+#include <eez/modules/psu/scheduler.h>
+#include <eez/modules/psu/sd_card.h>
+#include <eez/modules/psu/sd_worker.h>
+#include <eez/modules/psu/simulator_load.h>
 #if OPTION_DISPLAY
 #include <eez/modules/psu/gui/psu.h>
 #endif
@@ -50,6 +61,12 @@ using namespace debug;
 
 namespace scpi {
 
+#ifdef DEBUG
+static void benchmarkScheduler() {
+    scheduler::benchmark(1000);
+}
+#endif
+
 scpi_result_t scpi_cmd_debug(scpi_t *context) {
 #ifdef DEBUG
     int32_t cmd;
@@ -78,6 +95,79 @@ scpi_result_t scpi_cmd_debug(scpi_t *context) {
         // 
         } else if (cmd == 26) {
         	psu::gui::showPage(PAGE_ID_DEBUG_VARIABLES);
+        } else if (cmd == 27) {
+            eez::gui::setUpdateMode(eez::gui::UPDATE_MODE_FULL);
+        } else if (cmd == 28) {
+            eez::gui::setUpdateMode(eez::gui::UPDATE_MODE_RETAINED);
+        } else if (cmd == 29) {
+            eez::gui::setUpdateMode(eez::gui::UPDATE_MODE_VERIFY);
+        } else if (cmd == 30) {
+            osMessagePut(eez::gui::g_guiMessageQueueId, GUI_QUEUE_MESSAGE(psu::gui::GUI_QUEUE_MESSAGE_TYPE_TOUCH_INDEX_BENCHMARK, 10000), osWaitForever);
+        } else if (cmd == 31) {
+            uint32_t startTime = micros();
+            eez::gui::loadAllAssets();
+            DebugTrace("All assets loaded in %u us, %u KB\n", (unsigned)(micros() - startTime), (unsigned)(eez::gui::getAssetsLoadStats().ramUsed / 1024));
+        } else if (cmd == 32) {
+            if (!mp::isIdle()) {
+                SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+                return SCPI_RES_ERR;
+            }
+            eez::gui::benchmarkNameIndex(500, 10000);
+        } else if (cmd == 33) {
+            sd_worker::traceStats();
+            sd_worker::resetStats();
+        } else if (cmd == 34) {
+            sd_card::benchmarkTransfer(16 * 1024 * 1024);
+        } else if (cmd == 35) {
+            profile::benchmarkRecall(100);
+        } else if (cmd == 36) {
+            number::benchmark(100000);
+        } else if (cmd == 37) {
+            for (int i = 0; i < CH_NUM; i++) {
+                Channel &channel = Channel::get(i);
+                AdcStats stats;
+                if (channel.channelInterface && channel.channelInterface->getAdcStats(channel.subchannelIndex, stats)) {
+                    DebugTrace("CH%d ADC: schedule %d, %u conv/s (U %u, I %u), %u FIFO overflows, %u missed DRDY\n",
+                        i + 1, (int)stats.muxSchedule, (unsigned)stats.numConversions, (unsigned)stats.numUMonConversions,
+                        (unsigned)stats.numIMonConversions, (unsigned)stats.numFifoOverflows, (unsigned)stats.numMissedInterrupts);
+                }
+            }
+        } else if (cmd == 38) {
+            // DEBug 38,<channel>,<schedule>
+            int32_t channelIndex;
+            int32_t muxSchedule;
+            if (!SCPI_ParamInt32(context, &channelIndex, true) || !SCPI_ParamInt32(context, &muxSchedule, true)) {
+                return SCPI_RES_ERR;
+            }
+            if (channelIndex < 1 || channelIndex > CH_NUM) {
+                SCPI_ErrorPush(context, SCPI_ERROR_CHANNEL_NOT_FOUND);
+                return SCPI_RES_ERR;
+            }
+            if (muxSchedule != ADC_MUX_SCHEDULE_U_I && muxSchedule != ADC_MUX_SCHEDULE_U_BURST) {
+                SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+                return SCPI_RES_ERR;
+            }
+            Channel &channel = Channel::get(channelIndex - 1);
+            if (channel.channelInterface) {
+                channel.channelInterface->setAdcMuxSchedule(channel.subchannelIndex, (AdcMuxSchedule)muxSchedule);
+            }
+        } else if (cmd == 39) {
+#if defined(EEZ_PLATFORM_SIMULATOR)
+            simulator::runLoadScenarios();
+#else
+            SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+            return SCPI_RES_ERR;
+#endif
+        } else if (cmd == 40) {
+            benchmarkMonFilters(Channel::get(0).monFilterConf, 100000);
+        } else if (cmd == 41) {
+            // tasks are executed in the PSU thread
+            g_diagCallback = benchmarkScheduler;
+            while (g_diagCallback) {
+                osDelay(1);
+            }
+        } else if (cmd == 42) {
+            sound::benchmark(10);
         } else {
             SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
             return SCPI_RES_ERR;
@@ -466,6 +556,89 @@ scpi_result_t scpi_cmd_debugEvent(scpi_t *context) {
     return SCPI_RES_OK;
 }
 
+#if OPTION_TRACE
+static scpi_choice_def_t traceFormatChoice[] = {
+    { "JSON", trace::DUMP_FORMAT_JSON },
+    { "BINary", trace::DUMP_FORMAT_BINARY },
+    SCPI_CHOICE_LIST_END /* termination of option list */
+};
+#endif
+
+scpi_result_t scpi_cmd_debugTrace(scpi_t *context) {
+#if OPTION_TRACE
+    bool enable;
+    if (!SCPI_ParamBool(context, &enable, TRUE)) {
+        return SCPI_RES_ERR;
+    }
+
+    trace::setEnabled(enable);
+
+    return SCPI_RES_OK;
+#else
+    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+    return SCPI_RES_ERR;
+#endif
+}
+
+scpi_result_t scpi_cmd_debugTraceQ(scpi_t *context) {
+#if OPTION_TRACE
+    SCPI_ResultBool(context, trace::isEnabled());
+
+    return SCPI_RES_OK;
+#else
+    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+    return SCPI_RES_ERR;
+#endif
+}
+
+scpi_result_t scpi_cmd_debugTraceClear(scpi_t *context) {
+#if OPTION_TRACE
+    trace::clear();
+
+    return SCPI_RES_OK;
+#else
+    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+    return SCPI_RES_ERR;
+#endif
+}
+
+scpi_result_t scpi_cmd_debugTraceDump(scpi_t *context) {
+#if OPTION_TRACE
+    if (persist_conf::isSdLocked()) {
+        SCPI_ErrorPush(context, SCPI_ERROR_MEDIA_PROTECTED);
+        return SCPI_RES_ERR;
+    }
+
+    char filePath[MAX_PATH_LENGTH + 1];
+    if (!getFilePath(context, filePath, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    int32_t format = trace::DUMP_FORMAT_JSON;
+    if (!SCPI_ParamChoice(context, traceFormatChoice, &format, false)) {
+        if (SCPI_ParamErrorOccurred(context)) {
+            return SCPI_RES_ERR;
+        }
+    }
+
+    int err;
+    if (!sd_card::isMounted(&err)) {
+        SCPI_ErrorPush(context, err);
+        return SCPI_RES_ERR;
+    }
+
+    if (!trace::postDump(filePath, (trace::DumpFormat)format)) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    return SCPI_RES_OK;
+#else
+    SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
+    return SCPI_RES_ERR;
+#endif
+}
+
 } // namespace scpi
 } // namespace psu
 } // namespace eez
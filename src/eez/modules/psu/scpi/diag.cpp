@@ -24,6 +24,7 @@
 #include <eez/modules/psu/psu.h>
 #include <eez/modules/psu/calibration.h>
 #include <eez/modules/psu/devices.h>
+#include <eez/modules/psu/scheduler.h>
 #include <eez/modules/psu/scpi/psu.h>
 #include <eez/modules/psu/temperature.h>
 
@@ -315,6 +316,79 @@ scpi_result_t scpi_cmd_diagnosticInformationProtectionQ(scpi_t *context) {
     return SCPI_RES_OK;
 }
 
+static void printProtectionLatency(scpi_t *context, char *buffer, int channelIndex, const char *prefix, ProtectionLatency &latency) {
+    sprintf(buffer, "CH%d %s_trips=%u", channelIndex, prefix, (unsigned)latency.numTrips);
+    SCPI_ResultText(context, buffer);
+
+    if (latency.numTrips == 0) {
+        return;
+    }
+
+    sprintf(buffer, "CH%d %s_latency_last=%u us", channelIndex, prefix, (unsigned)latency.last);
+    SCPI_ResultText(context, buffer);
+    sprintf(buffer, "CH%d %s_latency_min=%u us", channelIndex, prefix, (unsigned)latency.min);
+    SCPI_ResultText(context, buffer);
+    sprintf(buffer, "CH%d %s_latency_max=%u us", channelIndex, prefix, (unsigned)latency.max);
+    SCPI_ResultText(context, buffer);
+
+    for (int i = 0; i < PROTECTION_LATENCY_NUM_BINS; i++) {
+        if (i < PROTECTION_LATENCY_NUM_BINS - 1) {
+            sprintf(buffer, "CH%d %s_latency_lt_%u_us=%u", channelIndex, prefix,
+                (unsigned)PROTECTION_LATENCY_BIN_LIMITS[i], (unsigned)latency.bins[i]);
+        } else {
+            sprintf(buffer, "CH%d %s_latency_ge_%u_us=%u", channelIndex, prefix,
+                (unsigned)PROTECTION_LATENCY_BIN_LIMITS[i - 1], (unsigned)latency.bins[i]);
+        }
+        SCPI_ResultText(context, buffer);
+    }
+}
+
+scpi_result_t scpi_cmd_diagnosticInformationProtectionLatencyQ(scpi_t *context) {
+    char buffer[128] = { 0 };
+
+    for (int i = 0; i < CH_NUM; ++i) {
+        Channel &channel = Channel::get(i);
+        printProtectionLatency(context, buffer, i + 1, "u", channel.ovp.latency);
+        printProtectionLatency(context, buffer, i + 1, "i", channel.ocp.latency);
+        printProtectionLatency(context, buffer, i + 1, "p", channel.opp.latency);
+    }
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_diagnosticInformationSchedulerQ(scpi_t *context) {
+    char buffer[128] = { 0 };
+
+    const scheduler::CycleStats &cycleStats = scheduler::getCycleStats();
+    sprintf(buffer, "cycle: n=%u, avg=%u us, max=%u us, budget=%u us, overruns=%u",
+        (unsigned)cycleStats.numCycles,
+        (unsigned)(cycleStats.numCycles ? cycleStats.totalTime / cycleStats.numCycles : 0),
+        (unsigned)cycleStats.maxTime, (unsigned)cycleStats.budget, (unsigned)cycleStats.numOverruns);
+    SCPI_ResultText(context, buffer);
+
+    for (int i = 0; i < scheduler::getNumTasks(); ++i) {
+        const scheduler::Task &task = scheduler::getTask(i);
+        sprintf(buffer, "%s: n=%u, avg=%u us, max=%u us, budget=%u us, overruns=%u, misses=%u, deferrals=%u",
+            task.name, (unsigned)task.numRuns,
+            (unsigned)(task.numRuns ? task.totalTime / task.numRuns : 0),
+            (unsigned)task.maxTime, (unsigned)task.budget, (unsigned)task.numOverruns,
+            (unsigned)task.numDeadlineMisses, (unsigned)task.numDeferrals);
+        SCPI_ResultText(context, buffer);
+    }
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_diagnosticInformationSchedulerClear(scpi_t *context) {
+    // stats are updated in the PSU thread
+    g_diagCallback = scheduler::resetStats;
+    while (g_diagCallback) {
+        osDelay(1);
+    }
+
+    return SCPI_RES_OK;
+}
+
 scpi_result_t scpi_cmd_diagnosticInformationTestQ(scpi_t *context) {
     int32_t deviceId = -1;
     if (!SCPI_ParamChoice(context, devices::g_deviceChoice, &deviceId, false)) {
@@ -30,6 +30,9 @@
 #include <eez/modules/psu/dlog_record.h>
 #include <eez/modules/psu/dlog_view.h>
 
+#include <eez/scpi/scpi.h>
+
+#include <eez/libs/image/bitmap.h>
 #include <eez/libs/image/jpeg.h>
 
 namespace eez {
@@ -166,29 +169,108 @@ scpi_result_t scpi_cmd_displayWindowTextClear(scpi_t *context) {
 #endif
 }
 
+#if OPTION_DISPLAY
+
+enum {
+    IMAGE_FORMAT_JPEG,
+    IMAGE_FORMAT_BMP,
+    IMAGE_FORMAT_JPEG_STREAM
+};
+
+static scpi_choice_def_t imageFormatChoice[] = {
+    { "JPEG", IMAGE_FORMAT_JPEG },
+    { "BMP", IMAGE_FORMAT_BMP },
+    { "JSTReam", IMAGE_FORMAT_JPEG_STREAM },
+    SCPI_CHOICE_LIST_END /* termination of option list */
+};
+
+static scpi_t *g_screenshotContext;
+static uint32_t g_screenshotStartTime;
+static bool g_screenshotFirstByteWritten;
+
+static void onScreenshotFirstByte() {
+    if (!g_screenshotFirstByteWritten) {
+        g_screenshotFirstByteWritten = true;
+#ifdef DEBUG
+        debug::g_screenshotTimeToFirstByte.set(micros() - g_screenshotStartTime);
+#endif
+    }
+}
+
+static bool writeScreenshotData(const uint8_t *data, size_t size) {
+    onScreenshotFirstByte();
+    SCPI_ResultArbitraryBlockData(g_screenshotContext, data, size);
+    return true;
+}
+
+// libscpi has no support for the indefinite length block, so it is written directly to the interface
+static bool writeScreenshotIndefiniteLengthBlockData(const uint8_t *data, size_t size) {
+    onScreenshotFirstByte();
+    g_screenshotContext->interface->write(g_screenshotContext, (const char *)data, size);
+    return true;
+}
+
+#endif
+
 scpi_result_t scpi_cmd_displayDataQ(scpi_t *context) {
 #if OPTION_DISPLAY
+    int32_t format;
+    if (!SCPI_ParamChoice(context, imageFormatChoice, &format, false)) {
+        if (SCPI_ParamErrorOccurred(context)) {
+            return SCPI_RES_ERR;
+        }
+        format = IMAGE_FORMAT_JPEG;
+    }
+
+    g_screenshotContext = context;
+    g_screenshotStartTime = micros();
+    g_screenshotFirstByteWritten = false;
+
+    eez::scpi::lockScreenshot();
+
     const uint8_t *screenshotPixels = mcu::display::takeScreenshot();
 
-    unsigned char* imageData;
-    size_t imageDataSize;
+    if (format == IMAGE_FORMAT_BMP) {
+        // size is known in advance, so pixels are sent while they are converted
+        SCPI_ResultArbitraryBlockHeader(context, BITMAP_SCREENSHOT_SIZE);
+        bitmapEncodeStream(screenshotPixels, writeScreenshotData);
+    } else if (format == IMAGE_FORMAT_JPEG_STREAM) {
+        // opt-in: JPEG is sent while it is encoded as IEEE 488.2 indefinite length block (#0),
+        // client must read until the connection is idle, because JPEG data can contain the terminator
+        writeScreenshotIndefiniteLengthBlockData((const uint8_t *)"#0", 2);
+        jpegEncodeStream(screenshotPixels, writeScreenshotIndefiniteLengthBlockData);
+        context->output_count++; // so the response terminator is written
+    } else {
+        // block header needs JPEG size, so whole image is encoded before it is sent
+        unsigned char* imageData;
+        size_t imageDataSize;
 
-    if (jpegEncode(screenshotPixels, &imageData, &imageDataSize)) {
-    	SCPI_ErrorPush(context, SCPI_ERROR_OUT_OF_MEMORY_FOR_REQ_OP);
-    	return SCPI_RES_ERR;
-    }
+        if (jpegEncode(screenshotPixels, &imageData, &imageDataSize)) {
+            eez::scpi::unlockScreenshot();
+            SCPI_ErrorPush(context, SCPI_ERROR_OUT_OF_MEMORY_FOR_REQ_OP);
+            return SCPI_RES_ERR;
+        }
+
+        onScreenshotFirstByte();
 
-    SCPI_ResultArbitraryBlockHeader(context, imageDataSize);
+        SCPI_ResultArbitraryBlockHeader(context, imageDataSize);
 
-    static const size_t CHUNK_SIZE = 1024;
+        static const size_t CHUNK_SIZE = 1024;
 
-    while (imageDataSize > 0) {
-        size_t n = MIN(imageDataSize, CHUNK_SIZE);
-        SCPI_ResultArbitraryBlockData(context, imageData, n);
-        imageData += n;
-        imageDataSize -= n;
+        while (imageDataSize > 0) {
+            size_t n = MIN(imageDataSize, CHUNK_SIZE);
+            SCPI_ResultArbitraryBlockData(context, imageData, n);
+            imageData += n;
+            imageDataSize -= n;
+        }
     }
 
+    eez::scpi::unlockScreenshot();
+
+#ifdef DEBUG
+    debug::g_screenshotDuration.set(micros() - g_screenshotStartTime);
+#endif
+
     return SCPI_RES_OK;
 #else
     SCPI_ErrorPush(context, SCPI_ERROR_HARDWARE_MISSING);
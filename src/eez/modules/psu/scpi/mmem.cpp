@@ -184,8 +184,6 @@ void uploadCallback(void *param, const void *buffer, int size) {
     } else {
         SCPI_ResultArbitraryBlockData(context, buffer, size);
     }
-
-    osDelay(0);
 }
 
 bool mmemUpload(const char *filePath, scpi_t *context, int *err) {
@@ -263,6 +261,12 @@ scpi_result_t scpi_cmd_mmemoryDownloadFname(scpi_t *context) {
     }
 
     if (g_downloading) {
+        int err;
+        if (!sd_card::downloadSync(&err)) {
+            finishDownloading(event_queue::EVENT_ERROR_FILE_DOWNLOAD_FAILED);
+            SCPI_ErrorPush(context, err);
+            return SCPI_RES_ERR;
+        }
         finishDownloading(event_queue::EVENT_INFO_FILE_DOWNLOAD_SUCCEEDED);
         return SCPI_RES_OK;
     }
@@ -333,6 +337,21 @@ scpi_result_t scpi_cmd_mmemoryDownloadData(scpi_t *context) {
     return SCPI_RES_OK;
 }
 
+scpi_result_t scpi_cmd_mmemoryDownloadSync(scpi_t *context) {
+    if (!g_downloading) {
+        return SCPI_RES_OK;
+    }
+
+    int err;
+    if (!sd_card::downloadSync(&err)) {
+        finishDownloading(event_queue::EVENT_ERROR_FILE_DOWNLOAD_FAILED);
+        SCPI_ErrorPush(context, err);
+        return SCPI_RES_ERR;
+    }
+
+    return SCPI_RES_OK;
+}
+
 scpi_result_t scpi_cmd_mmemoryDownloadAbort(scpi_t *context) {
     abortDownloading();
     return SCPI_RES_OK;
@@ -159,6 +159,82 @@ scpi_result_t scpi_cmd_senseCurrentDcRangeAutoQ(scpi_t *context) {
     return SCPI_RES_OK;
 }
 
+static scpi_choice_def_t monTapChoice[] = {
+    { "FAST", MON_TAP_FAST },
+    { "DISPlay", MON_TAP_DISPLAY },
+    { "DLOG", MON_TAP_DLOG },
+    SCPI_CHOICE_LIST_END /* termination of option list */
+};
+
+scpi_result_t scpi_cmd_senseMonitorFilter(scpi_t *context) {
+    int32_t tap;
+    if (!SCPI_ParamChoice(context, monTapChoice, &tap, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    Channel *channel = param_channel(context);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    MonFilterConf conf = channel->monFilterConf[tap];
+
+    int32_t length;
+    if (!SCPI_ParamInt32(context, &length, true)) {
+        return SCPI_RES_ERR;
+    }
+    if (length < 1 || length > MON_FILTER_MAX_LENGTH) {
+        SCPI_ErrorPush(context, SCPI_ERROR_DATA_OUT_OF_RANGE);
+        return SCPI_RES_ERR;
+    }
+    conf.length = (uint16_t)length;
+
+    int32_t decimation;
+    if (SCPI_ParamInt32(context, &decimation, false)) {
+        if (decimation < 1 || decimation > MON_FILTER_MAX_DECIMATION) {
+            SCPI_ErrorPush(context, SCPI_ERROR_DATA_OUT_OF_RANGE);
+            return SCPI_RES_ERR;
+        }
+        conf.decimation = (uint16_t)decimation;
+    } else if (SCPI_ParamErrorOccurred(context)) {
+        return SCPI_RES_ERR;
+    }
+
+    float iirCoefficient;
+    if (SCPI_ParamFloat(context, &iirCoefficient, false)) {
+        if (iirCoefficient < 0 || iirCoefficient > 1.0f) {
+            SCPI_ErrorPush(context, SCPI_ERROR_DATA_OUT_OF_RANGE);
+            return SCPI_RES_ERR;
+        }
+        conf.iirCoefficient = iirCoefficient;
+    } else if (SCPI_ParamErrorOccurred(context)) {
+        return SCPI_RES_ERR;
+    }
+
+    channel->setMonFilterConf((MonTap)tap, conf);
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_senseMonitorFilterQ(scpi_t *context) {
+    int32_t tap;
+    if (!SCPI_ParamChoice(context, monTapChoice, &tap, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    Channel *channel = param_channel(context);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    const MonFilterConf &conf = channel->monFilterConf[tap];
+    SCPI_ResultInt32(context, conf.length);
+    SCPI_ResultInt32(context, conf.decimation);
+    SCPI_ResultFloat(context, conf.iirCoefficient);
+
+    return SCPI_RES_OK;
+}
+
 } // namespace scpi
 } // namespace psu
 } // namespace eez
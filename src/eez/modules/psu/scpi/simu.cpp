@@ -24,6 +24,7 @@
 
 #include <eez/modules/psu/channel_dispatcher.h>
 #include <eez/modules/psu/io_pins.h>
+#include <eez/modules/psu/simulator_load.h>
 
 // SIMULATOR SPECIFC CONFIG
 #define SIM_LOAD_MIN 0
@@ -72,6 +73,48 @@ bool get_resistance_from_param(scpi_t *context, const scpi_number_t &param, floa
     return true;
 }
 
+static scpi_choice_def_t loadTypeChoice[] = {
+    { "RESistor", LOAD_TYPE_RESISTOR },
+    { "RC", LOAD_TYPE_RC },
+    { "RL", LOAD_TYPE_RL },
+    { "CCURrent", LOAD_TYPE_CC },
+    { "CPOWer", LOAD_TYPE_CP },
+    { "BATTery", LOAD_TYPE_BATTERY },
+    { "PROFile", LOAD_TYPE_PROFILE },
+    SCPI_CHOICE_LIST_END /* termination of option list */
+};
+
+static bool get_load_model_param(scpi_t *context, float &value, float min, float max, scpi_unit_t unit) {
+    scpi_number_t param;
+    if (!SCPI_ParamNumber(context, scpi_special_numbers_def, &param, true)) {
+        return false;
+    }
+
+    if (param.special) {
+        if (param.content.tag == SCPI_NUM_MAX) {
+            value = max;
+        } else if (param.content.tag == SCPI_NUM_MIN) {
+            value = min;
+        } else {
+            SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+            return false;
+        }
+    } else {
+        if (param.unit != SCPI_UNIT_NONE && param.unit != unit) {
+            SCPI_ErrorPush(context, SCPI_ERROR_INVALID_SUFFIX);
+            return false;
+        }
+
+        value = (float)param.content.value;
+        if (value < min || value > max) {
+            SCPI_ErrorPush(context, SCPI_ERROR_DATA_OUT_OF_RANGE);
+            return false;
+        }
+    }
+
+    return true;
+}
+
 static bool get_resistance_param(scpi_t *context, float &value) {
     scpi_number_t param;
     if (!SCPI_ParamNumber(context, scpi_special_numbers_def, &param, true)) {
@@ -157,6 +200,253 @@ scpi_result_t scpi_cmd_simulatorLoadQ(scpi_t *context) {
     return result_float(context, channel, value, UNIT_OHM);
 }
 
+scpi_result_t scpi_cmd_simulatorLoadType(scpi_t *context) {
+    int32_t type;
+    if (!SCPI_ParamChoice(context, loadTypeChoice, &type, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    Channel *channel = param_channel(context, FALSE, TRUE);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    if (type == LOAD_TYPE_PROFILE && getLoadModel(channel->channelIndex).profileLength == 0) {
+        SCPI_ErrorPush(context, SCPI_ERROR_EXECUTION_ERROR);
+        return SCPI_RES_ERR;
+    }
+
+    setLoadType(channel->channelIndex, (LoadType)type);
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_simulatorLoadTypeQ(scpi_t *context) {
+    Channel *channel = param_channel(context, FALSE, TRUE);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    resultChoiceName(context, loadTypeChoice, getLoadModel(channel->channelIndex).type);
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_simulatorLoadCapacitance(scpi_t *context) {
+    float value;
+    if (!get_load_model_param(context, value, 0, 10.0f, SCPI_UNIT_FARAD)) {
+        return SCPI_RES_ERR;
+    }
+
+    Channel *channel = param_channel(context, FALSE, TRUE);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    getLoadModel(channel->channelIndex).capacitance = value;
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_simulatorLoadCapacitanceQ(scpi_t *context) {
+    Channel *channel = param_channel(context, FALSE, TRUE);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    return result_float(context, channel, getLoadModel(channel->channelIndex).capacitance, UNIT_FARAD);
+}
+
+scpi_result_t scpi_cmd_simulatorLoadInductance(scpi_t *context) {
+    float value;
+    if (!get_load_model_param(context, value, 0, 10.0f, SCPI_UNIT_HENRY)) {
+        return SCPI_RES_ERR;
+    }
+
+    Channel *channel = param_channel(context, FALSE, TRUE);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    getLoadModel(channel->channelIndex).inductance = value;
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_simulatorLoadInductanceQ(scpi_t *context) {
+    Channel *channel = param_channel(context, FALSE, TRUE);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    return result_float(context, channel, getLoadModel(channel->channelIndex).inductance, UNIT_NONE);
+}
+
+scpi_result_t scpi_cmd_simulatorLoadCurrent(scpi_t *context) {
+    float value;
+    if (!get_load_model_param(context, value, 0, 100.0f, SCPI_UNIT_AMPER)) {
+        return SCPI_RES_ERR;
+    }
+
+    Channel *channel = param_channel(context, FALSE, TRUE);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    getLoadModel(channel->channelIndex).current = value;
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_simulatorLoadCurrentQ(scpi_t *context) {
+    Channel *channel = param_channel(context, FALSE, TRUE);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    return result_float(context, channel, getLoadModel(channel->channelIndex).current, UNIT_AMPER);
+}
+
+scpi_result_t scpi_cmd_simulatorLoadPower(scpi_t *context) {
+    float value;
+    if (!get_load_model_param(context, value, 0, 1000.0f, SCPI_UNIT_WATT)) {
+        return SCPI_RES_ERR;
+    }
+
+    Channel *channel = param_channel(context, FALSE, TRUE);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    getLoadModel(channel->channelIndex).power = value;
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_simulatorLoadPowerQ(scpi_t *context) {
+    Channel *channel = param_channel(context, FALSE, TRUE);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    return result_float(context, channel, getLoadModel(channel->channelIndex).power, UNIT_WATT);
+}
+
+scpi_result_t scpi_cmd_simulatorLoadBattery(scpi_t *context) {
+    float ocvEmpty;
+    if (!get_load_model_param(context, ocvEmpty, 0, 100.0f, SCPI_UNIT_VOLT)) {
+        return SCPI_RES_ERR;
+    }
+
+    float ocvFull;
+    if (!get_load_model_param(context, ocvFull, 0, 100.0f, SCPI_UNIT_VOLT)) {
+        return SCPI_RES_ERR;
+    }
+
+    float resistance;
+    if (!get_load_model_param(context, resistance, 0, 100.0f, SCPI_UNIT_OHM)) {
+        return SCPI_RES_ERR;
+    }
+
+    float capacity;
+    if (!get_load_model_param(context, capacity, 0.001f, 1000.0f, SCPI_UNIT_NONE)) {
+        return SCPI_RES_ERR;
+    }
+
+    if (ocvEmpty > ocvFull) {
+        SCPI_ErrorPush(context, SCPI_ERROR_ILLEGAL_PARAMETER_VALUE);
+        return SCPI_RES_ERR;
+    }
+
+    Channel *channel = param_channel(context, FALSE, TRUE);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    LoadModel &model = getLoadModel(channel->channelIndex);
+    model.batteryOcvEmpty = ocvEmpty;
+    model.batteryOcvFull = ocvFull;
+    model.batteryResistance = resistance;
+    model.batteryCapacity = capacity;
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_simulatorLoadBatterySoc(scpi_t *context) {
+    float value;
+    if (!get_load_model_param(context, value, 0, 100.0f, SCPI_UNIT_NONE)) {
+        return SCPI_RES_ERR;
+    }
+
+    Channel *channel = param_channel(context, FALSE, TRUE);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    getLoadModel(channel->channelIndex).batterySoc = value / 100.0f;
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_simulatorLoadBatterySocQ(scpi_t *context) {
+    Channel *channel = param_channel(context, FALSE, TRUE);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    return result_float(context, channel, getLoadModel(channel->channelIndex).batterySoc * 100.0f, UNIT_PERCENT);
+}
+
+scpi_result_t scpi_cmd_simulatorLoadProfile(scpi_t *context) {
+    char filePath[MAX_PATH_LENGTH + 1];
+    if (!getFilePath(context, filePath, true)) {
+        return SCPI_RES_ERR;
+    }
+
+    Channel *channel = param_channel(context, FALSE, TRUE);
+    if (!channel) {
+        return SCPI_RES_ERR;
+    }
+
+    int err;
+    if (!loadProfile(channel->channelIndex, filePath, &err)) {
+        SCPI_ErrorPush(context, err);
+        return SCPI_RES_ERR;
+    }
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_simulatorSlew(scpi_t *context) {
+    float value;
+    if (!get_load_model_param(context, value, 1.0f, 1000000.0f, SCPI_UNIT_NONE)) {
+        return SCPI_RES_ERR;
+    }
+
+    setOutputSlewRate(value);
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_simulatorSlewQ(scpi_t *context) {
+    return result_float(context, 0, getOutputSlewRate(), UNIT_NONE);
+}
+
+scpi_result_t scpi_cmd_simulatorNoise(scpi_t *context) {
+    float value;
+    if (!get_load_model_param(context, value, 0, 1000.0f, SCPI_UNIT_NONE)) {
+        return SCPI_RES_ERR;
+    }
+
+    setAdcNoise(value);
+
+    return SCPI_RES_OK;
+}
+
+scpi_result_t scpi_cmd_simulatorNoiseQ(scpi_t *context) {
+    return result_float(context, 0, getAdcNoise(), UNIT_NONE);
+}
+
 scpi_result_t scpi_cmd_simulatorVoltageProgramExternal(scpi_t *context) {
 
     float value;
@@ -402,6 +692,96 @@ scpi_result_t scpi_cmd_simulatorLoadQ(scpi_t *context) {
     return SCPI_RES_ERR;
 }
 
+scpi_result_t scpi_cmd_simulatorLoadType(scpi_t *context) {
+    SCPI_ErrorPush(context, SCPI_ERROR_UNDEFINED_HEADER);
+    return SCPI_RES_ERR;
+}
+
+scpi_result_t scpi_cmd_simulatorLoadTypeQ(scpi_t *context) {
+    SCPI_ErrorPush(context, SCPI_ERROR_UNDEFINED_HEADER);
+    return SCPI_RES_ERR;
+}
+
+scpi_result_t scpi_cmd_simulatorLoadCapacitance(scpi_t *context) {
+    SCPI_ErrorPush(context, SCPI_ERROR_UNDEFINED_HEADER);
+    return SCPI_RES_ERR;
+}
+
+scpi_result_t scpi_cmd_simulatorLoadCapacitanceQ(scpi_t *context) {
+    SCPI_ErrorPush(context, SCPI_ERROR_UNDEFINED_HEADER);
+    return SCPI_RES_ERR;
+}
+
+scpi_result_t scpi_cmd_simulatorLoadInductance(scpi_t *context) {
+    SCPI_ErrorPush(context, SCPI_ERROR_UNDEFINED_HEADER);
+    return SCPI_RES_ERR;
+}
+
+scpi_result_t scpi_cmd_simulatorLoadInductanceQ(scpi_t *context) {
+    SCPI_ErrorPush(context, SCPI_ERROR_UNDEFINED_HEADER);
+    return SCPI_RES_ERR;
+}
+
+scpi_result_t scpi_cmd_simulatorLoadCurrent(scpi_t *context) {
+    SCPI_ErrorPush(context, SCPI_ERROR_UNDEFINED_HEADER);
+    return SCPI_RES_ERR;
+}
+
+scpi_result_t scpi_cmd_simulatorLoadCurrentQ(scpi_t *context) {
+    SCPI_ErrorPush(context, SCPI_ERROR_UNDEFINED_HEADER);
+    return SCPI_RES_ERR;
+}
+
+scpi_result_t scpi_cmd_simulatorLoadPower(scpi_t *context) {
+    SCPI_ErrorPush(context, SCPI_ERROR_UNDEFINED_HEADER);
+    return SCPI_RES_ERR;
+}
+
+scpi_result_t scpi_cmd_simulatorLoadPowerQ(scpi_t *context) {
+    SCPI_ErrorPush(context, SCPI_ERROR_UNDEFINED_HEADER);
+    return SCPI_RES_ERR;
+}
+
+scpi_result_t scpi_cmd_simulatorLoadBattery(scpi_t *context) {
+    SCPI_ErrorPush(context, SCPI_ERROR_UNDEFINED_HEADER);
+    return SCPI_RES_ERR;
+}
+
+scpi_result_t scpi_cmd_simulatorLoadBatterySoc(scpi_t *context) {
+    SCPI_ErrorPush(context, SCPI_ERROR_UNDEFINED_HEADER);
+    return SCPI_RES_ERR;
+}
+
+scpi_result_t scpi_cmd_simulatorLoadBatterySocQ(scpi_t *context) {
+    SCPI_ErrorPush(context, SCPI_ERROR_UNDEFINED_HEADER);
+    return SCPI_RES_ERR;
+}
+
+scpi_result_t scpi_cmd_simulatorLoadProfile(scpi_t *context) {
+    SCPI_ErrorPush(context, SCPI_ERROR_UNDEFINED_HEADER);
+    return SCPI_RES_ERR;
+}
+
+scpi_result_t scpi_cmd_simulatorSlew(scpi_t *context) {
+    SCPI_ErrorPush(context, SCPI_ERROR_UNDEFINED_HEADER);
+    return SCPI_RES_ERR;
+}
+
+scpi_result_t scpi_cmd_simulatorSlewQ(scpi_t *context) {
+    SCPI_ErrorPush(context, SCPI_ERROR_UNDEFINED_HEADER);
+    return SCPI_RES_ERR;
+}
+
+scpi_result_t scpi_cmd_simulatorNoise(scpi_t *context) {
+    SCPI_ErrorPush(context, SCPI_ERROR_UNDEFINED_HEADER);
+    return SCPI_RES_ERR;
+}
+
+scpi_result_t scpi_cmd_simulatorNoiseQ(scpi_t *context) {
+    SCPI_ErrorPush(context, SCPI_ERROR_UNDEFINED_HEADER);
+    return SCPI_RES_ERR;
+}
+
 scpi_result_t scpi_cmd_simulatorVoltageProgramExternal(scpi_t *context) {
     SCPI_ErrorPush(context, SCPI_ERROR_UNDEFINED_HEADER);
     return SCPI_RES_ERR;
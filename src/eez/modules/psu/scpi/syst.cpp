@@ -260,7 +260,38 @@ scpi_result_t scpi_cmd_systemTimeZoneQ(scpi_t *context) {
 }
 
 scpi_result_t scpi_cmd_systemBeeperImmediate(scpi_t *context) {
-    sound::playBeep(true);
+    // optional [<frequency>[,<duration>]], synthesized as a single note
+    float frequency;
+    if (!SCPI_ParamFloat(context, &frequency, false)) {
+        if (SCPI_ParamErrorOccurred(context)) {
+            return SCPI_RES_ERR;
+        }
+        sound::playBeep(true);
+        return SCPI_RES_OK;
+    }
+
+    // above the half of the sample rate the note would be aliased
+    if (frequency < 20.0f || frequency > 20000.0f || frequency >= sound::getMaxNoteFrequency()) {
+        SCPI_ErrorPush(context, SCPI_ERROR_DATA_OUT_OF_RANGE);
+        return SCPI_RES_ERR;
+    }
+
+    float duration;
+    if (!SCPI_ParamFloat(context, &duration, false)) {
+        if (SCPI_ParamErrorOccurred(context)) {
+            return SCPI_RES_ERR;
+        }
+        duration = 0.1f;
+    }
+
+    if (duration < 0.001f || duration > 10.0f) {
+        SCPI_ErrorPush(context, SCPI_ERROR_DATA_OUT_OF_RANGE);
+        return SCPI_RES_ERR;
+    }
+
+    float notes[] = { frequency, duration, NAN };
+    sound::playNotes(notes);
+
     return SCPI_RES_OK;
 }
 
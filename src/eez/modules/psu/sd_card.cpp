@@ -26,6 +26,8 @@
 #endif
 
 #include <eez/firmware.h>
+#include <eez/memory.h>
+#include <eez/number.h>
 
 #include <eez/modules/psu/psu.h>
 
@@ -37,6 +39,8 @@
 #include <eez/modules/psu/list_program.h>
 #include <eez/modules/psu/profile.h>
 #include <eez/modules/psu/sd_card.h>
+#include <eez/modules/psu/sd_worker.h>
+#include <eez/modules/psu/debug.h>
 #include <eez/modules/psu/scpi/psu.h>
 
 #if OPTION_DISPLAY
@@ -51,7 +55,7 @@ extern "C" int g_sdCardIsPresent;
 #endif
 
 #define CONF_DEBOUNCE_TIMEOUT_MS 500
-#define CONF_DOWNLOAD_TIMEOUT_MS 10000
+#define CONF_SD_TRANSFER_CHUNK_SIZE (32 * 1024)
 
 namespace eez {
 
@@ -84,6 +88,10 @@ static File g_downloadFile;
 static uint32_t g_downloadedFileOffset;
 static char g_downloadFilePath[MAX_PATH_LENGTH + 1];
 
+// SD worker puts the index of the finished transfer buffer here
+osMessageQDef(g_transferMessageQueue, 2, uint32_t);
+osMessageQId g_transferMessageQueueId;
+
 static uint32_t g_getInfoVersion;
 
 static uint32_t g_debounceTimeout;
@@ -96,6 +104,8 @@ static void testTimeoutEvent(uint32_t &timeout, Event timeoutEvent);
 ////////////////////////////////////////////////////////////////////////////////
 
 void init() {
+    g_transferMessageQueueId = osMessageCreate(osMessageQ(g_transferMessageQueue), NULL);
+
 #if defined(EEZ_PLATFORM_STM32)
     MX_SDMMC1_SD_Init();
 	g_sdCardIsPresent = HAL_GPIO_ReadPin(SD_DETECT_GPIO_Port, SD_DETECT_Pin) == GPIO_PIN_RESET ? 1 : 0;
@@ -226,6 +236,8 @@ bool catalog(const char *dirPath, void *param,
             callback(param != nullptr ? param : &fileInfo, name, type, fileInfo.getSize());
         }
 
+        sd_worker::writeDlogIfDue();
+
         if (dir.findNext(fileInfo) != SD_FAT_RESULT_OK) {
             break;
         }
@@ -267,6 +279,83 @@ bool catalogLength(const char *dirPath, size_t *length, int *err) {
     return true;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+
+struct TransferBuffer {
+    uint8_t *data;
+    uint32_t size;
+    bool write;
+    volatile bool pending;
+    bool result;
+};
+
+static uint32_t g_transferChunkSize = CONF_SD_TRANSFER_CHUNK_SIZE;
+static TransferBuffer g_transferBuffers[2] = {
+    { SD_TRANSFER_BUFFER, 0, false, false, true },
+    { SD_TRANSFER_BUFFER + SD_TRANSFER_MAX_CHUNK_SIZE, 0, false, false, true }
+};
+static File *g_transferFile;
+
+static int g_downloadBufferIndex;
+static uint32_t g_downloadStartTime;
+
+void setTransferChunkSize(uint32_t chunkSize) {
+    if (chunkSize < SD_TRANSFER_MIN_CHUNK_SIZE) {
+        chunkSize = SD_TRANSFER_MIN_CHUNK_SIZE;
+    } else if (chunkSize > SD_TRANSFER_MAX_CHUNK_SIZE) {
+        chunkSize = SD_TRANSFER_MAX_CHUNK_SIZE;
+    }
+    g_transferChunkSize = chunkSize;
+}
+
+uint32_t getTransferChunkSize() {
+    return g_transferChunkSize;
+}
+
+void executeTransferRequest(int bufferIndex) {
+    TransferBuffer &transferBuffer = g_transferBuffers[bufferIndex];
+
+    if (transferBuffer.write) {
+        transferBuffer.result = g_transferFile->write(transferBuffer.data, transferBuffer.size) == transferBuffer.size;
+    } else {
+        transferBuffer.size = g_transferFile->read(transferBuffer.data, g_transferChunkSize);
+        transferBuffer.result = true;
+    }
+
+    osMessagePut(g_transferMessageQueueId, bufferIndex, osWaitForever);
+}
+
+static void startTransfer(int bufferIndex, bool write) {
+    TransferBuffer &transferBuffer = g_transferBuffers[bufferIndex];
+    transferBuffer.write = write;
+    transferBuffer.pending = true;
+
+#if !defined(__EMSCRIPTEN__)
+    if (sd_worker::g_sdWorkerTaskHandle && osThreadGetId() != sd_worker::g_sdWorkerTaskHandle) {
+        sd_worker::postRequest(sd_worker::REQUEST_SD_TRANSFER, bufferIndex);
+        return;
+    }
+#endif
+
+    executeTransferRequest(bufferIndex);
+}
+
+static bool waitTransfer(int bufferIndex) {
+    while (g_transferBuffers[bufferIndex].pending) {
+        osEvent event = osMessageGet(g_transferMessageQueueId, osWaitForever);
+        if (event.status == osEventMessage) {
+            g_transferBuffers[event.value.v].pending = false;
+        }
+    }
+    return g_transferBuffers[bufferIndex].result;
+}
+
+static uint32_t getTransferSpeed(uint32_t size, uint32_t startTime) {
+    uint32_t duration = micros() - startTime;
+    // in KB/s
+    return duration > 0 ? (uint32_t)((uint64_t)size * 1000000 / 1024 / duration) : 0;
+}
+
 bool upload(const char *filePath, void *param, void (*callback)(void *param, const void *buffer, int size), int *err) {
     if (!sd_card::isMounted(err)) {
         return false;
@@ -292,18 +381,34 @@ bool upload(const char *filePath, void *param, void (*callback)(void *param, con
 
     callback(param, NULL, totalSize);
 
-    const int CHUNK_SIZE = 512;
-    uint8_t buffer[CHUNK_SIZE];
+    uint32_t startTime = micros();
+
+    g_transferFile = &file;
+
+    int bufferIndex = 0;
+    startTransfer(bufferIndex, false);
 
     while (true) {
-        int size = file.read(buffer, CHUNK_SIZE);
+        waitTransfer(bufferIndex);
 
-        callback(param, buffer, size);
+        TransferBuffer &transferBuffer = g_transferBuffers[bufferIndex];
+        uint32_t size = transferBuffer.size;
 
         uploaded += size;
 
+        bool isLastChunk = size < g_transferChunkSize || uploaded >= totalSize;
+        if (!isLastChunk) {
+            // read next chunk while this one is sent
+            startTransfer(bufferIndex ^ 1, false);
+        }
+
+        if (size > 0) {
+            callback(param, transferBuffer.data, size);
+        }
+
 #if OPTION_DISPLAY
         if (!psu::gui::updateProgressPage(uploaded, totalSize)) {
+            waitTransfer(bufferIndex ^ 1);
             psu::gui::hideProgressPage();
             event_queue::pushEvent(event_queue::EVENT_WARNING_FILE_UPLOAD_ABORTED);
             if (err) {
@@ -314,7 +419,7 @@ bool upload(const char *filePath, void *param, void (*callback)(void *param, con
         }
 #endif
 
-        if (size < CHUNK_SIZE) {
+        if (isLastChunk) {
         	if (uploaded < totalSize) {
                 if (err) {
                     *err = SCPI_ERROR_MASS_STORAGE_ERROR;
@@ -323,12 +428,20 @@ bool upload(const char *filePath, void *param, void (*callback)(void *param, con
         	}
             break;
         }
+
+        bufferIndex ^= 1;
     }
 
     file.close();
 
     callback(param, NULL, -1);
 
+#ifdef DEBUG
+    if (result) {
+        debug::g_uploadSpeed.set(getTransferSpeed(uploaded, startTime));
+    }
+#endif
+
 #if OPTION_DISPLAY
     psu::gui::hideProgressPage();
 #endif
@@ -336,6 +449,30 @@ bool upload(const char *filePath, void *param, void (*callback)(void *param, con
     return result;
 }
 
+// sends filled buffer to the SD worker and continues with the other one
+static bool submitDownloadBuffer(int *perr) {
+    int bufferIndex = g_downloadBufferIndex;
+    startTransfer(bufferIndex, true);
+
+    g_downloadBufferIndex = bufferIndex ^ 1;
+
+    TransferBuffer &nextBuffer = g_transferBuffers[g_downloadBufferIndex];
+    bool result = waitTransfer(g_downloadBufferIndex);
+    nextBuffer.size = 0;
+    nextBuffer.result = true;
+
+    if (!result) {
+        // buffered data is lost, so download can't be continued
+        sd_card::reinitialize();
+        if (perr) {
+            *perr = SCPI_ERROR_MASS_STORAGE_ERROR;
+        }
+        return false;
+    }
+
+    return true;
+}
+
 bool download(const char *filePath, bool truncate, const void *buffer, size_t size, int *perr) {
     if (!sd_card::isMounted(perr)) {
         return false;
@@ -350,53 +487,119 @@ bool download(const char *filePath, bool truncate, const void *buffer, size_t si
 		}
         strcpy(g_downloadFilePath, filePath);
         g_downloadedFileOffset = 0;
+        g_downloadStartTime = micros();
+
+        g_transferFile = &g_downloadFile;
+        g_downloadBufferIndex = 0;
+        for (int i = 0; i < 2; i++) {
+            g_transferBuffers[i].size = 0;
+            g_transferBuffers[i].result = true;
+        }
 	}
 
-    int err = 0;
+    const uint8_t *data = (const uint8_t *)buffer;
 
-    uint32_t timeout = millis() + CONF_DOWNLOAD_TIMEOUT_MS;
-    while (millis() < timeout) {
-        size_t written = g_downloadFile.write((const uint8_t *)buffer, size);
-        if (written == size) {
-            if (g_downloadFile.sync()) {
-                g_downloadedFileOffset += size;
-                return true;
-            }
-        }
+    while (size > 0) {
+        TransferBuffer &transferBuffer = g_transferBuffers[g_downloadBufferIndex];
 
-        sd_card::reinitialize();
+        uint32_t n = MIN(size, g_transferChunkSize - transferBuffer.size);
+        memcpy(transferBuffer.data + transferBuffer.size, data, n);
+        transferBuffer.size += n;
+        data += n;
+        size -= n;
 
-        bool ropened = false;
+        g_downloadedFileOffset += n;
 
-        while (millis() < timeout) {
-            if (g_downloadFile.open(filePath, FILE_OPEN_EXISTING | FILE_WRITE)) {
-                if (g_downloadFile.seek(g_downloadedFileOffset)) {
-                    ropened = true;
-                    break;
-                }
+        if (transferBuffer.size >= g_transferChunkSize) {
+            if (!submitDownloadBuffer(perr)) {
+                return false;
             }
+        }
+    }
+
+    return true;
+}
 
-            sd_card::reinitialize();
+bool downloadSync(int *perr) {
+    if (g_transferBuffers[g_downloadBufferIndex].size > 0) {
+        if (!submitDownloadBuffer(perr)) {
+            return false;
         }
+    }
 
-        if (!ropened) {
-            break;
+    if (!waitTransfer(g_downloadBufferIndex ^ 1) || !g_downloadFile.sync()) {
+        sd_card::reinitialize();
+        if (perr) {
+            *perr = SCPI_ERROR_MASS_STORAGE_ERROR;
         }
+        return false;
     }
 
-    sd_card::reinitialize();
+#ifdef DEBUG
+    debug::g_downloadSpeed.set(getTransferSpeed(g_downloadedFileOffset, g_downloadStartTime));
+#endif
 
-    if (perr) {
-        *perr = err;
-    }
-    return false;
+    return true;
 }
 
 void downloadFinished() {
+    waitTransfer(0);
+    waitTransfer(1);
     g_downloadFile.close();
     onSdCardFileChangeHook(g_downloadFilePath);
 }
 
+static void benchmarkUploadCallback(void *param, const void *buffer, int size) {
+}
+
+void benchmarkTransfer(uint32_t fileSize) {
+    static const char *BENCHMARK_FILE_PATH = "/transfer.bin";
+
+    // data is received from the client in blocks of this size
+    static const uint32_t BLOCK_SIZE = 4096;
+
+    uint32_t savedChunkSize = g_transferChunkSize;
+
+    for (uint32_t chunkSize = SD_TRANSFER_MIN_CHUNK_SIZE; chunkSize <= SD_TRANSFER_MAX_CHUNK_SIZE; chunkSize *= 2) {
+        setTransferChunkSize(chunkSize);
+
+        int err = 0;
+
+        uint32_t startTime = micros();
+        bool result = true;
+        for (uint32_t i = 0; result && i < fileSize; i += BLOCK_SIZE) {
+            // any data will do, so it is taken from the memory
+            result = download(BENCHMARK_FILE_PATH, i == 0, MEMORY_BEGIN + i % (1024 * 1024), MIN(BLOCK_SIZE, fileSize - i), &err);
+        }
+        if (result) {
+            result = downloadSync(&err);
+        }
+        downloadFinished();
+        uint32_t downloadSpeed = getTransferSpeed(fileSize, startTime);
+
+        uint32_t uploadSpeed = 0;
+        if (result) {
+            startTime = micros();
+            result = upload(BENCHMARK_FILE_PATH, nullptr, benchmarkUploadCallback, &err);
+            uploadSpeed = getTransferSpeed(fileSize, startTime);
+        }
+
+        deleteFile(BENCHMARK_FILE_PATH, nullptr);
+
+        if (!result) {
+            DebugTrace("Transfer benchmark failed, err=%d\n", err);
+            break;
+        }
+
+        DebugTrace("Transfer %u KB chunks: download %u.%02u MB/s, upload %u.%02u MB/s\n",
+            (unsigned)(chunkSize / 1024),
+            (unsigned)(downloadSpeed / 1024), (unsigned)(downloadSpeed % 1024 * 100 / 1024),
+            (unsigned)(uploadSpeed / 1024), (unsigned)(uploadSpeed % 1024 * 100 / 1024));
+    }
+
+    setTransferChunkSize(savedChunkSize);
+}
+
 bool moveFile(const char *sourcePath, const char *destinationPath, int *err) {
     if (!sd_card::isMounted(err)) {
         return false;
@@ -661,16 +864,22 @@ int BufferedFileRead::read() {
 }
 
 int BufferedFileRead::read(void *buf, uint32_t nbyte) {
-    uint8_t *pBegin = (uint8_t *)buf;
-    uint8_t *pEnd = pBegin + nbyte;
-    uint8_t *p;
-    for (p = pBegin; p < pEnd; p++) {
-        if (!available()) {
+    uint8_t *p = (uint8_t *)buf;
+    uint32_t n = 0;
+    while (n < nbyte) {
+        readNextChunk();
+        if (position >= end) {
             break;
         }
-        *p = (uint8_t)read();
+        uint32_t chunkSize = end - position;
+        if (chunkSize > nbyte - n) {
+            chunkSize = nbyte - n;
+        }
+        memcpy(p + n, buffer + position, chunkSize);
+        position += chunkSize;
+        n += chunkSize;
     }
-    return p - pBegin;
+    return n;
 }
 
 bool BufferedFileRead::available() {
@@ -718,9 +927,8 @@ bool BufferedFileWrite::write(const uint8_t *buf, size_t size) {
 }
 
 bool BufferedFileWrite::print(float value, int numDecimalDigits) {
-    char buf[32];
-    sprintf(buf, "%.*f", numDecimalDigits, value);
-    int len = strlen(buf);
+    char buf[64];
+    size_t len = number::formatFloatFixed(value, numDecimalDigits, buf, sizeof(buf));
     return write((const uint8_t *)buf, len);
 }
 
@@ -906,60 +1114,32 @@ bool match(BufferedFileRead &file, unsigned int &result) {
 bool match(BufferedFileRead &file, float &result) {
     matchZeroOrMoreSpaces(file);
 
-    int c = file.peek();
-    if (c == -1) {
-        return false;
-    }
+    // collect everything that can be a part of the number and let the parser decide
+    char text[64];
+    size_t length = 0;
 
-    bool isNegative;
+    int c = file.peek();
     if (c == '-') {
-        file.read();
-        isNegative = true;
+        text[length++] = (char)file.read();
         c = file.peek();
-    } else {
-        isNegative = false;
     }
 
-    bool isFraction = false;
-    float fraction = 1.0;
-
-    long value = -1;
-
-    while (true) {
-        if (c == '.') {
-            if (isFraction) {
-                return false;
-            }
-            isFraction = true;
-        } else if (c >= '0' && c <= '9') {
-            if (value == -1) {
-                value = 0;
-            }
-
-            value = value * 10 + c - '0';
-
-            if (isFraction) {
-                fraction *= 0.1f;
-            }
-        } else {
-            if (value == -1) {
-                return false;
-            }
-
-            result = (float)value;
-            if (isNegative) {
-                result = -result;
-            }
-            if (isFraction) {
-                result *= fraction;
-            }
-
-            return true;
+    while ((c >= '0' && c <= '9') || c == '.' || c == 'e' || c == 'E' ||
+           ((c == '-' || c == '+') && length > 0 && (text[length - 1] == 'e' || text[length - 1] == 'E'))) {
+        if (length == sizeof(text)) {
+            return false;
         }
-
-        file.read();
+        text[length++] = (char)file.read();
         c = file.peek();
     }
+
+    float value;
+    if (length == 0 || number::parseFloat(text, length, value) != length) {
+        return false;
+    }
+
+    result = value;
+    return true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -54,9 +54,22 @@ bool makeParentDir(const char *filePath, int *err);
 bool exists(const char *dirPath, int *err);
 bool catalog(const char *dirPath, void *param, void (*callback)(void *param, const char *name, FileType type, size_t size), int *numFiles, int *err);
 bool catalogLength(const char *dirPath, size_t *length, int *err);
+// Upload and download are double buffered: while one chunk is sent to (or received from)
+// the client, the other one is read from (or written to) the SD card by the SD worker.
+#define SD_TRANSFER_MIN_CHUNK_SIZE (8 * 1024)
+#define SD_TRANSFER_MAX_CHUNK_SIZE (64 * 1024)
+void setTransferChunkSize(uint32_t chunkSize);
+uint32_t getTransferChunkSize();
+void executeTransferRequest(int bufferIndex); // called from SD worker
+
 bool upload(const char *filePath, void *param, void (*callback)(void *param, const void *buffer, int size), int *err);
 bool download(const char *filePath, bool truncate, const void *buffer, size_t size, int *err);
+// writes all the buffered data and syncs the file
+bool downloadSync(int *err);
 void downloadFinished();
+
+// downloads and uploads fileSize bytes with each chunk size and traces MB/s
+void benchmarkTransfer(uint32_t fileSize);
 bool moveFile(const char *sourcePath, const char *destinationPath, int *err);
 bool copyFile(const char *sourcePath, const char *destinationPath, bool showProgress, int *err);
 bool deleteFile(const char *filePath, int *err);
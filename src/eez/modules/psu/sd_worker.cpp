@@ -0,0 +1,323 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2015-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include <eez/debug.h>
+#include <eez/system.h>
+#include <eez/trace.h>
+
+#include <eez/scpi/scpi.h>
+
+#include <eez/modules/psu/psu.h>
+#include <eez/modules/psu/sd_worker.h>
+#include <eez/modules/psu/dlog_record.h>
+#include <eez/modules/psu/dlog_view.h>
+#include <eez/modules/psu/sd_card.h>
+#if OPTION_DISPLAY
+#include <eez/modules/psu/gui/file_manager.h>
+#endif
+
+// DLOG data is written at least this often, also while the long request is executed
+#define CONF_SD_WORKER_REALTIME_PERIOD_MS 10
+
+#define REQUEST_QUEUE_SIZE 8
+
+namespace eez {
+namespace psu {
+namespace sd_worker {
+
+void mainLoop(const void *);
+
+osThreadId g_sdWorkerTaskHandle;
+
+#if defined(EEZ_PLATFORM_STM32)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wwrite-strings"
+#endif
+
+osThreadDef(g_sdWorkerTask, mainLoop, osPriorityNormal, 0, 4096);
+
+#if defined(EEZ_PLATFORM_STM32)
+#pragma GCC diagnostic pop
+#endif
+
+// only used to wake up the worker, requests are in g_requestQueues
+osMessageQDef(g_sdWorkerMessageQueue, NUM_REQUEST_CLASSES * REQUEST_QUEUE_SIZE, uint32_t);
+osMessageQId g_sdWorkerMessageQueueId;
+
+osMutexId(g_requestQueuesMutexId);
+osMutexDef(g_requestQueuesMutex);
+
+struct Request {
+    uint8_t type;
+    uint32_t param;
+    uint32_t requestTime;
+};
+
+struct RequestQueue {
+    Request requests[REQUEST_QUEUE_SIZE];
+    uint8_t head;
+    uint8_t tail;
+    uint8_t count;
+};
+
+static RequestQueue g_requestQueues[NUM_REQUEST_CLASSES];
+
+static RequestClassStats g_stats[NUM_REQUEST_CLASSES];
+
+static uint32_t g_lastDlogWriteTime;
+
+////////////////////////////////////////////////////////////////////////////////
+
+static RequestClass getRequestClass(uint8_t type) {
+    if (type == REQUEST_TRACE_DUMP) {
+        return REQUEST_CLASS_BACKGROUND;
+    }
+    return REQUEST_CLASS_INTERACTIVE;
+}
+
+static int getHistogramBucket(uint32_t time) {
+    uint32_t ms = time / 1000;
+    int bucket = 0;
+    while (ms) {
+        ms >>= 1;
+        bucket++;
+    }
+    return bucket < SD_WORKER_HISTOGRAM_SIZE ? bucket : SD_WORKER_HISTOGRAM_SIZE - 1;
+}
+
+static void addStats(RequestClass requestClass, uint32_t waitTime, uint32_t executionTime) {
+    RequestClassStats &stats = g_stats[requestClass];
+
+    stats.numRequests++;
+
+    if (waitTime > stats.maxWaitTime) {
+        stats.maxWaitTime = waitTime;
+    }
+    stats.waitTimeHistogram[getHistogramBucket(waitTime)]++;
+
+    if (executionTime > stats.maxExecutionTime) {
+        stats.maxExecutionTime = executionTime;
+    }
+    stats.executionTimeHistogram[getHistogramBucket(executionTime)]++;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static bool popRequest(Request &request, RequestClass &requestClass) {
+    bool result = false;
+
+    osMutexWait(g_requestQueuesMutexId, osWaitForever);
+
+    for (int i = REQUEST_CLASS_INTERACTIVE; i < NUM_REQUEST_CLASSES; i++) {
+        RequestQueue &queue = g_requestQueues[i];
+        if (queue.count > 0) {
+            request = queue.requests[queue.tail];
+            queue.tail = (queue.tail + 1) % REQUEST_QUEUE_SIZE;
+            queue.count--;
+            requestClass = (RequestClass)i;
+            result = true;
+            break;
+        }
+    }
+
+    osMutexRelease(g_requestQueuesMutexId);
+
+    return result;
+}
+
+static void executeRequest(const Request &request) {
+    switch (request.type) {
+    case REQUEST_DLOG_SHOW_FILE:
+        dlog_view::openFile(nullptr);
+        break;
+
+    case REQUEST_DLOG_LOAD_BLOCK:
+        dlog_view::loadBlock();
+        break;
+
+    case REQUEST_SCREENSHOT:
+        scpi::saveScreenshot();
+        break;
+
+    case REQUEST_SD_TRANSFER:
+        sd_card::executeTransferRequest(request.param);
+        break;
+
+#if OPTION_TRACE
+    case REQUEST_TRACE_DUMP:
+        trace::executeDumpRequest();
+        break;
+#endif
+
+#if OPTION_DISPLAY
+    case REQUEST_FILE_MANAGER_LOAD_DIRECTORY:
+        gui::file_manager::doLoadDirectory();
+        break;
+
+    case REQUEST_FILE_MANAGER_OPEN_IMAGE_FILE:
+        gui::file_manager::openImageFile();
+        break;
+
+    case REQUEST_FILE_MANAGER_DELETE_FILE:
+        gui::file_manager::deleteFile();
+        break;
+
+    case REQUEST_FILE_MANAGER_RENAME_FILE:
+        gui::file_manager::doRenameFile();
+        break;
+
+    case REQUEST_FILE_MANAGER_SORT_FILES:
+        gui::file_manager::doSortFiles();
+        break;
+#endif
+    }
+}
+
+// DLOG data is written between any two requests and from writeDlogIfDue inside of the long requests,
+// so neither a long queue of requests nor a long request can overflow DLOG buffer.
+// Wait time is the time since the previous write.
+static void writeDlog() {
+    uint32_t startTime = micros();
+
+    if (dlog_record::isExecuting()) {
+        dlog_record::fileWrite();
+
+        uint32_t endTime = micros();
+        addStats(REQUEST_CLASS_REALTIME, startTime - g_lastDlogWriteTime, endTime - startTime);
+        g_lastDlogWriteTime = endTime;
+    } else {
+        g_lastDlogWriteTime = startTime;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void initMessageQueue() {
+    g_sdWorkerMessageQueueId = osMessageCreate(osMessageQ(g_sdWorkerMessageQueue), NULL);
+    g_requestQueuesMutexId = osMutexCreate(osMutex(g_requestQueuesMutex));
+}
+
+void startThread() {
+    g_lastDlogWriteTime = micros();
+    g_sdWorkerTaskHandle = osThreadCreate(osThread(g_sdWorkerTask), nullptr);
+}
+
+void oneIter();
+
+void mainLoop(const void *) {
+    TRACE_REGISTER_THREAD("SD worker");
+
+#ifdef __EMSCRIPTEN__
+    oneIter();
+#else
+    while (1) {
+        oneIter();
+    }
+#endif
+}
+
+void oneIter() {
+    osMessageGet(g_sdWorkerMessageQueueId, CONF_SD_WORKER_REALTIME_PERIOD_MS);
+
+    writeDlog();
+
+    Request request;
+    RequestClass requestClass;
+    while (popRequest(request, requestClass)) {
+        uint32_t startTime = micros();
+        executeRequest(request);
+        addStats(requestClass, startTime - request.requestTime, micros() - startTime);
+
+        writeDlog();
+    }
+}
+
+void writeDlogIfDue() {
+    if (osThreadGetId() == g_sdWorkerTaskHandle && micros() - g_lastDlogWriteTime >= CONF_SD_WORKER_REALTIME_PERIOD_MS * 1000) {
+        writeDlog();
+    }
+}
+
+bool isSdCardThread() {
+    osThreadId threadId = osThreadGetId();
+    return threadId == g_sdWorkerTaskHandle || threadId == scpi::g_scpiTaskHandle;
+}
+
+void postRequest(RequestType type, uint32_t param) {
+    RequestQueue &queue = g_requestQueues[getRequestClass(type)];
+
+    while (true) {
+        osMutexWait(g_requestQueuesMutexId, osWaitForever);
+
+        if (queue.count < REQUEST_QUEUE_SIZE) {
+            Request &request = queue.requests[queue.head];
+            request.type = type;
+            request.param = param;
+            request.requestTime = micros();
+            queue.head = (queue.head + 1) % REQUEST_QUEUE_SIZE;
+            queue.count++;
+
+            osMutexRelease(g_requestQueuesMutexId);
+            break;
+        }
+
+        osMutexRelease(g_requestQueuesMutexId);
+
+        osDelay(1);
+    }
+
+    // worker polls the request queues anyway, so it is fine if this fails
+    osMessagePut(g_sdWorkerMessageQueueId, 0, 0);
+}
+
+const RequestClassStats &getStats(RequestClass requestClass) {
+    return g_stats[requestClass];
+}
+
+void resetStats() {
+    memset(g_stats, 0, sizeof(g_stats));
+}
+
+void traceStats() {
+    static const char *g_requestClassNames[NUM_REQUEST_CLASSES] = { "realtime", "interactive", "background" };
+
+    for (int i = 0; i < NUM_REQUEST_CLASSES; i++) {
+        RequestClassStats &stats = g_stats[i];
+
+        DebugTrace("SD worker %s: %u requests, max wait %u us, max exec %u us\n",
+            g_requestClassNames[i], (unsigned)stats.numRequests, (unsigned)stats.maxWaitTime, (unsigned)stats.maxExecutionTime);
+
+        DebugTrace("  wait: %u %u %u %u %u %u %u %u %u %u %u %u\n",
+            (unsigned)stats.waitTimeHistogram[0], (unsigned)stats.waitTimeHistogram[1], (unsigned)stats.waitTimeHistogram[2],
+            (unsigned)stats.waitTimeHistogram[3], (unsigned)stats.waitTimeHistogram[4], (unsigned)stats.waitTimeHistogram[5],
+            (unsigned)stats.waitTimeHistogram[6], (unsigned)stats.waitTimeHistogram[7], (unsigned)stats.waitTimeHistogram[8],
+            (unsigned)stats.waitTimeHistogram[9], (unsigned)stats.waitTimeHistogram[10], (unsigned)stats.waitTimeHistogram[11]);
+
+        DebugTrace("  exec: %u %u %u %u %u %u %u %u %u %u %u %u\n",
+            (unsigned)stats.executionTimeHistogram[0], (unsigned)stats.executionTimeHistogram[1], (unsigned)stats.executionTimeHistogram[2],
+            (unsigned)stats.executionTimeHistogram[3], (unsigned)stats.executionTimeHistogram[4], (unsigned)stats.executionTimeHistogram[5],
+            (unsigned)stats.executionTimeHistogram[6], (unsigned)stats.executionTimeHistogram[7], (unsigned)stats.executionTimeHistogram[8],
+            (unsigned)stats.executionTimeHistogram[9], (unsigned)stats.executionTimeHistogram[10], (unsigned)stats.executionTimeHistogram[11]);
+    }
+}
+
+} // namespace sd_worker
+} // namespace psu
+} // namespace eez
@@ -0,0 +1,91 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2015-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <cmsis_os.h>
+
+namespace eez {
+namespace psu {
+
+// SD card worker thread. It executes SD card jobs requested by the GUI, so they don't
+// block SCPI thread, and it also writes DLOG data to the file.
+// Only jobs that do file I/O are executed here. Jobs that change the instrument or profile state
+// (profile save/recall/import, list import, profile cache) are executed in the SCPI thread.
+// Requests are executed by priority class: DLOG writes (realtime) first, then interactive
+// requests and then background requests. Requests of the same class are executed in FIFO order.
+// DLOG writes are also interleaved into the long requests, see writeDlogIfDue.
+// Job itself notifies the originating thread when it is finished (usually with GUI queue message).
+namespace sd_worker {
+
+enum RequestClass {
+    REQUEST_CLASS_REALTIME,
+    REQUEST_CLASS_INTERACTIVE,
+    REQUEST_CLASS_BACKGROUND,
+    NUM_REQUEST_CLASSES
+};
+
+enum RequestType {
+    REQUEST_DLOG_SHOW_FILE = 1,
+    REQUEST_DLOG_LOAD_BLOCK,
+    REQUEST_SCREENSHOT,
+    REQUEST_FILE_MANAGER_LOAD_DIRECTORY,
+    REQUEST_FILE_MANAGER_OPEN_IMAGE_FILE,
+    REQUEST_FILE_MANAGER_DELETE_FILE,
+    REQUEST_FILE_MANAGER_RENAME_FILE,
+    REQUEST_FILE_MANAGER_SORT_FILES,
+    REQUEST_SD_TRANSFER,
+    REQUEST_TRACE_DUMP
+};
+
+#define SD_WORKER_HISTOGRAM_SIZE 12
+
+// Latencies are in log2 buckets: bucket 0 is < 1 ms, bucket i is [2^(i-1), 2^i) ms
+// and the last one is everything above.
+struct RequestClassStats {
+    uint32_t numRequests;
+    uint32_t maxWaitTime; // from request to start of execution, in microseconds
+    uint32_t maxExecutionTime; // in microseconds
+    uint32_t waitTimeHistogram[SD_WORKER_HISTOGRAM_SIZE];
+    uint32_t executionTimeHistogram[SD_WORKER_HISTOGRAM_SIZE];
+};
+
+extern osThreadId g_sdWorkerTaskHandle;
+
+void initMessageQueue();
+void startThread();
+
+// Threads that can do blocking SD card I/O: SD worker and SCPI thread.
+bool isSdCardThread();
+
+// Blocks only if the queue of request class is full.
+void postRequest(RequestType type, uint32_t param = 0);
+
+// Called from the loops of the long requests, so DLOG data is written at least every
+// CONF_SD_WORKER_REALTIME_PERIOD_MS also while they are executed. Does nothing in other threads.
+void writeDlogIfDue();
+
+const RequestClassStats &getStats(RequestClass requestClass);
+void resetStats();
+void traceStats();
+
+} // namespace sd_worker
+} // namespace psu
+} // namespace eez
@@ -96,7 +96,10 @@ void UARTClass::releaseInputBuffer() {
 
 int UARTClass::write(const char *buffer, int size) {
 #if defined(EEZ_PLATFORM_STM32)    
-    CDC_Transmit_FS((uint8_t *)buffer, (uint16_t)size);
+    // CDC transmit buffer is 4 KB
+    for (int i = 0; i < size; i += 4096) {
+        CDC_Transmit_FS((uint8_t *)buffer + i, (uint16_t)MIN(size - i, 4096));
+    }
     return size;
 #endif
 
@@ -0,0 +1,524 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2015-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <scpi/scpi.h>
+
+#include <eez/debug.h>
+#include <eez/system.h>
+
+#include <eez/modules/psu/psu.h>
+#include <eez/modules/psu/channel_dispatcher.h>
+#include <eez/modules/psu/sd_card.h>
+#include <eez/modules/psu/simulator_load.h>
+
+#include <eez/libs/sd_fat/sd_fat.h>
+
+#define CONF_SIM_OUTPUT_SLEW_RATE 5000.0f // V/s
+#define CONF_SIM_OUTPUT_TIME_CONSTANT 0.001f // s
+#define CONF_SIM_ADC_NOISE 1.0f // LSB
+
+// longer steps (simulator was paused) are not integrated
+#define CONF_SIM_MAX_TIME_STEP 0.1f // s
+
+#define SCENARIO_SAMPLE_PERIOD_MS 1
+#define SCENARIO_MAX_SAMPLES 2000
+
+namespace eez {
+namespace psu {
+namespace simulator {
+
+static LoadModel g_loadModels[CH_MAX];
+
+static float g_outputSlewRate = CONF_SIM_OUTPUT_SLEW_RATE;
+static float g_adcNoise = CONF_SIM_ADC_NOISE;
+
+////////////////////////////////////////////////////////////////////////////////
+
+void resetLoad(int channelIndex) {
+    LoadModel &model = g_loadModels[channelIndex];
+
+    model.type = LOAD_TYPE_RESISTOR;
+
+    model.capacitance = 0.001f;
+    model.inductance = 0.01f;
+    model.current = 1.0f;
+    model.power = 10.0f;
+    model.batteryOcvEmpty = 3.0f;
+    model.batteryOcvFull = 4.2f;
+    model.batteryResistance = 0.1f;
+    model.batteryCapacity = 1.0f;
+
+    model.profileLength = 0;
+
+    resetLoadState(channelIndex);
+}
+
+void resetLoadState(int channelIndex) {
+    LoadModel &model = g_loadModels[channelIndex];
+
+    model.uSource = 0;
+    model.uCapacitor = 0;
+    model.iInductor = 0;
+    model.batterySoc = 0.5f;
+    model.profileElapsedTime = 0;
+    model.lastUpdateTime = micros();
+}
+
+LoadModel &getLoadModel(int channelIndex) {
+    return g_loadModels[channelIndex];
+}
+
+void setLoadType(int channelIndex, LoadType type) {
+    g_loadModels[channelIndex].type = type;
+    resetLoadState(channelIndex);
+}
+
+bool loadProfile(int channelIndex, const char *filePath, int *err) {
+    if (!sd_card::isMounted(err)) {
+        return false;
+    }
+
+    if (!sd_card::exists(filePath, err)) {
+        if (err) {
+            *err = SCPI_ERROR_FILE_NOT_FOUND;
+        }
+        return false;
+    }
+
+    File file;
+    if (!file.open(filePath, FILE_OPEN_EXISTING | FILE_READ)) {
+        if (err) {
+            *err = SCPI_ERROR_MASS_STORAGE_ERROR;
+        }
+        return false;
+    }
+
+    sd_card::BufferedFileRead bufferedFile(file);
+
+    LoadModel &model = g_loadModels[channelIndex];
+
+    uint16_t profileLength = 0;
+    bool success = true;
+
+    while (true) {
+        sd_card::matchZeroOrMoreSpaces(bufferedFile);
+        if (!bufferedFile.available()) {
+            break;
+        }
+
+        float time;
+        float resistance;
+        if (profileLength == LOAD_PROFILE_MAX_POINTS ||
+            !sd_card::match(bufferedFile, time) ||
+            !sd_card::match(bufferedFile, CSV_SEPARATOR) ||
+            !sd_card::match(bufferedFile, resistance) ||
+            resistance < 0 ||
+            (profileLength > 0 && time <= model.profileTime[profileLength - 1])) {
+            success = false;
+            break;
+        }
+
+        model.profileTime[profileLength] = time;
+        model.profileResistance[profileLength] = resistance;
+        profileLength++;
+    }
+
+    file.close();
+
+    if (!success || profileLength == 0) {
+        model.profileLength = 0;
+        if (err) {
+            *err = SCPI_ERROR_EXECUTION_ERROR;
+        }
+        return false;
+    }
+
+    model.profileLength = profileLength;
+    model.profileElapsedTime = 0;
+
+    return true;
+}
+
+void setOutputSlewRate(float slewRate) {
+    g_outputSlewRate = slewRate;
+}
+
+float getOutputSlewRate() {
+    return g_outputSlewRate;
+}
+
+void setAdcNoise(float noise) {
+    g_adcNoise = noise;
+}
+
+float getAdcNoise() {
+    return g_adcNoise;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Capacitor voltage after dt when charged with constant current i and discharged through r.
+static float capacitorStep(float u, float i, float r, float c, float dt) {
+    if (isinf(r)) {
+        return u + i * dt / c;
+    }
+    return i * r + (u - i * r) * expf(-dt / (r * c));
+}
+
+static float getProfileResistance(LoadModel &model, float dt) {
+    if (model.profileLength == 0) {
+        return INFINITY;
+    }
+
+    model.profileElapsedTime += dt;
+    float duration = model.profileTime[model.profileLength - 1];
+    if (duration > 0 && model.profileElapsedTime >= duration) {
+        model.profileElapsedTime = fmodf(model.profileElapsedTime, duration);
+    }
+
+    int i = 0;
+    while (i + 1 < model.profileLength && model.profileTime[i + 1] <= model.profileElapsedTime) {
+        i++;
+    }
+
+    return model.profileResistance[i];
+}
+
+static void solveResistor(float r, float uSource, float iSet, float &uMon, float &iMon, bool &cc) {
+    if (uSource > iSet * r) {
+        cc = true;
+        iMon = iSet;
+        uMon = iSet * r;
+    } else {
+        cc = false;
+        uMon = uSource;
+        iMon = isinf(r) ? 0 : uSource / r;
+    }
+}
+
+void updateLoad(Channel &channel, bool outputEnabled, float uSet, float iSet, float &uMon, float &iMon, bool &cc) {
+    LoadModel &model = g_loadModels[channel.channelIndex];
+
+    uint32_t time = micros();
+    float dt = (time - model.lastUpdateTime) / 1E6f;
+    model.lastUpdateTime = time;
+    if (dt > CONF_SIM_MAX_TIME_STEP) {
+        dt = CONF_SIM_MAX_TIME_STEP;
+    }
+
+    // output stage
+    if (!outputEnabled) {
+        uSet = 0;
+    }
+    float du = (uSet - model.uSource) * (1.0f - expf(-dt / CONF_SIM_OUTPUT_TIME_CONSTANT));
+    float duMax = g_outputSlewRate * dt;
+    if (du > duMax) {
+        du = duMax;
+    } else if (du < -duMax) {
+        du = -duMax;
+    }
+    model.uSource += du;
+
+    float r = channel.simulator.load;
+    float uSource = model.uSource;
+
+    if (!outputEnabled) {
+        // output is disconnected, only the state of the load is changed
+        if (model.capacitance > 0) {
+            model.uCapacitor = capacitorStep(model.uCapacitor, 0, r, model.capacitance, dt);
+        }
+        model.iInductor = 0;
+        uMon = 0;
+        iMon = 0;
+        cc = false;
+        return;
+    }
+
+    if (!channel.simulator.getLoadEnabled()) {
+        uMon = uSource;
+        iMon = 0;
+        cc = !(uSet > 0 && iSet > 0);
+        return;
+    }
+
+    if (model.type == LOAD_TYPE_RC && model.capacitance > 0) {
+        if (model.uCapacitor >= uSource && (isinf(r) || uSource <= iSet * r)) {
+            // CV, PSU can't sink the current so the capacitor above Uset is discharged only through the resistor
+            cc = false;
+            if (model.uCapacitor > uSource) {
+                model.uCapacitor = capacitorStep(model.uCapacitor, 0, r, model.capacitance, dt);
+                if (model.uCapacitor < uSource) {
+                    model.uCapacitor = uSource;
+                }
+            }
+            uMon = model.uCapacitor;
+            iMon = uMon > uSource || isinf(r) ? 0 : uSource / r;
+        } else {
+            // CC, charging with the current limit
+            model.uCapacitor = capacitorStep(model.uCapacitor, iSet, r, model.capacitance, dt);
+            if (model.uCapacitor >= uSource) {
+                model.uCapacitor = uSource;
+                cc = false;
+            } else {
+                cc = true;
+            }
+            uMon = model.uCapacitor;
+            iMon = iSet;
+        }
+    } else if (model.type == LOAD_TYPE_RL && model.inductance > 0) {
+        if (isinf(r)) {
+            model.iInductor = 0;
+        } else if (r == 0) {
+            model.iInductor += uSource * dt / model.inductance;
+        } else {
+            float iFinal = uSource / r;
+            model.iInductor = iFinal + (model.iInductor - iFinal) * expf(-dt * r / model.inductance);
+        }
+
+        if (model.iInductor > iSet) {
+            model.iInductor = iSet;
+            cc = true;
+            uMon = iSet * r;
+        } else {
+            cc = false;
+            uMon = uSource;
+        }
+        iMon = model.iInductor;
+    } else if (model.type == LOAD_TYPE_CC || model.type == LOAD_TYPE_CP) {
+        float iLoad = model.type == LOAD_TYPE_CC ? model.current : (uSource > 0 ? model.power / uSource : 0);
+        if (uSource <= 0) {
+            cc = false;
+            uMon = 0;
+            iMon = 0;
+        } else if (iLoad <= iSet) {
+            cc = false;
+            uMon = uSource;
+            iMon = iLoad;
+        } else {
+            // electronic load pulls the output voltage down to zero
+            cc = true;
+            uMon = 0;
+            iMon = iSet;
+        }
+    } else if (model.type == LOAD_TYPE_BATTERY) {
+        float ocv = model.batteryOcvEmpty + model.batterySoc * (model.batteryOcvFull - model.batteryOcvEmpty);
+        float rBattery = model.batteryResistance > 0.001f ? model.batteryResistance : 0.001f;
+
+        float i = (uSource - ocv) / rBattery;
+        cc = false;
+        if (i < 0) {
+            // PSU can't sink the current
+            i = 0;
+        } else if (i > iSet) {
+            i = iSet;
+            cc = true;
+        }
+
+        if (model.batteryCapacity > 0) {
+            model.batterySoc += i * dt / (model.batteryCapacity * 3600.0f);
+            if (model.batterySoc > 1.0f) {
+                model.batterySoc = 1.0f;
+            }
+        }
+
+        uMon = ocv + i * rBattery;
+        iMon = i;
+    } else {
+        if (model.type == LOAD_TYPE_PROFILE) {
+            r = getProfileResistance(model, dt);
+        }
+        solveResistor(r, uSource, iSet, uMon, iMon, cc);
+    }
+}
+
+float adcConversion(float value, float fullScale) {
+    static const float ADC_MAX = (float)((1L << ADC_RES) - 1);
+
+    float lsb = fullScale / ADC_MAX;
+    float noise = g_adcNoise * (2.0f * rand() / RAND_MAX - 1.0f);
+    float code = roundf(value / lsb + noise);
+
+    if (code < 0) {
+        code = 0;
+    } else if (code > ADC_MAX) {
+        code = ADC_MAX;
+    }
+
+    return code * lsb;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct Scenario {
+    const char *name;
+    LoadType type;
+    float resistance;
+    float parameter; // capacitance, inductance, current, power or battery capacity
+    float uSet;
+    float iSet;
+    // load resistance is changed to this value after the settling (0 - no step),
+    // OCP is enabled and the time until OCP is tripped is measured
+    float stepResistance;
+};
+
+static const Scenario g_scenarios[] = {
+    { "R", LOAD_TYPE_RESISTOR, 10.0f, 0, 10.0f, 2.0f, 0 },
+    { "RC", LOAD_TYPE_RC, 10.0f, 0.01f, 10.0f, 1.5f, 0 },
+    { "RL", LOAD_TYPE_RL, 5.0f, 0.5f, 10.0f, 3.0f, 0 },
+    { "CC", LOAD_TYPE_CC, 0, 1.0f, 12.0f, 2.0f, 0 },
+    { "CP", LOAD_TYPE_CP, 0, 20.0f, 24.0f, 1.0f, 0 },
+    { "battery", LOAD_TYPE_BATTERY, 0, 0.0002f, 4.2f, 1.0f, 0 },
+    { "OCP step", LOAD_TYPE_RESISTOR, 100.0f, 0, 10.0f, 1.0f, 2.0f },
+};
+
+static float g_scenarioSamples[SCENARIO_MAX_SAMPLES];
+
+static void traceScenario(const Scenario &scenario, int numSamples, uint32_t tripTime) {
+    float final = g_scenarioSamples[numSamples - 1];
+    float max = 0;
+
+    int t10 = -1;
+    int t90 = -1;
+    int tSettle = 0;
+    for (int i = 0; i < numSamples; i++) {
+        float u = g_scenarioSamples[i];
+        if (t10 == -1 && u >= final * 0.1f) {
+            t10 = i;
+        }
+        if (t90 == -1 && u >= final * 0.9f) {
+            t90 = i;
+        }
+        if (fabsf(u - final) > final * 0.01f) {
+            tSettle = i + 1;
+        }
+        if (u > max) {
+            max = u;
+        }
+    }
+
+    char ocpText[64] = "";
+    if (scenario.stepResistance != 0) {
+        if (tripTime) {
+            snprintf(ocpText, sizeof(ocpText), ", OCP trip %u us (latency %u us)", (unsigned)tripTime,
+                (unsigned)Channel::get(0).ocp.latency.last);
+        } else {
+            snprintf(ocpText, sizeof(ocpText), ", OCP not tripped");
+        }
+    }
+
+    DebugTrace("Load scenario %s: rise %d ms, settle %d ms, overshoot %d.%d%%, Umon %d mV, Imon %d mA%s\n",
+        scenario.name,
+        t10 != -1 && t90 != -1 ? (t90 - t10) * SCENARIO_SAMPLE_PERIOD_MS : -1,
+        tSettle * SCENARIO_SAMPLE_PERIOD_MS,
+        final > 0 ? (int)((max - final) * 1000 / final) / 10 : 0,
+        final > 0 ? (int)((max - final) * 1000 / final) % 10 : 0,
+        (int)(final * 1000),
+        (int)(channel_dispatcher::getIMonLast(Channel::get(0)) * 1000),
+        ocpText);
+}
+
+void runLoadScenarios() {
+    Channel &channel = Channel::get(0);
+
+    LoadModel savedModel = g_loadModels[0];
+    bool savedLoadEnabled = channel.simulator.getLoadEnabled();
+    float savedLoad = channel.simulator.getLoad();
+    float savedUSet = channel_dispatcher::getUSet(channel);
+    float savedISet = channel_dispatcher::getISet(channel);
+    int savedOcpState = channel.prot_conf.flags.i_state;
+    float savedOcpDelay = channel.prot_conf.i_delay;
+
+    for (size_t scenarioIndex = 0; scenarioIndex < sizeof(g_scenarios) / sizeof(Scenario); scenarioIndex++) {
+        const Scenario &scenario = g_scenarios[scenarioIndex];
+
+        channel_dispatcher::outputEnable(channel, false);
+        channel_dispatcher::clearProtection(channel);
+
+        LoadModel &model = g_loadModels[0];
+        resetLoad(0);
+        model.type = scenario.type;
+        model.capacitance = scenario.parameter;
+        model.inductance = scenario.parameter;
+        model.current = scenario.parameter;
+        model.power = scenario.parameter;
+        model.batteryCapacity = scenario.parameter;
+        model.batterySoc = 0;
+
+        channel_dispatcher::setLoadEnabled(channel, true);
+        channel_dispatcher::setLoad(channel, scenario.resistance);
+        channel_dispatcher::setVoltage(channel, scenario.uSet);
+        channel_dispatcher::setCurrent(channel, scenario.iSet);
+        channel_dispatcher::setOcpParameters(channel, scenario.stepResistance != 0 ? 1 : 0, 0);
+
+        osDelay(50);
+
+        channel_dispatcher::outputEnable(channel, true);
+
+        int numSamples = 0;
+        uint32_t stepTime = 0;
+        uint32_t tripTime = 0;
+
+        while (numSamples < SCENARIO_MAX_SAMPLES) {
+            osDelay(SCENARIO_SAMPLE_PERIOD_MS);
+
+            g_scenarioSamples[numSamples++] = channel_dispatcher::getUMonLast(channel);
+
+            if (scenario.stepResistance != 0) {
+                if (!stepTime && numSamples == SCENARIO_MAX_SAMPLES / 2) {
+                    stepTime = micros();
+                    channel_dispatcher::setLoad(channel, scenario.stepResistance);
+                }
+
+                if (stepTime && channel_dispatcher::isOcpTripped(channel)) {
+                    tripTime = micros() - stepTime;
+                    break;
+                }
+            }
+        }
+
+        if (scenario.stepResistance != 0) {
+            // rise and settle times are from the first half
+            numSamples = SCENARIO_MAX_SAMPLES / 2;
+        }
+
+        traceScenario(scenario, numSamples, tripTime);
+    }
+
+    channel_dispatcher::outputEnable(channel, false);
+    channel_dispatcher::clearProtection(channel);
+
+    g_loadModels[0] = savedModel;
+    resetLoadState(0);
+    channel_dispatcher::setLoadEnabled(channel, savedLoadEnabled);
+    channel_dispatcher::setLoad(channel, savedLoad);
+    channel_dispatcher::setVoltage(channel, savedUSet);
+    channel_dispatcher::setCurrent(channel, savedISet);
+    channel_dispatcher::setOcpParameters(channel, savedOcpState, savedOcpDelay);
+}
+
+} // namespace simulator
+} // namespace psu
+} // namespace eez
+
+#endif
@@ -0,0 +1,101 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2015-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+
+#include <stdint.h>
+
+namespace eez {
+namespace psu {
+
+class Channel;
+
+namespace simulator {
+
+enum LoadType {
+    LOAD_TYPE_RESISTOR,
+    LOAD_TYPE_RC,       // resistor in parallel with capacitor
+    LOAD_TYPE_RL,       // resistor in series with inductor
+    LOAD_TYPE_CC,       // constant current electronic load
+    LOAD_TYPE_CP,       // constant power electronic load
+    LOAD_TYPE_BATTERY,  // open circuit voltage, linear in SoC, and internal resistance
+    LOAD_TYPE_PROFILE   // resistance changed in time from the CSV file
+};
+
+#define LOAD_PROFILE_MAX_POINTS 64
+
+/// Per channel load model. Resistance of the resistor, RC, RL
+/// load is Channel::Simulator::load.
+struct LoadModel {
+    LoadType type;
+
+    float capacitance; // [F]
+    float inductance; // [H]
+    float current; // [A]
+    float power; // [W]
+    float batteryOcvEmpty; // [V]
+    float batteryOcvFull; // [V]
+    float batteryResistance; // [Ohm]
+    float batteryCapacity; // [Ah]
+
+    // profile, every row is <time [s]>,<resistance [Ohm]>, after the last row it starts again
+    uint16_t profileLength;
+    float profileTime[LOAD_PROFILE_MAX_POINTS];
+    float profileResistance[LOAD_PROFILE_MAX_POINTS];
+
+    // state
+    float uSource; // output voltage source, follows Uset with the slew limit
+    float uCapacitor;
+    float iInductor;
+    float batterySoc; // 0 - 1
+    float profileElapsedTime;
+    uint32_t lastUpdateTime;
+};
+
+void resetLoad(int channelIndex);
+void resetLoadState(int channelIndex);
+
+LoadModel &getLoadModel(int channelIndex);
+
+void setLoadType(int channelIndex, LoadType type);
+bool loadProfile(int channelIndex, const char *filePath, int *err);
+
+// Output voltage follows Uset with the first order response limited by the slew rate.
+void setOutputSlewRate(float slewRate); // [V/s]
+float getOutputSlewRate();
+
+// Peak ADC noise in LSB added before quantization.
+void setAdcNoise(float noise);
+float getAdcNoise();
+
+/// Calculates monitored values for the given set values. Time step is the time since the last call.
+void updateLoad(Channel &channel, bool outputEnabled, float uSet, float iSet, float &uMon, float &iMon, bool &cc);
+
+/// Adds noise and quantizes the value to the unipolar ADC with the given full scale.
+float adcConversion(float value, float fullScale);
+
+/// Runs the load scenarios on CH1 and traces rise, settle and protection trip times.
+void runLoadScenarios();
+
+} // namespace simulator
+} // namespace psu
+} // namespace eez
+
+#endif
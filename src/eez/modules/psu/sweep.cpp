@@ -0,0 +1,363 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2015-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <eez/debug.h>
+#include <eez/system.h>
+
+#include <scpi/scpi.h>
+
+#include <eez/modules/psu/psu.h>
+#include <eez/modules/psu/channel_dispatcher.h>
+#include <eez/modules/psu/dlog_record.h>
+#include <eez/modules/psu/sweep.h>
+#include <eez/modules/psu/trigger.h>
+
+// sweep is aborted if there is no new ADC sample for this long
+#define CONF_SWEEP_SAMPLE_TIMEOUT_MS 1000
+
+namespace eez {
+namespace psu {
+namespace sweep {
+
+enum State {
+    STATE_IDLE,
+    STATE_START,
+    STATE_SETTLING,
+    STATE_MEASURING
+};
+
+static Parameters g_parameters;
+static volatile State g_state;
+static volatile bool g_abortRequested;
+static int g_err;
+
+static uint32_t g_numPoints;
+static uint32_t g_pointIndex;
+static uint32_t g_startTime;
+static uint32_t g_stateTime; // settling start or the time of the last sample
+
+// -1 at the start of measuring, because the first conversion could be started
+// before the end of the settle time and it is skipped
+static int g_numUSamples;
+static int g_numISamples;
+static float g_uSum;
+static float g_iSum;
+
+static float g_savedValues[2];
+
+////////////////////////////////////////////////////////////////////////////////
+
+static Channel &getMeasuredChannel() {
+    return Channel::get(g_parameters.axes[g_parameters.numAxes - 1].channelIndex);
+}
+
+static float getAxisValue(const Axis &axis, uint32_t index) {
+    if (axis.numSteps < 2) {
+        return axis.start;
+    }
+    return axis.start + (axis.stop - axis.start) * index / (axis.numSteps - 1);
+}
+
+static float getSetValue(const Axis &axis) {
+    Channel &channel = Channel::get(axis.channelIndex);
+    return axis.parameter == PARAMETER_VOLTAGE ? channel_dispatcher::getUSet(channel) : channel_dispatcher::getISet(channel);
+}
+
+static bool setValue(const Axis &axis, float value) {
+    Channel &channel = Channel::get(axis.channelIndex);
+
+    if (axis.parameter == PARAMETER_VOLTAGE) {
+        if (value * channel_dispatcher::getISetUnbalanced(channel) > channel_dispatcher::getPowerLimit(channel)) {
+            return false;
+        }
+        channel_dispatcher::setVoltage(channel, value);
+    } else {
+        if (value * channel_dispatcher::getUSetUnbalanced(channel) > channel_dispatcher::getPowerLimit(channel)) {
+            return false;
+        }
+        channel_dispatcher::setCurrent(channel, value);
+    }
+
+    return true;
+}
+
+static void finish(int err) {
+    for (int i = g_parameters.numAxes - 1; i >= 0; i--) {
+        Axis &axis = g_parameters.axes[i];
+        Channel &channel = Channel::get(axis.channelIndex);
+        if (axis.parameter == PARAMETER_VOLTAGE) {
+            channel_dispatcher::setVoltage(channel, g_savedValues[i]);
+        } else {
+            channel_dispatcher::setCurrent(channel, g_savedValues[i]);
+        }
+    }
+
+    uint32_t duration = micros() - g_startTime;
+    DebugTrace("Sweep: %u points in %u ms, %u points/s\n", (unsigned)g_pointIndex, (unsigned)(duration / 1000),
+        (unsigned)(duration ? (uint64_t)g_pointIndex * 1000000 / duration : 0));
+
+    g_err = err;
+    g_state = STATE_IDLE;
+}
+
+static void setPoint() {
+    const Axis &innerAxis = g_parameters.axes[g_parameters.numAxes - 1];
+    uint32_t innerIndex = g_pointIndex % innerAxis.numSteps;
+
+    // outer axis is changed only at the start of the inner sweep
+    if (g_parameters.numAxes == 2 && innerIndex == 0) {
+        if (!setValue(g_parameters.axes[0], getAxisValue(g_parameters.axes[0], g_pointIndex / innerAxis.numSteps))) {
+            finish(SCPI_ERROR_POWER_LIMIT_EXCEEDED);
+            return;
+        }
+    }
+
+    if (!setValue(innerAxis, getAxisValue(innerAxis, innerIndex))) {
+        finish(SCPI_ERROR_POWER_LIMIT_EXCEEDED);
+        return;
+    }
+
+    g_state = STATE_SETTLING;
+    g_stateTime = micros();
+}
+
+static void storePoint() {
+    float uMon = g_uSum / g_numUSamples;
+    float iMon = g_iSum / g_numISamples;
+
+    if (g_parameters.uMon) {
+        g_parameters.uMon[g_pointIndex] = uMon;
+    }
+
+    if (g_parameters.iMon) {
+        g_parameters.iMon[g_pointIndex] = iMon;
+    }
+
+    if (g_parameters.dlog && dlog_record::isTraceExecuting()) {
+        float values[dlog_view::MAX_NUM_OF_Y_AXES] = { 0 };
+        if (g_parameters.axes[g_parameters.numAxes - 1].parameter == PARAMETER_VOLTAGE) {
+            values[0] = iMon;
+            values[1] = uMon;
+        } else {
+            values[0] = uMon;
+            values[1] = iMon;
+        }
+        dlog_record::log(values);
+    }
+
+    if (++g_pointIndex == g_numPoints) {
+        finish(0);
+    } else {
+        setPoint();
+    }
+}
+
+static int checkAxis(const Axis &axis) {
+    if (axis.channelIndex < 0 || axis.channelIndex >= CH_NUM) {
+        return SCPI_ERROR_CHANNEL_NOT_FOUND;
+    }
+
+    Channel &channel = Channel::get(axis.channelIndex);
+
+    if (axis.numSteps < 1) {
+        return SCPI_ERROR_DATA_OUT_OF_RANGE;
+    }
+
+    float min = axis.start < axis.stop ? axis.start : axis.stop;
+    float max = axis.start < axis.stop ? axis.stop : axis.start;
+
+    if (axis.parameter == PARAMETER_VOLTAGE) {
+        if (channel_dispatcher::getVoltageTriggerMode(channel) != TRIGGER_MODE_FIXED && !trigger::isIdle()) {
+            return SCPI_ERROR_CANNOT_CHANGE_TRANSIENT_TRIGGER;
+        }
+
+        if (channel.isRemoteProgrammingEnabled()) {
+            return SCPI_ERROR_EXECUTION_ERROR;
+        }
+
+        if (min < channel_dispatcher::getUMin(channel)) {
+            return SCPI_ERROR_DATA_OUT_OF_RANGE;
+        }
+
+        if (max > channel_dispatcher::getULimit(channel)) {
+            return SCPI_ERROR_VOLTAGE_LIMIT_EXCEEDED;
+        }
+    } else {
+        if (channel_dispatcher::getCurrentTriggerMode(channel) != TRIGGER_MODE_FIXED && !trigger::isIdle()) {
+            return SCPI_ERROR_CANNOT_CHANGE_TRANSIENT_TRIGGER;
+        }
+
+        if (min < channel_dispatcher::getIMin(channel)) {
+            return SCPI_ERROR_DATA_OUT_OF_RANGE;
+        }
+
+        if (max > channel_dispatcher::getILimit(channel)) {
+            return SCPI_ERROR_CURRENT_LIMIT_EXCEEDED;
+        }
+    }
+
+    return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool execute(const Parameters &parameters, int *err) {
+    if (g_state != STATE_IDLE || parameters.numAxes < 1 || parameters.numAxes > 2) {
+        if (err) {
+            *err = SCPI_ERROR_EXECUTION_ERROR;
+        }
+        return false;
+    }
+
+    for (int i = 0; i < parameters.numAxes; i++) {
+        int result = checkAxis(parameters.axes[i]);
+        if (result) {
+            if (err) {
+                *err = result;
+            }
+            return false;
+        }
+    }
+
+    if (parameters.settleTime > SWEEP_MAX_SETTLE_TIME) {
+        if (err) {
+            *err = SCPI_ERROR_DATA_OUT_OF_RANGE;
+        }
+        return false;
+    }
+
+    if (parameters.numAxes == 2 &&
+        parameters.axes[0].channelIndex == parameters.axes[1].channelIndex &&
+        parameters.axes[0].parameter == parameters.axes[1].parameter) {
+        if (err) {
+            *err = SCPI_ERROR_ILLEGAL_PARAMETER_VALUE;
+        }
+        return false;
+    }
+
+    g_parameters = parameters;
+    if (g_parameters.numSamples < 1) {
+        g_parameters.numSamples = 1;
+    }
+
+    g_numPoints = parameters.axes[0].numSteps;
+    if (parameters.numAxes == 2) {
+        g_numPoints *= parameters.axes[1].numSteps;
+    }
+
+    g_err = 0;
+    g_abortRequested = false;
+
+    // the rest is done by the PSU thread
+    g_state = STATE_START;
+
+    while (g_state != STATE_IDLE) {
+        osDelay(1);
+    }
+
+    if (g_err) {
+        if (err) {
+            *err = g_err;
+        }
+        return false;
+    }
+
+    return true;
+}
+
+void abort() {
+    if (g_state != STATE_IDLE) {
+        g_abortRequested = true;
+    }
+}
+
+bool isActive() {
+    return g_state != STATE_IDLE;
+}
+
+void tick(uint32_t tickCount) {
+    if (g_state == STATE_IDLE) {
+        return;
+    }
+
+    // set values are saved before anything is checked, so finish can always restore them
+    if (g_state == STATE_START) {
+        for (int i = 0; i < g_parameters.numAxes; i++) {
+            g_savedValues[i] = getSetValue(g_parameters.axes[i]);
+        }
+        g_pointIndex = 0;
+        g_startTime = tickCount;
+    }
+
+    if (g_abortRequested) {
+        finish(SCPI_ERROR_EXECUTION_ERROR);
+        return;
+    }
+
+    for (int i = 0; i < g_parameters.numAxes; i++) {
+        if (!Channel::get(g_parameters.axes[i].channelIndex).isOutputEnabled()) {
+            finish(SCPI_ERROR_EXECUTION_ERROR);
+            return;
+        }
+    }
+
+    if (g_state == STATE_START) {
+        setPoint();
+    } else if (g_state == STATE_SETTLING) {
+        if (tickCount - g_stateTime >= g_parameters.settleTime * 1000) {
+            g_numUSamples = -1;
+            g_numISamples = -1;
+            g_uSum = 0;
+            g_iSum = 0;
+            g_state = STATE_MEASURING;
+            g_stateTime = tickCount;
+        }
+    } else if (g_state == STATE_MEASURING) {
+        if (tickCount - g_stateTime >= CONF_SWEEP_SAMPLE_TIMEOUT_MS * 1000) {
+            finish(SCPI_ERROR_EXECUTION_ERROR);
+        }
+    }
+}
+
+void onAdcData(Channel &channel, AdcDataType adcDataType) {
+    if (g_state != STATE_MEASURING || &channel != &getMeasuredChannel()) {
+        return;
+    }
+
+    if (adcDataType == ADC_DATA_TYPE_U_MON) {
+        if (g_numUSamples++ >= 0) {
+            g_uSum += channel_dispatcher::getUMonLast(channel);
+        }
+    } else if (adcDataType == ADC_DATA_TYPE_I_MON) {
+        if (g_numISamples++ >= 0) {
+            g_iSum += channel_dispatcher::getIMonLast(channel);
+        }
+    } else {
+        return;
+    }
+
+    g_stateTime = micros();
+
+    if (g_numUSamples >= (int)g_parameters.numSamples && g_numISamples >= (int)g_parameters.numSamples) {
+        storePoint();
+    }
+}
+
+} // namespace sweep
+} // namespace psu
+} // namespace eez
@@ -0,0 +1,86 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2015-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+namespace eez {
+namespace psu {
+
+// Sweep and measure engine. Steps the voltage or current of one channel (or two channels
+// with the nested sweep) from the PSU thread and measures the channel of the inner axis.
+// Point is measured as the average of numSamples ADC conversions finished after the
+// settle time, and the next point is set as soon as the last of them arrives.
+namespace sweep {
+
+#define SWEEP_MAX_STEPS 65535
+
+// in milliseconds
+#define SWEEP_MAX_SETTLE_TIME 60000
+
+// Max. number of points when the results are collected to the MicroPython heap,
+// there is no limit when the points are only streamed to DLOG.
+#define SWEEP_MAX_RESULT_POINTS 4096
+
+enum Parameter {
+    PARAMETER_VOLTAGE,
+    PARAMETER_CURRENT
+};
+
+struct Axis {
+    int channelIndex;
+    Parameter parameter;
+    float start;
+    float stop;
+    uint16_t numSteps; // number of points, start and stop included
+};
+
+struct Parameters {
+    // axes[0] is the outer axis if numAxes is 2
+    Axis axes[2];
+    int numAxes;
+
+    uint32_t settleTime; // in milliseconds
+    uint16_t numSamples;
+
+    // Results, for every point in the order they are measured. Either or both can be nullptr.
+    float *uMon;
+    float *iMon;
+
+    // Every point is also logged to DLOG trace (if trace is executing) as
+    // Imon, Umon for the voltage sweep or Umon, Imon for the current sweep.
+    bool dlog;
+};
+
+// Called from any thread except PSU thread, returns when the sweep is finished.
+// Set values of the swept channels are restored at the end.
+bool execute(const Parameters &parameters, int *err);
+
+// Called from any thread, running sweep is stopped by the PSU thread and execute returns false.
+void abort();
+
+bool isActive();
+
+// called from PSU thread
+void tick(uint32_t tickCount);
+void onAdcData(Channel &channel, AdcDataType adcDataType);
+
+} // namespace sweep
+} // namespace psu
+} // namespace eez
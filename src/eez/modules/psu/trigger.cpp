@@ -24,6 +24,7 @@
 #include <eez/modules/psu/persist_conf.h>
 #include <eez/modules/psu/profile.h>
 #include <eez/modules/psu/ramp.h>
+#include <eez/modules/psu/sweep.h>
 #include <eez/modules/psu/trigger.h>
 #include <eez/scpi/regs.h>
 #include <eez/system.h>
@@ -377,6 +378,7 @@ void abort() {
     } else {
         list::abort();
         ramp::abort();
+        sweep::abort();
 
         bool sync = false;
         for (int i = 0; i < CH_NUM; ++i) {
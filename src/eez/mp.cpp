@@ -22,6 +22,7 @@
 #include <eez/firmware.h>
 #include <eez/mp.h>
 #include <eez/system.h>
+#include <eez/trace.h>
 #include <eez/scpi/scpi.h>
 
 #include <eez/libs/sd_fat/sd_fat.h>
@@ -150,6 +151,8 @@ void startThread() {
 void oneIter();
 
 void mainLoop(const void *) {
+    TRACE_REGISTER_THREAD("MicroPython");
+
 #ifdef __EMSCRIPTEN__
     oneIter();
 #else
@@ -205,6 +208,9 @@ void oneIter() {
 				mp_init();
 			}
 
+            // not TRACE_SCOPE, destructors are not called on nlr jump
+            TRACE_BEGIN("mp::execute");
+
 			nlr_buf_t nlr;
 			if (nlr_push(&nlr) == 0) {
 				mp_lexer_t *lex = mp_lexer_new_from_str_len(MP_QSTR__lt_stdin_gt_, g_scriptSource, g_scriptSourceLength, 0);
@@ -219,6 +225,8 @@ void oneIter() {
 				mp_obj_print_exception(&mp_plat_print, (mp_obj_t)nlr.ret_val);
                 onUncaughtScriptExceptionHook();
 			}
+
+            TRACE_END("mp::execute");
 #endif
 
             psu::gui::hideAsyncOperationInProgress();
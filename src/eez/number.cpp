@@ -0,0 +1,840 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2015-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <eez/debug.h>
+#include <eez/number.h>
+#include <eez/system.h>
+
+namespace eez {
+namespace number {
+
+// Decimal digits beyond this are only used as sticky digit. It is enough,
+// because exact midpoint between two floats has at most 112 significant digits.
+#define MAX_DIGITS 128
+
+#define MAX_DECIMAL_DIGITS 20
+
+// 1280 bits, largest number needed is about 650 bits
+#define BIG_INT_WORDS 40
+
+#define FLOAT_MANTISSA_BITS 23
+#define FLOAT_HIDDEN_BIT (1u << FLOAT_MANTISSA_BITS)
+#define FLOAT_MAX_BITS 0x7F7FFFFFu
+#define FLOAT_INFINITY_BITS 0x7F800000u
+
+static const float g_pow10f[] = {
+    1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f
+};
+
+static const double g_pow10d[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static const uint32_t g_pow10u[] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+struct BigInt {
+    int numWords;
+    uint32_t words[BIG_INT_WORDS];
+};
+
+static void bigSet(BigInt &a, uint32_t value) {
+    a.words[0] = value;
+    a.numWords = value ? 1 : 0;
+}
+
+static void bigMulAdd(BigInt &a, uint32_t m, uint32_t add) {
+    uint64_t carry = add;
+    for (int i = 0; i < a.numWords; i++) {
+        uint64_t t = (uint64_t)a.words[i] * m + carry;
+        a.words[i] = (uint32_t)t;
+        carry = t >> 32;
+    }
+    if (carry && a.numWords < BIG_INT_WORDS) {
+        a.words[a.numWords++] = (uint32_t)carry;
+    }
+}
+
+static void bigMulPow10(BigInt &a, int n) {
+    for (; n >= 9; n -= 9) {
+        bigMulAdd(a, g_pow10u[9], 0);
+    }
+    if (n > 0) {
+        bigMulAdd(a, g_pow10u[n], 0);
+    }
+}
+
+static void bigShiftLeft(BigInt &a, int n) {
+    if (a.numWords == 0 || n == 0) {
+        return;
+    }
+
+    int wordShift = n / 32;
+    int bitShift = n % 32;
+
+    int numWords = a.numWords + wordShift + (bitShift ? 1 : 0);
+    if (numWords > BIG_INT_WORDS) {
+        numWords = BIG_INT_WORDS;
+    }
+
+    for (int i = numWords - 1; i >= 0; i--) {
+        int j = i - wordShift;
+        uint32_t hi = j >= 0 && j < a.numWords ? a.words[j] : 0;
+        uint32_t lo = j - 1 >= 0 && j - 1 < a.numWords ? a.words[j - 1] : 0;
+        a.words[i] = bitShift ? (hi << bitShift) | (lo >> (32 - bitShift)) : hi;
+    }
+
+    a.numWords = numWords;
+    while (a.numWords > 0 && a.words[a.numWords - 1] == 0) {
+        a.numWords--;
+    }
+}
+
+static int bigCompare(const BigInt &a, const BigInt &b) {
+    if (a.numWords != b.numWords) {
+        return a.numWords < b.numWords ? -1 : 1;
+    }
+    for (int i = a.numWords - 1; i >= 0; i--) {
+        if (a.words[i] != b.words[i]) {
+            return a.words[i] < b.words[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+static void bigAdd(BigInt &a, const BigInt &b) {
+    int numWords = a.numWords > b.numWords ? a.numWords : b.numWords;
+    uint64_t carry = 0;
+    for (int i = 0; i < numWords; i++) {
+        uint64_t t = carry + (i < a.numWords ? a.words[i] : 0) + (i < b.numWords ? b.words[i] : 0);
+        a.words[i] = (uint32_t)t;
+        carry = t >> 32;
+    }
+    a.numWords = numWords;
+    if (carry && a.numWords < BIG_INT_WORDS) {
+        a.words[a.numWords++] = (uint32_t)carry;
+    }
+}
+
+// a must be >= b
+static void bigSub(BigInt &a, const BigInt &b) {
+    int64_t borrow = 0;
+    for (int i = 0; i < a.numWords; i++) {
+        int64_t t = (int64_t)a.words[i] - (i < b.numWords ? b.words[i] : 0) - borrow;
+        borrow = t < 0 ? 1 : 0;
+        a.words[i] = (uint32_t)t;
+    }
+    while (a.numWords > 0 && a.words[a.numWords - 1] == 0) {
+        a.numWords--;
+    }
+}
+
+// returns remainder
+static uint32_t bigDivSmall(BigInt &a, uint32_t d) {
+    uint64_t remainder = 0;
+    for (int i = a.numWords - 1; i >= 0; i--) {
+        uint64_t t = (remainder << 32) | a.words[i];
+        a.words[i] = (uint32_t)(t / d);
+        remainder = t % d;
+    }
+    while (a.numWords > 0 && a.words[a.numWords - 1] == 0) {
+        a.numWords--;
+    }
+    return (uint32_t)remainder;
+}
+
+// a = a >> n, returns -1, 0 or 1 if shifted out bits are less, equal or greater then half
+static int bigShiftRightRound(BigInt &a, int n) {
+    int wordShift = n / 32;
+    int bitShift = n % 32;
+
+    // examine shifted out bits
+    int half;
+    int halfWord = (n - 1) / 32;
+    uint32_t halfBit = 1u << ((n - 1) % 32);
+    if (halfWord >= a.numWords) {
+        half = -1;
+    } else {
+        uint32_t w = a.words[halfWord];
+        if (!(w & halfBit)) {
+            half = -1;
+        } else {
+            bool isRestZero = (w & (halfBit - 1)) == 0;
+            for (int i = 0; isRestZero && i < halfWord; i++) {
+                isRestZero = a.words[i] == 0;
+            }
+            half = isRestZero ? 0 : 1;
+        }
+    }
+
+    int numWords = a.numWords - wordShift;
+    if (numWords <= 0) {
+        a.numWords = 0;
+        return half;
+    }
+
+    for (int i = 0; i < numWords; i++) {
+        uint32_t lo = a.words[i + wordShift];
+        uint32_t hi = i + wordShift + 1 < a.numWords ? a.words[i + wordShift + 1] : 0;
+        a.words[i] = bitShift ? (lo >> bitShift) | (hi << (32 - bitShift)) : lo;
+    }
+
+    a.numWords = numWords;
+    while (a.numWords > 0 && a.words[a.numWords - 1] == 0) {
+        a.numWords--;
+    }
+
+    return half;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static uint32_t floatToBits(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static float bitsToFloat(uint32_t bits) {
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// absolute value of finite float is mantissa * 2^exponent
+static void decodeFloat(uint32_t bits, uint32_t &mantissa, int &exponent, bool &isNormal) {
+    int biasedExponent = (bits >> FLOAT_MANTISSA_BITS) & 0xFF;
+    mantissa = bits & (FLOAT_HIDDEN_BIT - 1);
+    if (biasedExponent) {
+        mantissa |= FLOAT_HIDDEN_BIT;
+        exponent = biasedExponent - 150;
+        isNormal = true;
+    } else {
+        exponent = -149;
+        isNormal = false;
+    }
+}
+
+// compares digits * 10^exponent10 with mantissa * 2^exponent2
+static int compareExact(const BigInt &digits, int exponent10, uint32_t mantissa, int exponent2) {
+    BigInt lhs = digits;
+
+    BigInt rhs;
+    bigSet(rhs, mantissa);
+
+    if (exponent10 >= 0) {
+        bigMulPow10(lhs, exponent10);
+    } else {
+        bigMulPow10(rhs, -exponent10);
+    }
+
+    if (exponent2 >= 0) {
+        bigShiftLeft(rhs, exponent2);
+    } else {
+        bigShiftLeft(lhs, -exponent2);
+    }
+
+    return bigCompare(lhs, rhs);
+}
+
+// compare with the midpoint between float and the next one
+static int compareWithUpperMidpoint(const BigInt &digits, int exponent10, uint32_t bits) {
+    uint32_t mantissa;
+    int exponent;
+    bool isNormal;
+    decodeFloat(bits, mantissa, exponent, isNormal);
+    return compareExact(digits, exponent10, 2 * mantissa + 1, exponent - 1);
+}
+
+// compare with the midpoint between float and the previous one
+static int compareWithLowerMidpoint(const BigInt &digits, int exponent10, uint32_t bits) {
+    uint32_t mantissa;
+    int exponent;
+    bool isNormal;
+    decodeFloat(bits, mantissa, exponent, isNormal);
+    if (mantissa == FLOAT_HIDDEN_BIT && (bits >> FLOAT_MANTISSA_BITS) > 1) {
+        // previous float is in the lower binade, so the gap is half
+        return compareExact(digits, exponent10, 4 * mantissa - 1, exponent - 2);
+    }
+    return compareExact(digits, exponent10, 2 * mantissa - 1, exponent - 1);
+}
+
+// value is digits * 10^exponent10, digits has no leading or trailing zeros
+static uint32_t decimalToFloatBits(const uint8_t *digits, int numDigits, int exponent10) {
+    // numbers outside of these limits are surely infinity or zero
+    int magnitude = numDigits + exponent10;
+    if (magnitude > 39) {
+        return FLOAT_INFINITY_BITS;
+    }
+    if (magnitude < -45) {
+        return 0;
+    }
+
+    int numMantissaDigits = numDigits < 19 ? numDigits : 19;
+    uint64_t mantissa = 0;
+    for (int i = 0; i < numMantissaDigits; i++) {
+        mantissa = mantissa * 10 + digits[i];
+    }
+
+    // exact when both mantissa and power of 10 are exact floats
+    if (numDigits == numMantissaDigits && mantissa <= (1u << 24) && exponent10 >= -10 && exponent10 <= 10) {
+        float value = (float)mantissa;
+        value = exponent10 >= 0 ? value * g_pow10f[exponent10] : value / g_pow10f[-exponent10];
+        return floatToBits(value);
+    }
+
+    // approximation which is at most one float away from the correct result
+    double approx = (double)mantissa;
+    int e = exponent10 + numDigits - numMantissaDigits;
+    for (; e > 22; e -= 22) {
+        approx *= 1e22;
+    }
+    for (; e < -22; e += 22) {
+        approx /= 1e22;
+    }
+    approx = e >= 0 ? approx * g_pow10d[e] : approx / g_pow10d[-e];
+
+    uint32_t bits = approx < 3.4028234663852886e38 ? floatToBits((float)approx) : FLOAT_MAX_BITS;
+
+    // and now correct it by the exact comparison with the midpoints
+    BigInt big;
+    bigSet(big, 0);
+    for (int i = 0; i < numDigits;) {
+        uint32_t chunk = 0;
+        int n;
+        for (n = 0; n < 9 && i < numDigits; n++, i++) {
+            chunk = chunk * 10 + digits[i];
+        }
+        bigMulAdd(big, g_pow10u[n], chunk);
+    }
+
+    while (true) {
+        int result = compareWithUpperMidpoint(big, exponent10, bits);
+        if (result > 0 || (result == 0 && (bits & 1))) {
+            if (bits == FLOAT_MAX_BITS) {
+                return FLOAT_INFINITY_BITS;
+            }
+            bits++;
+            continue;
+        }
+
+        if (bits == 0) {
+            break;
+        }
+
+        result = compareWithLowerMidpoint(big, exponent10, bits);
+        if (result < 0 || (result == 0 && (bits & 1))) {
+            bits--;
+            continue;
+        }
+
+        break;
+    }
+
+    return bits;
+}
+
+size_t parseFloat(const char *str, size_t len, float &value) {
+    size_t i = 0;
+
+    bool isNegative = false;
+    if (i < len && (str[i] == '+' || str[i] == '-')) {
+        isNegative = str[i] == '-';
+        i++;
+    }
+
+    uint8_t digits[MAX_DIGITS + 1];
+    int numDigits = 0;
+    int exponent10 = 0;
+    bool isSticky = false;
+    bool hasDigits = false;
+    bool isFraction = false;
+
+    for (; i < len; i++) {
+        char c = str[i];
+        if (c >= '0' && c <= '9') {
+            hasDigits = true;
+            if (numDigits == 0 && c == '0') {
+                // leading zero
+                if (isFraction) {
+                    exponent10--;
+                }
+            } else if (numDigits < MAX_DIGITS) {
+                digits[numDigits++] = c - '0';
+                if (isFraction) {
+                    exponent10--;
+                }
+            } else {
+                if (c != '0') {
+                    isSticky = true;
+                }
+                if (!isFraction) {
+                    exponent10++;
+                }
+            }
+        } else if (c == '.' && !isFraction) {
+            isFraction = true;
+        } else {
+            break;
+        }
+    }
+
+    if (!hasDigits) {
+        return 0;
+    }
+
+    if (i < len && (str[i] == 'e' || str[i] == 'E')) {
+        size_t j = i + 1;
+        bool isExponentNegative = false;
+        if (j < len && (str[j] == '+' || str[j] == '-')) {
+            isExponentNegative = str[j] == '-';
+            j++;
+        }
+        if (j < len && str[j] >= '0' && str[j] <= '9') {
+            int exponent = 0;
+            for (; j < len && str[j] >= '0' && str[j] <= '9'; j++) {
+                if (exponent < 100000) {
+                    exponent = exponent * 10 + str[j] - '0';
+                }
+            }
+            exponent10 += isExponentNegative ? -exponent : exponent;
+            i = j;
+        }
+    }
+
+    if (isSticky) {
+        digits[numDigits++] = 1;
+        exponent10--;
+    } else {
+        while (numDigits > 0 && digits[numDigits - 1] == 0) {
+            numDigits--;
+            exponent10++;
+        }
+    }
+
+    uint32_t bits = numDigits > 0 ? decimalToFloatBits(digits, numDigits, exponent10) : 0;
+    if (isNegative) {
+        bits |= 0x80000000u;
+    }
+    value = bitsToFloat(bits);
+
+    return i;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static size_t formatSpecial(uint32_t bits, char *str) {
+    if ((bits & FLOAT_INFINITY_BITS) != FLOAT_INFINITY_BITS) {
+        return 0;
+    }
+    if (bits & (FLOAT_HIDDEN_BIT - 1)) {
+        strcpy(str, "nan");
+        return 3;
+    }
+    strcpy(str, bits & 0x80000000u ? "-inf" : "inf");
+    return bits & 0x80000000u ? 4 : 3;
+}
+
+// floor(log10(2^exponent2))
+static int floorLog10Pow2(int exponent2) {
+    return exponent2 >= 0 ? (exponent2 * 78913) >> 18 : -((-exponent2 * 78913 + (1 << 18) - 1) >> 18);
+}
+
+// Shortest digits in the rounding interval (Steele & White / Burger & Dybvig free format).
+// Returns number of digits, value is 0.d1d2d3... * 10^exponent10.
+static int shortestDigits(uint32_t mantissa, int exponent, bool isNormal, uint8_t *digits, int &exponent10) {
+    BigInt r, s, mPlus, mMinus;
+
+    // gap to the previous float is half of the gap to the next one
+    bool isUnequalGap = isNormal && mantissa == FLOAT_HIDDEN_BIT && exponent > -149;
+
+    bigSet(r, mantissa);
+    bigSet(s, 1);
+    bigSet(mPlus, 1);
+    if (exponent >= 0) {
+        bigShiftLeft(r, exponent + 1);
+        bigShiftLeft(s, 1);
+        bigShiftLeft(mPlus, exponent);
+    } else {
+        bigShiftLeft(r, 1);
+        bigShiftLeft(s, 1 - exponent);
+    }
+    mMinus = mPlus;
+    if (isUnequalGap) {
+        bigShiftLeft(r, 1);
+        bigShiftLeft(s, 1);
+        bigShiftLeft(mPlus, 1);
+    }
+
+    int bitLength = 0;
+    for (uint32_t m = mantissa; m; m >>= 1) {
+        bitLength++;
+    }
+    int k = floorLog10Pow2(bitLength - 1 + exponent) + 1;
+
+    if (k >= 0) {
+        bigMulPow10(s, k);
+    } else {
+        bigMulPow10(r, -k);
+        bigMulPow10(mPlus, -k);
+        bigMulPow10(mMinus, -k);
+    }
+
+    bool isEven = (mantissa & 1) == 0;
+
+    // fixup k, so that (r + mPlus) / s < 1 and (r + mPlus) * 10 / s >= 1
+    BigInt t;
+    while (true) {
+        t = r;
+        bigAdd(t, mPlus);
+        int result = bigCompare(t, s);
+        if (result > 0 || (result == 0 && isEven)) {
+            bigMulAdd(s, 10, 0);
+            k++;
+        } else {
+            break;
+        }
+    }
+    while (true) {
+        t = r;
+        bigAdd(t, mPlus);
+        bigMulAdd(t, 10, 0);
+        int result = bigCompare(t, s);
+        if (result < 0 || (result == 0 && !isEven)) {
+            bigMulAdd(r, 10, 0);
+            bigMulAdd(mPlus, 10, 0);
+            bigMulAdd(mMinus, 10, 0);
+            k--;
+        } else {
+            break;
+        }
+    }
+
+    int numDigits = 0;
+    while (true) {
+        bigMulAdd(r, 10, 0);
+        bigMulAdd(mPlus, 10, 0);
+        bigMulAdd(mMinus, 10, 0);
+
+        uint8_t digit = 0;
+        while (bigCompare(r, s) >= 0) {
+            bigSub(r, s);
+            digit++;
+        }
+
+        int result = bigCompare(r, mMinus);
+        bool isLow = result < 0 || (result == 0 && isEven);
+
+        t = r;
+        bigAdd(t, mPlus);
+        result = bigCompare(t, s);
+        bool isHigh = result > 0 || (result == 0 && isEven);
+
+        if (isLow || isHigh || numDigits == 9) {
+            if (isLow && isHigh) {
+                t = r;
+                bigShiftLeft(t, 1);
+                result = bigCompare(t, s);
+                if (result > 0 || (result == 0 && (digit & 1))) {
+                    digit++;
+                }
+            } else if (isHigh) {
+                digit++;
+            }
+            digits[numDigits++] = digit;
+            break;
+        }
+
+        digits[numDigits++] = digit;
+    }
+
+    exponent10 = k;
+    return numDigits;
+}
+
+size_t formatFloat(float value, char *str) {
+    uint32_t bits = floatToBits(value);
+
+    size_t length = formatSpecial(bits, str);
+    if (length) {
+        return length;
+    }
+
+    char *p = str;
+    if (bits & 0x80000000u) {
+        *p++ = '-';
+    }
+
+    uint32_t mantissa;
+    int exponent;
+    bool isNormal;
+    decodeFloat(bits, mantissa, exponent, isNormal);
+
+    if (mantissa == 0) {
+        *p++ = '0';
+        *p = 0;
+        return p - str;
+    }
+
+    uint8_t digits[10];
+    int exponent10;
+    int numDigits = shortestDigits(mantissa, exponent, isNormal, digits, exponent10);
+
+    // exponent of the first digit
+    int e = exponent10 - 1;
+
+    if (e < -4 || e > 8) {
+        *p++ = '0' + digits[0];
+        if (numDigits > 1) {
+            *p++ = '.';
+            for (int i = 1; i < numDigits; i++) {
+                *p++ = '0' + digits[i];
+            }
+        }
+        *p++ = 'e';
+        if (e < 0) {
+            *p++ = '-';
+            e = -e;
+        } else {
+            *p++ = '+';
+        }
+        if (e >= 10) {
+            *p++ = '0' + e / 10;
+        } else {
+            *p++ = '0';
+        }
+        *p++ = '0' + e % 10;
+    } else if (e < 0) {
+        *p++ = '0';
+        *p++ = '.';
+        for (int i = -1; i > e; i--) {
+            *p++ = '0';
+        }
+        for (int i = 0; i < numDigits; i++) {
+            *p++ = '0' + digits[i];
+        }
+    } else {
+        for (int i = 0; i <= e || i < numDigits; i++) {
+            if (i == e + 1) {
+                *p++ = '.';
+            }
+            *p++ = '0' + (i < numDigits ? digits[i] : 0);
+        }
+    }
+
+    *p = 0;
+    return p - str;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+size_t formatFloatFixed(float value, int numDecimalDigits, char *str, size_t len) {
+    if (len == 0) {
+        return 0;
+    }
+
+    if (numDecimalDigits < 0) {
+        numDecimalDigits = 0;
+    } else if (numDecimalDigits > MAX_DECIMAL_DIGITS) {
+        numDecimalDigits = MAX_DECIMAL_DIGITS;
+    }
+
+    uint32_t bits = floatToBits(value);
+
+    // sign + 39 integer digits + point + decimal digits + '\0'
+    char text[1 + 39 + 1 + MAX_DECIMAL_DIGITS + 1];
+    char *p = text;
+
+    size_t length = formatSpecial(bits, text);
+    if (length) {
+        p += length;
+    } else {
+        if (bits & 0x80000000u) {
+            *p++ = '-';
+        }
+
+        uint32_t mantissa;
+        int exponent;
+        bool isNormal;
+        decodeFloat(bits, mantissa, exponent, isNormal);
+
+        // round(mantissa * 2^exponent * 10^numDecimalDigits), digits in reverse order
+        char reversed[72];
+        int numDigits = 0;
+
+        if (numDecimalDigits <= 9 && exponent >= -63 && exponent <= 9) {
+            uint64_t scaled = (uint64_t)mantissa * g_pow10u[numDecimalDigits];
+            if (exponent >= 0) {
+                scaled <<= exponent;
+            } else {
+                int shift = -exponent;
+                uint64_t remainder = scaled & ((1ull << shift) - 1);
+                uint64_t half = 1ull << (shift - 1);
+                scaled >>= shift;
+                if (remainder > half || (remainder == half && (scaled & 1))) {
+                    scaled++;
+                }
+            }
+
+            do {
+                reversed[numDigits++] = '0' + scaled % 10;
+                scaled /= 10;
+            } while (scaled);
+        } else {
+            BigInt scaled;
+            bigSet(scaled, mantissa);
+            bigMulPow10(scaled, numDecimalDigits);
+            if (exponent >= 0) {
+                bigShiftLeft(scaled, exponent);
+            } else {
+                int half = bigShiftRightRound(scaled, -exponent);
+                if (half > 0 || (half == 0 && scaled.numWords > 0 && (scaled.words[0] & 1))) {
+                    bigMulAdd(scaled, 1, 1);
+                }
+            }
+
+            do {
+                uint32_t chunk = bigDivSmall(scaled, g_pow10u[9]);
+                for (int i = 0; i < 9; i++) {
+                    reversed[numDigits++] = '0' + chunk % 10;
+                    chunk /= 10;
+                }
+            } while (scaled.numWords > 0);
+
+            while (numDigits > 1 && reversed[numDigits - 1] == '0') {
+                numDigits--;
+            }
+        }
+
+        while (numDigits <= numDecimalDigits) {
+            reversed[numDigits++] = '0';
+        }
+
+        for (int i = numDigits - 1; i >= 0; i--) {
+            *p++ = reversed[i];
+            if (i == numDecimalDigits && i > 0) {
+                *p++ = '.';
+            }
+        }
+    }
+
+    length = p - text;
+    if (length > len - 1) {
+        length = len - 1;
+    }
+    memcpy(str, text, length);
+    str[length] = 0;
+
+    return length;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void benchmark(int numIterations) {
+    char text[64];
+    float x;
+    float value;
+
+    // fixed seed, so every run is done with the same numbers
+    uint32_t seed = 1;
+
+    int numMismatches = 0;
+    int numFixedMismatches = 0;
+    int numLibcMismatches = 0;
+
+    for (int i = 0; i < numIterations; i++) {
+        seed = seed * 1103515245 + 12345;
+        uint32_t bits = seed;
+        if ((bits & FLOAT_INFINITY_BITS) == FLOAT_INFINITY_BITS) {
+            continue;
+        }
+
+        x = bitsToFloat(bits);
+
+        size_t length = formatFloat(x, text);
+        if (parseFloat(text, length, value) != length || floatToBits(value) != bits) {
+            numMismatches++;
+        }
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+        // value between 2^-10 and 2^10 with 4 decimal digits, as used in list files
+        x = bitsToFloat((bits & 0x807FFFFF) | ((117 + (bits >> 23) % 20) << FLOAT_MANTISSA_BITS));
+        formatFloatFixed(x, 4, text, sizeof(text));
+        char libcText[64];
+        snprintf(libcText, sizeof(libcText), "%.4f", x);
+        if (strcmp(text, libcText) != 0) {
+            numFixedMismatches++;
+        }
+
+        // random decimal text, parsed result must be the same as strtof
+        snprintf(libcText, sizeof(libcText), "%u.%05ue%d", (unsigned)(seed % 100000000), (unsigned)(seed >> 17) % 100000, (int)(seed % 90) - 50);
+        parseFloat(libcText, strlen(libcText), value);
+        if (floatToBits(value) != floatToBits(strtof(libcText, nullptr))) {
+            numLibcMismatches++;
+        }
+#endif
+    }
+
+    DebugTrace("Number codec: %d round trip, %d fixed, %d libc mismatches\n",
+        numMismatches, numFixedMismatches, numLibcMismatches);
+
+    static const char *g_samples[] = { "0.0001", "1.2345", "40", "-3.3", "0.000001", "3.40282e38", "1.17549435e-38", "123456.789" };
+    static const int NUM_SAMPLES = sizeof(g_samples) / sizeof(g_samples[0]);
+
+    uint32_t parseTime[2] = { 0, 0 };
+    uint32_t formatTime[2] = { 0, 0 };
+
+    for (int j = 0; j < 2; j++) {
+        uint32_t start = micros();
+        for (int i = 0; i < numIterations; i++) {
+            const char *sample = g_samples[i % NUM_SAMPLES];
+            if (j == 0) {
+                parseFloat(sample, strlen(sample), value);
+            } else {
+                value = strtof(sample, nullptr);
+            }
+        }
+        parseTime[j] = micros() - start;
+
+        start = micros();
+        for (int i = 0; i < numIterations; i++) {
+            x = (float)(i % 100000) * 0.001f;
+            if (j == 0) {
+                formatFloatFixed(x, 4, text, sizeof(text));
+            } else {
+                snprintf(text, sizeof(text), "%.4f", x);
+            }
+        }
+        formatTime[j] = micros() - start;
+    }
+
+    DebugTrace("Number codec: parse %u us (libc %u us), format %u us (libc %u us)\n",
+        (unsigned)parseTime[0], (unsigned)parseTime[1], (unsigned)formatTime[0], (unsigned)formatTime[1]);
+}
+
+} // namespace number
+} // namespace eez
@@ -0,0 +1,51 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2015-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+namespace eez {
+
+// Text <-> float conversion used for SD card files (SCPI output format is not changed).
+// Doesn't use C library (no locale, no heap), parsing is correctly rounded
+// and formatting is exact. Common cases (up to 7 significant digits) are done
+// with a single float operation, everything else with fixed size big integers.
+namespace number {
+
+// "-1.2345678e-38" + '\0'
+#define FLOAT_MAX_TEXT_LENGTH 16
+
+// Parses [+|-]digits[.digits][(e|E)[+|-]digits] from the start of str.
+// Returns number of characters used or 0 if str doesn't start with a number.
+size_t parseFloat(const char *str, size_t len, float &value);
+
+// Shortest text which parses back to the same float. Notation is the same as
+// for "%g": exponent is used if it is less then -4 or greater then 8.
+// str must have space for FLOAT_MAX_TEXT_LENGTH characters. Returns text length.
+size_t formatFloat(float value, char *str);
+
+// Same as snprintf(str, len, "%.*f", numDecimalDigits, value), numDecimalDigits is limited to 20.
+size_t formatFloatFixed(float value, int numDecimalDigits, char *str, size_t len);
+
+// Round trip check of numIterations pseudo random floats (and comparison with the C library
+// on the simulator) followed by the throughput of both. Result is sent to debug trace.
+void benchmark(int numIterations);
+
+} // namespace number
+} // namespace eez
@@ -0,0 +1,387 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2015-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Entry point of the bb3_bench target. It is built from the same sources as the simulator,
+// except main.cpp, with EEZ_PLATFORM_SIMULATOR_HEADLESS, so there is no window, input or audio.
+//
+// bb3_bench [--seed <n>] [--output <file>] [--state-dir <dir>] [--scenario <name>]... [--virtual-time] [--list]
+//
+// EEPROM, RTC and SD card of the simulator are kept in $HOME/.eez_psu_sim, --state-dir
+// replaces $HOME, so the benchmark can start from the empty state on every run.
+//
+// With --virtual-time the wall clock metrics are in the virtual time, they are exactly
+// the same on every run with the same seed, and the endurance scenarios take minutes.
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <eez/firmware.h>
+#include <eez/system.h>
+#include <eez/util.h>
+
+#include <eez/gui/gui.h>
+
+#include <eez/modules/psu/psu.h>
+#include <eez/modules/psu/scpi/psu.h>
+
+#include <eez/platform/simulator/bench/bench.h>
+
+#include <cmsis_os.h>
+
+////////////////////////////////////////////////////////////////////////////////
+
+void benchTask(const void *);
+osThreadDef(g_benchTask, benchTask, osPriorityNormal, 0, 4096);
+
+// time after boot for the welcome page, auto recall and the first measurements
+static const uint32_t BOOT_SETTLE_TIME = 3000;
+
+static const int MAX_SELECTED_SCENARIOS = 16;
+
+static uint32_t g_seed = 1;
+static const char *g_outputFilePath;
+static const char *g_selectedScenarios[MAX_SELECTED_SCENARIOS];
+static int g_numSelectedScenarios;
+static int g_exitCode;
+
+namespace eez {
+namespace bench {
+
+////////////////////////////////////////////////////////////////////////////////
+
+static uint32_t g_randomState;
+
+uint32_t randomUint() {
+    g_randomState = g_randomState * 1103515245 + 12345;
+    return g_randomState >> 1;
+}
+
+float randomFloat(float min, float max) {
+    return min + (max - min) * (randomUint() % 100001) / 100000.0f;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+using namespace eez::scpi;
+using namespace eez::psu::scpi;
+
+static const uint32_t SCPI_RESULT_MAX_LENGTH = 1024;
+
+static char g_scpiResult[SCPI_RESULT_MAX_LENGTH + 1];
+static uint32_t g_scpiResultLength; // can be longer than the stored part of the result
+static int_fast16_t g_lastError;
+static uint32_t g_numErrors;
+
+static size_t SCPI_Write(scpi_t *context, const char *data, size_t len) {
+    if (g_scpiResultLength < SCPI_RESULT_MAX_LENGTH) {
+        size_t n = MIN(len, SCPI_RESULT_MAX_LENGTH - g_scpiResultLength);
+        memcpy(g_scpiResult + g_scpiResultLength, data, n);
+        g_scpiResult[g_scpiResultLength + n] = 0;
+    }
+    g_scpiResultLength += len;
+    return len;
+}
+
+static scpi_result_t SCPI_Flush(scpi_t *context) {
+    return SCPI_RES_OK;
+}
+
+static int SCPI_Error(scpi_t *context, int_fast16_t err) {
+    if (err != 0) {
+        g_lastError = err;
+        if (err == SCPI_ERROR_INPUT_BUFFER_OVERRUN) {
+            psu::scpi::onBufferOverrun(*context);
+        }
+    }
+    return 0;
+}
+
+static scpi_result_t SCPI_Control(scpi_t *context, scpi_ctrl_name_t ctrl, scpi_reg_val_t val) {
+    return SCPI_RES_OK;
+}
+
+static scpi_result_t SCPI_Reset(scpi_t *context) {
+    return eez::reset() ? SCPI_RES_OK : SCPI_RES_ERR;
+}
+
+static scpi_reg_val_t g_scpiPsuRegs[SCPI_PSU_REG_COUNT];
+static scpi_psu_t g_scpiPsuContext = { g_scpiPsuRegs };
+
+static scpi_interface_t g_scpiInterface = {
+    SCPI_Error, SCPI_Write, SCPI_Control, SCPI_Flush, SCPI_Reset,
+};
+
+static char g_scpiInputBuffer[SCPI_PARSER_INPUT_BUFFER_LENGTH];
+static scpi_error_t g_errorQueueData[SCPI_PARSER_ERROR_QUEUE_SIZE + 1];
+
+static scpi_t g_scpiContext;
+
+bool scpi(const char *commandOrQueryFormat, ...) {
+    char commandOrQuery[256];
+
+    va_list args;
+    va_start(args, commandOrQueryFormat);
+    vsnprintf(commandOrQuery, sizeof(commandOrQuery), commandOrQueryFormat, args);
+    va_end(args);
+
+    g_scpiResultLength = 0;
+    g_scpiResult[0] = 0;
+    g_lastError = 0;
+
+    input(g_scpiContext, commandOrQuery, strlen(commandOrQuery));
+    input(g_scpiContext, "\r\n", 2);
+
+    if (g_lastError != 0) {
+        g_numErrors++;
+        fprintf(stderr, "%s: SCPI error %d, \"%s\"\n", commandOrQuery, (int)g_lastError, SCPI_ErrorTranslate(g_lastError));
+        return false;
+    }
+
+    if (g_scpiResultLength >= 2 && g_scpiResultLength <= SCPI_RESULT_MAX_LENGTH &&
+        g_scpiResult[g_scpiResultLength - 2] == '\r' && g_scpiResult[g_scpiResultLength - 1] == '\n') {
+        g_scpiResult[g_scpiResultLength - 2] = 0;
+    }
+
+    return true;
+}
+
+const char *getScpiResult() {
+    return g_scpiResult;
+}
+
+uint32_t getScpiResultLength() {
+    return g_scpiResultLength;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+bool waitFor(bool (*condition)(), uint32_t timeoutMs) {
+    uint32_t startTime = millis();
+    while (!condition()) {
+        if (millis() - startTime > timeoutMs) {
+            return false;
+        }
+        osDelay(1);
+    }
+    return true;
+}
+
+bool waitForFrames(uint32_t numFrames, uint32_t timeoutMs) {
+    uint32_t lastFrame = gui::g_frameStats.numFrames + numFrames;
+    uint32_t startTime = millis();
+    while ((int32_t)(gui::g_frameStats.numFrames - lastFrame) < 0) {
+        if (millis() - startTime > timeoutMs) {
+            return false;
+        }
+        osDelay(1);
+    }
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static FILE *g_fp;
+static bool g_firstScenario = true;
+static bool g_firstMetric;
+
+static void writeNumber(double value) {
+    if (isnan(value) || isinf(value)) {
+        fprintf(g_fp, "null");
+    } else if (value == floor(value) && fabs(value) < 1E15) {
+        fprintf(g_fp, "%.0f", value);
+    } else {
+        fprintf(g_fp, "%.3f", value);
+    }
+}
+
+void metric(const char *name, double value) {
+    fprintf(g_fp, "%s\n        \"%s\": ", g_firstMetric ? "" : ",", name);
+    writeNumber(value);
+    g_firstMetric = false;
+}
+
+void Stats::reset() {
+    count = 0;
+    min = 0;
+    max = 0;
+    total = 0;
+}
+
+void Stats::add(uint32_t value) {
+    if (count == 0 || value < min) {
+        min = value;
+    }
+    if (value > max) {
+        max = value;
+    }
+    total += value;
+    count++;
+}
+
+void metric(const char *prefix, const Stats &stats) {
+    char name[64];
+
+    snprintf(name, sizeof(name), "%s_count", prefix);
+    metric(name, stats.count);
+
+    snprintf(name, sizeof(name), "%s_mean_us", prefix);
+    metric(name, stats.count ? 1.0 * stats.total / stats.count : 0);
+
+    snprintf(name, sizeof(name), "%s_min_us", prefix);
+    metric(name, stats.min);
+
+    snprintf(name, sizeof(name), "%s_max_us", prefix);
+    metric(name, stats.max);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void syncPsuThreadCallback() {
+}
+
+// *RST is posted to the PSU thread, tick (and the callback) is executed only when its queue is empty
+static void syncPsuThread() {
+    psu::g_diagCallback = syncPsuThreadCallback;
+    while (psu::g_diagCallback) {
+        osDelay(1);
+    }
+}
+
+static bool isScenarioSelected(const char *name) {
+    if (g_numSelectedScenarios == 0) {
+        return true;
+    }
+    for (int i = 0; i < g_numSelectedScenarios; i++) {
+        if (strcmp(g_selectedScenarios[i], name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void runScenario(Scenario &scenario) {
+    fprintf(stderr, "Running %s...\n", scenario.name);
+
+    // every scenario starts from the same state
+    g_randomState = g_seed;
+    g_numErrors = 0;
+    scpi("*RST");
+    syncPsuThread();
+    scpi("*CLS");
+    scpi("SIMU:NOIS 0");
+
+    fprintf(g_fp, "%s\n    {\n      \"name\": \"%s\",\n      \"metrics\": {", g_firstScenario ? "" : ",", scenario.name);
+    g_firstScenario = false;
+    g_firstMetric = true;
+
+    uint64_t startTime = microsPrecise();
+    scenario.run();
+    metric("duration_ms", (microsPrecise() - startTime) / 1000.0);
+
+    fprintf(g_fp, "\n      },\n      \"errors\": %u\n    }", (unsigned)g_numErrors);
+    fflush(g_fp);
+}
+
+void run() {
+    psu::scpi::init(g_scpiContext, g_scpiPsuContext, &g_scpiInterface, g_scpiInputBuffer, SCPI_PARSER_INPUT_BUFFER_LENGTH, g_errorQueueData, SCPI_PARSER_ERROR_QUEUE_SIZE + 1);
+
+    g_fp = g_outputFilePath ? fopen(g_outputFilePath, "w") : stdout;
+    if (!g_fp) {
+        fprintf(stderr, "Can't open %s\n", g_outputFilePath);
+        g_exitCode = 1;
+        return;
+    }
+
+    fprintf(g_fp, "{\n  \"seed\": %u,\n  \"channels\": %d,\n  \"scenarios\": [", (unsigned)g_seed, psu::CH_NUM);
+
+    init();
+
+    for (int i = 0; i < NUM_SCENARIOS; i++) {
+        if (isScenarioSelected(g_scenarios[i].name)) {
+            runScenario(g_scenarios[i]);
+        }
+    }
+
+    fprintf(g_fp, "\n  ]\n}\n");
+
+    if (g_fp != stdout) {
+        fclose(g_fp);
+    }
+}
+
+} // namespace bench
+} // namespace eez
+
+////////////////////////////////////////////////////////////////////////////////
+
+void benchTask(const void *) {
+    eez::boot();
+
+    osDelay(BOOT_SETTLE_TIME);
+
+    eez::bench::run();
+
+    eez::shutdown();
+
+    while (true) {
+        osDelay(1000);
+    }
+}
+
+int main(int argc, char **argv) {
+    using namespace eez::bench;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--list") == 0) {
+            for (int j = 0; j < NUM_SCENARIOS; j++) {
+                printf("%s\n", g_scenarios[j].name);
+            }
+            return 0;
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            g_seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            g_outputFilePath = argv[++i];
+#if defined(EEZ_PLATFORM_SIMULATOR_UNIX)
+        } else if (strcmp(argv[i], "--state-dir") == 0 && i + 1 < argc) {
+            setenv("HOME", argv[++i], 1);
+#endif
+        } else if (strcmp(argv[i], "--virtual-time") == 0) {
+            osKernelEnableVirtualTime();
+        } else if (strcmp(argv[i], "--scenario") == 0 && i + 1 < argc) {
+            if (g_numSelectedScenarios < MAX_SELECTED_SCENARIOS) {
+                g_selectedScenarios[g_numSelectedScenarios++] = argv[++i];
+            }
+        } else {
+            fprintf(stderr, "Usage: %s [--seed <n>] [--output <file>] [--state-dir <dir>] [--scenario <name>]... [--virtual-time] [--list]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    osThreadCreate(osThread(g_benchTask), nullptr);
+
+    osKernelStart();
+
+    while (!eez::g_shutdown) {
+        osDelay(100);
+    }
+
+    return g_exitCode;
+}
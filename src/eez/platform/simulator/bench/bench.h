@@ -0,0 +1,71 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2015-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+namespace eez {
+/// Headless simulator benchmarks, every scenario writes its metrics into the JSON result.
+namespace bench {
+
+struct Scenario {
+    const char *name;
+    void (*run)();
+};
+
+extern Scenario g_scenarios[];
+extern const int NUM_SCENARIOS;
+
+/// Called once before the first scenario.
+void init();
+
+/// Pseudo random numbers from the seed given on the command line,
+/// so every run executes the same sequence of operations.
+uint32_t randomUint();
+float randomFloat(float min, float max);
+
+/// Executes SCPI command or query in the bench thread, returns false on error.
+bool scpi(const char *commandOrQueryFormat, ...);
+const char *getScpiResult();
+uint32_t getScpiResultLength();
+
+/// Polls the condition every millisecond, returns false on timeout.
+bool waitFor(bool (*condition)(), uint32_t timeoutMs);
+
+/// Waits until GUI thread draws the given number of frames.
+bool waitForFrames(uint32_t numFrames, uint32_t timeoutMs);
+
+void metric(const char *name, double value);
+
+// durations in us
+struct Stats {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+
+    void reset();
+    void add(uint32_t value);
+};
+
+/// Writes <prefix>_count, <prefix>_mean_us, <prefix>_min_us and <prefix>_max_us.
+void metric(const char *prefix, const Stats &stats);
+
+} // namespace bench
+} // namespace eez
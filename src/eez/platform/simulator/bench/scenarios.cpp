@@ -0,0 +1,553 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2015-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <eez/system.h>
+
+#include <eez/gui/gui.h>
+
+#include <eez/libs/sd_fat/sd_fat.h>
+
+#include <eez/modules/psu/psu.h>
+#include <eez/modules/psu/debug.h>
+#include <eez/modules/psu/dlog_record.h>
+#include <eez/modules/psu/dlog_view.h>
+#include <eez/modules/psu/list_program.h>
+#include <eez/modules/psu/scheduler.h>
+#include <eez/modules/psu/sd_card.h>
+#include <eez/modules/psu/trigger.h>
+#include <eez/modules/psu/gui/psu.h>
+
+#include <eez/platform/simulator/bench/bench.h>
+
+#include <cmsis_os.h>
+
+using namespace eez::psu;
+
+namespace eez {
+namespace bench {
+
+#define BENCH_DIR "/bench"
+
+static const uint32_t SCPI_MIX_NUM_COMMANDS = 2000;
+static const uint32_t GUI_NUM_FRAMES_PER_PAGE = 60;
+static const uint32_t DLOG_VIEW_NUM_ROWS = 200000;
+static const int DLOG_VIEW_NUM_STEPS = 40;
+static const int PROFILE_NUM_RECALLS = 50;
+static const int LIST_LENGTH = 10;
+static const float LIST_DWELL = 0.01f;
+static const int LIST_COUNT = 5;
+static const int CATALOG_NUM_FILES = 1000;
+static const int CATALOG_NUM_REPEATS = 10;
+static const float DLOG_ENDURANCE_PERIOD = 1.0f;
+static const float DLOG_ENDURANCE_TIME = 10 * 3600.0f;
+
+static uint32_t getElapsedTime(uint64_t startTime) {
+    return (uint32_t)(microsPrecise() - startTime);
+}
+
+static void schedulerMetrics(const char *taskName) {
+    for (int i = 0; i < scheduler::getNumTasks(); i++) {
+        const scheduler::Task &task = scheduler::getTask(i);
+        if (strcmp(task.name, taskName) == 0) {
+            char name[64];
+            snprintf(name, sizeof(name), "sched_%s_max_us", taskName);
+            metric(name, task.maxTime);
+            snprintf(name, sizeof(name), "sched_%s_deadline_misses", taskName);
+            metric(name, task.numDeadlineMisses);
+            snprintf(name, sizeof(name), "sched_%s_deferrals", taskName);
+            metric(name, task.numDeferrals);
+            break;
+        }
+    }
+
+    const scheduler::CycleStats &cycleStats = scheduler::getCycleStats();
+    metric("sched_cycle_max_us", cycleStats.maxTime);
+    metric("sched_cycle_overruns", cycleStats.numOverruns);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static bool isDlogIdle() {
+    return dlog_record::isIdle();
+}
+
+// U and I of the first numChannels channels at the minimal period
+static void dlog(int numChannels) {
+    for (int i = 0; i < numChannels; i++) {
+        scpi("SENS:DLOG:FUNC:VOLT ON,CH%d", i + 1);
+        scpi("SENS:DLOG:FUNC:CURR ON,CH%d", i + 1);
+    }
+    scpi("SENS:DLOG:PER %g", dlog_record::PERIOD_MIN);
+    scpi("SENS:DLOG:TIME %g", dlog_record::TIME_MIN);
+    scpi("TRIG:DLOG:SOUR IMM");
+
+    scpi("DIAG:SCH:CLE");
+
+    uint64_t startTime = microsPrecise();
+    if (!scpi("INIT:DLOG \"" BENCH_DIR "/dlog_ch%d.dlog\"", numChannels)) {
+        return;
+    }
+    osDelay(10);
+    bool finished = waitFor(isDlogIdle, (uint32_t)(10 * 1000 * dlog_record::TIME_MIN));
+    uint32_t duration = getElapsedTime(startTime);
+
+    if (!finished) {
+        scpi("ABOR:DLOG");
+    }
+
+    uint32_t expectedRows = (uint32_t)roundf(dlog_record::TIME_MIN / dlog_record::PERIOD_MIN);
+    metric("channels", numChannels);
+    metric("finished", finished ? 1 : 0);
+    metric("expected_rows", expectedRows);
+    metric("rows", dlog_record::g_recording.size);
+    metric("dropped_rows", dlog_record::g_recording.size < expectedRows ? expectedRows - dlog_record::g_recording.size : 0);
+    metric("file_length", dlog_record::g_fileLength);
+    metric("wall_time_ms", duration / 1000.0);
+    schedulerMetrics("dlog");
+}
+
+static void dlogOneChannel() {
+    dlog(1);
+}
+
+static void dlogAllChannels() {
+    dlog(CH_NUM);
+}
+
+// 10 hours of U and I of all channels, only with the virtual time
+static void dlogEndurance() {
+    if (!osKernelIsVirtualTime()) {
+        metric("skipped", 1);
+        return;
+    }
+
+    for (int i = 0; i < CH_NUM; i++) {
+        scpi("SENS:DLOG:FUNC:VOLT ON,CH%d", i + 1);
+        scpi("SENS:DLOG:FUNC:CURR ON,CH%d", i + 1);
+    }
+    scpi("SENS:DLOG:PER %g", DLOG_ENDURANCE_PERIOD);
+    scpi("SENS:DLOG:TIME %g", DLOG_ENDURANCE_TIME);
+    scpi("TRIG:DLOG:SOUR IMM");
+
+    uint64_t startTime = microsPrecise();
+    if (!scpi("INIT:DLOG \"" BENCH_DIR "/dlog_endurance.dlog\"")) {
+        return;
+    }
+    osDelay(10);
+    bool finished = waitFor(isDlogIdle, (uint32_t)(2 * 1000 * DLOG_ENDURANCE_TIME));
+    uint32_t duration = (uint32_t)((microsPrecise() - startTime) / 1000);
+
+    if (!finished) {
+        scpi("ABOR:DLOG");
+    }
+
+    uint32_t expectedRows = (uint32_t)roundf(DLOG_ENDURANCE_TIME / DLOG_ENDURANCE_PERIOD);
+    metric("finished", finished ? 1 : 0);
+    metric("expected_rows", expectedRows);
+    metric("rows", dlog_record::g_recording.size);
+    metric("file_length", dlog_record::g_fileLength);
+    metric("virtual_time_ms", duration);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void scpiMix() {
+    static const char *QUERIES[] = {
+        "*IDN?",
+        "SYST:ERR?",
+        "MEAS:VOLT? CH1",
+        "MEAS:CURR? CH1",
+        "VOLT?",
+        "CURR?",
+        "OUTP?",
+        "MEAS:POW? CH1"
+    };
+    static const int NUM_QUERIES = sizeof(QUERIES) / sizeof(const char *);
+
+    static uint32_t durations[SCPI_MIX_NUM_COMMANDS];
+
+    scpi("INST CH1");
+    scpi("OUTP 1");
+
+    Stats commands;
+    Stats queries;
+    commands.reset();
+    queries.reset();
+
+    for (uint32_t i = 0; i < SCPI_MIX_NUM_COMMANDS; i++) {
+        uint32_t r = randomUint() % (NUM_QUERIES + 2);
+
+        uint64_t startTime = microsPrecise();
+        if (r < (uint32_t)NUM_QUERIES) {
+            scpi(QUERIES[r]);
+        } else if (r == (uint32_t)NUM_QUERIES) {
+            scpi("VOLT %.2f", randomFloat(0, 10.0f));
+        } else {
+            scpi("CURR %.3f", randomFloat(0, 1.0f));
+        }
+        durations[i] = getElapsedTime(startTime);
+
+        if (r < (uint32_t)NUM_QUERIES) {
+            queries.add(durations[i]);
+        } else {
+            commands.add(durations[i]);
+        }
+    }
+
+    scpi("OUTP 0");
+
+    metric("set", commands);
+    metric("query", queries);
+
+    std::sort(durations, durations + SCPI_MIX_NUM_COMMANDS);
+    metric("p50_us", durations[SCPI_MIX_NUM_COMMANDS / 2]);
+    metric("p99_us", durations[SCPI_MIX_NUM_COMMANDS * 99 / 100]);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// every frame is drawn from scratch
+static void measureFrames(const char *prefix, uint32_t numFrames) {
+    Stats frames;
+    frames.reset();
+
+    for (uint32_t i = 0; i < numFrames; i++) {
+        gui::refreshScreen();
+        if (!waitForFrames(2, 1000)) {
+            break;
+        }
+        frames.add(gui::g_frameStats.lastTime);
+    }
+
+    metric(prefix, frames);
+}
+
+static void guiFrames() {
+    static const struct {
+        const char *name;
+        int pageId;
+    } PAGES[] = {
+        { "main", PAGE_ID_MAIN },
+        { "sys_settings", PAGE_ID_SYS_SETTINGS },
+        { "event_queue", PAGE_ID_EVENT_QUEUE },
+        { "file_manager", PAGE_ID_FILE_MANAGER },
+        { "dlog_view", PAGE_ID_DLOG_VIEW }
+    };
+
+    for (unsigned i = 0; i < sizeof(PAGES) / sizeof(PAGES[0]); i++) {
+        psu::gui::showPage(PAGES[i].pageId);
+        waitForFrames(5, 1000);
+        measureFrames(PAGES[i].name, GUI_NUM_FRAMES_PER_PAGE);
+    }
+
+    psu::gui::showPage(PAGE_ID_MAIN);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void putUint16(uint8_t *&p, uint16_t value) {
+    memcpy(p, &value, sizeof(value));
+    p += sizeof(value);
+}
+
+static void putUint32(uint8_t *&p, uint32_t value) {
+    memcpy(p, &value, sizeof(value));
+    p += sizeof(value);
+}
+
+static void putFloat(uint8_t *&p, float value) {
+    memcpy(p, &value, sizeof(value));
+    p += sizeof(value);
+}
+
+// version 1 file, U and I of CH1 and CH2 with the waveform and the noise from the seed
+static bool generateDlogFile(const char *filePath, uint32_t numRows) {
+    static const int NUM_CHANNELS = 2;
+    static const float PERIOD = dlog_record::PERIOD_MIN;
+
+    int err;
+    if (!sd_card::makeParentDir(filePath, &err)) {
+        return false;
+    }
+
+    File file;
+    if (!file.open(filePath, FILE_CREATE_ALWAYS | FILE_WRITE)) {
+        return false;
+    }
+
+    sd_card::BufferedFileWrite bufferedFile(file);
+
+    uint8_t header[dlog_view::DLOG_VERSION1_HEADER_SIZE];
+    uint8_t *p = header;
+    uint32_t columns = 0;
+    for (int i = 0; i < NUM_CHANNELS; i++) {
+        columns |= 3 << (4 * i);
+    }
+    putUint32(p, dlog_view::MAGIC1);
+    putUint32(p, dlog_view::MAGIC2);
+    putUint16(p, dlog_view::VERSION1);
+    putUint16(p, 0);
+    putUint32(p, columns);
+    putFloat(p, PERIOD);
+    putFloat(p, numRows * PERIOD);
+    putUint32(p, 0);
+
+    bool result = bufferedFile.write(header, sizeof(header));
+
+    for (uint32_t row = 0; row < numRows && result; row++) {
+        uint8_t values[NUM_CHANNELS * 2 * sizeof(float)];
+        p = values;
+        for (int i = 0; i < NUM_CHANNELS; i++) {
+            float phase = 2.0f * 3.14159265f * row / (2000.0f * (i + 1));
+            putFloat(p, 5.0f + 2.0f * sinf(phase) + randomFloat(-0.05f, 0.05f));
+            putFloat(p, 0.5f + 0.2f * cosf(phase) + randomFloat(-0.005f, 0.005f));
+        }
+        result = bufferedFile.write(values, sizeof(values));
+    }
+
+    result = result && bufferedFile.flush();
+    file.close();
+
+    return result;
+}
+
+static bool isDlogViewReady() {
+    dlog_view::State state = dlog_view::getState();
+    return state == dlog_view::STATE_READY || state == dlog_view::STATE_ERROR;
+}
+
+static void dlogViewZoomPan() {
+    static const char *FILE_PATH = BENCH_DIR "/view.dlog";
+
+    uint64_t startTime = microsPrecise();
+    if (!generateDlogFile(FILE_PATH, DLOG_VIEW_NUM_ROWS)) {
+        metric("generated", 0);
+        return;
+    }
+    metric("rows", DLOG_VIEW_NUM_ROWS);
+    metric("generate_ms", getElapsedTime(startTime) / 1000.0);
+
+    dlog_view::g_showLatest = false;
+
+    startTime = microsPrecise();
+    dlog_view::openFile(FILE_PATH);
+    psu::gui::showPage(PAGE_ID_DLOG_VIEW);
+    bool ready = waitFor(isDlogViewReady, 10000) && dlog_view::getState() == dlog_view::STATE_READY;
+    metric("open_ms", getElapsedTime(startTime) / 1000.0);
+    metric("opened", ready ? 1 : 0);
+    if (!ready) {
+        return;
+    }
+
+    dlog_view::Recording &recording = dlog_view::getRecording();
+
+    Stats zoom;
+    Stats pan;
+    Stats frames;
+    zoom.reset();
+    pan.reset();
+    frames.reset();
+
+    for (int i = 0; i < DLOG_VIEW_NUM_STEPS; i++) {
+        startTime = microsPrecise();
+        if (i % 2 == 0) {
+            // logarithmic distribution between the min and max zoom
+            float t = randomFloat(0, 1.0f);
+            dlog_view::changeXAxisDiv(recording, recording.xAxisDivMin * powf(recording.xAxisDivMax / recording.xAxisDivMin, t));
+        } else {
+            float maxOffset = dlog_view::getDuration(recording) - recording.xAxisDiv * dlog_view::NUM_HORZ_DIVISIONS;
+            dlog_view::changeXAxisOffset(recording, randomFloat(0, maxOffset > 0 ? maxOffset : 0));
+        }
+        gui::refreshScreen();
+        waitForFrames(2, 1000);
+        uint32_t duration = getElapsedTime(startTime);
+
+        (i % 2 == 0 ? zoom : pan).add(duration);
+        frames.add(gui::g_frameStats.lastTime);
+    }
+
+    metric("zoom", zoom);
+    metric("pan", pan);
+    metric("frame", frames);
+
+    psu::gui::showPage(PAGE_ID_MAIN);
+    waitForFrames(2, 1000);
+
+    int err;
+    sd_card::deleteFile(FILE_PATH, &err);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void profileRecall() {
+    scpi("INST CH1");
+    scpi("VOLT 5");
+    scpi("CURR 0.5");
+    scpi("*SAV 1");
+
+    Stats recall;
+    recall.reset();
+
+    for (int i = 0; i < PROFILE_NUM_RECALLS; i++) {
+        // change something, so the recall has to update the channel
+        scpi("VOLT %.2f", randomFloat(0, 10.0f));
+
+        uint64_t startTime = microsPrecise();
+        scpi("*RCL 1");
+        recall.add(getElapsedTime(startTime));
+    }
+
+    metric("recall", recall);
+#ifdef DEBUG
+    metric("recall_internal_us", psu::debug::g_profileRecallTime.get());
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static bool isListFinished() {
+    return !list::isActive() && trigger::isIdle();
+}
+
+static void listExecution() {
+    char voltages[128];
+    char *p = voltages;
+    for (int i = 0; i < LIST_LENGTH; i++) {
+        p += sprintf(p, "%s%.2f", i > 0 ? "," : "", randomFloat(1.0f, 10.0f));
+    }
+
+    scpi("INST CH1");
+    scpi("LIST:VOLT %s", voltages);
+    scpi("LIST:CURR 0.5");
+    scpi("LIST:DWEL %g", LIST_DWELL);
+    scpi("LIST:COUN %d", LIST_COUNT);
+    scpi("VOLT:MODE LIST");
+    scpi("CURR:MODE LIST");
+    scpi("TRIG:SOUR IMM");
+    scpi("OUTP 1");
+
+    scpi("DIAG:SCH:CLE");
+
+    uint64_t startTime = microsPrecise();
+    bool started = scpi("INIT");
+    osDelay(10);
+    bool finished = started && waitFor(isListFinished, 10000);
+    uint32_t duration = getElapsedTime(startTime);
+
+    if (!finished) {
+        scpi("ABOR");
+    }
+
+    scpi("OUTP 0");
+    scpi("VOLT:MODE FIX");
+    scpi("CURR:MODE FIX");
+
+    float expectedDuration = LIST_LENGTH * LIST_DWELL * LIST_COUNT;
+    metric("finished", finished ? 1 : 0);
+    metric("expected_ms", expectedDuration * 1000.0f);
+    metric("wall_time_ms", duration / 1000.0);
+    metric("overshoot_ms", duration / 1000.0 - expectedDuration * 1000.0);
+    schedulerMetrics("list");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void onCatalogFile(void *param, const char *name, FileType type, size_t size) {
+    ++*(uint32_t *)param;
+}
+
+static void fileCatalog() {
+    static const char *DIR_PATH = BENCH_DIR "/catalog";
+    static char fileNames[CATALOG_NUM_FILES][13];
+
+    int err;
+    sd_card::makeDir(DIR_PATH, &err);
+
+    char filePath[64];
+
+    uint64_t startTime = microsPrecise();
+    int numCreated = 0;
+    for (int i = 0; i < CATALOG_NUM_FILES; i++) {
+        // random names, so the files are not created in the sorted order
+        snprintf(fileNames[i], sizeof(fileNames[i]), "%08X.TXT", (unsigned)randomUint());
+        snprintf(filePath, sizeof(filePath), "%s/%s", DIR_PATH, fileNames[i]);
+        File file;
+        if (file.open(filePath, FILE_CREATE_ALWAYS | FILE_WRITE)) {
+            file.write(filePath, strlen(filePath));
+            file.close();
+            numCreated++;
+        }
+    }
+    metric("files", numCreated);
+    metric("create_ms", getElapsedTime(startTime) / 1000.0);
+
+    Stats catalog;
+    catalog.reset();
+    uint32_t numListed = 0;
+    for (int i = 0; i < CATALOG_NUM_REPEATS; i++) {
+        numListed = 0;
+        int numFiles;
+        startTime = microsPrecise();
+        sd_card::catalog(DIR_PATH, &numListed, onCatalogFile, &numFiles, &err);
+        catalog.add(getElapsedTime(startTime));
+    }
+    metric("listed", numListed);
+    metric("catalog", catalog);
+
+    startTime = microsPrecise();
+    scpi("MMEM:CAT? \"%s\"", DIR_PATH);
+    metric("scpi_catalog_us", getElapsedTime(startTime));
+    metric("scpi_catalog_length", getScpiResultLength());
+
+    startTime = microsPrecise();
+    for (int i = 0; i < CATALOG_NUM_FILES; i++) {
+        snprintf(filePath, sizeof(filePath), "%s/%s", DIR_PATH, fileNames[i]);
+        sd_card::deleteFile(filePath, &err);
+    }
+    sd_card::removeDir(DIR_PATH, &err);
+    metric("delete_ms", getElapsedTime(startTime) / 1000.0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void init() {
+    int err;
+    sd_card::makeDir(BENCH_DIR, &err);
+}
+
+Scenario g_scenarios[] = {
+    { "dlog_period_min_1ch", dlogOneChannel },
+    { "dlog_period_min_all_ch", dlogAllChannels },
+    { "dlog_endurance", dlogEndurance },
+    { "scpi_mix", scpiMix },
+    { "gui_frames", guiFrames },
+    { "dlog_view_zoom_pan", dlogViewZoomPan },
+    { "profile_recall", profileRecall },
+    { "list_execution", listExecution },
+    { "file_catalog", fileCatalog }
+};
+
+const int NUM_SCENARIOS = sizeof(g_scenarios) / sizeof(Scenario);
+
+} // namespace bench
+} // namespace eez
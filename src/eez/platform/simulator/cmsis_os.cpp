@@ -10,6 +10,11 @@
 #include <time.h>
 #endif
 
+#if !defined(__EMSCRIPTEN__)
+#include <condition_variable>
+#include <mutex>
+#endif
+
 #ifdef __EMSCRIPTEN__
 #define MAX_THREADS 100
 struct Thread {
@@ -21,12 +26,153 @@ static Thread g_threads[MAX_THREADS];
 Thread *g_currentThread;
 #endif
 
-osThreadId osThreadCreate(const osThreadDef_t *thread_def, void *argument) {
+////////////////////////////////////////////////////////////////////////////////
+// Virtual time
+//
+// Threads created with osThreadCreate and the thread which enabled the virtual time
+// are executed one at a time. The running thread gives up the CPU only in osDelay
+// (osMessageGet, osMessagePut and osMutexWait are waiting with osDelay), then the thread
+// with the earliest wake up time is resumed, threads with the same wake up time in the order
+// they called osDelay. The time is advanced to the wake up time of the resumed thread,
+// i.e. only when all the threads are waiting, so idle periods take no time at all and
+// the run doesn't depend on the host speed and load.
+
+#if !defined(__EMSCRIPTEN__)
+
+#define MAX_VIRTUAL_TIME_THREADS 32
+
+// Thread which reads the time this many times without calling osDelay is spinning
+// on the time, e.g. in the retry loop with the timeout, so the time is advanced by 1 ms.
+#define VIRTUAL_TIME_SPIN_READS 10000
+
+struct VirtualTimeThread {
+    const osThreadDef_t *threadDef;
+    void *argument;
+    std::condition_variable *cond;
+    bool running;
+    bool finished;
+    uint64_t wakeUpTime; // us
+    uint64_t order;
+    uint32_t numTimeReads;
+};
+
+static bool g_virtualTime;
+static std::mutex *g_virtualTimeMutex;
+static uint64_t g_virtualTimeNow; // us
+static uint64_t g_virtualTimeOrder;
+static VirtualTimeThread g_virtualTimeThreads[MAX_VIRTUAL_TIME_THREADS];
+static int g_numVirtualTimeThreads;
+static thread_local VirtualTimeThread *g_currentVirtualTimeThread;
+
+static VirtualTimeThread *addVirtualTimeThread(const osThreadDef_t *thread_def, void *argument) {
+    assert(g_numVirtualTimeThreads < MAX_VIRTUAL_TIME_THREADS);
+    VirtualTimeThread *thread = &g_virtualTimeThreads[g_numVirtualTimeThreads++];
+    thread->threadDef = thread_def;
+    thread->argument = argument;
+    thread->cond = new std::condition_variable();
+    thread->wakeUpTime = g_virtualTimeNow;
+    thread->order = ++g_virtualTimeOrder;
+    return thread;
+}
+
+// Must be called with the mutex locked, returns when the current thread is resumed.
+static void switchVirtualTimeThread(std::unique_lock<std::mutex> &lock, VirtualTimeThread *current) {
+    VirtualTimeThread *next = nullptr;
+    for (int i = 0; i < g_numVirtualTimeThreads; i++) {
+        VirtualTimeThread *thread = &g_virtualTimeThreads[i];
+        if (!thread->finished && (!next || thread->wakeUpTime < next->wakeUpTime ||
+            (thread->wakeUpTime == next->wakeUpTime && thread->order < next->order))) {
+            next = thread;
+        }
+    }
+
+    if (!next) {
+        return;
+    }
+
+    if (next->wakeUpTime > g_virtualTimeNow) {
+        g_virtualTimeNow = next->wakeUpTime;
+    }
+
+    current->running = false;
+    next->running = true;
+    next->numTimeReads = 0;
+    next->cond->notify_one();
+
+    while (!current->running && !current->finished) {
+        current->cond->wait(lock);
+    }
+}
+
+#ifdef EEZ_PLATFORM_SIMULATOR_WIN32
+static uint32_t __stdcall virtualTimeThreadFunc(void *lpParam) {
+#else
+static void *virtualTimeThreadFunc(void *lpParam) {
+#endif
+    VirtualTimeThread *thread = (VirtualTimeThread *)lpParam;
+    g_currentVirtualTimeThread = thread;
+
+    {
+        std::unique_lock<std::mutex> lock(*g_virtualTimeMutex);
+        while (!thread->running) {
+            thread->cond->wait(lock);
+        }
+    }
+
+    thread->threadDef->pthread(thread->argument);
+
+    std::unique_lock<std::mutex> lock(*g_virtualTimeMutex);
+    thread->finished = true;
+    switchVirtualTimeThread(lock, thread);
+
+    return 0;
+}
+
+void osKernelEnableVirtualTime() {
+    if (g_virtualTime) {
+        return;
+    }
+
+    g_virtualTimeMutex = new std::mutex();
+    g_currentVirtualTimeThread = addVirtualTimeThread(nullptr, nullptr);
+    g_currentVirtualTimeThread->running = true;
+    g_virtualTime = true;
+}
+
+bool osKernelIsVirtualTime() {
+    return g_virtualTime;
+}
+
+uint64_t osKernelVirtualTime() {
+    std::lock_guard<std::mutex> lock(*g_virtualTimeMutex);
+    VirtualTimeThread *current = g_currentVirtualTimeThread;
+    if (current && ++current->numTimeReads == VIRTUAL_TIME_SPIN_READS) {
+        current->numTimeReads = 0;
+        g_virtualTimeNow += 1000;
+    }
+    return g_virtualTimeNow;
+}
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+#if !defined(__EMSCRIPTEN__)
+static osThreadId createThread(THREAD_START_ROUTINE func, uint32_t stacksize, void *argument) {
 #ifdef EEZ_PLATFORM_SIMULATOR_WIN32
     DWORD threadId;
-    CreateThread(NULL, thread_def->stacksize, (LPTHREAD_START_ROUTINE)thread_def->pthread, argument, 0, &threadId);
+    CreateThread(NULL, stacksize, (LPTHREAD_START_ROUTINE)func, argument, 0, &threadId);
     return threadId;
-#elif defined(__EMSCRIPTEN__)
+#else
+    pthread_t thread;
+    pthread_create(&thread, 0, func, argument);
+    return thread;
+#endif
+}
+#endif
+
+osThreadId osThreadCreate(const osThreadDef_t *thread_def, void *argument) {
+#if defined(__EMSCRIPTEN__)
     for (int i = 0; i < MAX_THREADS; ++i) {
         if (!g_threads[i].thread_def) {
             g_threads[i].thread_def = thread_def;
@@ -37,12 +183,28 @@ osThreadId osThreadCreate(const osThreadDef_t *thread_def, void *argument) {
     assert(false);
     return nullptr;
 #else
-    pthread_t thread;
-    pthread_create(&thread, 0, thread_def->pthread, 0);
-    return thread;
+    if (g_virtualTime) {
+        std::lock_guard<std::mutex> lock(*g_virtualTimeMutex);
+        return createThread(virtualTimeThreadFunc, thread_def->stacksize, addVirtualTimeThread(thread_def, argument));
+    }
+#ifdef EEZ_PLATFORM_SIMULATOR_WIN32
+    return createThread(thread_def->pthread, thread_def->stacksize, argument);
+#else
+    return createThread(thread_def->pthread, thread_def->stacksize, 0);
+#endif
 #endif    
 }
 
+#if !defined(__EMSCRIPTEN__)
+osThreadId osThreadCreateExternal(const osThreadDef_t *thread_def, void *argument) {
+#ifdef EEZ_PLATFORM_SIMULATOR_WIN32
+    return createThread(thread_def->pthread, thread_def->stacksize, argument);
+#else
+    return createThread(thread_def->pthread, thread_def->stacksize, 0);
+#endif
+}
+#endif
+
 osThreadId osThreadGetId() {
 #ifdef EEZ_PLATFORM_SIMULATOR_WIN32
     return GetCurrentThreadId();
@@ -69,6 +231,31 @@ osStatus osKernelStart(void) {
 }
 
 osStatus osDelay(uint32_t millisec) {
+#if !defined(__EMSCRIPTEN__)
+    VirtualTimeThread *current = g_currentVirtualTimeThread;
+    if (current) {
+        std::unique_lock<std::mutex> lock(*g_virtualTimeMutex);
+        current->wakeUpTime = g_virtualTimeNow + millisec * 1000ULL;
+        current->order = ++g_virtualTimeOrder;
+        if (millisec == 0) {
+            // thread is spinning until some other thread does something, so if no other
+            // thread is ready now, time must pass until the first one is
+            uint64_t wakeUpTime = UINT64_MAX;
+            for (int i = 0; i < g_numVirtualTimeThreads; i++) {
+                VirtualTimeThread *thread = &g_virtualTimeThreads[i];
+                if (thread != current && !thread->finished && thread->wakeUpTime < wakeUpTime) {
+                    wakeUpTime = thread->wakeUpTime;
+                }
+            }
+            if (wakeUpTime != UINT64_MAX && wakeUpTime > current->wakeUpTime) {
+                current->wakeUpTime = wakeUpTime;
+            }
+        }
+        switchVirtualTimeThread(lock, current);
+        return osOK;
+    }
+#endif
+
 #ifdef EEZ_PLATFORM_SIMULATOR_WIN32
     Sleep(millisec);
     return osOK;
@@ -88,6 +275,12 @@ uint32_t osKernelSysTickFrequency = 1000000;
 #endif
 
 uint32_t osKernelSysTick() {
+#if !defined(__EMSCRIPTEN__)
+    if (g_virtualTime) {
+        return uint32_t((osKernelVirtualTime() / 1000) % 4294967296);
+    }
+#endif
+
 #ifdef EEZ_PLATFORM_SIMULATOR_WIN32
     static bool isFirstTime = true;
     static LARGE_INTEGER frequency;
@@ -67,6 +67,19 @@ osThreadId osThreadGetId();
 
 osStatus osKernelStart(void);
 
+#if !defined(__EMSCRIPTEN__)
+/// Switches the kernel to the virtual time, see cmsis_os.cpp. Must be called from the main
+/// thread before any thread is created.
+void osKernelEnableVirtualTime();
+bool osKernelIsVirtualTime();
+/// Virtual time in us.
+uint64_t osKernelVirtualTime();
+
+/// Creates the thread which is never scheduled by the virtual time, it runs concurrently
+/// like the interrupt handler. Use it for the thread blocking outside of the kernel, e.g. on stdin.
+osThreadId osThreadCreateExternal(const osThreadDef_t *thread_def, void *argument);
+#endif
+
 osStatus osDelay(uint32_t millisec);
 
 uint32_t osKernelSysTick(void);
@@ -18,7 +18,9 @@
 
 #include <eez/platform/simulator/events.h>
 
+#if !defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
 #include <SDL.h>
+#endif
 
 #include <eez/firmware.h>
 #include <eez/system.h>
@@ -41,6 +43,7 @@ void readEvents() {
     int yMouseWheel = 0;
     bool mouseButton2IsUp = false;
 
+#if !defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
     SDL_Event event;
     while (SDL_PollEvent(&event)) {
         if (event.type == SDL_MOUSEMOTION || event.type == SDL_MOUSEBUTTONDOWN || event.type == SDL_MOUSEBUTTONUP) {
@@ -67,6 +70,7 @@ void readEvents() {
             eez::shutdown();
         }
     }
+#endif
 
     // for web simulator
     if (yMouseWheel >= 100 || yMouseWheel <= -100) {
@@ -35,6 +35,9 @@
     SCPI_COMMAND("DIAGnostic[:INFOrmation]:ADC?", scpi_cmd_diagnosticInformationAdcQ) \
     SCPI_COMMAND("DIAGnostic[:INFOrmation]:CALibration?", scpi_cmd_diagnosticInformationCalibrationQ) \
     SCPI_COMMAND("DIAGnostic[:INFOrmation]:PROTection?", scpi_cmd_diagnosticInformationProtectionQ) \
+    SCPI_COMMAND("DIAGnostic[:INFOrmation]:PROTection:LATency?", scpi_cmd_diagnosticInformationProtectionLatencyQ) \
+    SCPI_COMMAND("DIAGnostic[:INFOrmation]:SCHeduler?", scpi_cmd_diagnosticInformationSchedulerQ) \
+    SCPI_COMMAND("DIAGnostic[:INFOrmation]:SCHeduler:CLEar", scpi_cmd_diagnosticInformationSchedulerClear) \
     SCPI_COMMAND("DIAGnostic[:INFOrmation]:TEST?", scpi_cmd_diagnosticInformationTestQ) \
     SCPI_COMMAND("DIAGnostic[:INFOrmation]:REGS?", scpi_cmd_diagnosticInformationRegsQ) \
     SCPI_COMMAND("DISPlay:BRIGhtness", scpi_cmd_displayBrightness) \
@@ -102,6 +105,7 @@
     SCPI_COMMAND("MMEMory:DOWNload:DATA", scpi_cmd_mmemoryDownloadData) \
     SCPI_COMMAND("MMEMory:DOWNload:FNAMe", scpi_cmd_mmemoryDownloadFname) \
     SCPI_COMMAND("MMEMory:DOWNload:SIZE", scpi_cmd_mmemoryDownloadSize) \
+    SCPI_COMMAND("MMEMory:DOWNload:SYNC", scpi_cmd_mmemoryDownloadSync) \
     SCPI_COMMAND("MMEMory:INFOrmation?", scpi_cmd_mmemoryInformationQ) \
     SCPI_COMMAND("MMEMory:LOAD:LIST#", scpi_cmd_mmemoryLoadList) \
     SCPI_COMMAND("MMEMory:LOAD:PROFile", scpi_cmd_mmemoryLoadProfile) \
@@ -167,6 +171,8 @@
     SCPI_COMMAND("SENSe:DLOG:TRACe[:DATA]", scpi_cmd_senseDlogTraceData) \
     SCPI_COMMAND("SENSe:DLOG:TRACe:REMark", scpi_cmd_senseDlogTraceRemark) \
     SCPI_COMMAND("SENSe:DLOG:TRACe:REMark?", scpi_cmd_senseDlogTraceRemarkQ) \
+    SCPI_COMMAND("SENSe:MONitor:FILTer", scpi_cmd_senseMonitorFilter) \
+    SCPI_COMMAND("SENSe:MONitor:FILTer?", scpi_cmd_senseMonitorFilterQ) \
     SCPI_COMMAND("[SOURce#]:CURRent:LIMit[:POSitive][:IMMediate][:AMPLitude]", scpi_cmd_sourceCurrentLimitPositiveImmediateAmplitude) \
     SCPI_COMMAND("[SOURce#]:CURRent:LIMit[:POSitive][:IMMediate][:AMPLitude]?", scpi_cmd_sourceCurrentLimitPositiveImmediateAmplitudeQ) \
     SCPI_COMMAND("[SOURce#]:CURRent:MODE", scpi_cmd_sourceCurrentMode) \
@@ -361,13 +367,32 @@
     SCPI_COMMAND("TRIGger[:SEQuence][:IMMediate]", scpi_cmd_triggerSequenceImmediate) \
     SCPI_COMMAND("APPLy", scpi_cmd_apply) \
     SCPI_COMMAND("APPLy?", scpi_cmd_applyQ) \
+    SCPI_COMMAND("APPLy:COMMit", scpi_cmd_applyCommit) \
+    SCPI_COMMAND("APPLy:STAGe", scpi_cmd_applyStage) \
+    SCPI_COMMAND("APPLy:STAGe:CLEar", scpi_cmd_applyStageClear) \
     SCPI_COMMAND("DEBUg?", scpi_cmd_debugQ) \
     SCPI_COMMAND("SIMUlator:EXIT", scpi_cmd_simulatorExit) \
     SCPI_COMMAND("SIMUlator:GUI", scpi_cmd_simulatorGui) \
     SCPI_COMMAND("SIMUlator:LOAD", scpi_cmd_simulatorLoad) \
+    SCPI_COMMAND("SIMUlator:LOAD:BATTery", scpi_cmd_simulatorLoadBattery) \
+    SCPI_COMMAND("SIMUlator:LOAD:BATTery:SOC", scpi_cmd_simulatorLoadBatterySoc) \
+    SCPI_COMMAND("SIMUlator:LOAD:BATTery:SOC?", scpi_cmd_simulatorLoadBatterySocQ) \
+    SCPI_COMMAND("SIMUlator:LOAD:CAPacitance", scpi_cmd_simulatorLoadCapacitance) \
+    SCPI_COMMAND("SIMUlator:LOAD:CAPacitance?", scpi_cmd_simulatorLoadCapacitanceQ) \
+    SCPI_COMMAND("SIMUlator:LOAD:CURRent", scpi_cmd_simulatorLoadCurrent) \
+    SCPI_COMMAND("SIMUlator:LOAD:CURRent?", scpi_cmd_simulatorLoadCurrentQ) \
+    SCPI_COMMAND("SIMUlator:LOAD:INDuctance", scpi_cmd_simulatorLoadInductance) \
+    SCPI_COMMAND("SIMUlator:LOAD:INDuctance?", scpi_cmd_simulatorLoadInductanceQ) \
+    SCPI_COMMAND("SIMUlator:LOAD:POWer", scpi_cmd_simulatorLoadPower) \
+    SCPI_COMMAND("SIMUlator:LOAD:POWer?", scpi_cmd_simulatorLoadPowerQ) \
+    SCPI_COMMAND("SIMUlator:LOAD:PROFile", scpi_cmd_simulatorLoadProfile) \
     SCPI_COMMAND("SIMUlator:LOAD:STATe", scpi_cmd_simulatorLoadState) \
     SCPI_COMMAND("SIMUlator:LOAD:STATe?", scpi_cmd_simulatorLoadStateQ) \
+    SCPI_COMMAND("SIMUlator:LOAD:TYPE", scpi_cmd_simulatorLoadType) \
+    SCPI_COMMAND("SIMUlator:LOAD:TYPE?", scpi_cmd_simulatorLoadTypeQ) \
     SCPI_COMMAND("SIMUlator:LOAD?", scpi_cmd_simulatorLoadQ) \
+    SCPI_COMMAND("SIMUlator:NOISe", scpi_cmd_simulatorNoise) \
+    SCPI_COMMAND("SIMUlator:NOISe?", scpi_cmd_simulatorNoiseQ) \
     SCPI_COMMAND("SIMUlator:PIN1", scpi_cmd_simulatorPin1) \
     SCPI_COMMAND("SIMUlator:PIN1?", scpi_cmd_simulatorPin1Q) \
     SCPI_COMMAND("SIMUlator:PIN2", scpi_cmd_simulatorPin2) \
@@ -377,6 +402,8 @@
     SCPI_COMMAND("SIMUlator:QUIT", scpi_cmd_simulatorQuit) \
     SCPI_COMMAND("SIMUlator:RPOL", scpi_cmd_simulatorRpol) \
     SCPI_COMMAND("SIMUlator:RPOL?", scpi_cmd_simulatorRpolQ) \
+    SCPI_COMMAND("SIMUlator:SLEW", scpi_cmd_simulatorSlew) \
+    SCPI_COMMAND("SIMUlator:SLEW?", scpi_cmd_simulatorSlewQ) \
     SCPI_COMMAND("SIMUlator:TEMPerature", scpi_cmd_simulatorTemperature) \
     SCPI_COMMAND("SIMUlator:TEMPerature?", scpi_cmd_simulatorTemperatureQ) \
     SCPI_COMMAND("SIMUlator:VOLTage:PROGram:EXTernal", scpi_cmd_simulatorVoltageProgramExternal) \
@@ -397,6 +424,10 @@
     SCPI_COMMAND("DEBUg:DCM220?", scpi_cmd_debugDcm220Q) \
     SCPI_COMMAND("DEBUg:DOWNload:FIRMware", scpi_cmd_debugDownloadFirmware) \
     SCPI_COMMAND("DEBUg:EVENt", scpi_cmd_debugEvent) \
+    SCPI_COMMAND("DEBUg:TRACe[:STATe]", scpi_cmd_debugTrace) \
+    SCPI_COMMAND("DEBUg:TRACe[:STATe]?", scpi_cmd_debugTraceQ) \
+    SCPI_COMMAND("DEBUg:TRACe:CLEar", scpi_cmd_debugTraceClear) \
+    SCPI_COMMAND("DEBUg:TRACe:DUMP", scpi_cmd_debugTraceDump) \
     SCPI_COMMAND("SYSTem:DATE:CLEar", scpi_cmd_systemDateClear) \
     SCPI_COMMAND("SYSTem:TIME:CLEar", scpi_cmd_systemTimeClear) \
     SCPI_COMMAND("SYSTem:CPU:SNO?", scpi_cmd_systemCpuSnoQ)
@@ -17,10 +17,12 @@
 */
 
 #include <stdio.h> // sprintf
+#include <string.h>
 
 #include <eez/system.h>
 #include <eez/sound.h>
 #include <eez/mp.h>
+#include <eez/trace.h>
 
 #include <eez/scpi/scpi.h>
 
@@ -36,6 +38,7 @@
 #include <eez/modules/psu/event_queue.h>
 #include <eez/modules/psu/profile.h>
 #include <eez/modules/psu/sd_card.h>
+#include <eez/modules/psu/sd_worker.h>
 #include <eez/modules/psu/dlog_record.h>
 #include <eez/modules/psu/dlog_view.h>
 #include <eez/modules/psu/datetime.h>
@@ -88,8 +91,110 @@ static bool g_isThreadAlive;
 
 bool g_screenshotGenerating;
 
+osMutexId(g_screenshotMutexId);
+osMutexDef(g_screenshotMutex);
+
+static File *g_screenshotFile;
+static uint32_t g_screenshotStartTime;
+static bool g_screenshotFirstByteWritten;
+
+static bool writeScreenshotData(const uint8_t *data, size_t size) {
+    if (!g_screenshotFirstByteWritten) {
+        g_screenshotFirstByteWritten = true;
+#ifdef DEBUG
+        psu::debug::g_screenshotTimeToFirstByte.set(micros() - g_screenshotStartTime);
+#endif
+    }
+    sd_worker::writeDlogIfDue();
+    return g_screenshotFile->write(data, size) == size;
+}
+
+void lockScreenshot() {
+    osMutexWait(g_screenshotMutexId, osWaitForever);
+}
+
+void unlockScreenshot() {
+    osMutexRelease(g_screenshotMutexId);
+}
+
+void saveScreenshot() {
+    if (!sd_card::isMounted(nullptr)) {
+        g_screenshotGenerating = false;
+        return;
+    }
+
+    sound::playShutter();
+
+    lockScreenshot();
+
+    g_screenshotStartTime = micros();
+
+    const uint8_t *screenshotPixels = mcu::display::takeScreenshot();
+
+    char filePath[MAX_PATH_LENGTH + 1];
+    uint8_t year, month, day, hour, minute, second;
+    datetime::getDateTime(year, month, day, hour, minute, second);
+    if (persist_conf::devConf.dateTimeFormat == datetime::FORMAT_DMY_24) {
+        sprintf(filePath, "%s/%02d_%02d_%02d-%02d_%02d_%02d.jpg",
+            SCREENSHOTS_DIR,
+            (int)day, (int)month, (int)year,
+            (int)hour, (int)minute, (int)second);
+    } else if (persist_conf::devConf.dateTimeFormat == datetime::FORMAT_MDY_24) {
+        sprintf(filePath, "%s/%02d_%02d_%02d-%02d_%02d_%02d.jpg",
+            SCREENSHOTS_DIR,
+            (int)month, (int)day, (int)year,
+            (int)hour, (int)minute, (int)second);
+    } else if (persist_conf::devConf.dateTimeFormat == datetime::FORMAT_DMY_12) {
+        bool am;
+        datetime::convertTime24to12(hour, am);
+        sprintf(filePath, "%s/%02d_%02d_%02d-%02d_%02d_%02d_%s.jpg",
+            SCREENSHOTS_DIR,
+            (int)day, (int)month, (int)year,
+            (int)hour, (int)minute, (int)second, am ? "AM" : "PM");
+    } else if (persist_conf::devConf.dateTimeFormat == datetime::FORMAT_MDY_12) {
+        bool am;
+        datetime::convertTime24to12(hour, am);
+        sprintf(filePath, "%s/%02d_%02d_%02d-%02d_%02d_%02d_%s.jpg",
+            SCREENSHOTS_DIR,
+            (int)month, (int)day, (int)year,
+            (int)hour, (int)minute, (int)second, am ? "AM" : "PM");
+    }
+
+    uint32_t timeout = millis() + CONF_SCREENSHOT_TIMEOUT_MS;
+    while (millis() < timeout) {
+        File file;
+        if (file.open(filePath, FILE_CREATE_ALWAYS | FILE_WRITE)) {
+            // JPEG is written to the file while it is encoded
+            g_screenshotFile = &file;
+            g_screenshotFirstByteWritten = false;
+            if (jpegEncodeStream(screenshotPixels, writeScreenshotData)) {
+                if (file.close()) {
+                    // success!
+#ifdef DEBUG
+                    psu::debug::g_screenshotDuration.set(micros() - g_screenshotStartTime);
+#endif
+                    unlockScreenshot();
+                    event_queue::pushEvent(event_queue::EVENT_INFO_SCREENSHOT_SAVED);
+                    onSdCardFileChangeHook(filePath);
+                    g_screenshotGenerating = false;
+                    return;
+                }
+            }
+        }
+
+        sd_card::reinitialize();
+    }
+
+    unlockScreenshot();
+
+    // timeout
+    event_queue::pushEvent(SCPI_ERROR_MASS_STORAGE_ERROR);
+    g_screenshotGenerating = false;
+}
+
 void initMessageQueue() {
     g_scpiMessageQueueId = osMessageCreate(osMessageQ(g_scpiMessageQueue), NULL);
+    g_screenshotMutexId = osMutexCreate(osMutex(g_screenshotMutex));
 }
 
 void startThread() {
@@ -101,6 +206,8 @@ void startThread() {
 void oneIter();
 
 void mainLoop(const void *) {
+    TRACE_REGISTER_THREAD("SCPI");
+
 #ifdef __EMSCRIPTEN__
     if (g_isThreadAlive) {
         oneIter();
@@ -119,6 +226,7 @@ void mainLoop(const void *) {
 void oneIter() {
     osEvent event = osMessageGet(g_scpiMessageQueueId, 25);
     if (event.status == osEventMessage) {
+        TRACE_SCOPE("scpi::dispatch");
     	uint32_t message = event.value.v;
     	uint32_t target = SCPI_QUEUE_MESSAGE_TARGET(message);
     	uint32_t type = SCPI_QUEUE_MESSAGE_TYPE(message);
@@ -149,92 +257,10 @@ void oneIter() {
 #endif
             else if (type == SCPI_QUEUE_MESSAGE_TYPE_DLOG_STATE_TRANSITION) {
                 eez::psu::dlog_record::stateTransition(param);
-            } else if (type == SCPI_QUEUE_MESSAGE_DLOG_SHOW_FILE) {
-                eez::psu::dlog_view::openFile(nullptr);
-            } else if (type == SCPI_QUEUE_MESSAGE_DLOG_LOAD_BLOCK) {
-                eez::psu::dlog_view::loadBlock();
             } else if (type == SCPI_QUEUE_MESSAGE_ABORT_DOWNLOADING) {
                 abortDownloading();
-            } else if (type == SCPI_QUEUE_MESSAGE_SCREENSHOT) {
-                if (!sd_card::isMounted(nullptr)) {
-                    g_screenshotGenerating = false;
-                    return;
-                }
-
-                sound::playShutter();
-
-                const uint8_t *screenshotPixels = mcu::display::takeScreenshot();
-
-                unsigned char* imageData;
-                size_t imageDataSize;
-
-                if (jpegEncode(screenshotPixels, &imageData, &imageDataSize)) {
-                    event_queue::pushEvent(SCPI_ERROR_OUT_OF_MEMORY_FOR_REQ_OP);
-                    g_screenshotGenerating = false;
-                    return;
-                }
-
-                char filePath[MAX_PATH_LENGTH + 1];
-                uint8_t year, month, day, hour, minute, second;
-                datetime::getDateTime(year, month, day, hour, minute, second);
-                if (persist_conf::devConf.dateTimeFormat == datetime::FORMAT_DMY_24) {
-                    sprintf(filePath, "%s/%02d_%02d_%02d-%02d_%02d_%02d.jpg",
-                        SCREENSHOTS_DIR,
-                        (int)day, (int)month, (int)year,
-                        (int)hour, (int)minute, (int)second);
-                } else if (persist_conf::devConf.dateTimeFormat == datetime::FORMAT_MDY_24) {
-                    sprintf(filePath, "%s/%02d_%02d_%02d-%02d_%02d_%02d.jpg",
-                        SCREENSHOTS_DIR,
-                        (int)month, (int)day, (int)year,
-                        (int)hour, (int)minute, (int)second);
-                } else if (persist_conf::devConf.dateTimeFormat == datetime::FORMAT_DMY_12) {
-                    bool am;
-                    datetime::convertTime24to12(hour, am);
-                    sprintf(filePath, "%s/%02d_%02d_%02d-%02d_%02d_%02d_%s.jpg",
-                        SCREENSHOTS_DIR,
-                        (int)day, (int)month, (int)year,
-                        (int)hour, (int)minute, (int)second, am ? "AM" : "PM");
-                } else if (persist_conf::devConf.dateTimeFormat == datetime::FORMAT_MDY_12) {
-                    bool am;
-                    datetime::convertTime24to12(hour, am);
-                    sprintf(filePath, "%s/%02d_%02d_%02d-%02d_%02d_%02d_%s.jpg",
-                        SCREENSHOTS_DIR,
-                        (int)month, (int)day, (int)year,
-                        (int)hour, (int)minute, (int)second, am ? "AM" : "PM");
-                }
-
-                uint32_t timeout = millis() + CONF_SCREENSHOT_TIMEOUT_MS;
-                while (millis() < timeout) {
-                    File file;
-                    if (file.open(filePath, FILE_CREATE_ALWAYS | FILE_WRITE)) {
-                        size_t written = file.write(imageData, imageDataSize);
-                        if (written == imageDataSize) {
-                            if (file.close()) {
-                                // success!
-                                event_queue::pushEvent(event_queue::EVENT_INFO_SCREENSHOT_SAVED);
-                                onSdCardFileChangeHook(filePath);
-                                g_screenshotGenerating = false;
-                                return;
-                            }
-                        }
-                    }
-
-                    sd_card::reinitialize();
-                }
-
-                // timeout
-                event_queue::pushEvent(SCPI_ERROR_MASS_STORAGE_ERROR);
-                g_screenshotGenerating = false;
-            } else if (type == SCPI_QUEUE_MESSAGE_TYPE_FILE_MANAGER_LOAD_DIRECTORY) {
-                file_manager::doLoadDirectory();
             } else if (type == SCPI_QUEUE_MESSAGE_TYPE_FILE_MANAGER_UPLOAD_FILE) {
                 file_manager::uploadFile();
-            } else if (type == SCPI_QUEUE_MESSAGE_TYPE_FILE_MANAGER_OPEN_IMAGE_FILE) {
-                file_manager::openImageFile();
-            } else if (type == SCPI_QUEUE_MESSAGE_TYPE_FILE_MANAGER_DELETE_FILE) {
-                file_manager::deleteFile();
-            } else if (type == SCPI_QUEUE_MESSAGE_TYPE_FILE_MANAGER_RENAME_FILE) {
-                file_manager::doRenameFile();
             } else if (type == SCPI_QUEUE_MESSAGE_DLOG_UPLOAD_FILE) {
                 dlog_view::uploadFile();
             } else if (type == SCPI_QUEUE_MESSAGE_FLASH_SLAVE_UPLOAD_HEX_FILE) {
@@ -262,6 +288,8 @@ void oneIter() {
                 psu::gui::UserProfilesPage::doDeleteProfile();
             } else if (type == SCPI_QUEUE_MESSAGE_TYPE_USER_PROFILES_PAGE_EDIT_REMARK) {
                 psu::gui::UserProfilesPage::doEditRemark();
+            } else if (type == SCPI_QUEUE_MESSAGE_TYPE_VERIFY_PROFILE_INDEX) {
+                profile::verifyIndex();
             } else if (type == SCPI_QUEUE_MESSAGE_TYPE_SOUND_TICK) {
                 sound::tick();
             }
@@ -297,8 +325,6 @@ void oneIter() {
 
         sd_card::tick();
 
-        eez::psu::dlog_record::fileWrite();
-
 #ifdef DEBUG
         psu::debug::tick(tickCount);
 #endif
@@ -55,15 +55,8 @@ enum {
     SCPI_QUEUE_MESSAGE_TYPE_SAVE_LIST = 1,
     SCPI_QUEUE_MESSAGE_TYPE_SD_DETECT_IRQ,
     SCPI_QUEUE_MESSAGE_TYPE_DLOG_STATE_TRANSITION,
-    SCPI_QUEUE_MESSAGE_DLOG_SHOW_FILE,
-    SCPI_QUEUE_MESSAGE_DLOG_LOAD_BLOCK,
     SCPI_QUEUE_MESSAGE_ABORT_DOWNLOADING,
-    SCPI_QUEUE_MESSAGE_SCREENSHOT,
-    SCPI_QUEUE_MESSAGE_TYPE_FILE_MANAGER_LOAD_DIRECTORY,
     SCPI_QUEUE_MESSAGE_TYPE_FILE_MANAGER_UPLOAD_FILE,
-    SCPI_QUEUE_MESSAGE_TYPE_FILE_MANAGER_OPEN_IMAGE_FILE,
-    SCPI_QUEUE_MESSAGE_TYPE_FILE_MANAGER_DELETE_FILE,
-    SCPI_QUEUE_MESSAGE_TYPE_FILE_MANAGER_RENAME_FILE,
     SCPI_QUEUE_MESSAGE_DLOG_UPLOAD_FILE,
     SCPI_QUEUE_MESSAGE_FLASH_SLAVE_UPLOAD_HEX_FILE,
     SCPI_QUEUE_MESSAGE_TYPE_SHUTDOWN,
@@ -77,6 +70,7 @@ enum {
     SCPI_QUEUE_MESSAGE_TYPE_USER_PROFILES_PAGE_EXPORT,
     SCPI_QUEUE_MESSAGE_TYPE_USER_PROFILES_PAGE_DELETE,
     SCPI_QUEUE_MESSAGE_TYPE_USER_PROFILES_PAGE_EDIT_REMARK,
+    SCPI_QUEUE_MESSAGE_TYPE_VERIFY_PROFILE_INDEX,
     SCPI_QUEUE_MESSAGE_TYPE_EVENT_QUEUE_REFRESH,
     SCPI_QUEUE_MESSAGE_TYPE_SOUND_TICK
 };
@@ -87,5 +81,13 @@ bool isThreadAlive();
 
 extern bool g_screenshotGenerating;
 
+// saves screenshot to the SCREENSHOTS_DIR, executed by SD worker
+void saveScreenshot();
+
+// Screenshot and JPEG output buffers are shared by saveScreenshot and DISP:DATA?,
+// so screenshot is locked from takeScreenshot until the image is encoded.
+void lockScreenshot();
+void unlockScreenshot();
+
 }
 }
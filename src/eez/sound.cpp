@@ -25,20 +25,24 @@
 #include <cmath>
 #include <queue>
 #include <stdio.h>
+#if !defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
 #include <SDL.h>
 #include <SDL_audio.h>
+#endif
 
 #elif defined(EEZ_PLATFORM_STM32)
 
 #include <math.h>
 #include <dac.h>
 #include <tim.h>
+
+extern "C" DMA_HandleTypeDef hdma_dac1; // dac.c
 #endif
 
 #include <eez/sound.h>
+#include <eez/debug.h>
 #include <eez/firmware.h>
 #include <eez/system.h>
-#include <eez/memory.h>
 #include <eez/modules/psu/psu.h>
 #include <eez/modules/psu/persist_conf.h>
 #include <eez/scpi/scpi.h>
@@ -142,6 +146,7 @@ enum {
 	CLICK_TUNE,
 	SHUTTER_TUNE,
 	BEEP_TUNE,
+	NOTES_TUNE,
 	POWER_UP_TUNE,
 	POWER_DOWN_TUNE
 };
@@ -1437,15 +1442,19 @@ uint8_t g_shutterSamples[16377] = {
 static const size_t g_shutterSamplesSize = sizeof(g_shutterSamples) / sizeof(uint8_t);
 #endif
 
-struct Tune {
-	float *tune;
-	uint32_t sampleRate;
-	float durationBetweenNotesFactor;
 #if defined(EEZ_PLATFORM_SIMULATOR)
-	int16_t *pSamples;
+typedef int16_t Sample;
+#define SILENCE 0
 #elif defined(EEZ_PLATFORM_STM32)
-	uint8_t *pSamples;
+typedef uint8_t Sample;
+#define SILENCE 0
 #endif
+
+struct Tune {
+	const float *tune; // pairs of note frequency and duration, NAN at the end
+	uint32_t sampleRate;
+	float durationBetweenNotesFactor;
+	const Sample *pSamples; // recorded tune, instead of the notes
 	unsigned int numSamples;
 };
 
@@ -1457,10 +1466,15 @@ struct Tune {
 #define SAMPLE_RATE 12000
 #endif
 
+#define NOTES_SIZE (2 * SOUND_MAX_NOTES + 1)
+
+static float g_notes[NOTES_SIZE] = { NAN }; // set by playNotes
+
 Tune g_tunes[] = {
 	{ g_clickTune, SAMPLE_RATE, 1.3f },
 	{ nullptr, 48000, 0, g_shutterSamples, g_shutterSamplesSize },
 	{ g_beepTune, SAMPLE_RATE, 1.3f },
+	{ g_notes, SAMPLE_RATE, 1.3f }, // NOTES_TUNE
 	{ g_powerUpTune, SAMPLE_RATE, 1.3f },
 	{ g_powerDownTune, SAMPLE_RATE, 0.75f }
 };
@@ -1470,83 +1484,215 @@ Tune g_tunes[] = {
 static int g_playNextTuneIndex = -1;
 static int g_currentTuneIndex = -1;
 static uint32_t g_currentTuneStartPlayTime;
+static uint32_t g_currentTuneDuration; // ms
 
 ////////////////////////////////////////////////////////////////////////////////
 
 #define PI 3.14159265f
 
 #if defined(EEZ_PLATFORM_SIMULATOR) && !defined(__EMSCRIPTEN__)
-static const uint32_t g_memoryForTuneSamplesSize = 256000;
-int16_t g_memoryForTuneSamples[g_memoryForTuneSamplesSize];
+#if defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
+uint32_t g_audioDevice; // no audio device, tunes are never played
+#else
 SDL_AudioDeviceID g_audioDevice;
+#endif
 #elif defined(EEZ_PLATFORM_STM32)
-static const uint32_t g_memoryForTuneSamplesSize = SOUND_TUNES_MEMORY_SIZE;
-uint8_t *g_memoryForTuneSamples = SOUND_TUNES_MEMORY;
+// DMA is circular, a half is filled while the other one is played
+static const uint32_t DMA_BUFFER_HALF_SIZE = 256;
+static Sample g_dmaBuffer[2 * DMA_BUFFER_HALF_SIZE];
 #endif
 
 #if !defined(__EMSCRIPTEN__)
 
-uint32_t g_memoryForTuneSamplesOffset;
+// Tunes are synthesized while they are played, from the sine wavetable with the phase
+// accumulator as oscillator, so nothing is generated in advance and the tune can be of any length.
 
-#if defined(EEZ_PLATFORM_SIMULATOR)
-unsigned int generateTuneSamples(float *tune, int sampleRate, int16_t *pMemBuffer, float durationBetweenNotesFactor) {
-#elif defined(EEZ_PLATFORM_STM32)
-unsigned int generateTuneSamples(float *tune, int sampleRate, uint8_t *pMemBuffer, float durationBetweenNotesFactor) {
-#endif
+#define WAVETABLE_SIZE_BITS 8
+#define WAVETABLE_SIZE (1 << WAVETABLE_SIZE_BITS)
 
-    unsigned int size = 0;
-	for (int i = 0; !isNaN(tune[i]); i += 2) {
-        if (i > 0) {
-            // add silence between notes
-			unsigned int silence = (unsigned int)roundf(durationBetweenNotesFactor * sampleRate * tune[i - 1]);
-            memset(pMemBuffer, 0, silence * sizeof(uint16_t));
-			size += silence;
-            pMemBuffer += silence;
-		}
+static Sample g_wavetable[WAVETABLE_SIZE]; // one period
+
+struct Player {
+	const Tune *tune; // nullptr when nothing is played
+	int noteIndex;
+	bool silence; // between the notes
+	uint32_t numSamplesLeft; // in the current note, silence or recorded tune
+	uint32_t phase; // 2^32 is one period
+	uint32_t phaseIncrement;
+	uint32_t sampleIndex; // of the recorded tune
+	float notes[NOTES_SIZE]; // NOTES_TUNE is copied, so playNotes can't change it while it is played
+	Tune notesTune;
+};
 
-		unsigned int duration = (unsigned int)roundf(sampleRate * tune[i + 1]);
-		size += duration;
-		
-        float f = 2 * PI * tune[i] / sampleRate;
+static Player g_player;
 
-		for (unsigned int k = 0; k < duration; k++) {
+#if defined(DEBUG)
+static uint32_t g_initDuration;
+#endif
+
+static void initWavetable() {
+	for (int i = 0; i < WAVETABLE_SIZE; i++) {
+		float value = sinf(2 * PI * i / WAVETABLE_SIZE);
 #if defined(EEZ_PLATFORM_SIMULATOR)
-			*pMemBuffer++ = (int16_t)clamp(32767.5f * sinf(k * f), -32768.0f, 32767.0f);
+		g_wavetable[i] = (Sample)clamp(32767.5f * value, -32768.0f, 32767.0f);
 #elif defined(EEZ_PLATFORM_STM32)
-			*pMemBuffer++ = (uint8_t)clamp(127.5f + 127.5f * sinf(k * f), 0.0f, 255.0f);
+		g_wavetable[i] = (Sample)clamp(127.5f + 127.5f * value, 0.0f, 255.0f);
 #endif
+	}
+}
+
+static uint32_t getNoteNumSamples(const Tune &tuneDef, int noteIndex) {
+	return (uint32_t)roundf(tuneDef.sampleRate * tuneDef.tune[noteIndex + 1]);
+}
+
+static uint32_t getSilenceNumSamples(const Tune &tuneDef, int noteIndex) {
+	return (uint32_t)roundf(tuneDef.durationBetweenNotesFactor * tuneDef.sampleRate * tuneDef.tune[noteIndex + 1]);
+}
+
+static uint32_t getTuneNumSamples(const Tune &tuneDef) {
+	if (tuneDef.pSamples) {
+		return tuneDef.numSamples;
+	}
+
+	uint32_t numSamples = 0;
+	for (int i = 0; !isNaN(tuneDef.tune[i]); i += 2) {
+		if (i > 0) {
+			numSamples += getSilenceNumSamples(tuneDef, i - 2);
 		}
+		numSamples += getNoteNumSamples(tuneDef, i);
+	}
+	return numSamples;
+}
 
+static void startPlayer(Player &player, const Tune &tuneDef) {
+	if (tuneDef.tune == g_notes) {
+		memcpy(player.notes, g_notes, sizeof(g_notes));
+		player.notesTune = tuneDef;
+		player.notesTune.tune = player.notes;
+		player.tune = &player.notesTune;
+	} else {
+		player.tune = &tuneDef;
+	}
+	player.sampleIndex = 0;
+	if (tuneDef.pSamples) {
+		player.numSamplesLeft = tuneDef.numSamples;
+	} else {
+		// the first advance starts the first note
+		player.noteIndex = -2;
+		player.silence = true;
+		player.numSamplesLeft = 0;
 	}
+}
 
-	// add zero to the end
-	*pMemBuffer = 0;
-	size++;
+// after the note comes the silence and then the next note
+static void advancePlayer(Player &player) {
+	const Tune &tuneDef = *player.tune;
 
-	return size;
+	if (tuneDef.pSamples) {
+		player.tune = nullptr;
+	} else if (player.silence) {
+		player.noteIndex += 2;
+		if (isNaN(tuneDef.tune[player.noteIndex])) {
+			player.tune = nullptr;
+			return;
+		}
+		player.silence = false;
+		player.numSamplesLeft = getNoteNumSamples(tuneDef, player.noteIndex);
+		player.phase = 0;
+		player.phaseIncrement = (uint32_t)(tuneDef.tune[player.noteIndex] * 4294967296.0f / tuneDef.sampleRate);
+	} else if (isNaN(tuneDef.tune[player.noteIndex + 2])) {
+		player.tune = nullptr;
+	} else {
+		player.silence = true;
+		player.numSamplesLeft = getSilenceNumSamples(tuneDef, player.noteIndex);
+	}
+}
+
+// silence is generated after the end of the tune
+static void generateSamples(Player &player, Sample *buffer, uint32_t numSamples) {
+	while (numSamples > 0) {
+		if (!player.tune) {
+			while (numSamples--) {
+				*buffer++ = SILENCE;
+			}
+			return;
+		}
+
+		if (player.numSamplesLeft == 0) {
+			advancePlayer(player);
+			continue;
+		}
+
+		uint32_t n = MIN(numSamples, player.numSamplesLeft);
+
+		if (player.tune->pSamples) {
+			memcpy(buffer, player.tune->pSamples + player.sampleIndex, n * sizeof(Sample));
+			player.sampleIndex += n;
+		} else if (player.silence) {
+			for (uint32_t i = 0; i < n; i++) {
+				buffer[i] = SILENCE;
+			}
+		} else {
+			uint32_t phase = player.phase;
+			uint32_t phaseIncrement = player.phaseIncrement;
+			for (uint32_t i = 0; i < n; i++) {
+				buffer[i] = g_wavetable[phase >> (32 - WAVETABLE_SIZE_BITS)];
+				phase += phaseIncrement;
+			}
+			player.phase = phase;
+		}
+
+		buffer += n;
+		numSamples -= n;
+		player.numSamplesLeft -= n;
+	}
 }
 
+#if defined(EEZ_PLATFORM_SIMULATOR) && !defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
+static void audioCallback(void *userdata, Uint8 *stream, int len) {
+	generateSamples(g_player, (Sample *)stream, len / sizeof(Sample));
+}
 #endif
 
-////////////////////////////////////////////////////////////////////////////////
+#if defined(EEZ_PLATFORM_STM32)
+static bool g_lastDmaBufferHalfSilent;
 
-#if !defined(__EMSCRIPTEN__)
-void initTune(Tune &tuneDef) {
-    if (!tuneDef.pSamples) {
-		tuneDef.pSamples = g_memoryForTuneSamples + g_memoryForTuneSamplesOffset;
-		tuneDef.numSamples = generateTuneSamples(tuneDef.tune, tuneDef.sampleRate, tuneDef.pSamples, tuneDef.durationBetweenNotesFactor);
-        g_memoryForTuneSamplesOffset += tuneDef.numSamples;
-        assert(g_memoryForTuneSamplesOffset * sizeof(uint8_t) <= g_memoryForTuneSamplesSize);
+static void fillDmaBufferHalf(Sample *buffer) {
+	if (!g_player.tune && g_lastDmaBufferHalfSilent) {
+		// the end of the tune is already played
+		HAL_DAC_Stop_DMA(&hdac, DAC_CHANNEL_1);
+		HAL_TIM_Base_Stop(&htim6);
+		return;
 	}
+	g_lastDmaBufferHalfSilent = !g_player.tune;
+	generateSamples(g_player, buffer, DMA_BUFFER_HALF_SIZE);
+}
+
+extern "C" void HAL_DAC_ConvHalfCpltCallbackCh1(DAC_HandleTypeDef *) {
+	fillDmaBufferHalf(g_dmaBuffer);
 }
+
+extern "C" void HAL_DAC_ConvCpltCallbackCh1(DAC_HandleTypeDef *) {
+	fillDmaBufferHalf(g_dmaBuffer + DMA_BUFFER_HALF_SIZE);
+}
+#endif
+
 #endif
 
+////////////////////////////////////////////////////////////////////////////////
+
 void init() {
 #if !defined(__EMSCRIPTEN__)
-	initTune(g_tunes[POWER_UP_TUNE]);
+#if defined(DEBUG)
+	uint64_t initStartTime = microsPrecise();
+#endif
+	initWavetable();
+#if defined(DEBUG)
+	g_initDuration = (uint32_t)(microsPrecise() - initStartTime);
+#endif
 #endif
 
-#if defined(EEZ_PLATFORM_SIMULATOR) && !defined(__EMSCRIPTEN__)
+#if defined(EEZ_PLATFORM_SIMULATOR) && !defined(__EMSCRIPTEN__) && !defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
 	SDL_InitSubSystem(SDL_INIT_AUDIO);
 
 	SDL_AudioSpec desiredSpec;
@@ -1557,6 +1703,7 @@ void init() {
 	desiredSpec.format = AUDIO_S16SYS;
 	desiredSpec.channels = 1;
 	desiredSpec.samples = 2048;
+	desiredSpec.callback = audioCallback;
 
 	SDL_AudioSpec obtainedSpec;
 
@@ -1565,23 +1712,37 @@ void init() {
 		printf("Failed to open audio: %s\n", SDL_GetError());
 	}
 #endif
+
+#if defined(EEZ_PLATFORM_STM32)
+	hdma_dac1.Init.Mode = DMA_CIRCULAR;
+	HAL_DMA_Init(&hdma_dac1);
+#endif
 }
 
 void startPlay(int iTune) {
 #if !defined(__EMSCRIPTEN__)
     Tune &tuneDef = g_tunes[iTune];
-	initTune(tuneDef);
+	g_currentTuneDuration = getTuneNumSamples(tuneDef) * 1000 / tuneDef.sampleRate;
 #if defined(EEZ_PLATFORM_SIMULATOR)
-    SDL_QueueAudio(g_audioDevice, tuneDef.pSamples, tuneDef.numSamples * 2);
+#if !defined(EEZ_PLATFORM_SIMULATOR_HEADLESS)
+	SDL_LockAudioDevice(g_audioDevice);
+	startPlayer(g_player, tuneDef);
+	SDL_UnlockAudioDevice(g_audioDevice);
     SDL_PauseAudioDevice(g_audioDevice, 0);
+#endif
 #elif defined(EEZ_PLATFORM_STM32)
 	HAL_DAC_Stop_DMA(&hdac, DAC_CHANNEL_1);
 	HAL_TIM_Base_Stop(&htim6);
 	HAL_TIM_Base_DeInit(&htim6);
 	htim6.Init.Period = 108000000 / tuneDef.sampleRate - 1;
 	HAL_TIM_Base_Init(&htim6);
+
+	startPlayer(g_player, tuneDef);
+	g_lastDmaBufferHalfSilent = false;
+	generateSamples(g_player, g_dmaBuffer, 2 * DMA_BUFFER_HALF_SIZE);
+
 	HAL_TIM_Base_Start(&htim6);
-	HAL_DAC_Start_DMA(&hdac, DAC_CHANNEL_1, (uint32_t *)tuneDef.pSamples, tuneDef.numSamples, DAC_ALIGN_8B_R);
+	HAL_DAC_Start_DMA(&hdac, DAC_CHANNEL_1, (uint32_t *)g_dmaBuffer, 2 * DMA_BUFFER_HALF_SIZE, DAC_ALIGN_8B_R);
 #endif
 #endif
 }
@@ -1595,9 +1756,7 @@ void tick() {
 #endif
 
 	if (g_currentTuneIndex != -1) {
-		Tune &tuneDef = g_tunes[g_currentTuneIndex];
-		uint32_t duration = tuneDef.numSamples * 1000 / tuneDef.sampleRate;
-		if (millis() - g_currentTuneStartPlayTime > duration) {
+		if (millis() - g_currentTuneStartPlayTime > g_currentTuneDuration) {
 			g_currentTuneIndex = -1;
 		}
 	}
@@ -1678,5 +1837,80 @@ void playShutter() {
     }
 }
 
+void playNotes(const float *notes) {
+#if !defined(__EMSCRIPTEN__)
+	if (!isNaN(notes[0])) {
+		// copied again by startPlayer, g_notes is only the pending tune
+		int i;
+		for (i = 0; i < NOTES_SIZE - 1 && !isNaN(notes[i]) && !isNaN(notes[i + 1]); i += 2) {
+			g_notes[i] = notes[i];
+			g_notes[i + 1] = notes[i + 1];
+		}
+		g_notes[i] = NAN;
+		playTune(NOTES_TUNE);
+	}
+#endif
+}
+
+float getMaxNoteFrequency() {
+#if !defined(__EMSCRIPTEN__)
+	return SAMPLE_RATE / 2.0f;
+#else
+	return 20000.0f;
+#endif
+}
+
+#if defined(DEBUG) && !defined(__EMSCRIPTEN__)
+void benchmark(uint32_t numSeconds) {
+	static Sample buffer[512];
+	static Player player;
+
+	static float notes[] = {
+		NOTE_C6, 1.0f,
+		NAN
+	};
+	Tune tuneDef = { notes, SAMPLE_RATE, 0 };
+
+	uint32_t numSamples = numSeconds * SAMPLE_RATE;
+
+	uint64_t start = microsPrecise();
+	for (uint32_t i = 0; i < numSeconds; i++) {
+		startPlayer(player, tuneDef);
+		for (uint32_t j = 0; j < SAMPLE_RATE; ) {
+			uint32_t n = MIN(sizeof(buffer) / sizeof(Sample), SAMPLE_RATE - j);
+			generateSamples(player, buffer, n);
+			j += n;
+		}
+	}
+	uint32_t wavetableDuration = (uint32_t)(microsPrecise() - start);
+
+	// the way the tunes were generated before, sinf per sample
+	volatile Sample sink;
+	float f = 2 * PI * NOTE_C6 / SAMPLE_RATE;
+	start = microsPrecise();
+	for (uint32_t k = 0; k < numSamples; k++) {
+#if defined(EEZ_PLATFORM_SIMULATOR)
+		sink = (Sample)clamp(32767.5f * sinf(k * f), -32768.0f, 32767.0f);
+#elif defined(EEZ_PLATFORM_STM32)
+		sink = (Sample)clamp(127.5f + 127.5f * sinf(k * f), 0.0f, 255.0f);
+#endif
+	}
+	uint32_t sinfDuration = (uint32_t)(microsPrecise() - start);
+	(void)sink;
+
+	// power up tune was generated in the init
+	uint32_t powerUpTuneNumSamples = getTuneNumSamples(g_tunes[POWER_UP_TUNE]);
+
+	DebugTrace("Sound: %u Hz, wavetable %u us, sinf %u us per second of audio\n", (unsigned)SAMPLE_RATE,
+		(unsigned)(wavetableDuration / numSeconds), (unsigned)(sinfDuration / numSeconds));
+	DebugTrace("Sound init: %u us, power up tune of %u samples generated before with sinf: %u us\n",
+		(unsigned)g_initDuration, (unsigned)powerUpTuneNumSamples,
+		(unsigned)((uint64_t)sinfDuration * powerUpTuneNumSamples / numSamples));
+}
+#elif defined(DEBUG)
+void benchmark(uint32_t numSeconds) {
+}
+#endif
+
 } // namespace sound
 } // namespace eez
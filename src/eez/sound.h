@@ -47,5 +47,19 @@ void playClick();
 /// Play shutter sound
 void playShutter();
 
+#define SOUND_MAX_NOTES 16
+
+/// Play the note frequency (Hz) and duration (s) pairs terminated with NAN.
+/// Notes are copied, up to SOUND_MAX_NOTES, and each frequency must be below getMaxNoteFrequency().
+void playNotes(const float *notes);
+
+/// Half of the sample rate, higher frequencies can't be synthesized.
+float getMaxNoteFrequency();
+
+#if defined(DEBUG)
+/// Traces CPU time per second of audio and the init time.
+void benchmark(uint32_t numSeconds);
+#endif
+
 } // namespace sound
 } // namespace eez
@@ -18,6 +18,10 @@
 
 #include <stdio.h>
 
+#if defined(EEZ_PLATFORM_SIMULATOR)
+#include <chrono>
+#endif
+
 #include <eez/system.h>
 
 #if defined(EEZ_PLATFORM_STM32)
@@ -52,10 +56,54 @@ uint32_t micros() {
 #endif
 
 #if defined(EEZ_PLATFORM_SIMULATOR)
+#if !defined(__EMSCRIPTEN__)
+    if (osKernelIsVirtualTime()) {
+        return (uint32_t)osKernelVirtualTime();
+    }
+#endif
 	return osKernelSysTick() * 1000;
 #endif
 }
 
+uint64_t microsPrecise() {
+#if defined(EEZ_PLATFORM_STM32)
+    // DWT cycle counter is extended to 64 bits, it overflows every ~20 seconds
+    // and this is called much more often than that from the PSU thread
+    static uint32_t g_lastCycles;
+    static uint64_t g_cyclesHigh;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (!(DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk)) {
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CYCCNT = 0;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    }
+
+    uint32_t cycles = DWT->CYCCNT;
+    if (cycles < g_lastCycles) {
+        g_cyclesHigh += 0x100000000ULL;
+    }
+    g_lastCycles = cycles;
+    uint64_t result = g_cyclesHigh + cycles;
+
+    __set_PRIMASK(primask);
+
+    return result / (SystemCoreClock / 1000000);
+#endif
+
+#if defined(EEZ_PLATFORM_SIMULATOR)
+#if !defined(__EMSCRIPTEN__)
+    if (osKernelIsVirtualTime()) {
+        return osKernelVirtualTime();
+    }
+#endif
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
 void delayMicroseconds(uint32_t microseconds) {
 #if defined(EEZ_PLATFORM_STM32)
 	while (microseconds--) {
@@ -34,6 +34,9 @@ namespace eez {
 
 uint32_t micros();
 uint32_t millis();
+
+/// Microseconds from the CPU cycle counter, micros() is incremented only once per tick.
+uint64_t microsPrecise();
 void delay(uint32_t millis);
 void delayMicroseconds(uint32_t microseconds);
 
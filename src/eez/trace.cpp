@@ -0,0 +1,418 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2015-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <eez/trace.h>
+
+#if OPTION_TRACE
+
+#include <atomic>
+#include <stdio.h>
+#include <string.h>
+
+#include <eez/memory.h>
+#include <eez/system.h>
+
+#include <eez/modules/psu/psu.h>
+#include <eez/modules/psu/event_queue.h>
+#include <eez/modules/psu/sd_card.h>
+#include <eez/modules/psu/sd_worker.h>
+#include <eez/modules/psu/scpi/psu.h>
+
+#include <eez/libs/sd_fat/sd_fat.h>
+
+namespace eez {
+namespace trace {
+
+#define TRACE_MAX_THREADS 8
+#define TRACE_MAX_NAMES 128
+#define CONF_SAVE_TRACE_TIMEOUT_MS 5000
+
+struct Event {
+    uint64_t timestamp; // us
+    const char *name;
+    uint8_t type;
+};
+
+static const uint32_t EVENTS_PER_THREAD = TRACE_BUFFER_SIZE / TRACE_MAX_THREADS / sizeof(Event);
+
+// Only the owner thread writes into the ring buffer, so there is no locking.
+struct ThreadBuffer {
+    std::atomic<bool> registered;
+    osThreadId threadId;
+    const char *name;
+    std::atomic<uint32_t> head; // total number of events written
+    Event *events;
+};
+
+static ThreadBuffer g_threadBuffers[TRACE_MAX_THREADS];
+static std::atomic<int> g_numThreadBuffers(0);
+
+static std::atomic<bool> g_initialized(false);
+static std::atomic<bool> g_enabled(true);
+
+static char g_shutdownDumpFilePath[MAX_PATH_LENGTH + 1];
+static DumpFormat g_shutdownDumpFormat;
+
+static std::atomic<bool> g_dumpRequested(false);
+static char g_dumpFilePath[MAX_PATH_LENGTH + 1];
+static DumpFormat g_dumpFormat;
+
+////////////////////////////////////////////////////////////////////////////////
+
+void init() {
+    for (int i = 0; i < TRACE_MAX_THREADS; i++) {
+        g_threadBuffers[i].events = (Event *)TRACE_BUFFER + i * EVENTS_PER_THREAD;
+    }
+    g_initialized.store(true, std::memory_order_release);
+}
+
+static ThreadBuffer *findThreadBuffer(osThreadId threadId) {
+    for (int i = 0; i < TRACE_MAX_THREADS; i++) {
+        ThreadBuffer &threadBuffer = g_threadBuffers[i];
+        if (threadBuffer.registered.load(std::memory_order_acquire) && threadBuffer.threadId == threadId) {
+            return &threadBuffer;
+        }
+    }
+    return nullptr;
+}
+
+void registerThread(const char *name) {
+    osThreadId threadId = osThreadGetId();
+    if (findThreadBuffer(threadId)) {
+        return;
+    }
+
+    int i = g_numThreadBuffers.fetch_add(1);
+    if (i >= TRACE_MAX_THREADS) {
+        return;
+    }
+
+    ThreadBuffer &threadBuffer = g_threadBuffers[i];
+    threadBuffer.threadId = threadId;
+    threadBuffer.name = name;
+    threadBuffer.head.store(0, std::memory_order_relaxed);
+    threadBuffer.registered.store(true, std::memory_order_release);
+}
+
+void event(EventType type, const char *name) {
+    if (!g_enabled.load(std::memory_order_relaxed) || !g_initialized.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    ThreadBuffer *threadBuffer = findThreadBuffer(osThreadGetId());
+    if (!threadBuffer) {
+        return;
+    }
+
+    uint32_t head = threadBuffer->head.load(std::memory_order_relaxed);
+    Event &traceEvent = threadBuffer->events[head % EVENTS_PER_THREAD];
+    traceEvent.timestamp = microsPrecise();
+    traceEvent.name = name;
+    traceEvent.type = type;
+    threadBuffer->head.store(head + 1, std::memory_order_release);
+}
+
+void setEnabled(bool enabled) {
+    g_enabled.store(enabled);
+}
+
+bool isEnabled() {
+    return g_enabled.load();
+}
+
+void clear() {
+    bool wasEnabled = g_enabled.exchange(false);
+
+    // event in progress, if any, is finished while waiting
+    osDelay(1);
+
+    for (int i = 0; i < TRACE_MAX_THREADS; i++) {
+        g_threadBuffers[i].head.store(0);
+    }
+
+    g_enabled.store(wasEnabled);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static uint32_t getNumEvents(const ThreadBuffer &threadBuffer) {
+    uint32_t head = threadBuffer.head.load(std::memory_order_acquire);
+    return head < EVENTS_PER_THREAD ? head : EVENTS_PER_THREAD;
+}
+
+static const Event &getEvent(const ThreadBuffer &threadBuffer, uint32_t eventIndex) {
+    uint32_t head = threadBuffer.head.load(std::memory_order_acquire);
+    return threadBuffer.events[(head - getNumEvents(threadBuffer) + eventIndex) % EVENTS_PER_THREAD];
+}
+
+static uint64_t getFirstTimestamp() {
+    uint64_t firstTimestamp = UINT64_MAX;
+    for (int i = 0; i < TRACE_MAX_THREADS; i++) {
+        const ThreadBuffer &threadBuffer = g_threadBuffers[i];
+        if (threadBuffer.registered && getNumEvents(threadBuffer) > 0) {
+            uint64_t timestamp = getEvent(threadBuffer, 0).timestamp;
+            if (timestamp < firstTimestamp) {
+                firstTimestamp = timestamp;
+            }
+        }
+    }
+    return firstTimestamp == UINT64_MAX ? 0 : firstTimestamp;
+}
+
+// printf from newlib nano doesn't support %llu
+static void formatUInt64(char *text, uint64_t value) {
+    char digits[21];
+    int n = 0;
+    do {
+        digits[n++] = '0' + value % 10;
+        value /= 10;
+    } while (value > 0);
+    while (n > 0) {
+        *text++ = digits[--n];
+    }
+    *text = 0;
+}
+
+static bool writeString(psu::sd_card::BufferedFileWrite &file, const char *str) {
+    return file.write((const uint8_t *)str, strlen(str));
+}
+
+static bool writeJson(psu::sd_card::BufferedFileWrite &file) {
+    static const char PHASE[] = { 'B', 'E', 'i' };
+
+    if (!writeString(file, "{\"traceEvents\":[\n")) {
+        return false;
+    }
+
+    uint64_t firstTimestamp = getFirstTimestamp();
+
+    char line[128];
+    char timestamp[21];
+    bool first = true;
+
+    for (int i = 0; i < TRACE_MAX_THREADS; i++) {
+        const ThreadBuffer &threadBuffer = g_threadBuffers[i];
+        if (!threadBuffer.registered) {
+            continue;
+        }
+
+        snprintf(line, sizeof(line), "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+            first ? "" : ",\n", i + 1, threadBuffer.name);
+        first = false;
+        if (!writeString(file, line)) {
+            return false;
+        }
+
+        // end events of the slices that began before the oldest event in the ring buffer are skipped
+        int depth = 0;
+
+        uint32_t numEvents = getNumEvents(threadBuffer);
+        for (uint32_t j = 0; j < numEvents; j++) {
+            const Event &event = getEvent(threadBuffer, j);
+
+            if (event.type == EVENT_BEGIN) {
+                depth++;
+            } else if (event.type == EVENT_END) {
+                if (depth == 0) {
+                    continue;
+                }
+                depth--;
+            }
+
+            formatUInt64(timestamp, event.timestamp - firstTimestamp);
+            snprintf(line, sizeof(line), ",\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%s,\"pid\":1,\"tid\":%d%s}",
+                event.name, PHASE[event.type], timestamp, i + 1, event.type == EVENT_INSTANT ? ",\"s\":\"t\"" : "");
+            if (!writeString(file, line)) {
+                return false;
+            }
+        }
+    }
+
+    return writeString(file, "\n]}\n");
+}
+
+// Binary format, all numbers are little endian:
+//   "EZTR", uint16 version, uint16 number of names, uint16 number of threads
+//   names: uint8 length, chars
+//   threads: uint8 name length, chars, uint32 number of events,
+//     events: uint64 timestamp [us], uint16 name index, uint8 type
+static bool writeUInt(psu::sd_card::BufferedFileWrite &file, uint64_t value, int numBytes) {
+    uint8_t buffer[8];
+    for (int i = 0; i < numBytes; i++) {
+        buffer[i] = (uint8_t)(value >> (8 * i));
+    }
+    return file.write(buffer, numBytes);
+}
+
+static bool writeShortString(psu::sd_card::BufferedFileWrite &file, const char *str) {
+    size_t length = strlen(str);
+    if (length > 255) {
+        length = 255;
+    }
+    return writeUInt(file, length, 1) && file.write((const uint8_t *)str, length);
+}
+
+static bool writeBinary(psu::sd_card::BufferedFileWrite &file) {
+    static const char *names[TRACE_MAX_NAMES];
+    int numNames = 0;
+    int numThreads = 0;
+
+    for (int i = 0; i < TRACE_MAX_THREADS; i++) {
+        const ThreadBuffer &threadBuffer = g_threadBuffers[i];
+        if (!threadBuffer.registered) {
+            continue;
+        }
+        numThreads++;
+
+        uint32_t numEvents = getNumEvents(threadBuffer);
+        for (uint32_t j = 0; j < numEvents; j++) {
+            const char *name = getEvent(threadBuffer, j).name;
+            int k;
+            for (k = 0; k < numNames && names[k] != name; k++) {
+            }
+            if (k == numNames && numNames < TRACE_MAX_NAMES) {
+                names[numNames++] = name;
+            }
+        }
+    }
+
+    if (!file.write((const uint8_t *)"EZTR", 4) || !writeUInt(file, 1, 2) || !writeUInt(file, numNames, 2) || !writeUInt(file, numThreads, 2)) {
+        return false;
+    }
+
+    for (int i = 0; i < numNames; i++) {
+        if (!writeShortString(file, names[i])) {
+            return false;
+        }
+    }
+
+    uint64_t firstTimestamp = getFirstTimestamp();
+
+    for (int i = 0; i < TRACE_MAX_THREADS; i++) {
+        const ThreadBuffer &threadBuffer = g_threadBuffers[i];
+        if (!threadBuffer.registered) {
+            continue;
+        }
+
+        uint32_t numEvents = getNumEvents(threadBuffer);
+        if (!writeShortString(file, threadBuffer.name) || !writeUInt(file, numEvents, 4)) {
+            return false;
+        }
+
+        for (uint32_t j = 0; j < numEvents; j++) {
+            const Event &event = getEvent(threadBuffer, j);
+            int nameIndex;
+            for (nameIndex = 0; nameIndex < numNames && names[nameIndex] != event.name; nameIndex++) {
+            }
+            if (nameIndex == numNames) {
+                nameIndex = 0xFFFF;
+            }
+
+            if (!writeUInt(file, event.timestamp - firstTimestamp, 8) || !writeUInt(file, nameIndex, 2) || !writeUInt(file, event.type, 1)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+static bool dump(const char *filePath, DumpFormat format, int *err) {
+    using namespace psu;
+
+    if (!sd_card::isMounted(err)) {
+        return false;
+    }
+
+    if (!sd_card::makeParentDir(filePath, err)) {
+        return false;
+    }
+
+    bool wasEnabled = g_enabled.exchange(false);
+    osDelay(1);
+
+    bool result = false;
+
+    uint32_t timeout = millis() + CONF_SAVE_TRACE_TIMEOUT_MS;
+    while (millis() < timeout) {
+        File file;
+        if (file.open(filePath, FILE_CREATE_ALWAYS | FILE_WRITE)) {
+            sd_card::BufferedFileWrite bufferedFile(file);
+
+            if (format == DUMP_FORMAT_JSON ? writeJson(bufferedFile) : writeBinary(bufferedFile)) {
+                if (bufferedFile.flush()) {
+                    if (file.close()) {
+                        onSdCardFileChangeHook(filePath);
+                        result = true;
+                        break;
+                    }
+                }
+            }
+        }
+
+        sd_card::reinitialize();
+    }
+
+    g_enabled.store(wasEnabled);
+
+    if (!result && err) {
+        *err = SCPI_ERROR_MASS_STORAGE_ERROR;
+    }
+
+    return result;
+}
+
+bool postDump(const char *filePath, DumpFormat format) {
+    if (g_dumpRequested.exchange(true)) {
+        return false;
+    }
+
+    strncpy(g_dumpFilePath, filePath, MAX_PATH_LENGTH);
+    g_dumpFilePath[MAX_PATH_LENGTH] = 0;
+    g_dumpFormat = format;
+
+    psu::sd_worker::postRequest(psu::sd_worker::REQUEST_TRACE_DUMP);
+
+    return true;
+}
+
+void executeDumpRequest() {
+    int err;
+    if (!dump(g_dumpFilePath, g_dumpFormat, &err)) {
+        psu::event_queue::pushEvent(err);
+    }
+
+    g_dumpRequested.store(false);
+}
+
+void setShutdownDump(const char *filePath, DumpFormat format) {
+    strncpy(g_shutdownDumpFilePath, filePath, MAX_PATH_LENGTH);
+    g_shutdownDumpFilePath[MAX_PATH_LENGTH] = 0;
+    g_shutdownDumpFormat = format;
+}
+
+void shutdownDump() {
+    if (g_shutdownDumpFilePath[0]) {
+        dump(g_shutdownDumpFilePath, g_shutdownDumpFormat, nullptr);
+    }
+}
+
+} // namespace trace
+} // namespace eez
+
+#endif // OPTION_TRACE
@@ -0,0 +1,101 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2015-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifndef OPTION_TRACE
+#define OPTION_TRACE 0
+#endif
+
+namespace eez {
+namespace trace {
+
+enum EventType {
+    EVENT_BEGIN,
+    EVENT_END,
+    EVENT_INSTANT
+};
+
+enum DumpFormat {
+    DUMP_FORMAT_JSON,  // Chrome trace, open with chrome://tracing or Perfetto
+    DUMP_FORMAT_BINARY
+};
+
+#if OPTION_TRACE
+
+/// Must be called after the TRACE_BUFFER memory is accessible, until then nothing is recorded.
+void init();
+
+/// Every thread has its own ring buffer, events from the threads that are not registered are dropped.
+void registerThread(const char *name);
+
+/// Name must be a static string, only the pointer is stored.
+void event(EventType type, const char *name);
+
+void setEnabled(bool enabled);
+bool isEnabled();
+void clear();
+
+/// Dump is written to the SD card by the SD worker, recording is paused during the dump.
+/// Returns false if the previous dump is not finished yet, errors are pushed to the event queue.
+bool postDump(const char *filePath, DumpFormat format);
+void executeDumpRequest();
+
+/// Dump is written on shutdown if the file path is set, used by the simulator --trace option.
+void setShutdownDump(const char *filePath, DumpFormat format);
+void shutdownDump();
+
+struct Scope {
+    Scope(const char *name_) : name(name_) {
+        event(EVENT_BEGIN, name);
+    }
+
+    ~Scope() {
+        event(EVENT_END, name);
+    }
+
+    const char *name;
+};
+
+#endif
+
+} // namespace trace
+} // namespace eez
+
+#if OPTION_TRACE
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+#define TRACE_REGISTER_THREAD(name) ::eez::trace::registerThread(name)
+#define TRACE_SCOPE(name) ::eez::trace::Scope TRACE_CONCAT(traceScope, __LINE__)(name)
+#define TRACE_BEGIN(name) ::eez::trace::event(::eez::trace::EVENT_BEGIN, name)
+#define TRACE_END(name) ::eez::trace::event(::eez::trace::EVENT_END, name)
+#define TRACE_INSTANT(name) ::eez::trace::event(::eez::trace::EVENT_INSTANT, name)
+
+#else
+
+#define TRACE_REGISTER_THREAD(name) (void)0
+#define TRACE_SCOPE(name) (void)0
+#define TRACE_BEGIN(name) (void)0
+#define TRACE_END(name) (void)0
+#define TRACE_INSTANT(name) (void)0
+
+#endif
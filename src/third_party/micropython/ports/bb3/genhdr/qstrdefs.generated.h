@@ -254,6 +254,8 @@ QDEF(MP_QSTR_sleep, (const byte*)"\xea\x05" "sleep")
 QDEF(MP_QSTR_sleep_ms, (const byte*)"\x0b\x08" "sleep_ms")
 QDEF(MP_QSTR_sleep_us, (const byte*)"\x13\x08" "sleep_us")
 QDEF(MP_QSTR_sqrt, (const byte*)"\x21\x04" "sqrt")
+QDEF(MP_QSTR_sweep, (const byte*)"\xd1\x05" "sweep")
+QDEF(MP_QSTR_sweep2, (const byte*)"\xc3\x06" "sweep2")
 QDEF(MP_QSTR_tan, (const byte*)"\xfe\x03" "tan")
 QDEF(MP_QSTR_ticks_add, (const byte*)"\x9d\x09" "ticks_add")
 QDEF(MP_QSTR_ticks_cpu, (const byte*)"\x1a\x09" "ticks_cpu")
@@ -20,11 +20,13 @@
 #include <stdlib.h>
 
 #include <eez/mp.h>
+#include <scpi/scpi.h>
 
 #include <eez/modules/psu/psu.h>
 #include <eez/modules/psu/channel_dispatcher.h>
 #include <eez/modules/psu/trigger.h>
 #include <eez/modules/psu/dlog_record.h>
+#include <eez/modules/psu/sweep.h>
 
 #ifdef _MSC_VER
 #pragma warning( push )
@@ -33,6 +35,7 @@
 
 extern "C" {
 #include "modeez.h"
+#include <py/objlist.h>
 #include <py/objtuple.h>
 #include <py/runtime.h>
 }
@@ -186,3 +189,110 @@ mp_obj_t modeez_dlogTraceData(size_t n_args, const mp_obj_t *args) {
 
     return mp_const_none;
 }
+
+// ch, param, start, stop, steps
+static void getSweepAxis(const mp_obj_t *args, sweep::Axis &axis) {
+    axis.channelIndex = mp_obj_get_int(args[0]) - 1;
+    if (axis.channelIndex < 0 || axis.channelIndex >= CH_NUM) {
+        mp_raise_ValueError("Invalid channel index");
+    }
+
+    const char *parameter = mp_obj_str_get_str(args[1]);
+    if (strcmp(parameter, "U") == 0) {
+        axis.parameter = sweep::PARAMETER_VOLTAGE;
+    } else if (strcmp(parameter, "I") == 0) {
+        axis.parameter = sweep::PARAMETER_CURRENT;
+    } else {
+        mp_raise_ValueError("Invalid sweep parameter");
+    }
+
+    axis.start = (float)mp_obj_get_float(args[2]);
+    axis.stop = (float)mp_obj_get_float(args[3]);
+
+    int numSteps = mp_obj_get_int(args[4]);
+    if (numSteps < 1 || numSteps > SWEEP_MAX_STEPS) {
+        mp_raise_ValueError("Invalid number of steps");
+    }
+    axis.numSteps = (uint16_t)numSteps;
+}
+
+static mp_obj_t newFloatList(const float *values, size_t numValues) {
+    mp_obj_list_t *list = (mp_obj_list_t *)MP_OBJ_TO_PTR(mp_obj_new_list(numValues, NULL));
+    for (size_t i = 0; i < numValues; i++) {
+        list->items[i] = mp_obj_new_float(values[i]);
+    }
+    return MP_OBJ_FROM_PTR(list);
+}
+
+// settle[, numSamples[, dlog]]
+static mp_obj_t doSweep(sweep::Parameters &parameters, size_t n_args, const mp_obj_t *args) {
+    int settleTime = mp_obj_get_int(args[0]);
+    if (settleTime < 0 || settleTime > SWEEP_MAX_SETTLE_TIME) {
+        mp_raise_ValueError("Invalid settle time");
+    }
+    parameters.settleTime = settleTime;
+
+    int numSamples = n_args > 1 ? mp_obj_get_int(args[1]) : 1;
+    if (numSamples < 1 || numSamples > 1000) {
+        mp_raise_ValueError("Invalid number of samples");
+    }
+    parameters.numSamples = (uint16_t)numSamples;
+
+    parameters.dlog = n_args > 2 ? mp_obj_is_true(args[2]) : false;
+
+    size_t numPoints = parameters.axes[0].numSteps;
+    if (parameters.numAxes == 2) {
+        numPoints *= parameters.axes[1].numSteps;
+    }
+
+    // results are not collected when streamed to DLOG, so there is no limit on the number of points
+    if (!parameters.dlog && numPoints > SWEEP_MAX_RESULT_POINTS) {
+        mp_raise_ValueError("Too many points, use DLOG for more than 4096 points");
+    }
+
+    if (parameters.dlog) {
+        parameters.uMon = nullptr;
+        parameters.iMon = nullptr;
+    } else {
+        parameters.uMon = m_new(float, numPoints);
+        parameters.iMon = m_new(float, numPoints);
+    }
+
+    int err;
+    if (!sweep::execute(parameters, &err)) {
+        if (!parameters.dlog) {
+            m_del(float, parameters.uMon, numPoints);
+            m_del(float, parameters.iMon, numPoints);
+        }
+        mp_raise_ValueError(SCPI_ErrorTranslate(err));
+    }
+
+    if (parameters.dlog) {
+        return mp_const_none;
+    }
+
+    mp_obj_t result[2] = {
+        newFloatList(parameters.uMon, numPoints),
+        newFloatList(parameters.iMon, numPoints)
+    };
+
+    m_del(float, parameters.uMon, numPoints);
+    m_del(float, parameters.iMon, numPoints);
+
+    return mp_obj_new_tuple(2, result);
+}
+
+mp_obj_t modeez_sweep(size_t n_args, const mp_obj_t *args) {
+    sweep::Parameters parameters;
+    parameters.numAxes = 1;
+    getSweepAxis(args, parameters.axes[0]);
+    return doSweep(parameters, n_args - 5, args + 5);
+}
+
+mp_obj_t modeez_sweep2(size_t n_args, const mp_obj_t *args) {
+    sweep::Parameters parameters;
+    parameters.numAxes = 2;
+    getSweepAxis(args, parameters.axes[0]);
+    getSweepAxis(args + 5, parameters.axes[1]);
+    return doSweep(parameters, n_args - 10, args + 10);
+}
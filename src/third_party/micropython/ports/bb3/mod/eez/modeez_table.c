@@ -25,6 +25,8 @@ STATIC MP_DEFINE_CONST_FUN_OBJ_1(modeez_getI_obj, modeez_getI);
 STATIC MP_DEFINE_CONST_FUN_OBJ_2(modeez_setI_obj, modeez_setI);
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(modeez_getOutputMode_obj, modeez_getOutputMode);
 STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(modeez_dlogTraceData_obj, 1, 4, modeez_dlogTraceData);
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(modeez_sweep_obj, 6, 8, modeez_sweep);
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(modeez_sweep2_obj, 11, 13, modeez_sweep2);
 
 STATIC const mp_rom_map_elem_t modeez_module_globals_table[] = {
   { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_eez) },
@@ -35,6 +37,8 @@ STATIC const mp_rom_map_elem_t modeez_module_globals_table[] = {
   { MP_ROM_QSTR(MP_QSTR_setI), (mp_obj_t)&modeez_setI_obj },
   { MP_ROM_QSTR(MP_QSTR_getOutputMode), (mp_obj_t)&modeez_getOutputMode_obj },
   { MP_ROM_QSTR(MP_QSTR_dlogTraceData), (mp_obj_t)&modeez_dlogTraceData_obj },
+  { MP_ROM_QSTR(MP_QSTR_sweep), (mp_obj_t)&modeez_sweep_obj },
+  { MP_ROM_QSTR(MP_QSTR_sweep2), (mp_obj_t)&modeez_sweep2_obj },
 };
 
 STATIC MP_DEFINE_CONST_DICT(modeez_module_globals, modeez_module_globals_table);
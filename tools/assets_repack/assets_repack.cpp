@@ -0,0 +1,258 @@
+/*
+ * EEZ Modular Firmware
+ * Copyright (C) 2015-present, Envox d.o.o.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Repacks the assets array exported by EEZ Studio (single LZ4 block) into the sections format
+// decompressed lazily by src/eez/gui/assets.cpp. Must be executed after every export,
+// otherwise the firmware falls back to decompressing all the assets at boot.
+//
+// Build:
+//     g++ -O2 -I../../src/eez/libs/lz4 assets_repack.cpp ../../src/eez/libs/lz4/lz4.c -o assets_repack
+//
+// Usage:
+//     assets_repack src/eez/gui/document_simulator.cpp src/eez/gui/document_simulator.h
+//     assets_repack src/eez/gui/document_stm32.cpp src/eez/gui/document_stm32.h
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include <lz4.h>
+
+// must be the same as in assets.cpp
+#define ASSETS_SECTIONS_TAG 0x315A5A45
+
+static const char *ASSETS_DEFINITION = "const uint8_t assets[";
+static const char *ASSETS_DECLARATION = "extern const uint8_t assets[";
+
+static bool readFile(const char *filePath, std::string &content) {
+    FILE *fp = fopen(filePath, "rb");
+    if (!fp) {
+        return false;
+    }
+    char buffer[65536];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), fp)) > 0) {
+        content.append(buffer, n);
+    }
+    fclose(fp);
+    return true;
+}
+
+static bool writeFile(const char *filePath, const std::string &content) {
+    FILE *fp = fopen(filePath, "wb");
+    if (!fp) {
+        return false;
+    }
+    bool result = fwrite(content.data(), 1, content.size(), fp) == content.size();
+    return fclose(fp) == 0 && result;
+}
+
+static uint32_t getUInt32(const std::vector<uint8_t> &data, uint32_t offset) {
+    return data[offset] | (data[offset + 1] << 8) | (data[offset + 2] << 16) | ((uint32_t)data[offset + 3] << 24);
+}
+
+static void putUInt32(std::vector<uint8_t> &data, uint32_t offset, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        data[offset + i] = (value >> (8 * i)) & 0xFF;
+    }
+}
+
+// finds "{ ... };" after the assets definition and parses the hex bytes
+static bool parseAssets(const std::string &source, size_t &begin, size_t &end, std::vector<uint8_t> &assets) {
+    size_t definition = source.find(ASSETS_DEFINITION);
+    if (definition == std::string::npos) {
+        return false;
+    }
+
+    begin = source.find('{', definition);
+    end = source.find("};", begin);
+    if (begin == std::string::npos || end == std::string::npos) {
+        return false;
+    }
+
+    const char *p = source.c_str() + begin + 1;
+    const char *pEnd = source.c_str() + end;
+    while (p < pEnd) {
+        char *next;
+        unsigned long value = strtoul(p, &next, 0);
+        if (next == p) {
+            p++;
+            continue;
+        }
+        if (value > 0xFF) {
+            return false;
+        }
+        assets.push_back((uint8_t)value);
+        p = next;
+    }
+
+    return true;
+}
+
+static std::string formatAssets(const std::vector<uint8_t> &assets) {
+    std::string result = "{\n";
+    char buffer[8];
+    for (size_t i = 0; i < assets.size(); i++) {
+        if (i % 16 == 0) {
+            result += "    ";
+        }
+        snprintf(buffer, sizeof(buffer), "0x%02X", assets[i]);
+        result += buffer;
+        if (i + 1 < assets.size()) {
+            result += i % 16 == 15 ? ",\n" : ", ";
+        }
+    }
+    result += "\n";
+    return result;
+}
+
+static bool replaceSize(std::string &source, const char *prefix, size_t size) {
+    size_t begin = source.find(prefix);
+    if (begin == std::string::npos) {
+        return false;
+    }
+    begin += strlen(prefix);
+    size_t end = source.find(']', begin);
+    if (end == std::string::npos) {
+        return false;
+    }
+    source.replace(begin, end - begin, std::to_string(size));
+    return true;
+}
+
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <document.cpp> <document.h>\n", argv[0]);
+        return 1;
+    }
+
+    std::string source;
+    std::string header;
+    if (!readFile(argv[1], source) || !readFile(argv[2], header)) {
+        fprintf(stderr, "Failed to read input files\n");
+        return 1;
+    }
+
+    size_t arrayBegin;
+    size_t arrayEnd;
+    std::vector<uint8_t> assets;
+    if (!parseAssets(source, arrayBegin, arrayEnd, assets) || assets.size() < 4) {
+        fprintf(stderr, "Assets array not found in %s\n", argv[1]);
+        return 1;
+    }
+
+    if (getUInt32(assets, 0) == ASSETS_SECTIONS_TAG) {
+        printf("Assets are already in the sections format\n");
+        return 0;
+    }
+
+    // first 4 bytes (uint32_t) are decompressed size
+    uint32_t decompressedSize = getUInt32(assets, 0);
+    std::vector<uint8_t> decompressed(decompressedSize);
+    int result = LZ4_decompress_safe((const char *)assets.data() + 4, (char *)decompressed.data(), (int)assets.size() - 4, (int)decompressedSize);
+    if (result != (int)decompressedSize) {
+        fprintf(stderr, "Failed to decompress assets\n");
+        return 1;
+    }
+
+    // header: document, styles, fonts, bitmaps and colors offsets,
+    // fonts and bitmaps start with the table of offsets
+    uint32_t documentOffset = getUInt32(decompressed, 0);
+    uint32_t stylesOffset = getUInt32(decompressed, 4);
+    uint32_t fontsOffset = getUInt32(decompressed, 8);
+    uint32_t bitmapsOffset = getUInt32(decompressed, 12);
+    uint32_t colorsOffset = getUInt32(decompressed, 16);
+
+    struct Range {
+        uint32_t begin;
+        uint32_t end;
+    };
+    std::vector<Range> blocks;
+    blocks.push_back({ documentOffset, stylesOffset });
+    blocks.push_back({ stylesOffset, fontsOffset });
+    blocks.push_back({ colorsOffset, decompressedSize });
+
+    uint32_t numFonts = getUInt32(decompressed, fontsOffset) / 4;
+    for (uint32_t i = 0; i < numFonts; i++) {
+        uint32_t begin = fontsOffset + getUInt32(decompressed, fontsOffset + 4 * i);
+        uint32_t end = i + 1 < numFonts ? fontsOffset + getUInt32(decompressed, fontsOffset + 4 * (i + 1)) : bitmapsOffset;
+        blocks.push_back({ begin, end });
+    }
+
+    uint32_t numBitmaps = getUInt32(decompressed, bitmapsOffset) / 4;
+    for (uint32_t i = 0; i < numBitmaps; i++) {
+        uint32_t begin = bitmapsOffset + getUInt32(decompressed, bitmapsOffset + 4 * i);
+        uint32_t end = i + 1 < numBitmaps ? bitmapsOffset + getUInt32(decompressed, bitmapsOffset + 4 * (i + 1)) : colorsOffset;
+        blocks.push_back({ begin, end });
+    }
+
+    // AssetsSectionsHeader
+    std::vector<uint8_t> repacked(12 + 12 * blocks.size());
+    putUInt32(repacked, 0, ASSETS_SECTIONS_TAG);
+    putUInt32(repacked, 4, numFonts);
+    putUInt32(repacked, 8, numBitmaps);
+
+    std::vector<char> compressed(LZ4_compressBound((int)decompressedSize));
+    std::vector<uint8_t> verify(decompressedSize);
+
+    for (size_t i = 0; i < blocks.size(); i++) {
+        uint32_t size = blocks[i].end - blocks[i].begin;
+        int compressedSize = LZ4_compress_default((const char *)decompressed.data() + blocks[i].begin, compressed.data(), (int)size, (int)compressed.size());
+        if (compressedSize <= 0) {
+            fprintf(stderr, "Failed to compress block %d\n", (int)i);
+            return 1;
+        }
+
+        // blocks are aligned to 4 bytes
+        while (repacked.size() % 4) {
+            repacked.push_back(0);
+        }
+        uint32_t offset = (uint32_t)repacked.size();
+        repacked.insert(repacked.end(), compressed.begin(), compressed.begin() + compressedSize);
+
+        putUInt32(repacked, 12 + 12 * i, offset);
+        putUInt32(repacked, 12 + 12 * i + 4, compressedSize);
+        putUInt32(repacked, 12 + 12 * i + 8, size);
+
+        if (LZ4_decompress_safe((const char *)repacked.data() + offset, (char *)verify.data(), compressedSize, (int)size) != (int)size ||
+            memcmp(verify.data(), decompressed.data() + blocks[i].begin, size) != 0) {
+            fprintf(stderr, "Verification of block %d failed\n", (int)i);
+            return 1;
+        }
+    }
+
+    source.replace(arrayBegin, arrayEnd - arrayBegin, formatAssets(repacked));
+    if (!replaceSize(source, ASSETS_DEFINITION, repacked.size()) || !replaceSize(header, ASSETS_DECLARATION, repacked.size())) {
+        fprintf(stderr, "Assets array size not found\n");
+        return 1;
+    }
+
+    if (!writeFile(argv[1], source) || !writeFile(argv[2], header)) {
+        fprintf(stderr, "Failed to write output files\n");
+        return 1;
+    }
+
+    printf("%d fonts, %d bitmaps, %d blocks, %d bytes (was %d)\n", (int)numFonts, (int)numBitmaps,
+        (int)blocks.size(), (int)repacked.size(), (int)assets.size());
+
+    return 0;
+}